@@ -0,0 +1,196 @@
+//
+// Created by dev on 10/17/26.
+//
+
+/**
+ * @file aot_bench.c
+ * @brief Compare the interpreter with AOT-compiled native code.
+ *
+ * The program is assembled once, translated to C, compiled with the system
+ * compiler and dlopen()ed. Both engines then run it from identical
+ * RAM/CPU states; the final registers, flags, retired-instruction count and
+ * RAM must match exactly before any timing is reported.
+ *
+ * Usage: aot_bench [-n trials] [--packed] [-S] [file.asm]
+ *   -n trials  number of timed runs per engine (default 10)
+ *   --packed   assemble with the packed encoding
+ *   -S         print the generated C source and exit
+ * Without a file a built-in loop that mixes ALU, memory, compare and
+ * branch instructions is used.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "aot.h"
+#include "assembler.h"
+#include "cpu.h"
+#include "cpu_exec.h"
+#include "log.h"
+#include "ram.h"
+
+static const char *DEFAULT_PROGRAM =
+    ".org 0x0000\n"
+    "main:\n"
+    "    LOADI R0, 0\n"
+    "    LOADI R1, 1000000\n"
+    "    LOADI R2, 1\n"
+    "    LOADI R3, 7\n"
+    "    LOADI R6, 3\n"
+    "    LOADA A0, 0x2000\n"
+    "loop:\n"
+    "    ADD    R0, R3\n"
+    "    MLP    R3, 5\n"
+    "    XOR    R4, R0\n"
+    "    LOADM  R5, (A0)\n"
+    "    ADD    R5, R2\n"
+    "    STOREM (A0), R5\n"
+    "    CMP    R4, R6\n"
+    "    JZ     skip\n"
+    "    DIV    R4, R6\n"
+    "skip:\n"
+    "    SUB    R1, R2\n"
+    "    JNZ    loop\n"
+    "    HALT\n";
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Return true if both runs ended in exactly the same state.
+ */
+static bool same_state(const CPU *a, const RAM *ram_a, const CPU *b, const RAM *ram_b) {
+    return a->pc == b->pc
+        && a->zero_flag == b->zero_flag
+        && a->negative_flag == b->negative_flag
+        && a->running == b->running
+        && a->instructions_retired == b->instructions_retired
+        && memcmp(a->registers, b->registers, sizeof(a->registers)) == 0
+        && memcmp(a->address_registers, b->address_registers, sizeof(a->address_registers)) == 0
+        && memcmp(ram_a->cells, ram_b->cells, sizeof(ram_a->cells)) == 0;
+}
+
+int main(int argc, char **argv) {
+    int trials = 10;
+    bool print_source = false;
+    InstructionEncoding encoding = ENCODING_WIDE;
+    const char *source = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            trials = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--packed") == 0) {
+            encoding = ENCODING_PACKED;
+        } else if (strcmp(argv[i], "-S") == 0) {
+            print_source = true;
+        } else {
+            source = argv[i];
+        }
+    }
+    if (trials < 1)
+        trials = 1;
+
+    log_set_enabled(LOG_DEBUG, false);
+    log_set_enabled(LOG_INFO, false);
+
+    char source_path[] = "/tmp/aot_bench_src_XXXXXX";
+    if (!source) {
+        int fd = mkstemp(source_path);
+        if (fd < 0) {
+            perror("mkstemp");
+            return 1;
+        }
+        FILE *f = fdopen(fd, "w");
+        fputs(DEFAULT_PROGRAM, f);
+        fclose(f);
+        source = source_path;
+    }
+
+    static RAM image;
+    ram_init(&image);
+    AssemblyRange range = assemble_into(image.cells, RAM_SIZE, source, encoding);
+    if (source == source_path)
+        unlink(source_path);
+    if (range.error) {
+        fprintf(stderr, "Assembly failed\n");
+        return 1;
+    }
+
+    if (print_source)
+        return aot_translate(image.cells, RAM_SIZE, range, NULL, stdout) ? 0 : 1;
+
+    AotModule module;
+    uint64_t compile_ns = 0;
+    if (!aot_build(&module, image.cells, RAM_SIZE, range, &compile_ns)) {
+        fprintf(stderr, "AOT build failed\n");
+        return 1;
+    }
+
+    static RAM ram_interp, ram_aot;
+    CPU cpu_interp, cpu_aot;
+    uint64_t *interp_ns = calloc((size_t)trials, sizeof(uint64_t));
+    uint64_t *aot_ns = calloc((size_t)trials, sizeof(uint64_t));
+    if (!interp_ns || !aot_ns) {
+        aot_unload(&module);
+        return 1;
+    }
+
+    bool ok = true;
+    for (int t = 0; t < trials && ok; t++) {
+        memcpy(ram_interp.cells, image.cells, sizeof(image.cells));
+        cpu_init(&cpu_interp);
+        uint64_t t0 = now_ns();
+        bool interp_ok = cpu_run(&cpu_interp, &ram_interp, range);
+        interp_ns[t] = now_ns() - t0;
+
+        memcpy(ram_aot.cells, image.cells, sizeof(image.cells));
+        cpu_init(&cpu_aot);
+        t0 = now_ns();
+        bool aot_ok = aot_run(&module, &cpu_aot, &ram_aot);
+        aot_ns[t] = now_ns() - t0;
+
+        if (interp_ok != aot_ok || !same_state(&cpu_interp, &ram_interp, &cpu_aot, &ram_aot)) {
+            fprintf(stderr, "State mismatch between interpreter and AOT code (trial %d)\n", t);
+            ok = false;
+        }
+    }
+    aot_unload(&module);
+
+    if (ok) {
+        qsort(interp_ns, (size_t)trials, sizeof(uint64_t), compare_u64);
+        qsort(aot_ns, (size_t)trials, sizeof(uint64_t), compare_u64);
+        uint64_t retired = cpu_interp.instructions_retired;
+        uint64_t interp_median = interp_ns[trials / 2];
+        uint64_t aot_median = aot_ns[trials / 2];
+
+        printf("program: %u words (%s), %llu instructions retired, state verified identical\n",
+               range.end_address - range.start_address, encoding_name(encoding), (unsigned long long)retired);
+        printf("aot compile: %.1f ms (translate + cc + load)\n", (double)compile_ns / 1e6);
+        printf("%-12s %12s %10s %10s\n", "engine", "median_ms", "ns/insn", "MIPS");
+        printf("%-12s %12.3f %10.2f %10.1f\n", "interpreter", (double)interp_median / 1e6,
+               retired ? (double)interp_median / (double)retired : 0.0,
+               interp_median ? (double)retired * 1e3 / (double)interp_median : 0.0);
+        printf("%-12s %12.3f %10.2f %10.1f\n", "aot", (double)aot_median / 1e6,
+               retired ? (double)aot_median / (double)retired : 0.0,
+               aot_median ? (double)retired * 1e3 / (double)aot_median : 0.0);
+        printf("speedup: %.1fx; compile cost recovered after %.1f runs\n",
+               aot_median ? (double)interp_median / (double)aot_median : 0.0,
+               interp_median > aot_median ? (double)compile_ns / (double)(interp_median - aot_median) : 0.0);
+    }
+
+    free(interp_ns);
+    free(aot_ns);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,666 @@
+//
+// Created by dev on 10/17/26.
+//
+
+/**
+ * @file bench.c
+ * @brief Reproducible interpreter benchmark suite with MIPS reporting.
+ *
+ * Each workload is a generated guest program that stresses one part of
+ * the interpreter. A workload is assembled once; every run then starts
+ * from a pristine copy of the assembled RAM and a fresh CPU, so all runs
+ * execute exactly the same instruction stream. After `warmup` untimed runs,
+ * `trials` timed runs are collected and summarised as median, p99, min and
+ * mean wall time, ns per guest instruction and guest MIPS (computed from
+ * the median).
+ *
+ * Workloads of kind WORKLOAD_ASSEMBLE time the assembler instead: a
+ * synthetic program (see asmgen.h) with `iterations` instructions and one
+ * label per 20 instructions is assembled into a buffer large enough for
+ * it, and "insns" / MIPS count source instructions assembled.
+ *
+ * Execution workloads also read host hardware counters (perf_counters.h)
+ * around every timed cpu_run(): cycles, instructions, branch misses and
+ * L1D/LLC misses, averaged over the trials. From them the suite derives
+ * host instructions per guest instruction, branch mispredicts per
+ * dispatched guest instruction, IPC and cache misses per thousand guest
+ * instructions. Without perf access (no PMU, perf_event_paranoid too
+ * high) only wall-clock numbers are reported.
+ *
+ * The process is pinned to one CPU (the one it starts on unless --cpu is
+ * given) so trials are not spread across cores with different caches or
+ * frequencies. JSON output puts one workload per line so results can be
+ * diffed, and --baseline compares a run against a previously saved JSON.
+ * The JSON header records the build type, compiler and flags the suite was
+ * built with; --baseline refuses a file recorded by a different build, so
+ * an unoptimised run is never compared against an optimised one.
+ *
+ * Usage: bench [options]
+ *   --trials N     timed runs per workload (default 20)
+ *   --warmup N     untimed runs before timing (default 3)
+ *   --scale F      multiply every workload's iteration count (default 1.0)
+ *   --cpu K        pin to CPU K; -1 disables pinning (default: current CPU)
+ *   --filter NAME  only run workloads whose name contains NAME
+ *   --json         print JSON instead of a table
+ *   --baseline F   compare medians against a JSON file written by --json
+ *   --no-perf      do not open hardware performance counters
+ *   --list         list workloads and exit
+ */
+
+#define _GNU_SOURCE
+#include <sched.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "asmgen.h"
+#include "assembler.h"
+#include "cpu.h"
+#include "cpu_exec.h"
+#include "encoding.h"
+#include "log.h"
+#include "perf_counters.h"
+#include "ram.h"
+
+/** Generates the source of a workload for a given iteration count. */
+typedef void (*WorkloadSource)(FILE *out, uint32_t iterations);
+
+/** What a workload measures. */
+typedef enum {
+    WORKLOAD_EXECUTE,          /**< cpu_run() of the assembled program */
+    WORKLOAD_ASSEMBLE          /**< assemble_into() of a synthetic program */
+} WorkloadKind;
+
+typedef struct {
+    const char *name;
+    const char *description;
+    uint32_t iterations;       /**< Loop iterations (source instructions for WORKLOAD_ASSEMBLE) at --scale 1.0 */
+    WorkloadSource source;     /**< Unused for WORKLOAD_ASSEMBLE */
+    WorkloadKind kind;
+} Workload;
+
+typedef struct {
+    uint64_t retired;
+    uint64_t median_ns;
+    uint64_t p99_ns;
+    uint64_t min_ns;
+    uint64_t mean_ns;
+    double perf[PERF_COUNTER_COUNT];        /**< Mean counter value per timed run */
+    bool perf_valid[PERF_COUNTER_COUNT];    /**< Counter was read in every timed run */
+} WorkloadResult;
+
+/**
+ * @brief Tight register-only ALU loop.
+ */
+static void source_alu(FILE *out, uint32_t iterations) {
+    fprintf(out,
+            ".org 0x0000\n"
+            "main:\n"
+            "    LOADI R0, %u\n"
+            "    LOADI R1, 1\n"
+            "    LOADI R2, 0x12345\n"
+            "    LOADI R3, 7\n"
+            "loop:\n"
+            "    ADD R2, R3\n"
+            "    XOR R4, R2\n"
+            "    AND R4, 0xFFFF\n"
+            "    MLP R3, 3\n"
+            "    OR  R5, R4\n"
+            "    SUB R2, R1\n"
+            "    SUB R0, R1\n"
+            "    JNZ loop\n"
+            "    HALT\n",
+            iterations);
+}
+
+/**
+ * @brief Copy-and-increment over a 64-word window through LOADM/STOREM.
+ *
+ * The ISA cannot advance an address register, so the stream is unrolled:
+ * half of the accesses use literal addresses and half go through an
+ * address register reloaded with LOADA.
+ */
+static void source_memory(FILE *out, uint32_t iterations) {
+    fprintf(out,
+            ".org 0x0000\n"
+            "main:\n"
+            "    LOADI R0, %u\n"
+            "    LOADI R1, 1\n"
+            "loop:\n",
+            iterations);
+    for (uint32_t k = 0; k < 32; k++) {
+        fprintf(out, "    LOADM  R2, (0x%04X)\n", 0x4000 + k);
+        fprintf(out, "    ADD    R2, R1\n");
+        fprintf(out, "    STOREM (0x%04X), R2\n", 0x5000 + k);
+    }
+    for (uint32_t k = 32; k < 64; k++) {
+        fprintf(out, "    LOADA  A0, 0x%04X\n", 0x4000 + k);
+        fprintf(out, "    LOADA  A1, 0x%04X\n", 0x5000 + k);
+        fprintf(out, "    LOADM  R2, (A0)\n");
+        fprintf(out, "    STOREM (A1), R2\n");
+    }
+    fprintf(out,
+            "    SUB R0, R1\n"
+            "    JNZ loop\n"
+            "    HALT\n");
+}
+
+/**
+ * @brief Data-dependent branches driven by a linear congruential generator.
+ */
+static void source_branch(FILE *out, uint32_t iterations) {
+    fprintf(out,
+            ".org 0x0000\n"
+            "main:\n"
+            "    LOADI R0, %u\n"
+            "    LOADI R1, 1\n"
+            "    LOADI R2, 12345\n"
+            "loop:\n"
+            "    MLP R2, 1103515245\n"
+            "    ADD R2, 12345\n"
+            "    LOADI R3, 0\n"
+            "    OR  R3, R2\n"
+            "    AND R3, 0x10000\n"
+            "    JZ  even\n"
+            "    ADD R4, 1\n"
+            "    JMP second\n"
+            "even:\n"
+            "    ADD R5, 1\n"
+            "second:\n"
+            "    LOADI R3, 0\n"
+            "    OR  R3, R2\n"
+            "    AND R3, 0x400000\n"
+            "    JNZ odd\n"
+            "    XOR R6, R2\n"
+            "odd:\n"
+            "    CMP R4, R5\n"
+            "    JZ  tie\n"
+            "    ADD R7, 1\n"
+            "tie:\n"
+            "    SUB R0, R1\n"
+            "    JNZ loop\n"
+            "    HALT\n",
+            iterations);
+}
+
+/**
+ * @brief Division-heavy loop (register and immediate divisors).
+ */
+static void source_div(FILE *out, uint32_t iterations) {
+    fprintf(out,
+            ".org 0x0000\n"
+            "main:\n"
+            "    LOADI R0, %u\n"
+            "    LOADI R1, 1\n"
+            "    LOADI R3, 7\n"
+            "loop:\n"
+            "    LOADI R2, 0xFFFFFFF0\n"
+            "    DIV R2, R3\n"
+            "    DIV R2, 3\n"
+            "    ADD R6, R2\n"
+            "    LOADI R4, 1000000007\n"
+            "    DIV R4, R0\n"
+            "    DIV R4, 13\n"
+            "    XOR R6, R4\n"
+            "    SUB R0, R1\n"
+            "    JNZ loop\n"
+            "    HALT\n",
+            iterations);
+}
+
+/**
+ * @brief Seeded synthetic program with the default asmgen mix.
+ */
+static void source_synthetic(FILE *out, uint32_t iterations) {
+    AsmGenConfig config;
+    asmgen_default_config(&config);
+    config.iterations = iterations;
+    asmgen_write(&config, out, NULL);
+}
+
+static const Workload WORKLOADS[] = {
+    { "alu",      "register ALU loop (ADD/XOR/AND/MLP/OR/SUB)",    1000000, source_alu, WORKLOAD_EXECUTE },
+    { "memory",   "LOADM/STOREM streaming, literal + (An) forms",   40000, source_memory, WORKLOAD_EXECUTE },
+    { "branch",   "LCG-driven data-dependent JZ/JNZ/JMP/CMP",       500000, source_branch, WORKLOAD_EXECUTE },
+    { "div",      "DIV-heavy loop, register and immediate divisors", 800000, source_div, WORKLOAD_EXECUTE },
+    { "synth",    "asmgen default mix, 4K-insn body, 256 labels",     256, source_synthetic, WORKLOAD_EXECUTE },
+    { "asm_10k",  "assemble 10K synthetic insns, 500 labels",       10000, NULL, WORKLOAD_ASSEMBLE },
+    { "asm_100k", "assemble 100K synthetic insns, 5K labels",      100000, NULL, WORKLOAD_ASSEMBLE },
+    { "asm_1m",   "assemble 1M synthetic insns, 50K labels",      1000000, NULL, WORKLOAD_ASSEMBLE },
+};
+
+#define WORKLOAD_COUNT (sizeof(WORKLOADS) / sizeof(WORKLOADS[0]))
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Nearest-rank percentile of a sorted sample array.
+ */
+static uint64_t percentile(const uint64_t *sorted, int count, double p) {
+    int rank = (int)ceil(p / 100.0 * count);
+    if (rank < 1)
+        rank = 1;
+    if (rank > count)
+        rank = count;
+    return sorted[rank - 1];
+}
+
+/**
+ * @brief Pin the process to one CPU.
+ *
+ * @param cpu CPU index, or -1 for the CPU the process is running on now.
+ * @return The CPU pinned to, or -1 if pinning failed.
+ */
+static int pin_to_cpu(int cpu) {
+    if (cpu < 0)
+        cpu = sched_getcpu();
+    if (cpu < 0)
+        return -1;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0 ? cpu : -1;
+}
+
+/**
+ * @brief Sort the samples of a finished workload and fill in its summary.
+ */
+static void summarise(uint64_t *samples, int trials, uint64_t retired, WorkloadResult *result) {
+    qsort(samples, (size_t)trials, sizeof(uint64_t), compare_u64);
+    uint64_t total = 0;
+    for (int t = 0; t < trials; t++)
+        total += samples[t];
+
+    result->retired = retired;
+    result->median_ns = percentile(samples, trials, 50.0);
+    result->p99_ns = percentile(samples, trials, 99.0);
+    result->min_ns = samples[0];
+    result->mean_ns = total / (uint64_t)trials;
+}
+
+/**
+ * @brief Time assembly of a generated source file.
+ *
+ * The output buffer is sized from the generator's wide-encoding word count,
+ * so programs far larger than RAM can be assembled.
+ */
+static bool time_assembly(const Workload *workload, const char *path, const AsmGenStats *stats, int warmup,
+                          int trials, WorkloadResult *result) {
+    uint64_t capacity = stats->wide_words + 64;
+    if (capacity > UINT32_MAX) {
+        fprintf(stderr, "%s: program too large\n", workload->name);
+        return false;
+    }
+    uint32_t *buffer = calloc((size_t)capacity, sizeof(uint32_t));
+    uint64_t *samples = calloc((size_t)trials, sizeof(uint64_t));
+    if (!buffer || !samples) {
+        free(buffer);
+        free(samples);
+        return false;
+    }
+
+    for (int run = 0; run < warmup + trials; run++) {
+        uint64_t t0 = now_ns();
+        AssemblyRange range = assemble_into(buffer, (uint32_t)capacity, path, ENCODING_WIDE);
+        uint64_t elapsed = now_ns() - t0;
+        if (range.error) {
+            fprintf(stderr, "%s: assembly failed\n", workload->name);
+            free(buffer);
+            free(samples);
+            return false;
+        }
+        if (run >= warmup)
+            samples[run - warmup] = elapsed;
+    }
+
+    summarise(samples, trials, stats->instructions, result);
+    free(buffer);
+    free(samples);
+    return true;
+}
+
+/**
+ * @brief Generate, assemble and time one workload.
+ */
+static bool run_workload(const Workload *workload, double scale, int warmup, int trials, PerfCounters *perf,
+                         WorkloadResult *result) {
+    memset(result, 0, sizeof(*result));
+    char path[] = "/tmp/bench_workload_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return false;
+    }
+    FILE *f = fdopen(fd, "w");
+    uint32_t iterations = (uint32_t)(workload->iterations * scale);
+    if (iterations == 0)
+        iterations = 1;
+
+    if (workload->kind == WORKLOAD_ASSEMBLE) {
+        AsmGenConfig config;
+        AsmGenStats stats;
+        asmgen_default_config(&config);
+        config.instructions = iterations;
+        config.labels = iterations / 20 > 0 ? iterations / 20 : 1;
+        config.iterations = 1;
+        log_set_enabled(LOG_WARN, false); /* large programs overlap the data region; they are never run */
+        bool generated = asmgen_write(&config, f, &stats);
+        log_set_enabled(LOG_WARN, true);
+        fclose(f);
+        bool ok = generated && time_assembly(workload, path, &stats, warmup, trials, result);
+        unlink(path);
+        return ok;
+    }
+
+    workload->source(f, iterations);
+    fclose(f);
+
+    /* Initialised once: ram_init() sets up each RAM's lock, which is never destroyed. */
+    static RAM image;
+    static RAM ram;
+    static bool rams_ready = false;
+    if (!rams_ready) {
+        ram_init(&image);
+        ram_init(&ram);
+        rams_ready = true;
+    } else {
+        memset(image.cells, 0, sizeof(image.cells));
+    }
+    AssemblyRange range = assemble_into(image.cells, RAM_SIZE, path, ENCODING_WIDE);
+    unlink(path);
+    if (range.error) {
+        fprintf(stderr, "%s: assembly failed\n", workload->name);
+        return false;
+    }
+
+    uint64_t *samples = calloc((size_t)trials, sizeof(uint64_t));
+    if (!samples)
+        return false;
+
+    double perf_sum[PERF_COUNTER_COUNT] = { 0 };
+    int perf_runs[PERF_COUNTER_COUNT] = { 0 };
+
+    CPU cpu;
+    for (int run = 0; run < warmup + trials; run++) {
+        memcpy(ram.cells, image.cells, sizeof(image.cells));
+        cpu_init(&cpu);
+        perf_counters_start(perf);
+        uint64_t t0 = now_ns();
+        bool ok = cpu_run(&cpu, &ram, range);
+        uint64_t elapsed = now_ns() - t0;
+        PerfSample sample;
+        perf_counters_stop(perf, &sample);
+        if (!ok) {
+            fprintf(stderr, "%s: execution failed\n", workload->name);
+            free(samples);
+            return false;
+        }
+        if (run < warmup)
+            continue;
+        samples[run - warmup] = elapsed;
+        for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+            if (sample.valid[c]) {
+                perf_sum[c] += (double)sample.values[c];
+                perf_runs[c]++;
+            }
+        }
+    }
+
+    summarise(samples, trials, cpu.instructions_retired, result);
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        result->perf_valid[c] = perf_runs[c] == trials;
+        result->perf[c] = result->perf_valid[c] ? perf_sum[c] / trials : 0.0;
+    }
+    free(samples);
+    return true;
+}
+
+static double mips(const WorkloadResult *r) {
+    return r->median_ns ? (double)r->retired * 1e3 / (double)r->median_ns : 0.0;
+}
+
+static double ns_per_insn(const WorkloadResult *r) {
+    return r->retired ? (double)r->median_ns / (double)r->retired : 0.0;
+}
+
+/**
+ * @brief Mean counter value per guest instruction, or NAN if unavailable.
+ */
+static double per_guest_insn(const WorkloadResult *r, PerfCounter counter) {
+    return r->perf_valid[counter] && r->retired ? r->perf[counter] / (double)r->retired : NAN;
+}
+
+static double host_ipc(const WorkloadResult *r) {
+    return r->perf_valid[PERF_CYCLES] && r->perf_valid[PERF_INSTRUCTIONS] && r->perf[PERF_CYCLES] > 0
+        ? r->perf[PERF_INSTRUCTIONS] / r->perf[PERF_CYCLES] : NAN;
+}
+
+/**
+ * @brief Print one derived metric as a table cell ("-" when unavailable).
+ */
+static void print_metric(double value, const char *format) {
+    if (isnan(value))
+        printf(" %8s", "-");
+    else
+        printf(format, value);
+}
+
+/**
+ * @brief Print the raw counters and derived metrics as JSON members.
+ */
+static void print_perf_json(const WorkloadResult *r) {
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        if (r->perf_valid[c])
+            printf(", \"%s\": %.0f", perf_counter_name((PerfCounter)c), r->perf[c]);
+    }
+    double derived[] = { per_guest_insn(r, PERF_INSTRUCTIONS), per_guest_insn(r, PERF_BRANCH_MISSES), host_ipc(r),
+                         per_guest_insn(r, PERF_L1D_MISSES) * 1e3, per_guest_insn(r, PERF_LLC_MISSES) * 1e3 };
+    const char *names[] = { "host_insns_per_guest", "mispredicts_per_dispatch", "ipc",
+                            "l1d_misses_per_kinsn", "llc_misses_per_kinsn" };
+    for (size_t i = 0; i < sizeof(derived) / sizeof(derived[0]); i++) {
+        if (!isnan(derived[i]))
+            printf(", \"%s\": %.4f", names[i], derived[i]);
+    }
+}
+
+#ifndef BENCH_BUILD_TYPE
+#define BENCH_BUILD_TYPE "unknown"
+#endif
+#ifndef BENCH_C_FLAGS
+#define BENCH_C_FLAGS ""
+#endif
+
+/** Build description written to the JSON header and checked by --baseline. */
+#define BENCH_BUILD "\"build\": \"" BENCH_BUILD_TYPE "\", \"compiler\": \"" __VERSION__ \
+                    "\", \"cflags\": \"" BENCH_C_FLAGS "\""
+
+/**
+ * @brief Check that a JSON file written by --json comes from this build.
+ *
+ * @return false (with a message) if the file is missing or its build type,
+ *         compiler or flags differ from this binary's.
+ */
+static bool baseline_same_build(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "cannot read baseline %s\n", path);
+        return false;
+    }
+    char line[1024];
+    bool same = fgets(line, sizeof(line), f) && strstr(line, BENCH_BUILD);
+    fclose(f);
+    if (!same)
+        fprintf(stderr, "baseline %s was recorded by a different build; this one is {%s}\n", path, BENCH_BUILD);
+    return same;
+}
+
+/**
+ * @brief Look up a workload's median in a JSON file written by --json.
+ *
+ * Relies on the one-object-per-line layout this tool writes.
+ *
+ * @return Median in ns, or 0 if the workload is not in the file.
+ */
+static uint64_t baseline_median(const char *path, const char *name) {
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return 0;
+
+    char line[512];
+    char key[64];
+    snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+    uint64_t median = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (!strstr(line, key))
+            continue;
+        const char *m = strstr(line, "\"median_ns\": ");
+        if (m)
+            median = strtoull(m + strlen("\"median_ns\": "), NULL, 10);
+        break;
+    }
+    fclose(f);
+    return median;
+}
+
+int main(int argc, char **argv) {
+    int trials = 20;
+    int warmup = 3;
+    int cpu = -1;
+    bool pin = true;
+    double scale = 1.0;
+    bool json = false;
+    const char *filter = NULL;
+    const char *baseline = NULL;
+    bool use_perf = true;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trials") == 0 && i + 1 < argc) {
+            trials = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            scale = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            cpu = atoi(argv[++i]);
+            pin = cpu >= 0;
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline = argv[++i];
+        } else if (strcmp(argv[i], "--no-perf") == 0) {
+            use_perf = false;
+        } else if (strcmp(argv[i], "--list") == 0) {
+            for (size_t w = 0; w < WORKLOAD_COUNT; w++)
+                printf("%-9s %s\n", WORKLOADS[w].name, WORKLOADS[w].description);
+            return 0;
+        } else {
+            fprintf(stderr, "Usage: %s [--trials N] [--warmup N] [--scale F] [--cpu K] [--filter NAME] "
+                            "[--json] [--baseline FILE] [--no-perf] [--list]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (trials < 1)
+        trials = 1;
+    if (warmup < 0)
+        warmup = 0;
+    if (scale <= 0)
+        scale = 1.0;
+    if (baseline && !baseline_same_build(baseline))
+        return 2;
+
+    log_set_enabled(LOG_DEBUG, false);
+    log_set_enabled(LOG_INFO, false);
+
+    int pinned = pin ? pin_to_cpu(cpu) : -1;
+    if (pin && pinned < 0)
+        fprintf(stderr, "warning: unable to pin to a CPU, results may be noisier\n");
+
+    /* Opened after pinning so the counters follow the measuring thread on its CPU. */
+    PerfCounters perf;
+    perf_counters_init(&perf);
+    bool have_perf = use_perf && perf_counters_open(&perf);
+    if (!have_perf) {
+        if (use_perf)
+            fprintf(stderr, "warning: hardware performance counters unavailable, reporting wall-clock only\n");
+    }
+
+    if (json) {
+        printf("{%s, \"trials\": %d, \"warmup\": %d, \"scale\": %.3f, \"pinned_cpu\": %d, \"perf\": %s, "
+               "\"workloads\": [\n", BENCH_BUILD, trials, warmup, scale, pinned, have_perf ? "true" : "false");
+    } else {
+        printf("%s build, trials %d, warmup %d, scale %.2f, pinned cpu %d, perf counters %s\n", BENCH_BUILD_TYPE,
+               trials, warmup, scale, pinned, have_perf ? "on" : "off");
+        printf("%-9s %12s %10s %10s %10s %10s %9s %8s", "workload", "insns", "median_ms", "p99_ms", "min_ms",
+               "mean_ms", "ns/insn", "MIPS");
+        if (have_perf)
+            printf(" %8s %8s %8s %8s %8s", "host/g", "mis/disp", "IPC", "L1m/Kg", "LLCm/Kg");
+        printf(baseline ? " %9s\n" : "\n", "vs_base");
+    }
+
+    bool ok = true;
+    bool first = true;
+    for (size_t w = 0; w < WORKLOAD_COUNT; w++) {
+        const Workload *workload = &WORKLOADS[w];
+        if (filter && !strstr(workload->name, filter))
+            continue;
+
+        WorkloadResult r;
+        if (!run_workload(workload, scale, warmup, trials, &perf, &r)) {
+            ok = false;
+            continue;
+        }
+
+        uint64_t base = baseline ? baseline_median(baseline, workload->name) : 0;
+        double delta = base ? 100.0 * ((double)r.median_ns - (double)base) / (double)base : 0.0;
+
+        if (json) {
+            printf("%s  {\"name\": \"%s\", \"instructions\": %llu, \"median_ns\": %llu, \"p99_ns\": %llu, "
+                   "\"min_ns\": %llu, \"mean_ns\": %llu, \"ns_per_insn\": %.3f, \"mips\": %.2f",
+                   first ? "" : ",\n", workload->name, (unsigned long long)r.retired,
+                   (unsigned long long)r.median_ns, (unsigned long long)r.p99_ns,
+                   (unsigned long long)r.min_ns, (unsigned long long)r.mean_ns, ns_per_insn(&r), mips(&r));
+            print_perf_json(&r);
+            if (base)
+                printf(", \"baseline_median_ns\": %llu, \"delta_pct\": %.2f", (unsigned long long)base, delta);
+            printf("}");
+        } else {
+            printf("%-9s %12llu %10.3f %10.3f %10.3f %10.3f %9.2f %8.1f", workload->name,
+                   (unsigned long long)r.retired, (double)r.median_ns / 1e6, (double)r.p99_ns / 1e6,
+                   (double)r.min_ns / 1e6, (double)r.mean_ns / 1e6, ns_per_insn(&r), mips(&r));
+            if (have_perf) {
+                print_metric(per_guest_insn(&r, PERF_INSTRUCTIONS), " %8.1f");
+                print_metric(per_guest_insn(&r, PERF_BRANCH_MISSES), " %8.4f");
+                print_metric(host_ipc(&r), " %8.2f");
+                print_metric(per_guest_insn(&r, PERF_L1D_MISSES) * 1e3, " %8.2f");
+                print_metric(per_guest_insn(&r, PERF_LLC_MISSES) * 1e3, " %8.3f");
+            }
+            if (base)
+                printf(" %+8.1f%%", delta);
+            else if (baseline)
+                printf(" %9s", "n/a");
+            printf("\n");
+        }
+        fflush(stdout);
+        first = false;
+    }
+
+    perf_counters_close(&perf);
+    if (json)
+        printf("\n]}\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+//
+// Created by dev on 10/17/26.
+//
+
+/**
+ * @file embed_bench.c
+ * @brief Jobs per second through the embedding API (emulator.h).
+ *
+ * A small checksum program is loaded into one instance and run once per
+ * input with emu_run_batch(); each input supplies a data window and reads
+ * the result back through an output window. A second pass assembles and
+ * runs a fresh source per job with emu_assemble_run_batch(). Every result
+ * is checked against the host-computed checksum.
+ *
+ * Usage: embed_bench [-n jobs] [-e engine]
+ *   -n jobs    number of jobs per pass (default 100000)
+ *   -e engine  engine name from engine.h (default switch)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "emulator.h"
+
+#define INPUT_WORDS  16
+#define INPUT_BASE   0x4000
+#define OUTPUT_BASE  0x4100
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Write the checksum program: R0 = sum of (word * 3) over the input window.
+ *
+ * @return Number of bytes written (excluding the terminator).
+ */
+static size_t write_program(char *out, size_t size, uint32_t bias) {
+    size_t n = (size_t)snprintf(out, size, ".org 0x0000\n    LOADI R0, %u\n", bias);
+    for (int i = 0; i < INPUT_WORDS; i++)
+        n += (size_t)snprintf(out + n, size - n, "    LOADM R1, (0x%04X)\n    MLP R1, 3\n    ADD R0, R1\n",
+                              INPUT_BASE + i);
+    n += (size_t)snprintf(out + n, size - n, "    STOREM (0x%04X), R0\n    HALT\n", OUTPUT_BASE);
+    return n;
+}
+
+static uint32_t expected_sum(const uint32_t *words, uint32_t bias) {
+    uint32_t sum = bias;
+    for (int i = 0; i < INPUT_WORDS; i++)
+        sum += words[i] * 3u;
+    return sum;
+}
+
+int main(int argc, char **argv) {
+    size_t jobs = 100000;
+    const char *engine = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            jobs = strtoull(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+            engine = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [-n jobs] [-e engine]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (jobs == 0)
+        jobs = 1;
+
+    EmuConfig config;
+    emu_config_default(&config);
+    config.engine = engine;
+    Emulator *emu = emu_create(&config);
+    if (!emu)
+        return 1;
+
+    char source[4096];
+    size_t length = write_program(source, sizeof(source), 0);
+    if (!emu_load_source(emu, source, length)) {
+        emu_destroy(emu);
+        return 1;
+    }
+
+    uint32_t *data = malloc(jobs * INPUT_WORDS * sizeof(uint32_t));
+    uint32_t *outputs = malloc(jobs * sizeof(uint32_t));
+    EmuInput *inputs = calloc(jobs, sizeof(EmuInput));
+    EmuResult *results = malloc(jobs * sizeof(EmuResult));
+    if (!data || !outputs || !inputs || !results) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (size_t j = 0; j < jobs; j++) {
+        for (int i = 0; i < INPUT_WORDS; i++)
+            data[j * INPUT_WORDS + i] = (uint32_t)(j * 2654435761u + (uint32_t)i);
+        inputs[j].data = &data[j * INPUT_WORDS];
+        inputs[j].data_address = INPUT_BASE;
+        inputs[j].data_count = INPUT_WORDS;
+        inputs[j].output = &outputs[j];
+        inputs[j].output_address = OUTPUT_BASE;
+        inputs[j].output_count = 1;
+    }
+
+    uint64_t t0 = now_ns();
+    size_t ok = emu_run_batch(emu, inputs, jobs, results);
+    uint64_t run_ns = now_ns() - t0;
+
+    size_t wrong = 0;
+    for (size_t j = 0; j < jobs; j++) {
+        uint32_t expected = expected_sum(&data[j * INPUT_WORDS], 0);
+        if (outputs[j] != expected || results[j].registers[0] != expected)
+            wrong++;
+    }
+    printf("run_batch:          %zu jobs, %zu ok, %zu wrong, %.3f s, %.0f jobs/s, %.2f us/job\n", jobs, ok, wrong,
+           (double)run_ns / 1e9, (double)jobs * 1e9 / (double)run_ns, (double)run_ns / 1e3 / (double)jobs);
+
+    /* Assemble + run: one distinct source per job (the bias differs). */
+    size_t source_jobs = jobs < 10000 ? jobs : 10000;
+    char **sources = malloc(source_jobs * sizeof(char *));
+    size_t *lengths = malloc(source_jobs * sizeof(size_t));
+    if (!sources || !lengths) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (size_t j = 0; j < source_jobs; j++) {
+        sources[j] = malloc(sizeof(source));
+        lengths[j] = write_program(sources[j], sizeof(source), (uint32_t)j);
+    }
+
+    t0 = now_ns();
+    ok = emu_assemble_run_batch(emu, (const char *const *)sources, lengths, source_jobs, results);
+    uint64_t asm_ns = now_ns() - t0;
+
+    wrong = 0;
+    static const uint32_t zeros[INPUT_WORDS];
+    for (size_t j = 0; j < source_jobs; j++) {
+        if (results[j].registers[0] != expected_sum(zeros, (uint32_t)j))
+            wrong++;
+    }
+    printf("assemble_run_batch: %zu jobs, %zu ok, %zu wrong, %.3f s, %.0f jobs/s, %.2f us/job\n", source_jobs, ok,
+           wrong, (double)asm_ns / 1e9, (double)source_jobs * 1e9 / (double)asm_ns,
+           (double)asm_ns / 1e3 / (double)source_jobs);
+
+    for (size_t j = 0; j < source_jobs; j++)
+        free(sources[j]);
+    free(sources);
+    free(lengths);
+    free(data);
+    free(outputs);
+    free(inputs);
+    free(results);
+    emu_destroy(emu);
+    return wrong ? 1 : 0;
+}
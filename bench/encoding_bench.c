@@ -0,0 +1,213 @@
+//
+// Created by dev on 10/17/26.
+//
+
+/**
+ * @file encoding_bench.c
+ * @brief Compare code size and execution cost of the wide and packed encodings.
+ *
+ * The program is assembled once per encoding, round-tripped through an
+ * image file (exercising the header flag and loader), then executed a
+ * number of times. For each encoding the benchmark reports the static code
+ * size, the average instruction length and the time per guest instruction.
+ *
+ * Usage: encoding_bench [-n trials] [-d] [file.asm]
+ *   -n trials  number of timed runs per encoding (default 20)
+ *   -d         print the disassembly of both images
+ * Without a file a built-in loop that mixes ALU, memory and branch
+ * instructions is used.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "assembler.h"
+#include "cpu.h"
+#include "cpu_exec.h"
+#include "disasm.h"
+#include "image.h"
+#include "log.h"
+#include "ram.h"
+
+static const char *DEFAULT_PROGRAM =
+    ".org 0x0000\n"
+    "main:\n"
+    "    LOADI R0, 0\n"
+    "    LOADI R1, 200000\n"
+    "    LOADI R2, 1\n"
+    "    LOADI R3, 3\n"
+    "    LOADA A0, 0x2000\n"
+    "loop:\n"
+    "    ADD    R0, R3\n"
+    "    XOR    R4, R0\n"
+    "    LOADM  R5, (A0)\n"
+    "    ADD    R5, R2\n"
+    "    STOREM (A0), R5\n"
+    "    AND    R4, 0xFF\n"
+    "    SUB    R1, R2\n"
+    "    JNZ    loop\n"
+    "    HALT\n";
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Count the instructions in an assembled range.
+ */
+static uint32_t count_instructions(const RAM *ram, AssemblyRange range) {
+    uint32_t count = 0;
+    uint32_t pc = range.start_address;
+    while (pc < range.end_address) {
+        DecodedInstruction insn;
+        if (!decode_instruction(ram->cells, RAM_SIZE, pc, range.encoding, &insn))
+            break;
+        pc += insn.length;
+        count++;
+    }
+    return count;
+}
+
+typedef struct {
+    uint32_t code_words;
+    uint32_t instructions;
+    uint64_t retired;
+    uint64_t median_ns;
+} EncodingResult;
+
+/**
+ * @brief Assemble, round-trip through an image file, and time one encoding.
+ */
+static bool bench_encoding(const char *source, InstructionEncoding encoding, int trials, bool dump,
+                           EncodingResult *result) {
+    static RAM ram;
+    static RAM loaded;
+    ram_init(&ram);
+    ram_init(&loaded);
+
+    AssemblyRange range = assemble_into(ram.cells, RAM_SIZE, source, encoding);
+    if (range.error) {
+        fprintf(stderr, "Assembly failed for %s encoding\n", encoding_name(encoding));
+        return false;
+    }
+
+    char image_path[] = "/tmp/encoding_bench_XXXXXX";
+    int fd = mkstemp(image_path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return false;
+    }
+    close(fd);
+    bool saved = image_write(image_path, ram.cells, range);
+    AssemblyRange image_range = saved ? image_load(&loaded, image_path) : range;
+    unlink(image_path);
+    if (!saved || image_range.error || image_range.encoding != encoding) {
+        fprintf(stderr, "Image round-trip failed for %s encoding\n", encoding_name(encoding));
+        return false;
+    }
+
+    if (dump) {
+        printf("--- %s image ---\n", encoding_name(encoding));
+        disassemble(loaded.cells, RAM_SIZE, image_range, stdout);
+    }
+
+    uint64_t *samples = calloc((size_t)trials, sizeof(uint64_t));
+    if (!samples)
+        return false;
+
+    /* The loop body stores into data memory, so every trial starts from a
+       pristine copy of the loaded image. */
+    static RAM work;
+    CPU cpu;
+    for (int t = 0; t < trials; t++) {
+        memcpy(work.cells, loaded.cells, sizeof(work.cells));
+        cpu_init(&cpu);
+        uint64_t t0 = now_ns();
+        bool ok = cpu_run(&cpu, &work, image_range);
+        samples[t] = now_ns() - t0;
+        if (!ok) {
+            fprintf(stderr, "Execution failed for %s encoding\n", encoding_name(encoding));
+            free(samples);
+            return false;
+        }
+    }
+    qsort(samples, (size_t)trials, sizeof(uint64_t), compare_u64);
+
+    result->code_words = image_range.end_address - image_range.start_address;
+    result->instructions = count_instructions(&loaded, image_range);
+    result->retired = cpu.instructions_retired;
+    result->median_ns = samples[trials / 2];
+    free(samples);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int trials = 20;
+    bool dump = false;
+    const char *source = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            trials = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-d") == 0) {
+            dump = true;
+        } else {
+            source = argv[i];
+        }
+    }
+    if (trials < 1)
+        trials = 1;
+
+    log_set_enabled(LOG_DEBUG, false);
+    log_set_enabled(LOG_INFO, false);
+
+    char source_path[] = "/tmp/encoding_bench_src_XXXXXX";
+    if (!source) {
+        int fd = mkstemp(source_path);
+        if (fd < 0) {
+            perror("mkstemp");
+            return 1;
+        }
+        FILE *f = fdopen(fd, "w");
+        fputs(DEFAULT_PROGRAM, f);
+        fclose(f);
+        source = source_path;
+    }
+
+    EncodingResult wide, packed;
+    bool ok = bench_encoding(source, ENCODING_WIDE, trials, dump, &wide)
+           && bench_encoding(source, ENCODING_PACKED, trials, dump, &packed);
+    if (source == source_path)
+        unlink(source_path);
+    if (!ok)
+        return 1;
+
+    printf("%-8s %10s %10s %12s %14s %12s %10s\n",
+           "encoding", "code_words", "code_bytes", "words/insn", "retired", "median_ms", "ns/insn");
+    const EncodingResult *rows[2] = { &wide, &packed };
+    const char *names[2] = { "wide", "packed" };
+    for (int i = 0; i < 2; i++) {
+        const EncodingResult *r = rows[i];
+        printf("%-8s %10u %10u %12.2f %14llu %12.3f %10.2f\n",
+               names[i], r->code_words, r->code_words * 4u,
+               r->instructions ? (double)r->code_words / r->instructions : 0.0,
+               (unsigned long long)r->retired,
+               (double)r->median_ns / 1e6,
+               r->retired ? (double)r->median_ns / (double)r->retired : 0.0);
+    }
+    printf("packed/wide: code size %.1f%%, time %.1f%%\n",
+           100.0 * packed.code_words / (wide.code_words ? wide.code_words : 1),
+           100.0 * (double)packed.median_ns / (double)(wide.median_ns ? wide.median_ns : 1));
+    return 0;
+}
@@ -0,0 +1,137 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_AOT_H
+#define INC_8BIT_CPU_EMULATOR_AOT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "assembler.h"
+#include "cpu.h"
+#include "ram.h"
+
+/**
+ * @file aot.h
+ * @brief Ahead-of-time translation of assembled programs to native code via C.
+ *
+ * aot_translate() turns an assembled range into one self-contained C
+ * function: every jump target becomes a C label, registers and flags live
+ * in locals, and each instruction is emitted with the exact semantics of
+ * cpu_run() (32-bit wraparound, zero flag on LOADI/LOADM/ALU/CMP, negative
+ * flag on CMP only, same fault conditions). The generated file includes
+ * only <stdint.h> so it compiles without the emulator headers.
+ *
+ * aot_compile() builds it with the system C compiler (`cc`, or $CC) into a
+ * shared object, aot_load() dlopen()s it and aot_run() executes it against
+ * a CPU/RAM pair, leaving the CPU in the same state cpu_run() would.
+ *
+ * Limitations: the translation is a snapshot of the code, so programs that
+ * overwrite their own instructions are not supported; jumps must land on
+ * instruction boundaries inside the range (see cfg_build()).
+ */
+
+/**
+ * @enum AotStatus
+ * @brief Result codes returned by a translated program function.
+ */
+typedef enum {
+    AOT_STATUS_END            = 0, /**< PC reached end_address (CPU still running, like cpu_run) */
+    AOT_STATUS_HALT           = 1, /**< HALT executed */
+    AOT_STATUS_BAD_REGISTER   = 2, /**< Register index out of range */
+    AOT_STATUS_BAD_AREGISTER  = 3, /**< Address-register index out of range */
+    AOT_STATUS_BAD_LITERAL    = 4, /**< Literal address outside RAM */
+    AOT_STATUS_BAD_ACCESS     = 5, /**< Register-indirect memory access outside RAM */
+    AOT_STATUS_DIV_ZERO       = 6, /**< Division by zero */
+    AOT_STATUS_BAD_MODE       = 7  /**< Invalid addressing/operand mode */
+} AotStatus;
+
+/**
+ * @brief Signature of a translated program.
+ *
+ * @param regs General-purpose registers (MAX_REGISTERS words, in/out).
+ * @param aregs Address registers (MAX_ADDRESS_REGISTERS words, in/out).
+ * @param mem RAM cells (RAM_SIZE words).
+ * @param flags flags[0] = zero flag, flags[1] = negative flag (in/out).
+ * @param retired Incremented by the number of instructions completed.
+ * @param pc Receives the final program counter.
+ * @return An AotStatus value.
+ */
+typedef uint32_t (*AotProgramFn)(uint32_t *regs, uint32_t *aregs, uint32_t *mem, uint8_t *flags,
+                                 uint64_t *retired, uint32_t *pc);
+
+/**
+ * @struct AotModule
+ * @brief A loaded translated program.
+ */
+typedef struct {
+    void *handle;            /**< dlopen() handle */
+    AotProgramFn entry;      /**< Translated program function */
+    AssemblyRange range;     /**< Range the program was translated from */
+} AotModule;
+
+/** Default name of the generated function. */
+#define AOT_DEFAULT_SYMBOL "aot_program"
+
+/**
+ * @brief Translate an assembled range into a C translation unit.
+ *
+ * @param words Memory indexed by absolute address (e.g. ram->cells).
+ * @param limit Number of addressable words in `words`.
+ * @param range Range to translate; `range.encoding` selects the decoder.
+ * @param symbol Name of the generated function (NULL for AOT_DEFAULT_SYMBOL).
+ * @param out Destination stream for the C source.
+ * @return false (with an error logged) if the range cannot be analysed
+ *         (see cfg_build()) or writing fails.
+ */
+bool aot_translate(const uint32_t *words, uint32_t limit, AssemblyRange range, const char *symbol, FILE *out);
+
+/**
+ * @brief Compile a generated C file into a shared object with the system compiler.
+ *
+ * Runs `$CC` (default `cc`) with `-O2 -shared -fPIC`.
+ *
+ * @return true if the compiler exited successfully.
+ */
+bool aot_compile(const char *c_path, const char *so_path);
+
+/**
+ * @brief dlopen() a compiled program and resolve its entry point.
+ *
+ * @param module Output module; release with aot_unload().
+ * @param so_path Shared object built by aot_compile().
+ * @param symbol Function name used at translation (NULL for the default).
+ * @param range Range the program was translated from.
+ * @return false (with an error logged) if loading or symbol lookup fails.
+ */
+bool aot_load(AotModule *module, const char *so_path, const char *symbol, AssemblyRange range);
+
+/**
+ * @brief Translate, compile and load a range in one step using a temporary directory.
+ *
+ * Intermediate files are removed once the shared object is loaded.
+ *
+ * @param compile_ns Optional output: wall time spent translating and compiling.
+ */
+bool aot_build(AotModule *module, const uint32_t *words, uint32_t limit, AssemblyRange range,
+               uint64_t *compile_ns);
+
+/**
+ * @brief Run a loaded program against a CPU/RAM pair.
+ *
+ * Mirrors cpu_run(): the PC starts at range.start_address, the CPU stops
+ * at HALT (running = false), at end_address (running stays true) or on a
+ * fault (running = false, error logged, returns false); `stop_reason` is
+ * set the way the interpreter sets it.
+ * `instructions_retired` is advanced by the number of completed instructions.
+ */
+bool aot_run(const AotModule *module, CPU *cpu, RAM *ram);
+
+/**
+ * @brief Unload a module loaded by aot_load()/aot_build().
+ */
+void aot_unload(AotModule *module);
+
+#endif //INC_8BIT_CPU_EMULATOR_AOT_H
@@ -0,0 +1,110 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_ASMGEN_H
+#define INC_8BIT_CPU_EMULATOR_ASMGEN_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file asmgen.h
+ * @brief Seeded generator of synthetic assembly programs for scale testing.
+ *
+ * The generated program is a single outer loop around a straight-line
+ * body:
+ *
+ *     main:   LOADI R7, <iterations>; LOADA A0..A3 into the data region
+ *     outer:  <body: mix of ALU/MLP/DIV/LOADI/LOADM/STOREM/CMP/JZ/JNZ/JMP,
+ *              with labels L0..Ln-1 evenly spaced>
+ *     tail:   SUB R7, 1; JNZ outer; HALT
+ *
+ * Body branches only jump forward (to one of the next few labels or to
+ * `tail`), DIV only uses nonzero immediate divisors and R7 is never
+ * touched by the body, so every generated program terminates without
+ * faulting after exactly `iterations` passes. Memory operands stay inside
+ * [data_base, data_base + memory_words), either as literal addresses or
+ * through A0..A3. The same configuration and seed always produce the same
+ * text, so the programs can be used as reproducible benchmark inputs for
+ * both the assembler (large static size, many labels) and the executor
+ * (dynamic instruction count = body size x iterations).
+ */
+
+/**
+ * @struct AsmGenMix
+ * @brief Relative weights of the non-branch instruction classes in the body.
+ *
+ * Weights are relative to each other; a zero weight disables a class.
+ */
+typedef struct {
+    uint32_t alu;    /**< ADD/SUB/AND/OR/XOR, register or immediate operand */
+    uint32_t mul;    /**< MLP, register or immediate operand */
+    uint32_t div;    /**< DIV by a nonzero immediate */
+    uint32_t load;   /**< LOADM (literal or (An)), occasionally re-pointing An with LOADA */
+    uint32_t store;  /**< STOREM (literal or (An)) */
+    uint32_t cmp;    /**< CMP between two registers */
+    uint32_t loadi;  /**< LOADI with a random immediate */
+} AsmGenMix;
+
+/**
+ * @struct AsmGenConfig
+ * @brief Shape of a generated program.
+ */
+typedef struct {
+    uint64_t seed;           /**< RNG seed; equal seeds give identical output */
+    uint32_t instructions;   /**< Body size in instructions (branches included) */
+    uint32_t labels;         /**< Labels spread evenly over the body */
+    double branch_density;   /**< Fraction of body instructions that are branches (0..1) */
+    uint32_t memory_words;   /**< Size of the data region touched by LOADM/STOREM */
+    uint32_t data_base;      /**< First data word; 0 places the region at the top of RAM */
+    uint32_t iterations;     /**< Trip count of the outer loop */
+    uint32_t origin;         /**< Address of the first instruction (.org) */
+    AsmGenMix mix;           /**< Instruction mix of the body */
+} AsmGenConfig;
+
+/**
+ * @struct AsmGenStats
+ * @brief Summary of a generated program.
+ */
+typedef struct {
+    uint64_t instructions;   /**< Static instructions written (prologue and tail included) */
+    uint64_t wide_words;     /**< Size of the program in words with the wide encoding */
+    uint32_t labels;         /**< Labels written (main/outer/tail included) */
+    uint32_t branches;       /**< Branch instructions in the body */
+    uint32_t loads;          /**< LOADM instructions in the body */
+    uint32_t stores;         /**< STOREM instructions in the body */
+    uint64_t dynamic_upper;  /**< Upper bound on retired instructions when run */
+} AsmGenStats;
+
+/**
+ * @brief Fill a configuration with the defaults used by the `asmgen` tool.
+ *
+ * 4096-instruction body, 256 labels, 10% branches, 4096-word data region
+ * at the top of RAM, 256 outer iterations (about one million retired
+ * instructions), seed 1.
+ */
+void asmgen_default_config(AsmGenConfig *config);
+
+/**
+ * @brief Write a program described by `config` to `out`.
+ *
+ * @param config Program shape; validated before anything is written.
+ * @param out Destination stream.
+ * @param stats Optional output summary.
+ * @return false (with an error logged) on an invalid configuration or a
+ *         write error.
+ */
+bool asmgen_write(const AsmGenConfig *config, FILE *out, AsmGenStats *stats);
+
+/**
+ * @brief Parse a mix specification such as "alu=40,mul=5,div=0".
+ *
+ * Classes not named keep their current weight in `mix`.
+ *
+ * @return false (with an error logged) on an unknown class or bad number.
+ */
+bool asmgen_parse_mix(const char *spec, AsmGenMix *mix);
+
+#endif //INC_8BIT_CPU_EMULATOR_ASMGEN_H
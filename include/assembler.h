@@ -5,22 +5,28 @@
 #ifndef INC_8BIT_CPU_EMULATOR_ASSEMBLER_H
 #define INC_8BIT_CPU_EMULATOR_ASSEMBLER_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "cpu.h"
 #include "ram.h"
+#include "encoding.h"
+#include "parser.h"
 
 /**
  * @brief Range of addresses produced by an assembly operation.
  *
  * start_address and end_address are inclusive bounds of the memory region
  * where assembled code/data was written. The `error` flag is set to true
- * if assembly failed and the range should be considered invalid.
+ * if assembly failed and the range should be considered invalid. The
+ * `encoding` records the instruction layout so cpu_run() and the tools
+ * decode the range the same way it was produced.
  */
 typedef struct {
     uint32_t start_address; /**< Inclusive start address of assembled output */
     uint32_t end_address;   /**< Inclusive end address of assembled output */
     bool error;             /**< True if assembly failed */
+    InstructionEncoding encoding; /**< Instruction layout of the range (wide by default) */
 } AssemblyRange;
 
 /**
@@ -67,4 +73,59 @@ typedef enum {
  */
 AssemblyRange assemble(RAM *ram, CPU *cpu, const char *file_path);
 
+/**
+ * @brief Assemble an input file into a caller-provided word buffer.
+ *
+ * Same translation as assemble() but without touching any RAM or CPU
+ * instance: words are written to `buffer` at their absolute addresses
+ * (so `buffer` must cover every address the program emits to, typically
+ * RAM_SIZE words). The function uses no global or shared mutable state and
+ * may be called concurrently from multiple threads with distinct buffers.
+ *
+ * @param buffer Output buffer indexed by absolute word address.
+ * @param capacity Number of words available in `buffer`; emitting past it
+ *                 fails the assembly.
+ * @param file_path Path to the assembly source file to process (NUL-terminated).
+ * @param encoding Instruction layout to emit (ENCODING_WIDE or ENCODING_PACKED).
+ * @return AssemblyRange describing the range of addresses written on success;
+ *         if assembly fails the returned AssemblyRange has `error == true`.
+ */
+AssemblyRange assemble_into(uint32_t *buffer, uint32_t capacity, const char *file_path,
+                            InstructionEncoding encoding);
+
+/**
+ * @brief Assemble a source file and keep its labels.
+ *
+ * Same as assemble_into(); on success `labels` receives every label the
+ * source defines (name and word address), for tools that report by symbol.
+ * Release it with label_table_free(); after a failure it is empty.
+ *
+ * @param buffer Output buffer indexed by absolute word address.
+ * @param capacity Number of words available in `buffer`.
+ * @param file_path Path to the assembly source file to process (NUL-terminated).
+ * @param encoding Instruction layout to emit (ENCODING_WIDE or ENCODING_PACKED).
+ * @param labels Receives the label table (must not be NULL).
+ * @return AssemblyRange describing the range of addresses written on success;
+ *         if assembly fails the returned AssemblyRange has `error == true`.
+ */
+AssemblyRange assemble_into_labels(uint32_t *buffer, uint32_t capacity, const char *file_path,
+                                   InstructionEncoding encoding, LabelTable *labels);
+
+/**
+ * @brief Assemble source text held in memory into a caller-provided buffer.
+ *
+ * Same contract as assemble_into() (absolute addressing, no shared state),
+ * for hosts that keep programs in memory rather than on disk.
+ *
+ * @param buffer Output buffer indexed by absolute word address.
+ * @param capacity Number of words available in `buffer`.
+ * @param source Assembly source text; need not be NUL-terminated.
+ * @param length Number of bytes in `source` (must be nonzero).
+ * @param encoding Instruction layout to emit (ENCODING_WIDE or ENCODING_PACKED).
+ * @return AssemblyRange describing the range of addresses written on success;
+ *         if assembly fails the returned AssemblyRange has `error == true`.
+ */
+AssemblyRange assemble_source(uint32_t *buffer, uint32_t capacity, const char *source, size_t length,
+                              InstructionEncoding encoding);
+
 #endif //INC_8BIT_CPU_EMULATOR_ASSEMBLER_H
@@ -0,0 +1,94 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_BATCH_ASSEMBLER_H
+#define INC_8BIT_CPU_EMULATOR_BATCH_ASSEMBLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "assembler.h"
+
+/**
+ * @file batch_assembler.h
+ * @brief Assemble many source files concurrently, each into its own image.
+ *
+ * The batch driver spreads a list of files over a fixed pool of worker
+ * threads. Every worker owns a private RAM-sized scratch buffer and calls
+ * assemble_into(), so no RAM/CPU instance is shared between files. The
+ * emitted range of each file is copied out into a compact, heap-allocated
+ * AssemblyImage.
+ */
+
+/**
+ * @struct AssemblyImage
+ * @brief Result of assembling one file in batch mode.
+ *
+ * `words` holds the emitted words for the address range
+ * [range.start_address, range.end_address); `words[0]` corresponds to
+ * `range.start_address`. On failure `range.error` is true and `words` is NULL.
+ */
+typedef struct {
+    const char *file_path; /**< Source path (borrowed from the caller's list) */
+    uint32_t *words;       /**< Emitted words, owned by the image (NULL on error) */
+    uint32_t word_count;   /**< Number of entries in `words` */
+    AssemblyRange range;   /**< Address range the words belong to */
+    uint64_t elapsed_ns;   /**< Wall-clock time spent assembling this file */
+} AssemblyImage;
+
+/**
+ * @struct BatchStats
+ * @brief Aggregate timing and throughput figures for one batch run.
+ */
+typedef struct {
+    size_t files_total;     /**< Number of files submitted */
+    size_t files_failed;    /**< Number of files whose assembly failed */
+    size_t thread_count;    /**< Worker threads actually used */
+    uint64_t words_emitted; /**< Sum of word_count over successful images */
+    uint64_t wall_ns;       /**< Wall-clock time of the whole batch */
+    uint64_t busy_ns;       /**< Sum of per-file assembly times */
+    uint64_t min_file_ns;   /**< Fastest successful file */
+    uint64_t max_file_ns;   /**< Slowest file */
+} BatchStats;
+
+/**
+ * @brief Assemble `count` files concurrently using a pool of worker threads.
+ *
+ * Files are handed out to workers dynamically (one at a time) so a few
+ * large files do not stall the rest of the batch. `images` must point to an
+ * array of at least `count` entries; entry i always describes
+ * `file_paths[i]`, regardless of completion order.
+ *
+ * @param file_paths Array of source paths to assemble.
+ * @param count Number of entries in `file_paths` and `images`.
+ * @param thread_count Requested worker count; 0 selects the number of online CPUs.
+ * @param encoding Instruction layout to emit for every file.
+ * @param images Output array receiving one AssemblyImage per input file.
+ * @param stats Optional output for aggregate timing/throughput (may be NULL).
+ * @return true if every file assembled successfully, false if at least one
+ *         failed or the pool could not be started.
+ */
+bool batch_assemble(const char *const *file_paths, size_t count, size_t thread_count,
+                    InstructionEncoding encoding, AssemblyImage *images, BatchStats *stats);
+
+/**
+ * @brief Release the word buffers owned by an array of images.
+ *
+ * @param images Array previously filled by batch_assemble().
+ * @param count Number of entries in `images`.
+ */
+void batch_images_free(AssemblyImage *images, size_t count);
+
+/**
+ * @brief Print a per-file timing table (optional) and the aggregate stats.
+ *
+ * @param images Array filled by batch_assemble().
+ * @param count Number of entries in `images`.
+ * @param stats Aggregate statistics returned by batch_assemble().
+ * @param per_file When true print one line per file before the summary.
+ */
+void batch_print_stats(const AssemblyImage *images, size_t count, const BatchStats *stats, bool per_file);
+
+#endif //INC_8BIT_CPU_EMULATOR_BATCH_ASSEMBLER_H
@@ -0,0 +1,123 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_BRANCH_SIM_H
+#define INC_8BIT_CPU_EMULATOR_BRANCH_SIM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "assembler.h"
+
+/**
+ * @file branch_sim.h
+ * @brief Branch predictor models for guest conditional branches (JZ/JNZ).
+ *
+ * Several predictors can watch the same run; each one predicts every
+ * conditional branch before its outcome is known and is then trained with
+ * it. JMP is unconditional and not modelled. Available predictors:
+ *
+ *   static   backward taken, forward not taken
+ *   bimodal  4096 two-bit counters indexed by PC
+ *   gshare   4096 two-bit counters indexed by PC xor 12 bits of global history
+ *   tage     bimodal base plus four tagged tables with 5, 11, 22 and 44
+ *            branches of global history (a small TAGE-like predictor)
+ *
+ * Only cpu_execute_predicted() (cpu_exec.h) feeds the models; the other
+ * engines carry no predictor code. Statistics are kept per branch PC, and
+ * the estimated penalty is mispredictions x `penalty_cycles`.
+ */
+
+/**
+ * @enum BranchPredictorKind
+ * @brief Predictor models.
+ */
+typedef enum {
+    BPRED_STATIC = 0,
+    BPRED_BIMODAL,
+    BPRED_GSHARE,
+    BPRED_TAGE,
+    BPRED_KIND_COUNT
+} BranchPredictorKind;
+
+/** Default cost of one misprediction in cycles. */
+#define BPRED_DEFAULT_PENALTY 10u
+
+/**
+ * @struct BranchPcStats
+ * @brief Outcomes of one branch instruction.
+ */
+typedef struct {
+    uint64_t executed;
+    uint64_t taken;
+} BranchPcStats;
+
+/** Opaque state of the TAGE-like predictor. */
+typedef struct TagePredictor TagePredictor;
+
+/**
+ * @struct BranchSim
+ * @brief Predictors selected for one run plus their statistics.
+ */
+typedef struct {
+    BranchPredictorKind kinds[BPRED_KIND_COUNT];  /**< Selected predictors, in report order */
+    uint32_t count;
+    uint32_t penalty_cycles;                      /**< Cycles lost per misprediction */
+    uint64_t history;                             /**< Global history, newest outcome in bit 0 */
+    uint8_t *bimodal;                             /**< Two-bit counters of the bimodal predictor */
+    uint8_t *gshare;                              /**< Two-bit counters of gshare */
+    TagePredictor *tage;
+
+    AssemblyRange range;                          /**< Program range the per-PC tables cover */
+    BranchPcStats *per_pc;                        /**< Indexed by PC - range.start_address */
+    uint64_t *pc_mispredicts[BPRED_KIND_COUNT];   /**< Per predictor, indexed like per_pc */
+    BranchPcStats totals;                         /**< Every conditional branch, outside the range too */
+    uint64_t mispredicts[BPRED_KIND_COUNT];       /**< Totals per predictor, outside the range too */
+} BranchSim;
+
+/**
+ * @brief Short name of a predictor ("gshare").
+ */
+const char *branch_predictor_name(BranchPredictorKind kind);
+
+/**
+ * @brief Parse a comma-separated list of predictor names ("all" selects every one).
+ *
+ * @param kinds Receives up to BPRED_KIND_COUNT predictors without duplicates.
+ * @param count Receives the number of predictors.
+ * @return false (with an error logged) on an unknown name.
+ */
+bool branch_predictor_parse_list(const char *list, BranchPredictorKind *kinds, uint32_t *count);
+
+/**
+ * @brief Allocate the selected predictors (all counters weakly not-taken) and zeroed statistics.
+ *
+ * @return false (with an error logged) if memory runs out.
+ */
+bool branch_sim_init(BranchSim *sim, const BranchPredictorKind *kinds, uint32_t count, uint32_t penalty_cycles,
+                     AssemblyRange range);
+
+/**
+ * @brief Release everything owned by the simulator.
+ */
+void branch_sim_free(BranchSim *sim);
+
+/**
+ * @brief Let every predictor predict the branch at `pc`, then train it with the outcome.
+ *
+ * @param pc Address of the JZ/JNZ.
+ * @param target Branch target (used by the static predictor).
+ * @param taken Actual outcome.
+ */
+void branch_sim_record(BranchSim *sim, uint32_t pc, uint32_t target, bool taken);
+
+/**
+ * @brief Print accuracy and penalty per predictor and the `top` branches with the most mispredictions.
+ *
+ * @param words Memory holding the program, used to disassemble the listed PCs.
+ */
+void branch_sim_print(const BranchSim *sim, const uint32_t *words, uint32_t top, FILE *out);
+
+#endif //INC_8BIT_CPU_EMULATOR_BRANCH_SIM_H
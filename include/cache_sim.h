@@ -0,0 +1,198 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_CACHE_SIM_H
+#define INC_8BIT_CPU_EMULATOR_CACHE_SIM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "assembler.h"
+#include "code_regions.h"
+
+/**
+ * @file cache_sim.h
+ * @brief Set-associative data cache model for guest LOADM/STOREM traffic.
+ *
+ * The model is write-back and write-allocate: a store miss fills the line
+ * like a load miss, stores only mark the line dirty, and a dirty line is
+ * written back when it is evicted (or by cache_sim_flush() at the end of a
+ * run). Guest addresses are word addresses; sizes are given in bytes with
+ * 4-byte words. Sizes, line length and associativity must be powers of two.
+ *
+ * Only cpu_execute_cached() (cpu_exec.h) feeds the model, so the other
+ * engines carry no cache code at all. Statistics are kept per PC of the
+ * accessing instruction; cache_sim_print() aggregates them per label
+ * region at report time.
+ */
+
+/**
+ * @enum CacheReplacement
+ * @brief Victim selection within a set.
+ */
+typedef enum {
+    CACHE_REPLACE_LRU,   /**< True least-recently-used (per-line timestamps) */
+    CACHE_REPLACE_PLRU   /**< Tree pseudo-LRU (ways - 1 bits per set) */
+} CacheReplacement;
+
+/**
+ * @struct CacheConfig
+ * @brief Geometry and policy of the simulated cache.
+ */
+typedef struct {
+    uint32_t size_bytes;         /**< Total capacity */
+    uint32_t line_bytes;         /**< Line size (at least one 4-byte word) */
+    uint32_t ways;               /**< Associativity, 1..64 (1 = direct mapped) */
+    CacheReplacement replacement;
+} CacheConfig;
+
+/**
+ * @struct CacheCounters
+ * @brief Access and miss counts.
+ */
+typedef struct {
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t read_misses;
+    uint64_t write_misses;
+    uint64_t writebacks;         /**< Dirty lines written back (evictions and the final flush) */
+} CacheCounters;
+
+/**
+ * @struct CachePcStats
+ * @brief Accesses and misses of one memory instruction.
+ */
+typedef struct {
+    uint64_t accesses;
+    uint64_t misses;
+} CachePcStats;
+
+/** Marks an empty line in CacheSim::lines. */
+#define CACHE_LINE_INVALID UINT32_MAX
+
+/**
+ * @struct CacheSim
+ * @brief Cache state plus statistics for one run.
+ */
+typedef struct {
+    CacheConfig config;
+    uint32_t line_shift;         /**< log2(words per line) */
+    uint32_t set_mask;           /**< sets - 1 */
+    uint32_t *lines;             /**< Line number held by each way, sets x ways */
+    uint8_t *dirty;              /**< Dirty bit of each way */
+    uint64_t *stamps;            /**< LRU: last use of each way */
+    uint64_t *plru;              /**< PLRU: tree bits of each set */
+    uint64_t clock;
+    CacheCounters totals;
+    AssemblyRange range;         /**< Program range the per-PC table covers */
+    CachePcStats *per_pc;        /**< Indexed by PC - range.start_address */
+    CachePcStats outside;        /**< Accesses by code outside the range */
+} CacheSim;
+
+/**
+ * @brief Default geometry: 4 KiB, 32-byte lines, 4 ways, LRU.
+ */
+void cache_config_default(CacheConfig *config);
+
+/**
+ * @brief Parse "size=8k,line=64,ways=2,policy=plru" on top of the defaults.
+ *
+ * Every key is optional; sizes accept a k suffix. `default` alone keeps
+ * the defaults.
+ *
+ * @return false (with an error logged) on an unknown key or invalid geometry.
+ */
+bool cache_config_parse(const char *spec, CacheConfig *config);
+
+/**
+ * @brief Allocate an empty cache and zeroed per-PC statistics for `range`.
+ *
+ * @return false (with an error logged) on invalid geometry or no memory.
+ */
+bool cache_sim_init(CacheSim *sim, const CacheConfig *config, AssemblyRange range);
+
+/**
+ * @brief Release everything owned by the simulator.
+ */
+void cache_sim_free(CacheSim *sim);
+
+/**
+ * @brief Handle a miss: choose a victim, write it back if dirty, fill the line.
+ *
+ * Called by cache_sim_access(); not part of the fast path.
+ */
+void cache_sim_fill(CacheSim *sim, uint32_t set, uint32_t line, bool write);
+
+/**
+ * @brief Mark `way` of `set` most recently used.
+ */
+static inline void cache_sim_touch(CacheSim *sim, uint32_t set, uint32_t way) {
+    if (sim->config.replacement == CACHE_REPLACE_LRU) {
+        sim->stamps[set * sim->config.ways + way] = ++sim->clock;
+        return;
+    }
+    /* Point every node on the path to `way` away from it. */
+    uint64_t bits = sim->plru[set];
+    uint32_t node = 1;
+    for (uint32_t half = sim->config.ways >> 1; half; half >>= 1) {
+        bool right = (way & half) != 0;
+        if (right)
+            bits &= ~(1ull << node);
+        else
+            bits |= 1ull << node;
+        node = 2 * node + right;
+    }
+    sim->plru[set] = bits;
+}
+
+/**
+ * @brief Simulate one access by the instruction at `pc` to word `address`.
+ */
+static inline void cache_sim_access(CacheSim *sim, uint32_t pc, uint32_t address, bool write) {
+    uint32_t line = address >> sim->line_shift;
+    uint32_t set = line & sim->set_mask;
+    uint32_t *ways = &sim->lines[set * sim->config.ways];
+
+    uint32_t offset = pc - sim->range.start_address;
+    CachePcStats *stats = pc >= sim->range.start_address && offset < sim->range.end_address - sim->range.start_address
+        ? &sim->per_pc[offset] : &sim->outside;
+    stats->accesses++;
+    if (write)
+        sim->totals.writes++;
+    else
+        sim->totals.reads++;
+
+    for (uint32_t way = 0; way < sim->config.ways; way++) {
+        if (ways[way] == line) {
+            if (write)
+                sim->dirty[set * sim->config.ways + way] = 1;
+            cache_sim_touch(sim, set, way);
+            return;
+        }
+    }
+
+    stats->misses++;
+    if (write)
+        sim->totals.write_misses++;
+    else
+        sim->totals.read_misses++;
+    cache_sim_fill(sim, set, line, write);
+}
+
+/**
+ * @brief Write back every dirty line (counted in `writebacks`) and mark it clean.
+ */
+void cache_sim_flush(CacheSim *sim);
+
+/**
+ * @brief Print totals, the label regions and the `top` PCs with the most misses.
+ *
+ * @param regions Label regions of the range, or NULL to skip that table.
+ * @param words Memory holding the program, used to disassemble the listed PCs.
+ */
+void cache_sim_print(const CacheSim *sim, const CodeRegionMap *regions, const uint32_t *words, uint32_t top,
+                     FILE *out);
+
+#endif //INC_8BIT_CPU_EMULATOR_CACHE_SIM_H
@@ -0,0 +1,153 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_CFG_H
+#define INC_8BIT_CPU_EMULATOR_CFG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "assembler.h"
+#include "encoding.h"
+
+/**
+ * @file cfg.h
+ * @brief Basic blocks, control-flow graph, dominators and natural loops.
+ *
+ * cfg_build() decodes the code reachable from the start of an assembled
+ * range and derives its structure:
+ *  - basic blocks, split at the entry, jump targets and after every
+ *    JMP/JZ/JNZ/HALT (the only instructions that redirect control);
+ *  - successor and predecessor edges;
+ *  - the dominator tree (Lengauer-Tarjan) with O(1) dominance queries;
+ *  - the natural-loop nesting forest (back edges to a dominating header,
+ *    bodies collapsed innermost-first with union-find).
+ *
+ * Every phase is linear in the size of the image up to the inverse
+ * Ackermann / path-compression factor, and all traversals are iterative,
+ * so multi-thousand-block images need no deep recursion.
+ *
+ * Reaching `end_address` (falling off the end or jumping to it) stops the
+ * CPU like HALT does; such edges set BasicBlock::exits instead of naming
+ * a successor block.
+ *
+ * Code is found by following fall-throughs and jump targets from
+ * start_address, so words control never reaches (.org gaps, inline data)
+ * belong to no block and need not decode. Every block is therefore
+ * reachable; BasicBlock::reachable stays for callers that check it.
+ */
+
+/** Marks an absent block, loop or successor index. */
+#define CFG_NONE UINT32_MAX
+
+/**
+ * @struct BasicBlock
+ * @brief A maximal straight-line run of instructions.
+ *
+ * For conditional jumps `succ[0]` is the taken target and `succ[1]` the
+ * fall-through; for JMP and straight-line terminators only `succ[0]` is
+ * used. Unused or out-of-range successors are CFG_NONE.
+ */
+typedef struct {
+    uint32_t start_address;  /**< Address of the first instruction */
+    uint32_t end_address;    /**< One past the last word of the block */
+    uint32_t first_insn;     /**< Index of the first instruction in ControlFlowGraph::insns */
+    uint32_t insn_count;
+    uint32_t terminator;     /**< Opcode of the last instruction */
+    uint32_t succ[2];
+    uint32_t pred_first;     /**< First index into ControlFlowGraph::preds */
+    uint32_t pred_count;
+    uint32_t idom;           /**< Immediate dominator; CFG_NONE for the entry and unreachable blocks */
+    uint32_t dom_pre;        /**< Dominator-tree preorder interval used by cfg_dominates() */
+    uint32_t dom_post;
+    uint32_t loop;           /**< Innermost enclosing loop, or CFG_NONE */
+    uint32_t loop_depth;     /**< Number of loops enclosing the block (0 = none) */
+    bool reachable;          /**< Reachable from the entry block */
+    bool exits;              /**< Control can reach end_address from this block */
+} BasicBlock;
+
+/**
+ * @struct NaturalLoop
+ * @brief One loop of the nesting forest, identified by its header block.
+ */
+typedef struct {
+    uint32_t header;         /**< Block every iteration enters through */
+    uint32_t parent;         /**< Enclosing loop, or CFG_NONE for outermost loops */
+    uint32_t depth;          /**< 1 for outermost loops */
+    uint32_t block_count;    /**< Blocks in the body, including nested loops */
+    uint32_t back_edges;     /**< Number of latch -> header edges */
+} NaturalLoop;
+
+/**
+ * @struct ControlFlowGraph
+ * @brief Analysis results for one assembled range. Owns all its arrays.
+ */
+typedef struct {
+    AssemblyRange range;
+    DecodedInstruction *insns;   /**< Decoded instructions in address order */
+    uint32_t *insn_addresses;    /**< Address of each entry in `insns` */
+    uint32_t insn_count;
+    BasicBlock *blocks;          /**< Blocks in address order; block 0 is the entry */
+    uint32_t block_count;
+    uint32_t *preds;             /**< Predecessor lists, sliced by BasicBlock::pred_first/pred_count */
+    uint32_t *rpo;               /**< Reachable blocks in reverse postorder */
+    uint32_t reachable_count;    /**< Length of `rpo` */
+    NaturalLoop *loops;          /**< Inner loops precede the loops that enclose them */
+    uint32_t loop_count;
+    uint32_t *block_of;          /**< Block of each address of the range (CFG_NONE for data), indexed from start */
+} ControlFlowGraph;
+
+/**
+ * @brief Build the CFG, dominator tree and loop forest for a range.
+ *
+ * @param cfg Output; release with cfg_free() (also after a failure).
+ * @param words Memory indexed by absolute address (e.g. ram->cells).
+ * @param limit Number of addressable words in `words`.
+ * @param range Assembled range to analyse; `range.encoding` selects the decoder.
+ * @return false (with an error logged) if a reachable word does not
+ *         decode, a reachable instruction overruns the range, a jump leaves
+ *         the range or lands inside an instruction, or memory runs out.
+ */
+bool cfg_build(ControlFlowGraph *cfg, const uint32_t *words, uint32_t limit, AssemblyRange range);
+
+/**
+ * @brief Release every array owned by the CFG and reset it.
+ */
+void cfg_free(ControlFlowGraph *cfg);
+
+/**
+ * @brief Return the block containing `address`, or CFG_NONE if it is outside
+ *        the range or not part of any reachable instruction.
+ */
+uint32_t cfg_block_at(const ControlFlowGraph *cfg, uint32_t address);
+
+/**
+ * @brief Return true if block `a` dominates block `b` (every block dominates itself).
+ *
+ * Unreachable blocks dominate nothing and are dominated by nothing.
+ */
+bool cfg_dominates(const ControlFlowGraph *cfg, uint32_t a, uint32_t b);
+
+/**
+ * @brief Return true if `block` belongs to `loop` (directly or via a nested loop).
+ */
+bool cfg_loop_contains(const ControlFlowGraph *cfg, uint32_t loop, uint32_t block);
+
+/**
+ * @brief Write the CFG in Graphviz DOT format.
+ *
+ * Blocks are boxes labelled with their address range (and their
+ * instructions if `with_instructions`); loop headers are highlighted,
+ * taken/fall-through edges are labelled T/F, back edges are drawn bold and
+ * dashed edges lead to the synthetic "exit" node.
+ */
+void cfg_write_dot(const ControlFlowGraph *cfg, FILE *out, bool with_instructions);
+
+/**
+ * @brief Print block, edge and loop counts plus per-loop details.
+ */
+void cfg_print_summary(const ControlFlowGraph *cfg, FILE *out);
+
+#endif //INC_8BIT_CPU_EMULATOR_CFG_H
@@ -0,0 +1,76 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_CODE_REGIONS_H
+#define INC_8BIT_CPU_EMULATOR_CODE_REGIONS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "assembler.h"
+#include "parser.h"
+
+/**
+ * @file code_regions.h
+ * @brief Split a program range into label regions for per-symbol reports.
+ *
+ * A region runs from one label to the next label (or the end of the
+ * range), so every address of the range belongs to exactly one region.
+ * Code before the first label forms an "<entry>" region; a range without
+ * labels (binary images, optimized programs) is a single "<program>"
+ * region. When several labels share an address the first one defined
+ * names the region.
+ */
+
+/** Region index for addresses outside the range. */
+#define CODE_REGION_NONE UINT32_MAX
+
+/**
+ * @struct CodeRegion
+ * @brief One label region [start_address, end_address).
+ */
+typedef struct {
+    char name[64];
+    uint32_t start_address;
+    uint32_t end_address;
+} CodeRegion;
+
+/**
+ * @struct CodeRegionMap
+ * @brief Regions of one range in address order, plus an address index.
+ */
+typedef struct {
+    AssemblyRange range;
+    CodeRegion *regions;
+    uint32_t count;
+    uint32_t *region_of;     /**< Region of each address of the range, indexed from start */
+} CodeRegionMap;
+
+/**
+ * @brief Build the region map of `range` from a label table.
+ *
+ * @param map Output; release with code_regions_free() (also after a failure).
+ * @param range Program range to cover.
+ * @param labels Labels of the program, or NULL for a single region.
+ *        Labels outside the range are ignored.
+ * @return false (with an error logged) if memory runs out.
+ */
+bool code_regions_build(CodeRegionMap *map, AssemblyRange range, const LabelTable *labels);
+
+/**
+ * @brief Release the arrays owned by the map and reset it.
+ */
+void code_regions_free(CodeRegionMap *map);
+
+/**
+ * @brief Return the region containing `address`, or CODE_REGION_NONE.
+ */
+static inline uint32_t code_region_at(const CodeRegionMap *map, uint32_t address) {
+    uint32_t offset = address - map->range.start_address;
+    if (address < map->range.start_address || offset >= map->range.end_address - map->range.start_address)
+        return CODE_REGION_NONE;
+    return map->region_of[offset];
+}
+
+#endif //INC_8BIT_CPU_EMULATOR_CODE_REGIONS_H
@@ -0,0 +1,104 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_COVERAGE_H
+#define INC_8BIT_CPU_EMULATOR_COVERAGE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file coverage.h
+ * @brief AFL-style edge coverage bitmap for guest programs.
+ *
+ * Every executed JMP/JZ/JNZ adds one to the byte of the bitmap selected by
+ * its edge (branch PC, next PC); a conditional branch that falls through
+ * records the fall-through edge, so both outcomes are distinguishable. The
+ * index is (location(from) >> 1) ^ location(to), with location() a
+ * multiplicative hash of the word address, exactly like AFL's
+ * (prev_location >> 1) ^ cur_location. Counters wrap at 256.
+ *
+ * The bitmap has a fixed size of COVERAGE_MAP_SIZE bytes and lives either
+ * on the heap or in a System V shared memory segment created by an
+ * external tool (afl-fuzz exports its segment id as `__AFL_SHM_ID`).
+ * Only cpu_execute_covered() (cpu_exec.h) records edges.
+ */
+
+/** log2 of the bitmap size. */
+#define COVERAGE_MAP_BITS 16
+
+/** Bitmap size in bytes (AFL's MAP_SIZE). */
+#define COVERAGE_MAP_SIZE (1u << COVERAGE_MAP_BITS)
+
+/**
+ * @struct CoverageMap
+ * @brief Edge hit counters.
+ */
+typedef struct {
+    uint8_t *bits;              /**< COVERAGE_MAP_SIZE counters */
+    bool shared;                /**< `bits` is an attached shared memory segment */
+} CoverageMap;
+
+/**
+ * @brief Allocate a zeroed bitmap on the heap.
+ *
+ * @return false (with an error logged) if memory runs out.
+ */
+bool coverage_map_init(CoverageMap *map);
+
+/**
+ * @brief Use an existing System V shared memory segment as the bitmap.
+ *
+ * The segment must be at least COVERAGE_MAP_SIZE bytes; it is not cleared,
+ * so the owner decides when counts start.
+ *
+ * @return false (with an error logged) if the segment cannot be attached.
+ */
+bool coverage_map_attach_shm(CoverageMap *map, int shm_id);
+
+/**
+ * @brief Free the heap bitmap or detach the shared segment.
+ */
+void coverage_map_free(CoverageMap *map);
+
+/**
+ * @brief Zero every counter.
+ */
+void coverage_map_reset(CoverageMap *map);
+
+/**
+ * @brief Hash of one guest word address into the bitmap index space.
+ */
+static inline uint32_t coverage_location(uint32_t pc) {
+    return (pc * 0x9E3779B1u) >> (32 - COVERAGE_MAP_BITS);
+}
+
+/**
+ * @brief Bitmap index of the edge from `from` to `to`.
+ */
+static inline uint32_t coverage_edge_index(uint32_t from, uint32_t to) {
+    return (coverage_location(from) >> 1) ^ coverage_location(to);
+}
+
+/**
+ * @brief Record one execution of the edge from `from` to `to`.
+ */
+static inline void coverage_edge(CoverageMap *map, uint32_t from, uint32_t to) {
+    map->bits[coverage_edge_index(from, to)]++;
+}
+
+/**
+ * @brief Number of non-zero counters (distinct edges hit, up to collisions).
+ */
+uint32_t coverage_map_count(const CoverageMap *map);
+
+/**
+ * @brief Write the raw bitmap (COVERAGE_MAP_SIZE bytes) to `path`.
+ *
+ * @return false (with an error logged) on an I/O error.
+ */
+bool coverage_map_write(const CoverageMap *map, const char *path);
+
+#endif //INC_8BIT_CPU_EMULATOR_COVERAGE_H
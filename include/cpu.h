@@ -28,6 +28,38 @@
  */
 #define MAX_ADDRESS_REGISTERS 8
 
+/**
+ * @enum CpuStopReason
+ * @brief Why the last run of the CPU ended.
+ *
+ * Set by every execution engine (cpu_exec.h, aot.h) when it returns, so
+ * callers can tell a clean HALT from a fault without parsing the log.
+ */
+typedef enum {
+    CPU_STOP_NONE = 0,              /**< Not run yet, or still running */
+    CPU_STOP_HALT,                  /**< HALT executed */
+    CPU_STOP_END,                   /**< PC reached the end of the program range */
+    CPU_STOP_LIMIT,                 /**< Instruction limit reached; the run can be resumed */
+    CPU_STOP_INVALID_INSTRUCTION,   /**< Unknown opcode or malformed instruction at PC */
+    CPU_STOP_DIV_ZERO,              /**< Division by zero */
+    CPU_STOP_FAULT,                 /**< Invalid register/operand mode or out-of-range memory access */
+    CPU_STOP_ERROR,                 /**< The engine itself failed (e.g. JIT compilation) */
+    CPU_STOP_BREAKPOINT,            /**< Debugger breakpoint reached (debugger.h); the run can be resumed */
+    CPU_STOP_WATCHPOINT             /**< Debugger watchpoint written (debugger.h); the run can be resumed */
+} CpuStopReason;
+
+/**
+ * @brief Short lowercase name of a stop reason ("halt", "div_zero", ...).
+ */
+const char *cpu_stop_reason_name(CpuStopReason reason);
+
+/**
+ * @brief Return true if `reason` means the program faulted or could not run.
+ */
+static inline bool cpu_stop_is_error(CpuStopReason reason) {
+    return reason >= CPU_STOP_INVALID_INSTRUCTION && reason <= CPU_STOP_ERROR;
+}
+
 /**
  * @struct CPU
  * @brief CPU state container used by the emulator.
@@ -40,6 +72,11 @@
  *   MAX_ADDRESS_REGISTERS.
  * - registers: General-purpose 16-bit registers used by instructions.
  * - running: Execution flag; true while the CPU is executing instructions.
+ * - instructions_retired: Count of successfully executed instructions, used
+ *   to compare encodings and engines by work done rather than wall time.
+ * - stop_reason: Why the last run ended (see CpuStopReason).
+ * - cycles: Estimated guest cycles, advanced only by the timed engine
+ *   (cpu_execute_timed(), cycle_model.h).
  */
 typedef struct {
     uint32_t pc; /**< Program counter. Interpret according to addressing model. */
@@ -48,6 +85,9 @@ typedef struct {
     bool zero_flag;
     bool negative_flag; /**< Negative flag set when last compare result (signed) < 0. */
     bool running; /**< True if CPU is currently running/executing. */
+    uint64_t instructions_retired; /**< Instructions completed since cpu_init(). */
+    CpuStopReason stop_reason; /**< Why the last run ended. */
+    uint64_t cycles; /**< Estimated cycles since cpu_init() (timed engine only). */
 } CPU;
 
 /**
@@ -8,6 +8,15 @@
 #include "cpu.h"
 #include "ram.h"
 #include "assembler.h"
+#include "branch_sim.h"
+#include "cache_sim.h"
+#include "coverage.h"
+#include "cycle_model.h"
+#include "heatmap.h"
+#include "mmio.h"
+#include "observer.h"
+#include "smp.h"
+#include "trace.h"
 
 /**
  * @brief Execute the program loaded into RAM between start and end addresses.
@@ -24,4 +33,191 @@
  */
 bool cpu_run(CPU *cpu, RAM *ram, AssemblyRange assembly_range);
 
+/**
+ * @brief Run a program with the switch-dispatch interpreter.
+ *
+ * Same semantics as cpu_run(), plus an instruction budget. The engines
+ * below all share these semantics and the same instruction handlers, so
+ * they leave identical CPU/RAM state; they differ only in how
+ * instructions are fetched and dispatched (see engine.h for the table).
+ *
+ * @param max_instructions Stop with CPU_STOP_LIMIT once this many
+ *        instructions have retired in this call (0 = no limit). The CPU
+ *        stays `running` with the PC on the next instruction.
+ * @return Why the run ended; also stored in `cpu->stop_reason`.
+ */
+CpuStopReason cpu_execute(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions);
+
+/**
+ * @brief Execute exactly one instruction at the current PC.
+ *
+ * Continues from the current state instead of starting at
+ * assembly_range.start_address, so it is the building block for
+ * debuggers and trace replay. A CPU that is not running is left alone.
+ * Returns CPU_STOP_END once the PC reaches end_address, without
+ * executing anything there.
+ *
+ * @return CPU_STOP_NONE if execution can continue, otherwise why it
+ *         stopped; also stored in `cpu->stop_reason`.
+ */
+CpuStopReason cpu_step(CPU *cpu, RAM *ram, AssemblyRange assembly_range);
+
+/**
+ * @brief Continue a run with the predecoding engine from the current PC.
+ *
+ * Same as cpu_execute_predecoded() except that the PC is left where it
+ * is, so a run stopped with CPU_STOP_LIMIT (or a CPU restored from a
+ * checkpoint) picks up exactly where it was. `max_instructions` counts
+ * from the current instructions_retired.
+ *
+ * @return Why the run ended; also stored in `cpu->stop_reason`.
+ */
+CpuStopReason cpu_continue(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions);
+
+/**
+ * @brief Run a program with threaded (computed-goto) dispatch.
+ *
+ * Falls back to cpu_execute() on compilers without labels-as-values.
+ */
+CpuStopReason cpu_execute_threaded(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions);
+
+/**
+ * @brief Run a program from a per-run decode cache over the program range.
+ *
+ * Stores into the program range invalidate the affected cache entries,
+ * so self-modifying code behaves as with cpu_execute().
+ */
+CpuStopReason cpu_execute_predecoded(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions);
+
+/**
+ * @brief Run a program with the predecoding engine and simulate its data cache.
+ *
+ * Every LOADM/STOREM that passes its bounds checks is fed to `cache`
+ * (see cache_sim.h) before it touches RAM; the run itself behaves exactly
+ * like cpu_execute_predecoded(). Dirty lines are not flushed at the end,
+ * so a run stopped by the limit can be continued; call cache_sim_flush()
+ * before reading the final write-back count.
+ *
+ * @param cache Initialized cache model (must not be NULL).
+ * @return Why the run ended; also stored in `cpu->stop_reason`.
+ */
+CpuStopReason cpu_execute_cached(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                 CacheSim *cache);
+
+/**
+ * @brief Run a program with the predecoding engine and simulate branch prediction.
+ *
+ * Every JZ/JNZ with a valid target is fed to `branches` (see branch_sim.h)
+ * with its actual outcome; the run itself behaves exactly like
+ * cpu_execute_predecoded().
+ *
+ * @param branches Initialized predictor models (must not be NULL).
+ * @return Why the run ended; also stored in `cpu->stop_reason`.
+ */
+CpuStopReason cpu_execute_predicted(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                    BranchSim *branches);
+
+/**
+ * @brief Run a program with the predecoding engine and record edge coverage.
+ *
+ * Every JMP/JZ/JNZ that completes adds one to the counter of its edge
+ * (see coverage.h). The bitmap is not cleared first, so several runs can
+ * accumulate into one map; the run itself behaves exactly like
+ * cpu_execute_predecoded().
+ *
+ * @param coverage Initialized bitmap (must not be NULL).
+ * @return Why the run ended; also stored in `cpu->stop_reason`.
+ */
+CpuStopReason cpu_execute_covered(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                  CoverageMap *coverage);
+
+/**
+ * @brief Run a program with the predecoding engine and record an execution trace.
+ *
+ * Every completed JZ/JNZ appends its outcome and every completed STOREM
+ * its address and value to `trace` (see trace.h); the run itself behaves
+ * exactly like cpu_execute_predecoded(). Open the writer right before the
+ * call and close it right after, so the header and END record match.
+ *
+ * @param trace Writer opened with trace_writer_open() (must not be NULL).
+ * @return Why the run ended; also stored in `cpu->stop_reason`.
+ */
+CpuStopReason cpu_execute_traced(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                 TraceWriter *trace);
+
+/**
+ * @brief Run a program with the predecoding engine and publish its state for monitors.
+ *
+ * The state is published to `publisher` (see observer.h) when the run
+ * starts, after every `publisher->interval` retired JMP/JZ/JNZ and when
+ * it ends; the run itself behaves exactly like cpu_execute_predecoded().
+ *
+ * @param publisher Initialized publisher (must not be NULL).
+ * @return Why the run ended; also stored in `cpu->stop_reason`.
+ */
+CpuStopReason cpu_execute_observed(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                   StatePublisher *publisher);
+
+/**
+ * @brief Run a program with the predecoding engine and profile its memory accesses.
+ *
+ * The fetch of every instruction (the word at its PC) and every LOADM and
+ * STOREM that completes are counted in `heatmap` (see heatmap.h), which
+ * also tracks first touches and closes its working-set windows as the
+ * instruction count passes them. Call heatmap_finish() afterwards to close
+ * the last window; the run itself behaves exactly like
+ * cpu_execute_predecoded().
+ *
+ * @param heatmap Initialized heatmap (must not be NULL).
+ * @return Why the run ended; also stored in `cpu->stop_reason`.
+ */
+CpuStopReason cpu_execute_heatmapped(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                     MemoryHeatmap *heatmap);
+
+/**
+ * @brief Run a program with the predecoding engine and memory-mapped devices.
+ *
+ * Every LOADM/STOREM whose target lies in a page claimed on `mmio` (see
+ * mmio.h) calls the owning device instead of touching RAM; other accesses
+ * cost one table lookup more than in cpu_execute_predecoded(), which this
+ * run otherwise matches. A device callback that fails stops the run with
+ * CPU_STOP_FAULT.
+ *
+ * @param mmio Bus with the mapped devices (must not be NULL).
+ * @return Why the run ended; also stored in `cpu->stop_reason`.
+ */
+CpuStopReason cpu_execute_mapped(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                 const MmioBus *mmio);
+
+/**
+ * @brief Run one core of a multi-core run with the predecoding engine.
+ *
+ * Every LOADM/STOREM with an in-range target is bracketed by
+ * smp_access_begin() and smp_access_end() (see smp.h), which record or
+ * replay the order in which cores access each page; the run otherwise
+ * behaves exactly like cpu_execute_predecoded(). Called by smp_run().
+ *
+ * @param core This core's view of the run (must not be NULL).
+ * @return Why the run ended (CPU_STOP_ERROR if a replay diverged); also
+ *         stored in `cpu->stop_reason`.
+ */
+CpuStopReason cpu_execute_shared(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                 SmpCore *core);
+
+/**
+ * @brief Run a program while estimating its cycle count.
+ *
+ * Executes like cpu_execute_predecoded() and adds the cost of every
+ * retired instruction under `model` to `cpu->cycles`: static costs are
+ * summed per basic block and charged once per block entered, taken
+ * branches add the model's penalty (see cycle_model.h).
+ *
+ * @param model Cost table (must not be NULL).
+ * @param profile If non-NULL, also receives cycles per label region;
+ *        blocks are split at region boundaries so the split is exact.
+ * @return Why the run ended; also stored in `cpu->stop_reason`.
+ */
+CpuStopReason cpu_execute_timed(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                const CycleModel *model, CycleProfile *profile);
+
 #endif //INC_8BIT_CPU_EMULATOR_CPU_EXEC_H
\ No newline at end of file
@@ -0,0 +1,105 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_CYCLE_MODEL_H
+#define INC_8BIT_CPU_EMULATOR_CYCLE_MODEL_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "code_regions.h"
+#include "cpu.h"
+#include "isa.h"
+
+/**
+ * @file cycle_model.h
+ * @brief Per-opcode cycle costs used to estimate guest run time.
+ *
+ * The timed engine (cpu_execute_timed() in cpu_exec.h) charges every
+ * instruction its opcode cost, plus `memory_cycles` for LOADM/STOREM, and
+ * adds `branch_taken_cycles` whenever a JMP/JZ/JNZ redirects control. The
+ * static part is summed per basic block ahead of time, so estimating costs
+ * one add per block entered rather than one per instruction.
+ *
+ * Cost files are plain text, one `KEY VALUE` pair per line; `#` and `;`
+ * start comments. KEY is a mnemonic (case-insensitive), `memory`,
+ * `branch_taken` or `name` (a label for reports). Unlisted keys keep the
+ * defaults of cycle_model_default():
+ *
+ *   name    small-mcu
+ *   DIV     34
+ *   MLP     2
+ *   memory  1
+ */
+
+/** Largest cost accepted from a file, per opcode or penalty. */
+#define CYCLE_COST_MAX 1000000u
+
+/**
+ * @struct CycleModel
+ * @brief Cost table of one target.
+ */
+typedef struct {
+    char name[64];                  /**< Shown in reports */
+    uint32_t opcode_cycles[256];    /**< Base cost per opcode */
+    uint32_t memory_cycles;         /**< Extra cost of LOADM/STOREM */
+    uint32_t branch_taken_cycles;   /**< Extra cost of a JMP/JZ/JNZ that changes the PC */
+} CycleModel;
+
+/**
+ * @brief Fill `model` with the built-in costs ("default").
+ *
+ * One cycle per instruction, MLP 3, DIV 20, two extra cycles for memory
+ * operands and two for a taken branch.
+ */
+void cycle_model_default(CycleModel *model);
+
+/**
+ * @brief Load a cost file on top of the built-in costs.
+ *
+ * @return false (with the file and line logged) if the file cannot be
+ *         read, a key is unknown or a value is not a number up to
+ *         CYCLE_COST_MAX. `model` is then left at the defaults.
+ */
+bool cycle_model_load(CycleModel *model, const char *path);
+
+/**
+ * @brief Static cost of one instruction (opcode cost plus memory extra).
+ */
+static inline uint32_t cycle_model_cost(const CycleModel *model, uint32_t opcode) {
+    uint32_t cycles = model->opcode_cycles[opcode & 0xFFu];
+    if (opcode == ISA_LOADM || opcode == ISA_STOREM)
+        cycles += model->memory_cycles;
+    return cycles;
+}
+
+/**
+ * @struct CycleProfile
+ * @brief Cycles attributed to each label region during a timed run.
+ */
+typedef struct {
+    const CodeRegionMap *regions;   /**< Borrowed; must outlive the profile */
+    uint64_t *cycles;               /**< One counter per region */
+    uint64_t outside_cycles;        /**< Code executed outside the program range */
+} CycleProfile;
+
+/**
+ * @brief Allocate zeroed counters for the regions of `regions`.
+ *
+ * @return false (with an error logged) if memory runs out.
+ */
+bool cycle_profile_init(CycleProfile *profile, const CodeRegionMap *regions);
+
+/**
+ * @brief Release the counters.
+ */
+void cycle_profile_free(CycleProfile *profile);
+
+/**
+ * @brief Print total cycles, CPI and the regions that used cycles, busiest first.
+ */
+void cycle_profile_print(const CycleProfile *profile, const CycleModel *model, const CPU *cpu, FILE *out);
+
+#endif //INC_8BIT_CPU_EMULATOR_CYCLE_MODEL_H
@@ -0,0 +1,180 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_DEBUGGER_H
+#define INC_8BIT_CPU_EMULATOR_DEBUGGER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "assembler.h"
+#include "cpu.h"
+#include "parser.h"
+#include "ram.h"
+
+/**
+ * @file debugger.h
+ * @brief Breakpoints, watchpoints and single-stepping without slowing the engine down.
+ *
+ * A Debugger owns a CPU and a copy of the program's RAM and runs them with
+ * cpu_continue() and cpu_step(); the engine loop is the same one ordinary
+ * runs use and contains no debugger checks.
+ *
+ * Breakpoints replace the first word of an instruction with ISA_TRAP and
+ * keep the original aside. The trap does not decode, so the engine stops
+ * on it the way it stops on any invalid word, and the debugger reports
+ * CPU_STOP_BREAKPOINT. Resuming from a breakpoint puts the original back
+ * for one cpu_step() and patches the trap in again. Guest LOADM of a
+ * patched word sees the trap; debugger_read() hides it.
+ *
+ * Watchpoints write-protect (mprotect()) the host pages backing the
+ * watched words while the guest runs. A STOREM into such a page faults;
+ * the SIGSEGV handler records the address and old value, unprotects the
+ * page, lets the store complete and clears `running`, so the engine stops
+ * after the store retires. Stores to unwatched words that share a host
+ * page with a watched one stop too and are resumed silently. Only one
+ * debugger with watchpoints can run at a time in a process.
+ */
+
+/** Most breakpoints one debugger holds. */
+#define DEBUGGER_MAX_BREAKPOINTS 64
+
+/** Most watchpoints (address ranges) one debugger holds. */
+#define DEBUGGER_MAX_WATCHPOINTS 16
+
+/** Opaque debugging session. */
+typedef struct Debugger Debugger;
+
+/**
+ * @struct WatchHit
+ * @brief The store that stopped the last run with CPU_STOP_WATCHPOINT.
+ */
+typedef struct {
+    uint32_t address;            /**< Watched word that was written */
+    uint32_t old_value;
+    uint32_t new_value;
+    uint32_t pc;                 /**< Address of the STOREM */
+} WatchHit;
+
+/**
+ * @brief Start a session on a copy of `image`, with the PC at range.start_address.
+ *
+ * @param image RAM_SIZE words holding the loaded program.
+ * @return The session, or NULL (with an error logged) if memory runs out.
+ */
+Debugger *debugger_create(const uint32_t *image, AssemblyRange range);
+
+/**
+ * @brief Release a session. NULL is ignored.
+ */
+void debugger_destroy(Debugger *dbg);
+
+/**
+ * @brief CPU of the session; may be modified between runs.
+ */
+CPU *debugger_cpu(Debugger *dbg);
+
+/**
+ * @brief Program range of the session.
+ */
+AssemblyRange debugger_range(const Debugger *dbg);
+
+/**
+ * @brief Set a breakpoint on the instruction starting at `address`.
+ *
+ * @return false (with an error logged) if `address` is outside the program
+ *         range or inside an instruction, already has a breakpoint, or the
+ *         table is full.
+ */
+bool debugger_set_breakpoint(Debugger *dbg, uint32_t address);
+
+/**
+ * @brief Remove the breakpoint at `address`, restoring the original word.
+ *
+ * @return false if there is no breakpoint at `address`.
+ */
+bool debugger_clear_breakpoint(Debugger *dbg, uint32_t address);
+
+/**
+ * @brief Stop after any STOREM into words [address, address + words).
+ *
+ * @return false (with an error logged) if the range leaves RAM or the table is full.
+ */
+bool debugger_set_watchpoint(Debugger *dbg, uint32_t address, uint32_t words);
+
+/**
+ * @brief Remove the watchpoint that starts at `address`.
+ *
+ * @return false if no watchpoint starts at `address`.
+ */
+bool debugger_clear_watchpoint(Debugger *dbg, uint32_t address);
+
+/**
+ * @brief Execute one instruction, stepping over a breakpoint at the PC.
+ *
+ * @return CPU_STOP_NONE if execution can continue, CPU_STOP_WATCHPOINT if
+ *         the instruction wrote a watched word, otherwise why the program
+ *         stopped.
+ */
+CpuStopReason debugger_step(Debugger *dbg);
+
+/**
+ * @brief Run until a breakpoint, a watchpoint or the end of the program.
+ *
+ * A breakpoint at the current PC is stepped over first, so continuing
+ * from a breakpoint does not stop on it again; after CPU_STOP_LIMIT it
+ * is not, since the run stopped before reaching it.
+ *
+ * @param max_instructions Stop with CPU_STOP_LIMIT after this many instructions (0 = none).
+ * @return Why the run stopped; also stored in the CPU's stop_reason.
+ */
+CpuStopReason debugger_continue(Debugger *dbg, uint64_t max_instructions);
+
+/**
+ * @brief The store behind the last CPU_STOP_WATCHPOINT.
+ */
+const WatchHit *debugger_watch_hit(const Debugger *dbg);
+
+/**
+ * @brief Copy `count` words of guest memory, showing original words under breakpoints.
+ *
+ * @return false if the range leaves RAM.
+ */
+bool debugger_read(const Debugger *dbg, uint32_t address, uint32_t count, uint32_t *out);
+
+/**
+ * @brief Write `count` words of guest memory; breakpoints in the range stay set.
+ *
+ * @return false if the range leaves RAM.
+ */
+bool debugger_write(Debugger *dbg, uint32_t address, uint32_t count, const uint32_t *words);
+
+/**
+ * @brief Execute one command line of the text interface.
+ *
+ * Commands (addresses are numbers or, with `labels`, label names):
+ *   break|b LOC, delete|d LOC      set / remove a breakpoint
+ *   watch|w LOC [WORDS], unwatch LOC  set / remove a watchpoint
+ *   step|s [N]                     execute N instructions (default 1)
+ *   continue|c [N]                 run until something stops it (at most N instructions)
+ *   regs|r                         print PC, registers and flags
+ *   mem|x LOC [N]                  print N words of memory (default 8)
+ *   info|i                         list breakpoints and watchpoints
+ *   help|h, quit|q
+ *
+ * @param labels Label table for symbolic locations, or NULL.
+ * @param out Where replies go.
+ * @return false when the command was quit.
+ */
+bool debugger_command(Debugger *dbg, const LabelTable *labels, const char *line, FILE *out);
+
+/**
+ * @brief Read commands from `in` until quit or end of input.
+ *
+ * A prompt is printed when `in` is a terminal.
+ */
+void debugger_repl(Debugger *dbg, const LabelTable *labels, FILE *in, FILE *out);
+
+#endif //INC_8BIT_CPU_EMULATOR_DEBUGGER_H
@@ -0,0 +1,49 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_DISASM_H
+#define INC_8BIT_CPU_EMULATOR_DISASM_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "assembler.h"
+#include "encoding.h"
+
+/**
+ * @file disasm.h
+ * @brief Render decoded instructions back into assembler syntax.
+ *
+ * Output uses the same syntax the assembler accepts (jump targets are
+ * printed as hex literals), so a disassembly listing can be re-assembled.
+ */
+
+/**
+ * @brief Format one decoded instruction as assembler text.
+ *
+ * @param insn Decoded instruction.
+ * @param buf Output buffer (always NUL-terminated if `size` > 0).
+ * @param size Size of `buf` in bytes.
+ * @return Number of characters that would have been written (snprintf semantics).
+ */
+int format_instruction(const DecodedInstruction *insn, char *buf, size_t size);
+
+/**
+ * @brief Disassemble an assembled range, one instruction per line.
+ *
+ * Each line has the form "0xADDR: <raw words>  MNEMONIC operands". Words
+ * that do not decode are printed as ".word 0x........" and skipped one at
+ * a time.
+ *
+ * @param words Memory indexed by absolute address (e.g. ram->cells).
+ * @param limit Number of addressable words in `words`.
+ * @param range Range to disassemble; `range.encoding` selects the decoder.
+ * @param out Destination stream.
+ * @return true if every word in the range decoded as an instruction.
+ */
+bool disassemble(const uint32_t *words, uint32_t limit, AssemblyRange range, FILE *out);
+
+#endif //INC_8BIT_CPU_EMULATOR_DISASM_H
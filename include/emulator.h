@@ -0,0 +1,224 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_EMULATOR_H
+#define INC_8BIT_CPU_EMULATOR_EMULATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "assembler.h"
+#include "coverage.h"
+#include "cpu.h"
+#include "encoding.h"
+#include "log.h"
+#include "mmio.h"
+#include "observer.h"
+#include "ram.h"
+
+/**
+ * @file emulator.h
+ * @brief Embeddable, reentrant emulator API (libcpu_emulator).
+ *
+ * An Emulator instance owns a CPU, a RAM, the pristine image of the loaded
+ * program and its configuration. Every run starts from that image, so a
+ * host loads a program once and runs it with many inputs without paying
+ * for assembly or allocation again:
+ *
+ *   EmuConfig config;
+ *   emu_config_default(&config);
+ *   Emulator *emu = emu_create(&config);
+ *   emu_load_source(emu, text, strlen(text));
+ *   emu_run_batch(emu, inputs, count, results);
+ *   emu_destroy(emu);
+ *
+ * Instances share no mutable state: log messages go to the instance's own
+ * LogSink (installed on the calling thread for the duration of each call,
+ * see log_set_thread_sink()), so distinct instances may be used from
+ * distinct threads concurrently. A single instance is not thread-safe.
+ */
+
+/** Opaque instance handle. */
+typedef struct Emulator Emulator;
+
+/**
+ * @struct EmuConfig
+ * @brief Per-instance configuration, copied by emu_create().
+ */
+typedef struct {
+    const char *engine;            /**< Engine name from engine.h; NULL for the default */
+    uint64_t max_instructions;     /**< Instruction budget per run; 0 = unlimited */
+    InstructionEncoding encoding;  /**< Layout used when assembling source */
+    bool optimize;                 /**< Run the peephole optimizer on every loaded program */
+    LogSink log;                   /**< Message destination; `log.write == NULL` discards */
+} EmuConfig;
+
+/**
+ * @struct EmuPatch
+ * @brief Words written to RAM before a run.
+ */
+typedef struct {
+    uint32_t address;           /**< First RAM address written */
+    uint32_t count;             /**< Number of words */
+    const uint32_t *words;      /**< `count` words (borrowed) */
+} EmuPatch;
+
+/**
+ * @struct EmuInput
+ * @brief Per-run input and output windows.
+ *
+ * All pointers are borrowed for the duration of the call and may be NULL.
+ */
+typedef struct {
+    const uint32_t *registers;  /**< Initial R0..R7 (MAX_REGISTERS words); NULL = zeros */
+    const uint32_t *data;       /**< Words written to RAM before the run */
+    uint32_t data_address;      /**< First RAM address of `data` */
+    uint32_t data_count;        /**< Number of words in `data` */
+    const EmuPatch *patches;    /**< Further RAM patches, applied after `data` */
+    uint32_t patch_count;       /**< Number of entries in `patches` */
+    uint32_t *output;           /**< Receives RAM words after the run */
+    uint32_t output_address;    /**< First RAM address copied to `output` */
+    uint32_t output_count;      /**< Number of words copied to `output` */
+    uint64_t max_instructions;  /**< Budget for this run; 0 uses the instance's limit */
+} EmuInput;
+
+/**
+ * @struct EmuResult
+ * @brief Final state of one run.
+ */
+typedef struct {
+    CpuStopReason stop;                 /**< Why the run ended (CPU_STOP_ERROR if it never started) */
+    uint64_t instructions;              /**< Instructions retired by this run */
+    uint32_t pc;                        /**< Final program counter */
+    uint32_t registers[MAX_REGISTERS];  /**< Final R0..R7 */
+    bool zero_flag;                     /**< Final zero flag */
+    bool negative_flag;                 /**< Final negative flag */
+} EmuResult;
+
+/**
+ * @brief Fill `config` with defaults: switch engine, no limit, wide
+ *        encoding, no optimizer, WARN and ERROR messages to stderr.
+ */
+void emu_config_default(EmuConfig *config);
+
+/**
+ * @brief Create an instance.
+ *
+ * @param config Configuration (NULL for emu_config_default()).
+ * @return The instance, or NULL if the engine is unknown, the engine cannot
+ *         honour `max_instructions`, or memory is exhausted.
+ */
+Emulator *emu_create(const EmuConfig *config);
+
+/**
+ * @brief Release an instance and everything it owns. NULL is ignored.
+ */
+void emu_destroy(Emulator *emu);
+
+/**
+ * @brief Assemble source text held in memory and make it the loaded program.
+ *
+ * @return false (with an error sent to the instance's sink) on failure;
+ *         the previously loaded program is then unloaded.
+ */
+bool emu_load_source(Emulator *emu, const char *source, size_t length);
+
+/**
+ * @brief Load a program from disk: `.asm` files are assembled, anything
+ *        else is read as a binary image (see image.h).
+ */
+bool emu_load_file(Emulator *emu, const char *path);
+
+/**
+ * @brief Load an already assembled program.
+ *
+ * @param words Memory indexed by absolute address; words outside `range`
+ *              are ignored and start as zero.
+ * @param limit Number of addressable words in `words`.
+ * @param range Program range and encoding.
+ */
+bool emu_load_words(Emulator *emu, const uint32_t *words, uint32_t limit, AssemblyRange range);
+
+/**
+ * @brief Load an already assembled program stored compactly.
+ *
+ * @param code The program's words: code[0] belongs at range.start_address
+ *             and there are end_address - start_address of them.
+ * @param range Program range and encoding.
+ */
+bool emu_load_program(Emulator *emu, const uint32_t *code, AssemblyRange range);
+
+/**
+ * @brief Run the loaded program once from its pristine image.
+ *
+ * @param input Input/output windows (NULL for none).
+ * @param result Receives the final state (may be NULL).
+ * @return true if the run ended without an error stop reason.
+ */
+bool emu_run(Emulator *emu, const EmuInput *input, EmuResult *result);
+
+/**
+ * @brief Run the loaded program once per input.
+ *
+ * @param inputs `count` inputs (NULL runs `count` times with no input).
+ * @param results `count` results.
+ * @return Number of runs that ended without an error stop reason.
+ */
+size_t emu_run_batch(Emulator *emu, const EmuInput *inputs, size_t count, EmuResult *results);
+
+/**
+ * @brief Assemble and run each source once.
+ *
+ * Sources that fail to assemble get `stop == CPU_STOP_ERROR`. Afterwards
+ * the last source is the loaded program (nothing is loaded if it failed).
+ *
+ * @param sources `count` source texts.
+ * @param lengths Byte length of each source.
+ * @param results `count` results.
+ * @return Number of sources that assembled and ran without an error stop reason.
+ */
+size_t emu_assemble_run_batch(Emulator *emu, const char *const *sources, const size_t *lengths, size_t count,
+                              EmuResult *results);
+
+/**
+ * @brief Record edge coverage of the following runs into `map` (NULL stops it).
+ *
+ * While a map is set, runs use the covered predecoding engine
+ * (cpu_execute_covered()) whatever engine the instance was created with.
+ * The map is borrowed and never cleared by the instance.
+ */
+void emu_set_coverage(Emulator *emu, CoverageMap *map);
+
+/**
+ * @brief Publish the live state of the following runs to `publisher` (NULL stops it).
+ *
+ * While a publisher is set (and no coverage map is), runs use the observed
+ * predecoding engine (cpu_execute_observed()) whatever engine the instance
+ * was created with, so monitor threads can follow them with
+ * state_snapshot_read(). The publisher is borrowed.
+ */
+void emu_set_publisher(Emulator *emu, StatePublisher *publisher);
+
+/**
+ * @brief Give the following runs the memory-mapped devices on `bus` (NULL removes them).
+ *
+ * While a bus is set, runs use the mapped predecoding engine
+ * (cpu_execute_mapped()) whatever engine the instance was created with.
+ * Coverage and state publication are not recorded, since those engines
+ * have no devices. The bus and its device state are borrowed; flush a
+ * console (mmio_console_flush()) after the runs.
+ */
+void emu_set_mmio(Emulator *emu, const MmioBus *bus);
+
+/** CPU state after the most recent run. */
+const CPU *emu_cpu(const Emulator *emu);
+
+/** RAM contents after the most recent run. */
+const RAM *emu_ram(const Emulator *emu);
+
+/** Range of the loaded program (`error` is set when nothing is loaded). */
+AssemblyRange emu_program_range(const Emulator *emu);
+
+#endif //INC_8BIT_CPU_EMULATOR_EMULATOR_H
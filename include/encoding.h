@@ -0,0 +1,248 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_ENCODING_H
+#define INC_8BIT_CPU_EMULATOR_ENCODING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "isa.h"
+
+/**
+ * @file encoding.h
+ * @brief Binary instruction encodings and the shared decoder/encoder.
+ *
+ * Two encodings exist for the same ISA:
+ *
+ * ENCODING_WIDE (original): every field occupies its own 32-bit word.
+ *   LOADI/LOADA:  [op, reg, value]                 3 words
+ *   LOADM:        [op, reg, mode, addr|areg]       4 words
+ *   STOREM:       [op, addr|areg, mode, reg]       4 words
+ *   ALU ops:      [op, dst, mode, src|imm]         4 words
+ *   CMP:          [op, reg_a, reg_b]               3 words
+ *   JMP/JZ/JNZ:   [op, target]                     2 words
+ *   HALT:         [op]                             1 word
+ *
+ * ENCODING_PACKED: one instruction word plus an optional immediate word.
+ *   bits  0..7   opcode
+ *   bits  8..11  reg      (destination / loaded / stored / compared register)
+ *   bits 12..15  src      (source register or address-register index)
+ *   bit   16     IMM      (1: the next word holds the immediate / literal
+ *                          address / jump target; 0: `src` is used)
+ *   bits 17..31  reserved (must be zero)
+ *
+ *   For LOADM/STOREM the IMM bit doubles as the ADDR_LITERAL mode and for
+ *   ALU ops as the OPERAND_NUMERIC mode, so register forms take one word
+ *   and literal forms two. LOADI, LOADA and jumps always carry IMM.
+ *
+ * Both encodings decode into the same DecodedInstruction so the executor,
+ * disassembler and analysis passes are written once.
+ */
+
+/**
+ * @enum InstructionEncoding
+ * @brief Selects how instructions are laid out in memory.
+ */
+typedef enum {
+    ENCODING_WIDE   = 0, /**< One word per field (default, original layout) */
+    ENCODING_PACKED = 1  /**< Opcode/registers/mode in one word + optional immediate */
+} InstructionEncoding;
+
+#define PACKED_OPCODE_MASK  0x000000FFu
+#define PACKED_REG_SHIFT    8
+#define PACKED_SRC_SHIFT    12
+#define PACKED_FIELD_MASK   0xFu
+#define PACKED_IMM_FLAG     0x00010000u
+#define PACKED_RESERVED     0xFFFE0000u
+
+/**
+ * @struct DecodedInstruction
+ * @brief Encoding-independent view of one instruction.
+ *
+ * Field usage per opcode:
+ *  - LOADI:      reg = destination, operand = immediate
+ *  - LOADA:      reg = address register, operand = literal address
+ *  - LOADM:      reg = destination, mode = AddrMode, operand = address or A-index
+ *  - STOREM:     reg = source register, mode = AddrMode, operand = address or A-index
+ *  - ALU ops:    reg = destination, mode = OperandType, operand = register or immediate
+ *  - CMP:        reg = left register, operand = right register
+ *  - JMP/JZ/JNZ: operand = target address
+ *  - HALT:       no fields
+ */
+typedef struct {
+    uint32_t opcode;  /**< isa_instruction_t value */
+    uint32_t reg;     /**< Primary register field */
+    uint32_t mode;    /**< AddrMode / OperandType where applicable, 0 otherwise */
+    uint32_t operand; /**< Source register, immediate, address or jump target */
+    uint32_t length;  /**< Encoded size in words */
+} DecodedInstruction;
+
+/**
+ * @brief Return true if `opcode` is one of the two-operand ALU instructions
+ * that accept either a register or a numeric source (ADD..XOR).
+ */
+static inline bool isa_is_alu(uint32_t opcode) {
+    return opcode >= ISA_ADD && opcode <= ISA_XOR;
+}
+
+/**
+ * @brief Return true if `opcode` transfers control (JMP, JZ, JNZ).
+ */
+static inline bool isa_is_jump(uint32_t opcode) {
+    return opcode == ISA_JMP || opcode == ISA_JZ || opcode == ISA_JNZ;
+}
+
+/**
+ * @brief Per-opcode decode rules, indexed by the low 8 bits of the opcode.
+ *
+ * `wide_length` is the instruction size in the wide encoding (0 = invalid
+ * opcode). `packed_imm` tells which IMM flag values are legal in the packed
+ * encoding: bit 0 set = IMM clear allowed, bit 1 set = IMM set allowed.
+ * Looking these up avoids a switch per fetched instruction.
+ */
+typedef struct {
+    uint8_t wide_length;
+    uint8_t packed_imm;
+} OpcodeDecodeRule;
+
+#define PACKED_IMM_NEVER  0x1u
+#define PACKED_IMM_ALWAYS 0x2u
+#define PACKED_IMM_EITHER 0x3u
+
+static const OpcodeDecodeRule opcode_decode_rules[256] = {
+    [ISA_LOADI]  = { 3, PACKED_IMM_ALWAYS },
+    [ISA_LOADA]  = { 3, PACKED_IMM_ALWAYS },
+    [ISA_LOADM]  = { 4, PACKED_IMM_EITHER },
+    [ISA_STOREM] = { 4, PACKED_IMM_EITHER },
+    [ISA_ADD]    = { 4, PACKED_IMM_EITHER },
+    [ISA_SUB]    = { 4, PACKED_IMM_EITHER },
+    [ISA_MLP]    = { 4, PACKED_IMM_EITHER },
+    [ISA_DIV]    = { 4, PACKED_IMM_EITHER },
+    [ISA_AND]    = { 4, PACKED_IMM_EITHER },
+    [ISA_OR]     = { 4, PACKED_IMM_EITHER },
+    [ISA_XOR]    = { 4, PACKED_IMM_EITHER },
+    [ISA_JMP]    = { 2, PACKED_IMM_ALWAYS },
+    [ISA_JZ]     = { 2, PACKED_IMM_ALWAYS },
+    [ISA_JNZ]    = { 2, PACKED_IMM_ALWAYS },
+    [ISA_CMP]    = { 3, PACKED_IMM_NEVER },
+    [ISA_HALT]   = { 1, PACKED_IMM_NEVER },
+};
+
+/**
+ * @brief Decode the instruction at `pc`.
+ *
+ * Defined inline because it sits on the interpreter's fetch path.
+ *
+ * @param words Memory image indexed by absolute word address.
+ * @param limit Number of addressable words in `words`.
+ * @param pc Address of the instruction to decode.
+ * @param encoding Encoding the image was assembled with.
+ * @param out Receives the decoded fields. `out->opcode` is filled even
+ *            when decoding fails so callers can report the bad opcode.
+ * @return true on success; false if the opcode is unknown, reserved bits
+ *         are set, or the instruction runs past `limit`.
+ */
+static inline bool decode_instruction(const uint32_t *words, uint32_t limit, uint32_t pc,
+                                      InstructionEncoding encoding, DecodedInstruction *out) {
+    out->reg = 0;
+    out->mode = 0;
+    out->operand = 0;
+    out->length = 1;
+
+    if (pc >= limit) {
+        out->opcode = 0;
+        return false;
+    }
+
+    uint32_t word = words[pc];
+
+    if (encoding == ENCODING_PACKED) {
+        uint32_t op = word & PACKED_OPCODE_MASK;
+        uint32_t imm = (word >> 16) & 1u;
+        out->opcode = op;
+        if ((word & PACKED_RESERVED) || !(opcode_decode_rules[op].packed_imm & (1u << imm)))
+            return false;
+        out->reg = (word >> PACKED_REG_SHIFT) & PACKED_FIELD_MASK;
+        out->length = 1 + imm;
+        if (imm) {
+            if (pc + 1 >= limit)
+                return false;
+            out->operand = words[pc + 1];
+            /* IMM doubles as ADDR_LITERAL / OPERAND_NUMERIC; it carries no
+               mode for opcodes whose operand is always an immediate. */
+            out->mode = opcode_decode_rules[op].packed_imm == PACKED_IMM_EITHER;
+        } else {
+            out->operand = (word >> PACKED_SRC_SHIFT) & PACKED_FIELD_MASK;
+        }
+        return true;
+    }
+
+    out->opcode = word;
+    uint32_t length = word <= 0xFFu ? opcode_decode_rules[word].wide_length : 0;
+    if (length == 0)
+        return false;
+    out->length = length;
+    if (pc + length > limit)
+        return false;
+
+    switch (word) {
+        case ISA_HALT:
+            break;
+        case ISA_JMP: case ISA_JZ: case ISA_JNZ:
+            out->operand = words[pc + 1];
+            break;
+        case ISA_LOADI: case ISA_LOADA: case ISA_CMP:
+            out->reg = words[pc + 1];
+            out->operand = words[pc + 2];
+            break;
+        case ISA_STOREM:
+            out->operand = words[pc + 1];
+            out->mode = words[pc + 2];
+            out->reg = words[pc + 3];
+            break;
+        default:
+            out->reg = words[pc + 1];
+            out->mode = words[pc + 2];
+            out->operand = words[pc + 3];
+            break;
+    }
+    return true;
+}
+
+/**
+ * @brief Encode an instruction into one or more words.
+ *
+ * @param insn Instruction to encode (`length` is ignored and recomputed).
+ * @param encoding Target encoding.
+ * @param out Output array with room for at least 4 words.
+ * @return Number of words written, or 0 if the instruction cannot be
+ *         represented (unknown opcode, or a register field that does not
+ *         fit the packed layout).
+ */
+uint32_t encode_instruction(const DecodedInstruction *insn, InstructionEncoding encoding, uint32_t out[4]);
+
+/**
+ * @brief Size in words of an instruction without encoding it.
+ *
+ * @param opcode isa_instruction_t value.
+ * @param has_immediate For LOADM/STOREM/ALU: true when the operand is a
+ *        literal address or numeric immediate (ignored for other opcodes).
+ * @param encoding Target encoding.
+ * @return Size in words, or 0 for unknown opcodes.
+ */
+uint32_t instruction_length(uint32_t opcode, bool has_immediate, InstructionEncoding encoding);
+
+/**
+ * @brief Return the assembler mnemonic for an opcode ("???" if unknown).
+ */
+const char *opcode_mnemonic(uint32_t opcode);
+
+/**
+ * @brief Return a short lowercase name for an encoding ("wide"/"packed").
+ */
+const char *encoding_name(InstructionEncoding encoding);
+
+#endif //INC_8BIT_CPU_EMULATOR_ENCODING_H
@@ -0,0 +1,67 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_ENGINE_H
+#define INC_8BIT_CPU_EMULATOR_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "assembler.h"
+#include "cpu.h"
+#include "ram.h"
+
+/**
+ * @file engine.h
+ * @brief Table of interchangeable execution engines.
+ *
+ * Every engine runs an assembled range against a CPU/RAM pair with the
+ * semantics of cpu_run() and reports a CpuStopReason, so drivers can pick
+ * one by name and compare several on the same workload:
+ *
+ *   switch      decode at PC + switch dispatch (cpu_execute)
+ *   threaded    computed-goto dispatch (cpu_execute_threaded)
+ *   predecoded  per-run decode cache over the program range (cpu_execute_predecoded)
+ *   jit         translate to C, compile and dlopen (aot.h); needs a system C
+ *               compiler at run time, does not support instruction limits and,
+ *               being a static translation, does not see self-modifying code
+ *   timed       predecoded execution that also estimates cycles with the
+ *               built-in cost table (cpu_execute_timed, cycle_model.h)
+ */
+
+/** Signature shared by all engines (see cpu_execute()). */
+typedef CpuStopReason (*EngineRunFn)(CPU *cpu, RAM *ram, AssemblyRange range, uint64_t max_instructions);
+
+/**
+ * @struct ExecEngine
+ * @brief One entry of the engine table.
+ */
+typedef struct {
+    const char *name;          /**< Name used on the command line */
+    const char *description;   /**< One-line description */
+    bool supports_limit;       /**< Whether `max_instructions` is honoured */
+    bool translates;           /**< Translates the whole program per call; hosts that run a
+                                    program repeatedly should build it once (see emulator.c) */
+    EngineRunFn run;           /**< Entry point */
+} ExecEngine;
+
+/**
+ * @brief Return the engine table.
+ *
+ * @param count Receives the number of entries.
+ */
+const ExecEngine *engine_list(size_t *count);
+
+/**
+ * @brief Look up an engine by name (case-insensitive).
+ *
+ * @return The engine, or NULL (with an error logged) if there is none.
+ */
+const ExecEngine *engine_find(const char *name);
+
+/** The engine used when none is requested (switch dispatch). */
+const ExecEngine *engine_default(void);
+
+#endif //INC_8BIT_CPU_EMULATOR_ENGINE_H
@@ -0,0 +1,173 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_FUZZER_H
+#define INC_8BIT_CPU_EMULATOR_FUZZER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "assembler.h"
+#include "cpu.h"
+
+/**
+ * @file fuzzer.h
+ * @brief In-process, coverage-guided fuzzer for guest programs.
+ *
+ * The program is assembled once by the caller. Each worker thread owns an
+ * Emulator instance (emulator.h) with its own edge bitmap (coverage.h), so
+ * an execution is: pick a corpus entry, mutate a copy of it, write it to
+ * the input window, run with the instruction budget and classify the
+ * bitmap. Between executions the instance restores only the RAM pages the
+ * previous run touched.
+ *
+ * Hit counts are bucketed like AFL (1, 2, 3, 4-7, 8-15, 16-31, 32-127,
+ * 128+). An input is kept when it sets a bucket bit no earlier input of
+ * the same outcome set: normal runs (halt/end) go to the corpus and are
+ * mutated further; faulting runs are kept as crashes and runs that
+ * exhaust the budget as timeouts.
+ *
+ * Only the bitmap entries the program's own branches can reach are read
+ * and cleared after each execution; they are found by decoding the
+ * program range once. A full scan of the bitmap runs every
+ * FUZZ_FULL_SCAN_PERIOD executions of a worker, and after any execution
+ * that stored into the program's pages, and adds the stray entries it
+ * finds (code outside the range, rewritten branches) to that worker's list.
+ */
+
+/** Default instruction budget per execution. */
+#define FUZZ_DEFAULT_BUDGET 100000u
+
+/** Default number of inputs kept per kind. */
+#define FUZZ_DEFAULT_CAPACITY 4096u
+
+/** Largest input window in words. */
+#define FUZZ_MAX_INPUT_WORDS 4096u
+
+/** Executions of a worker between full bitmap scans. */
+#define FUZZ_FULL_SCAN_PERIOD 1024u
+
+/** Opaque fuzzer handle. */
+typedef struct Fuzzer Fuzzer;
+
+/**
+ * @struct FuzzConfig
+ * @brief Fuzzing campaign settings.
+ */
+typedef struct {
+    uint32_t input_address;      /**< First RAM word of the mutated window */
+    uint32_t input_words;        /**< Window length, 1..FUZZ_MAX_INPUT_WORDS */
+    uint64_t max_instructions;   /**< Budget per execution (0 = FUZZ_DEFAULT_BUDGET) */
+    uint64_t max_execs;          /**< Stop after this many executions in total (0 = no limit) */
+    uint32_t max_seconds;        /**< Stop after this many seconds (0 = no limit) */
+    size_t workers;              /**< Worker threads (0 = online CPUs) */
+    uint32_t capacity;           /**< Inputs kept per kind (0 = FUZZ_DEFAULT_CAPACITY) */
+    uint64_t seed;               /**< Random seed (0 = from the clock) */
+} FuzzConfig;
+
+/**
+ * @enum FuzzEntryKind
+ * @brief What a kept input did.
+ */
+typedef enum {
+    FUZZ_CORPUS = 0,             /**< Ended normally and reached new coverage */
+    FUZZ_CRASH,                  /**< Ended with an error stop reason */
+    FUZZ_TIMEOUT,                /**< Exhausted the instruction budget */
+    FUZZ_KIND_COUNT
+} FuzzEntryKind;
+
+/**
+ * @struct FuzzStats
+ * @brief Campaign progress.
+ */
+typedef struct {
+    uint64_t execs;              /**< Executions so far (seeds included) */
+    uint64_t crashes;            /**< Executions that crashed */
+    uint64_t timeouts;           /**< Executions that exhausted the budget */
+    uint32_t kept[FUZZ_KIND_COUNT];  /**< Inputs kept per kind */
+    uint32_t edges;              /**< Bitmap entries ever hit by a normal run */
+    double seconds;              /**< Time spent in fuzzer_run() */
+} FuzzStats;
+
+/** Called about once per second from the thread running fuzzer_run(). */
+typedef void (*FuzzProgress)(void *user, const FuzzStats *stats);
+
+/**
+ * @brief Fill `config` with defaults (no input window).
+ */
+void fuzz_config_default(FuzzConfig *config);
+
+/**
+ * @brief Create a fuzzer for an assembled program.
+ *
+ * @param words Memory indexed by absolute address holding the program
+ *              (RAM_SIZE words, as filled by assemble_into()).
+ * @param range Program range and encoding.
+ * @return The fuzzer, or NULL (with an error logged) on an invalid window
+ *         or when memory runs out.
+ */
+Fuzzer *fuzzer_create(const FuzzConfig *config, const uint32_t *words, AssemblyRange range);
+
+/**
+ * @brief Release the fuzzer. NULL is ignored.
+ */
+void fuzzer_destroy(Fuzzer *fuzzer);
+
+/**
+ * @brief Run one seed input and add it to the corpus, whatever its outcome.
+ *
+ * Inputs shorter than the window are zero-padded; longer ones are cut.
+ * Call before fuzzer_run(); an all-zero input is used when no seed is given.
+ *
+ * @return false (with an error logged) if the corpus is full.
+ */
+bool fuzzer_add_seed(Fuzzer *fuzzer, const uint32_t *words, uint32_t count);
+
+/**
+ * @brief Fuzz with every worker until a limit is reached or fuzzer_stop() is called.
+ *
+ * @param progress Optional progress callback.
+ * @return false (with an error logged) if no worker could be started.
+ */
+bool fuzzer_run(Fuzzer *fuzzer, FuzzProgress progress, void *user);
+
+/**
+ * @brief Ask fuzzer_run() to return soon. Safe to call from a signal handler.
+ */
+void fuzzer_stop(Fuzzer *fuzzer);
+
+/**
+ * @brief Current statistics.
+ */
+void fuzzer_stats(const Fuzzer *fuzzer, FuzzStats *stats);
+
+/**
+ * @brief One kept input (`input_words` words).
+ *
+ * @param stop Receives the stop reason of its first execution (may be NULL).
+ * @return The input, or NULL if `index` is out of range.
+ */
+const uint32_t *fuzzer_entry(const Fuzzer *fuzzer, FuzzEntryKind kind, uint32_t index, CpuStopReason *stop);
+
+/**
+ * @brief Write every kept input to DIR/queue, DIR/crashes and DIR/timeouts.
+ *
+ * Each file holds the window as little-endian 32-bit words and is named
+ * id-NNNNNN (crashes add the stop reason). Directories are created as needed.
+ *
+ * @return false (with an error logged) on an I/O error.
+ */
+bool fuzzer_write_entries(const Fuzzer *fuzzer, const char *dir);
+
+/**
+ * @brief Read a seed file written by fuzzer_write_entries() (or any raw word file).
+ *
+ * @param words Receives up to `capacity` little-endian words.
+ * @param count Receives the number of words read.
+ * @return false (with an error logged) if the file cannot be read.
+ */
+bool fuzz_read_input(const char *path, uint32_t *words, uint32_t capacity, uint32_t *count);
+
+#endif //INC_8BIT_CPU_EMULATOR_FUZZER_H
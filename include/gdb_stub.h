@@ -0,0 +1,52 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_GDB_STUB_H
+#define INC_8BIT_CPU_EMULATOR_GDB_STUB_H
+
+#include <stdbool.h>
+
+#include "debugger.h"
+
+/**
+ * @file gdb_stub.h
+ * @brief GDB remote serial protocol stub on top of a Debugger session.
+ *
+ * Serves one debugger connection over TCP or a Unix domain socket.
+ * Supported packets: `?`, `g`/`G` and `p`/`P` (registers), `m`/`M`
+ * (hex memory), `x`/`X` (binary memory), `c`/`s` and `vCont` (resume,
+ * with Ctrl-C interrupting a continue), `Z0`/`z0` (software
+ * breakpoints), `Z2`/`z2` (write watchpoints), `qSupported`,
+ * `qXfer:features:read` (target description), `QStartNoAckMode`,
+ * the thread queries GDB issues on connect, `D` and `k`.
+ *
+ * GDB addresses bytes while the guest addresses 32-bit words: guest word
+ * W is GDB bytes 4W..4W+3, little-endian, and the `pc` register is shown
+ * as a byte address too. General registers r0-r7, address registers
+ * a0-a7 (word addresses), `flags` (bit 0 Z, bit 1 N) and the retired
+ * instruction count are described in the target XML.
+ *
+ * Memory packets move whole ranges with one debugger_read() or
+ * debugger_write() call, and replies up to GDB_STUB_PACKET_SIZE bytes,
+ * so a large `x` read costs one copy rather than a call per word.
+ */
+
+/** Largest packet the stub accepts and sends (advertised as PacketSize). */
+#define GDB_STUB_PACKET_SIZE 0x10000
+
+/** Instructions a continue runs between checks for a Ctrl-C from GDB. */
+#define GDB_STUB_SLICE (1u << 20)
+
+/**
+ * @brief Listen on `address`, accept one connection and serve it until GDB detaches or kills.
+ *
+ * @param address "HOST:PORT" or ":PORT" (TCP; the host defaults to
+ *        127.0.0.1), or a path containing '/' for a Unix domain socket
+ *        (an existing socket file is replaced and removed afterwards).
+ * @return false (with an error logged) if the socket could not be set up
+ *         or the connection failed.
+ */
+bool gdb_stub_serve(Debugger *dbg, const char *address);
+
+#endif //INC_8BIT_CPU_EMULATOR_GDB_STUB_H
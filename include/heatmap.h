@@ -0,0 +1,186 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_HEATMAP_H
+#define INC_8BIT_CPU_EMULATOR_HEATMAP_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ram.h"
+
+/**
+ * @file heatmap.h
+ * @brief Guest memory access heatmap and working-set profile.
+ *
+ * RAM is split into buckets of a configurable power-of-two number of
+ * words (one dirty-tracking page by default). The profiled engine
+ * (cpu_execute_heatmapped(), cpu_exec.h) reports every instruction fetch
+ * (the word at the PC) and every LOADM/STOREM that completes. For each
+ * bucket the heatmap keeps:
+ *
+ * - read, write and fetch counts. With `sample=N` only about one access
+ *   in N is counted, with weight N and a randomized gap so fixed-stride
+ *   loops do not alias with the period;
+ * - the first access: instruction number, PC, word address and kind.
+ *
+ * Which buckets were touched is tracked exactly, whatever the sampling, in
+ * two bitmaps set like ram_mark_dirty(): one for the whole run and one for
+ * the current window of `window` instructions. Closing a window records
+ * how many buckets it touched, which gives the working-set size over time.
+ */
+
+/** Default window of the working-set series, in instructions. */
+#define HEATMAP_DEFAULT_WINDOW 65536
+
+/**
+ * @enum HeatmapKind
+ * @brief Kind of memory access.
+ */
+typedef enum {
+    HEATMAP_READ,       /**< LOADM */
+    HEATMAP_WRITE,      /**< STOREM */
+    HEATMAP_FETCH,      /**< Instruction fetch (the word at the PC) */
+    HEATMAP_KIND_COUNT
+} HeatmapKind;
+
+/**
+ * @struct HeatmapConfig
+ * @brief Bucket size, sampling period and working-set window.
+ */
+typedef struct {
+    uint32_t bucket_words;      /**< Words per bucket, a power of two up to RAM_SIZE */
+    uint32_t sample_period;     /**< Count about one access in this many (1 = every access) */
+    uint64_t window;            /**< Instructions per working-set window */
+} HeatmapConfig;
+
+/**
+ * @struct HeatmapWindow
+ * @brief Working set of one window.
+ */
+typedef struct {
+    uint64_t end;               /**< instructions_retired when the window closed */
+    uint32_t buckets;           /**< Buckets touched in the window */
+    uint32_t cumulative;        /**< Buckets touched since the start of the run */
+} HeatmapWindow;
+
+/** Marks a bucket that was never touched in MemoryHeatmap::first_instruction. */
+#define HEATMAP_UNTOUCHED UINT64_MAX
+
+/**
+ * @struct MemoryHeatmap
+ * @brief Per-bucket counters, first touches and the working-set series of one run.
+ */
+typedef struct {
+    HeatmapConfig config;
+    uint32_t bucket_shift;          /**< log2(bucket_words) */
+    uint32_t buckets;               /**< RAM_SIZE / bucket_words */
+    uint64_t *counts[HEATMAP_KIND_COUNT]; /**< Estimated accesses per bucket and kind */
+    uint64_t *first_instruction;    /**< Instruction number of the first access (HEATMAP_UNTOUCHED if none) */
+    uint32_t *first_pc;             /**< PC of the first access */
+    uint32_t *first_address;        /**< Word address of the first access */
+    uint8_t *first_kind;            /**< HeatmapKind of the first access */
+    uint64_t *touched;              /**< One bit per bucket touched in the run */
+    uint64_t *window_touched;       /**< One bit per bucket touched in the current window */
+    uint32_t touched_count;         /**< Bits set in `touched` */
+    uint32_t countdown;             /**< Accesses until the next sample */
+    uint64_t random;                /**< xorshift state for the sampling gaps */
+    uint64_t window_end;            /**< Instruction number that closes the current window */
+    HeatmapWindow *windows;
+    size_t window_count;
+    size_t window_capacity;
+    bool windows_truncated;         /**< A window was dropped for lack of memory */
+} MemoryHeatmap;
+
+/**
+ * @brief Default configuration: 256-word buckets (RAM_PAGE_SHIFT), every
+ *        access counted, HEATMAP_DEFAULT_WINDOW instructions per window.
+ */
+void heatmap_config_default(HeatmapConfig *config);
+
+/**
+ * @brief Parse "bucket=64,sample=16,window=100000" on top of the defaults.
+ *
+ * Every key is optional; `default` alone keeps the defaults.
+ *
+ * @return false (with an error logged) on an unknown key or invalid value.
+ */
+bool heatmap_config_parse(const char *spec, HeatmapConfig *config);
+
+/**
+ * @brief Allocate an empty heatmap.
+ *
+ * @return false (with an error logged) on an invalid configuration or no memory.
+ */
+bool heatmap_init(MemoryHeatmap *map, const HeatmapConfig *config);
+
+/**
+ * @brief Release everything owned by the heatmap.
+ */
+void heatmap_free(MemoryHeatmap *map);
+
+/**
+ * @brief Record the first access to a bucket; not part of the fast path.
+ */
+void heatmap_first_touch(MemoryHeatmap *map, uint32_t address, uint32_t pc, uint64_t instruction,
+                         HeatmapKind kind);
+
+/**
+ * @brief Count a sampled access and draw the gap to the next one.
+ */
+void heatmap_sample(MemoryHeatmap *map, uint32_t bucket, HeatmapKind kind);
+
+/**
+ * @brief Close every window that ends at or before `instruction`; not part of the fast path.
+ */
+void heatmap_close_windows(MemoryHeatmap *map, uint64_t instruction);
+
+/**
+ * @brief Record one access to word `address` by instruction number `instruction` at `pc`.
+ */
+static inline void heatmap_access(MemoryHeatmap *map, uint32_t address, uint32_t pc, uint64_t instruction,
+                                  HeatmapKind kind) {
+    uint32_t bucket = address >> map->bucket_shift;
+    uint64_t bit = 1ull << (bucket & 63);
+    map->window_touched[bucket >> 6] |= bit;
+    if (!(map->touched[bucket >> 6] & bit))
+        heatmap_first_touch(map, address, pc, instruction, kind);
+    if (--map->countdown == 0)
+        heatmap_sample(map, bucket, kind);
+}
+
+/**
+ * @brief Record the fetch of the instruction numbered `instruction` at `pc`.
+ *
+ * Also closes the working-set window once `instruction` reaches its end.
+ */
+static inline void heatmap_fetch(MemoryHeatmap *map, uint32_t pc, uint64_t instruction) {
+    if (instruction >= map->window_end)
+        heatmap_close_windows(map, instruction);
+    heatmap_access(map, pc, pc, instruction, HEATMAP_FETCH);
+}
+
+/**
+ * @brief Close the partial window at the end of a run ending at `instruction`.
+ *
+ * Call once after the profiled run; the series then covers the whole run.
+ */
+void heatmap_finish(MemoryHeatmap *map, uint64_t instruction);
+
+/**
+ * @brief Print totals, the working-set summary, the `top` hottest buckets,
+ *        the first touches in order and one-line-per-64-cells read, write
+ *        and fetch maps.
+ */
+void heatmap_print(const MemoryHeatmap *map, uint32_t top, FILE *out);
+
+/**
+ * @brief Write every touched bucket and the working-set series to `path` as JSON.
+ *
+ * @return false (with an error logged) if the file could not be written.
+ */
+bool heatmap_write_json(const MemoryHeatmap *map, const char *path);
+
+#endif //INC_8BIT_CPU_EMULATOR_HEATMAP_H
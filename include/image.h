@@ -0,0 +1,68 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_IMAGE_H
+#define INC_8BIT_CPU_EMULATOR_IMAGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "assembler.h"
+#include "ram.h"
+
+/**
+ * @file image.h
+ * @brief Binary program images: save assembled ranges and load them back.
+ *
+ * File layout (all fields 32-bit little-endian):
+ *   word 0: IMAGE_MAGIC ("C32I")
+ *   word 1: IMAGE_VERSION
+ *   word 2: flags (IMAGE_FLAG_PACKED selects the packed encoding)
+ *   word 3: start address
+ *   word 4: end address (exclusive)
+ *   words 5..: end - start program words
+ *
+ * The encoding flag travels with the image, so a loaded AssemblyRange is
+ * always decoded by cpu_run() and the disassembler the way it was built.
+ */
+
+#define IMAGE_MAGIC        0x49323343u /* "C32I" */
+#define IMAGE_VERSION      1u
+#define IMAGE_FLAG_PACKED  0x00000001u
+
+/**
+ * @brief Write the words of an assembled range to an image file.
+ *
+ * @param path Destination file path.
+ * @param words Memory indexed by absolute address (e.g. ram->cells or an
+ *              assemble_into() buffer) holding the range's words.
+ * @param range Range to save; its `encoding` sets the header flag.
+ * @return true on success, false on invalid range or I/O error.
+ */
+bool image_write(const char *path, const uint32_t *words, AssemblyRange range);
+
+/**
+ * @brief Read an image file into a word buffer at its absolute addresses.
+ *
+ * @param path Image file path.
+ * @param buffer Destination indexed by absolute address.
+ * @param capacity Number of words available in `buffer`.
+ * @return Range described by the header (with `encoding` taken from the
+ *         flags); `error == true` on bad magic/version, unknown flags,
+ *         truncated file or a range that does not fit in `buffer`.
+ */
+AssemblyRange image_read(const char *path, uint32_t *buffer, uint32_t capacity);
+
+/**
+ * @brief Load an image file into RAM.
+ *
+ * Convenience wrapper over image_read() targeting `ram->cells`.
+ *
+ * @param ram Initialized RAM receiving the program words.
+ * @param path Image file path.
+ * @return Range of the loaded program; `error == true` on failure.
+ */
+AssemblyRange image_load(RAM *ram, const char *path);
+
+#endif //INC_8BIT_CPU_EMULATOR_IMAGE_H
@@ -46,8 +46,6 @@
  *    set flags like zero or carry if implemented).
  */
 
-#define MAX_LABELS 256
-
 /**
  * @enum isa_instruction_t
  * @brief Numeric opcode values used by the assembler and CPU.
@@ -72,6 +70,7 @@ typedef enum {
     ISA_JZ  = 0x0D,     /**< JZ addr         - Jump if zero_flag flag set (semantics: dependent on CPU flags). Example: JZ 0x0200 */
     ISA_JNZ = 0x0E,     /**< JNZ addr        - Jump if zero_flag flag not set. Example: JNZ 0x0204 */
     ISA_CMP = 0x0F,     /**< CMP R(i), R(j)  - Compare registers (signed): sets zero_flag if equal and negative_flag if R[i] < R[j]. Example: CMP R0, R1 */
+    ISA_TRAP = 0xFE,    /**< Reserved breakpoint trap: patched over an instruction by the debugger (debugger.h), never assembled and never decoded */
     ISA_HALT = 0xFF     /**< HALT            - Stop execution. Example: HALT */
 } isa_instruction_t;
 
@@ -0,0 +1,193 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_JOB_PROTOCOL_H
+#define INC_8BIT_CPU_EMULATOR_JOB_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu.h"
+
+/**
+ * @file job_protocol.h
+ * @brief Binary framing spoken by the job server (job_server.h) and its clients.
+ *
+ * Every message is a frame: a 32-bit little-endian payload length followed
+ * by that many payload bytes. All integers are little-endian and every
+ * field starts at a multiple of 4 bytes from the payload start.
+ *
+ * Request payload (client -> server):
+ *   u8  type            JOB_MSG_RUN_SOURCE or JOB_MSG_RUN_PROGRAM
+ *   u8  flags           JOB_FLAG_*
+ *   u16 patch_count     number of RAM patches that follow
+ *   u32 request_id      echoed in the result; chosen by the client
+ *   u64 max_instructions  0 = the server's limit (requests are capped by it)
+ *   u32 output_address  first RAM word returned in the result
+ *   u32 output_count    number of RAM words returned
+ *   u32 registers[8]    only if JOB_FLAG_REGISTERS
+ *   patches             patch_count x { u32 address, u32 count, u32 words[count] }
+ *   RUN_SOURCE:         u32 source_length, source bytes (padded to 4)
+ *   RUN_PROGRAM:        u64 program_id
+ *
+ * Result payload (server -> client):
+ *   u8  type            JOB_MSG_RESULT
+ *   u8  status          JobStatus
+ *   u8  stop            CpuStopReason (valid when status is JOB_STATUS_OK)
+ *   u8  flags           bit 0 zero flag, bit 1 negative flag
+ *   u32 request_id
+ *   u64 program_id      cache key of the program that ran (use with RUN_PROGRAM)
+ *   u64 instructions    instructions retired
+ *   u32 pc
+ *   u32 registers[8]
+ *   u32 output_count, u32 words[output_count]
+ */
+
+/** Largest accepted payload; bigger frames close the connection. */
+#define JOB_MAX_PAYLOAD (4u << 20)
+
+/**
+ * @enum JobMessageType
+ * @brief Payload type byte.
+ */
+typedef enum {
+    JOB_MSG_RUN_SOURCE  = 1,    /**< Assemble (or find in the cache) and run source text */
+    JOB_MSG_RUN_PROGRAM = 2,    /**< Run a cached program by id */
+    JOB_MSG_RESULT      = 0x81  /**< Server reply */
+} JobMessageType;
+
+/** Request carries initial register values. */
+#define JOB_FLAG_REGISTERS 0x01u
+/** Source is assembled with the packed encoding. */
+#define JOB_FLAG_PACKED    0x02u
+
+/**
+ * @enum JobStatus
+ * @brief Outcome of a request, independent of how the guest stopped.
+ */
+typedef enum {
+    JOB_STATUS_OK              = 0, /**< The program ran; see `stop` */
+    JOB_STATUS_BAD_REQUEST     = 1, /**< Malformed payload or window outside RAM */
+    JOB_STATUS_UNKNOWN_PROGRAM = 2, /**< program_id not in the cache (resend the source) */
+    JOB_STATUS_ASSEMBLY_FAILED = 3, /**< Source did not assemble */
+    JOB_STATUS_OVERLOADED      = 4, /**< Job queue full; retry later */
+    JOB_STATUS_INTERNAL        = 5  /**< Server-side failure */
+} JobStatus;
+
+/**
+ * @struct JobPatch
+ * @brief One RAM patch of a decoded request (words point into the payload).
+ */
+typedef struct {
+    uint32_t address;
+    uint32_t count;
+    const uint32_t *words;
+} JobPatch;
+
+/**
+ * @struct JobRequest
+ * @brief A request, either to encode or as decoded from a payload.
+ *
+ * After job_decode_request() all pointers refer into the (4-byte aligned)
+ * payload buffer, which must outlive the request.
+ */
+typedef struct {
+    uint8_t type;                       /**< JOB_MSG_RUN_SOURCE or JOB_MSG_RUN_PROGRAM */
+    uint8_t flags;                      /**< JOB_FLAG_* */
+    uint32_t request_id;
+    uint64_t max_instructions;
+    uint32_t output_address;
+    uint32_t output_count;
+    uint32_t registers[MAX_REGISTERS];  /**< Used when JOB_FLAG_REGISTERS is set */
+    const JobPatch *patches;            /**< Encode: caller's array. Decode: see job_decode_request() */
+    uint16_t patch_count;
+    const char *source;                 /**< RUN_SOURCE text (not NUL-terminated) */
+    uint32_t source_length;
+    uint64_t program_id;                /**< RUN_PROGRAM id */
+} JobRequest;
+
+/**
+ * @struct JobResult
+ * @brief A result, either to encode or as decoded from a payload.
+ */
+typedef struct {
+    uint8_t status;                     /**< JobStatus */
+    uint8_t stop;                       /**< CpuStopReason */
+    bool zero_flag;
+    bool negative_flag;
+    uint32_t request_id;
+    uint64_t program_id;
+    uint64_t instructions;
+    uint32_t pc;
+    uint32_t registers[MAX_REGISTERS];
+    const uint32_t *output;             /**< output_count words (decode: points into the payload) */
+    uint32_t output_count;
+} JobResult;
+
+/**
+ * @struct JobBuffer
+ * @brief Growable byte buffer used to build and accumulate frames.
+ */
+typedef struct {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+} JobBuffer;
+
+/** Release the buffer's storage and reset it to empty. */
+void job_buffer_free(JobBuffer *buffer);
+
+/** Append `length` bytes; false if memory is exhausted. */
+bool job_buffer_append(JobBuffer *buffer, const void *bytes, size_t length);
+
+/** Remove the first `count` bytes. */
+void job_buffer_consume(JobBuffer *buffer, size_t count);
+
+/**
+ * @brief Append one request frame (length prefix included) to `out`.
+ */
+bool job_encode_request(JobBuffer *out, const JobRequest *request);
+
+/**
+ * @brief Append one result frame (length prefix included) to `out`.
+ */
+bool job_encode_result(JobBuffer *out, const JobResult *result);
+
+/**
+ * @brief Decode a request payload in place.
+ *
+ * Word fields are converted to host byte order inside `payload`, so the
+ * patches' `words` can be used directly. `patches` receives up to
+ * `patch_capacity` entries; more patches than that is an error.
+ *
+ * @param payload Payload bytes (without the length prefix), 4-byte aligned.
+ * @param length Payload length.
+ * @param request Output.
+ * @param patches Storage for the decoded patch descriptors.
+ * @param patch_capacity Entries available in `patches`.
+ * @return false if the payload is malformed. `request->request_id` is
+ *         still filled in when the header was readable.
+ */
+bool job_decode_request(uint8_t *payload, size_t length, JobRequest *request, JobPatch *patches,
+                        size_t patch_capacity);
+
+/**
+ * @brief Decode a result payload in place (same conventions as above).
+ */
+bool job_decode_result(uint8_t *payload, size_t length, JobResult *result);
+
+/**
+ * @brief If `buffer` starts with a complete frame, return its payload length.
+ *
+ * @param payload_length Receives the payload length.
+ * @return 1 if a full frame is buffered, 0 if more bytes are needed,
+ *         -1 if the announced length exceeds JOB_MAX_PAYLOAD.
+ */
+int job_frame_ready(const JobBuffer *buffer, uint32_t *payload_length);
+
+/** Short name of a JobStatus value. */
+const char *job_status_name(JobStatus status);
+
+#endif //INC_8BIT_CPU_EMULATOR_JOB_PROTOCOL_H
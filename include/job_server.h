@@ -0,0 +1,75 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_JOB_SERVER_H
+#define INC_8BIT_CPU_EMULATOR_JOB_SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file job_server.h
+ * @brief Emulator job server on a Unix domain socket (Linux, epoll).
+ *
+ * One I/O thread multiplexes the listening socket and every client
+ * connection with epoll and parses request frames (job_protocol.h). Jobs go
+ * to a bounded queue served by a pool of worker threads; each worker owns a
+ * pre-created Emulator instance (emulator.h), so a job pays neither for
+ * process start-up nor for ram_init(). Assembled programs are kept in a
+ * shared LRU cache keyed by a hash of their source, so repeated sources are
+ * assembled once and clients can refer to them by id afterwards. A source
+ * hit is compared with the cached text, so a hash collision is a miss. Results
+ * are handed back to the I/O thread through an eventfd and written without
+ * blocking. A client may pipeline any number of requests; results may come
+ * back out of order and carry the request id.
+ */
+
+/** Opaque server handle. */
+typedef struct JobServer JobServer;
+
+/**
+ * @struct JobServerConfig
+ * @brief Server settings.
+ */
+typedef struct {
+    const char *socket_path;     /**< Path to bind (an existing socket file is replaced) */
+    size_t workers;              /**< Worker threads / warm instances (0 = online CPUs) */
+    size_t queue_capacity;       /**< Pending jobs before OVERLOADED replies (0 = 4096) */
+    size_t cache_entries;        /**< Programs kept in the cache (0 = 256) */
+    const char *engine;          /**< Engine name for the workers (NULL = default) */
+    uint64_t max_instructions;   /**< Cap applied to every job; 0 = no cap */
+    bool verbose;                /**< Forward guest/assembler messages to stderr */
+} JobServerConfig;
+
+/**
+ * @brief Fill `config` with defaults (no socket path).
+ */
+void job_server_config_default(JobServerConfig *config);
+
+/**
+ * @brief Bind the socket, create the worker instances and start the workers.
+ *
+ * @return The server, or NULL (with an error logged) on failure.
+ */
+JobServer *job_server_create(const JobServerConfig *config);
+
+/**
+ * @brief Serve until job_server_stop() is called.
+ *
+ * @return false if the event loop failed.
+ */
+bool job_server_run(JobServer *server);
+
+/**
+ * @brief Ask a running server to stop. Async-signal-safe.
+ */
+void job_server_stop(JobServer *server);
+
+/**
+ * @brief Stop the workers, close every connection and remove the socket file.
+ */
+void job_server_destroy(JobServer *server);
+
+#endif //INC_8BIT_CPU_EMULATOR_JOB_SERVER_H
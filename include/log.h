@@ -5,6 +5,8 @@
 #ifndef INC_8BIT_CPU_EMULATOR_LOG_H
 #define INC_8BIT_CPU_EMULATOR_LOG_H
 
+#include <stdbool.h>
+
 #define unscast unsigned // Use in formatters to avoid platform-specific compiler warnings
 
 /**
@@ -36,5 +38,52 @@ typedef enum
  */
 void log_write(LogLevel level, const char *fmt, ...);
 
+/**
+ * @brief Enable or disable output for a single log level.
+ *
+ * Batch and benchmark drivers use this to drop DEBUG/INFO chatter that
+ * would otherwise dominate run time.
+ *
+ * @param level Severity level to configure.
+ * @param enabled true to print messages of `level`, false to suppress them.
+ */
+void log_set_enabled(LogLevel level, bool enabled);
+
+/** Bit representing `level` in LogSink::level_mask. */
+#define LOG_LEVEL_BIT(level) (1u << (unsigned)(level))
+
+/** Mask selecting every log level. */
+#define LOG_LEVELS_ALL (LOG_LEVEL_BIT(LOG_UNAUTHORIZED + 1) - 1u)
+
+/**
+ * @brief Callback receiving one formatted log message (no timestamp, no newline).
+ */
+typedef void (*LogSinkFn)(void *user, LogLevel level, const char *message);
+
+/**
+ * @struct LogSink
+ * @brief Per-thread destination for log messages.
+ *
+ * While a sink is installed on a thread, log_write() calls from that thread
+ * go to the sink, filtered by its own level mask, instead of stdout and the
+ * process-wide flags set with log_set_enabled(). Embedders (see emulator.h)
+ * install their instance's sink for the duration of each call, so several
+ * instances can log to different places concurrently.
+ */
+typedef struct {
+    LogSinkFn write;       /**< Message callback; NULL discards everything */
+    void *user;            /**< Passed back to `write` */
+    unsigned level_mask;   /**< LOG_LEVEL_BIT() of every level to deliver */
+} LogSink;
+
+/**
+ * @brief Install `sink` for the calling thread (NULL restores stdout logging).
+ *
+ * The sink is borrowed and must outlive its installation.
+ *
+ * @return The previously installed sink, so callers can nest and restore.
+ */
+const LogSink *log_set_thread_sink(const LogSink *sink);
+
 
 #endif //INC_8BIT_CPU_EMULATOR_LOG_H
\ No newline at end of file
@@ -0,0 +1,137 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_METRICS_H
+#define INC_8BIT_CPU_EMULATOR_METRICS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu.h"
+#include "job_protocol.h"
+
+/**
+ * @file metrics.h
+ * @brief Process-wide metrics registry with Prometheus text exposition.
+ *
+ * The registry has a fixed catalogue of counters, histograms and gauges.
+ * Counters and histograms are sharded per thread: each recording thread
+ * owns a block of slots that only it writes (plain relaxed loads and
+ * stores, no locked instructions), and a scrape sums every shard under
+ * the registry mutex. Shards of exiting threads are folded into a
+ * retired total, so counts never go backwards. Gauges are single atomics
+ * set by whoever owns the quantity.
+ *
+ * Recording happens per run, per job or on an error path, never per
+ * instruction, and every recording call returns immediately until
+ * metrics_set_enabled(true).
+ */
+
+/** Stop reasons counted by emulator_runs_total. */
+#define METRIC_STOP_REASONS (CPU_STOP_WATCHPOINT + 1)
+
+/** Job statuses counted by emulator_jobs_total. */
+#define METRIC_JOB_STATUSES (JOB_STATUS_INTERNAL + 1)
+
+/** Most buckets a histogram has (+Inf excluded). */
+#define METRIC_MAX_BUCKETS 16
+
+/**
+ * @enum MetricCounter
+ * @brief Monotonic counters.
+ */
+typedef enum {
+    METRIC_INSTRUCTIONS,                                    /**< emulator_instructions_retired_total */
+    METRIC_RUNS,                                            /**< emulator_runs_total{stop}; add the CpuStopReason */
+    METRIC_ERROR_DIV_ZERO = METRIC_RUNS + METRIC_STOP_REASONS, /**< emulator_errors_total{kind="div_zero"} */
+    METRIC_ERROR_INVALID_INSTRUCTION,                       /**< ...{kind="invalid_instruction"} */
+    METRIC_ERROR_REGISTER_INDEX,                            /**< ...{kind="register_index"} (validation.c) */
+    METRIC_ERROR_ADDRESS_INDEX,                             /**< ...{kind="address_register_index"} (validation.c) */
+    METRIC_ERROR_ADDRESS_LITERAL,                           /**< ...{kind="address_literal"} (validation.c) */
+    METRIC_ERROR_MEMORY_BOUNDS,                             /**< ...{kind="memory_bounds"} (validation.c) */
+    METRIC_JOBS,                                            /**< emulator_jobs_total{status}; add the JobStatus */
+    METRIC_CONNECTIONS = METRIC_JOBS + METRIC_JOB_STATUSES, /**< emulator_connections_accepted_total */
+    METRIC_CACHE_HITS,                                      /**< emulator_program_cache_lookups_total{result="hit"} */
+    METRIC_CACHE_MISSES,                                    /**< ...{result="miss"} */
+    METRIC_COUNTER_COUNT
+} MetricCounter;
+
+/**
+ * @enum MetricHistogram
+ * @brief Distributions; values are recorded in integer base units.
+ */
+typedef enum {
+    METRIC_RUN_SECONDS,         /**< emulator_run_duration_seconds (nanoseconds recorded) */
+    METRIC_JOB_LATENCY,         /**< emulator_job_latency_seconds, request parsed to result queued (nanoseconds) */
+    METRIC_RUN_DIRTY_PAGES,     /**< emulator_run_dirty_pages: RAM pages written by one run */
+    METRIC_HISTOGRAM_COUNT
+} MetricHistogram;
+
+/**
+ * @enum MetricGauge
+ * @brief Instantaneous values.
+ */
+typedef enum {
+    METRIC_QUEUE_DEPTH,         /**< emulator_job_queue_depth */
+    METRIC_OPEN_CONNECTIONS,    /**< emulator_open_connections */
+    METRIC_WORKERS,             /**< emulator_workers */
+    METRIC_GAUGE_COUNT
+} MetricGauge;
+
+/**
+ * @brief Turn recording on or off for the whole process (off at start-up).
+ */
+void metrics_set_enabled(bool enabled);
+
+/**
+ * @brief Whether recording is on; callers test it before timing anything.
+ */
+bool metrics_enabled(void);
+
+/**
+ * @brief Add `amount` to a counter in the calling thread's shard.
+ */
+void metrics_add(MetricCounter counter, uint64_t amount);
+
+/**
+ * @brief Record one value of a histogram in the calling thread's shard.
+ */
+void metrics_observe(MetricHistogram histogram, uint64_t value);
+
+/**
+ * @brief Set a gauge.
+ */
+void metrics_set_gauge(MetricGauge gauge, int64_t value);
+
+/**
+ * @brief Write every metric in the Prometheus text format (version 0.0.4).
+ *
+ * @return false if writing failed.
+ */
+bool metrics_write(FILE *out);
+
+/** Opaque exporter thread. */
+typedef struct MetricsExporter MetricsExporter;
+
+/**
+ * @brief Start exporting metrics in a background thread.
+ *
+ * @param listen_address "HOST:PORT" or ":PORT" to serve `GET /metrics`
+ *        over HTTP (host defaults to 127.0.0.1), or NULL.
+ * @param textfile Path rewritten atomically (write, then rename) every
+ *        `interval_seconds` and on stop, for node_exporter's textfile
+ *        collector, or NULL.
+ * @param interval_seconds Textfile period (0 = 15).
+ * @return The exporter, or NULL (with an error logged) if the socket
+ *         could not be set up or neither output was given.
+ */
+MetricsExporter *metrics_exporter_start(const char *listen_address, const char *textfile, unsigned interval_seconds);
+
+/**
+ * @brief Write the textfile one last time, stop the thread and release the exporter. NULL is ignored.
+ */
+void metrics_exporter_stop(MetricsExporter *exporter);
+
+#endif //INC_8BIT_CPU_EMULATOR_METRICS_H
@@ -0,0 +1,188 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_MMIO_H
+#define INC_8BIT_CPU_EMULATOR_MMIO_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu.h"
+#include "ram.h"
+
+/**
+ * @file mmio.h
+ * @brief Memory-mapped I/O devices with page-level dispatch.
+ *
+ * A device claims whole RAM pages (RAM_PAGE_SHIFT words each) starting at
+ * a page-aligned base address. The bus keeps one byte per page naming the
+ * device that owns it, so the mapped engine (cpu_execute_mapped(),
+ * cpu_exec.h) sends a LOADM/STOREM to a device after one table lookup and
+ * lets every other access go to RAM. The other engines have no bus at all.
+ * Instruction fetches always read RAM.
+ *
+ * A device callback gets the word offset from the device base and the CPU
+ * performing the access. It returns false to fault the access, which stops
+ * the run with CPU_STOP_FAULT. A NULL callback reads as zero and ignores
+ * writes. Device stores do not touch RAM or its dirty bits.
+ *
+ * Two devices are provided:
+ * - console (MmioConsole): buffered byte output to a host stream;
+ * - cycles (MmioCycleCounter): a 64-bit cycle counter.
+ */
+
+/** Most devices on one bus. */
+#define MMIO_MAX_DEVICES 16
+
+/** Words per MMIO page (the dirty-tracking page). */
+#define MMIO_PAGE_WORDS (1u << RAM_PAGE_SHIFT)
+
+/**
+ * @struct MmioDevice
+ * @brief One device: the pages it claims and its callbacks.
+ */
+typedef struct {
+    const char *name;
+    uint32_t base;              /**< First word, a multiple of MMIO_PAGE_WORDS */
+    uint32_t size;              /**< Words of registers; whole pages are claimed */
+    void *context;              /**< Passed to the callbacks */
+    bool (*read)(void *context, const CPU *cpu, uint32_t offset, uint32_t *value);
+    bool (*write)(void *context, const CPU *cpu, uint32_t offset, uint32_t value);
+} MmioDevice;
+
+/**
+ * @struct MmioBus
+ * @brief The mapped devices and the page dispatch table.
+ *
+ * Holds no pointers into itself, so it can be copied.
+ */
+typedef struct {
+    MmioDevice devices[MMIO_MAX_DEVICES];
+    uint32_t device_count;
+    uint8_t pages[RAM_PAGES];   /**< 1 + index of the owning device, 0 = RAM */
+} MmioBus;
+
+/**
+ * @brief Start with no devices: every page is RAM.
+ */
+void mmio_bus_init(MmioBus *bus);
+
+/**
+ * @brief Map a copy of `device` onto its pages.
+ *
+ * @return false (with an error logged) if the base is not page-aligned,
+ *         the range does not fit in RAM, a page is already taken or the
+ *         bus is full.
+ */
+bool mmio_map(MmioBus *bus, const MmioDevice *device);
+
+/**
+ * @brief Device owning word `address`, or NULL for RAM. `address` must be below RAM_SIZE.
+ */
+static inline const MmioDevice *mmio_lookup(const MmioBus *bus, uint32_t address) {
+    uint8_t slot = bus->pages[address >> RAM_PAGE_SHIFT];
+    return slot ? &bus->devices[slot - 1] : NULL;
+}
+
+/**
+ * @brief Read word `address` of `device` for `cpu`.
+ *
+ * @return false (with an error logged) if the device faulted the access.
+ */
+bool mmio_read(const MmioDevice *device, const CPU *cpu, uint32_t address, uint32_t *value);
+
+/**
+ * @brief Write word `address` of `device` for `cpu`.
+ *
+ * @return false (with an error logged) if the device faulted the access.
+ */
+bool mmio_write(const MmioDevice *device, const CPU *cpu, uint32_t address, uint32_t value);
+
+/** Console registers (word offsets from the base). */
+enum {
+    MMIO_CONSOLE_DATA  = 0,     /**< Write: append the low byte to the buffer */
+    MMIO_CONSOLE_FLUSH = 1,     /**< Write: flush the buffer to the stream */
+    MMIO_CONSOLE_COUNT = 2,     /**< Read: bytes written so far (low 32 bits) */
+    MMIO_CONSOLE_WORDS
+};
+
+/** Bytes the console buffers before it writes them to its stream. */
+#define MMIO_CONSOLE_BUFFER 4096
+
+/**
+ * @struct MmioConsole
+ * @brief State of a console device.
+ *
+ * Bytes are written to the stream when the buffer fills, when the guest
+ * writes FLUSH and on mmio_console_flush(), so a run costs one fwrite()
+ * per buffer rather than one per byte.
+ */
+typedef struct {
+    FILE *out;
+    uint64_t written;           /**< Bytes the guest has written */
+    size_t length;              /**< Bytes waiting in `buffer` */
+    char buffer[MMIO_CONSOLE_BUFFER];
+} MmioConsole;
+
+/**
+ * @brief Prepare a console writing to `out`.
+ */
+void mmio_console_init(MmioConsole *console, FILE *out);
+
+/**
+ * @brief Device descriptor of `console` at `base`, for mmio_map().
+ */
+MmioDevice mmio_console_device(MmioConsole *console, uint32_t base);
+
+/**
+ * @brief Write the buffered bytes to the stream; call after the run.
+ *
+ * @return false (with an error logged) if the stream reported an error.
+ */
+bool mmio_console_flush(MmioConsole *console);
+
+/** Cycle counter registers (word offsets from the base). */
+enum {
+    MMIO_CYCLES_LOW   = 0,      /**< Read: low 32 bits; latches the high half */
+    MMIO_CYCLES_HIGH  = 1,      /**< Read: high 32 bits as of the last LOW read */
+    MMIO_CYCLES_RESET = 2,      /**< Write: restart counting from zero */
+    MMIO_CYCLES_WORDS
+};
+
+/**
+ * @struct MmioCycleCounter
+ * @brief State of a cycle counter device.
+ *
+ * The mapped engine does not estimate cycles, so the counter runs at one
+ * cycle per retired instruction: it reads instructions_retired minus its
+ * value at the last reset. The LOADM reading it has not retired yet and is
+ * not counted.
+ */
+typedef struct {
+    uint64_t origin;            /**< Count at the last reset */
+    uint32_t latched_high;      /**< High half latched by the last LOW read */
+} MmioCycleCounter;
+
+/**
+ * @brief Prepare a counter that starts at zero.
+ */
+void mmio_cycle_counter_init(MmioCycleCounter *counter);
+
+/**
+ * @brief Device descriptor of `counter` at `base`, for mmio_map().
+ */
+MmioDevice mmio_cycle_counter_device(MmioCycleCounter *counter, uint32_t base);
+
+/**
+ * @brief Map the devices listed in `spec`, "console@0xFF00,cycles@0xFE00".
+ *
+ * Each kind may appear once and uses the state passed for it.
+ *
+ * @return false (with an error logged) on an unknown kind, a bad address
+ *         or a mapping conflict.
+ */
+bool mmio_bus_parse(MmioBus *bus, const char *spec, MmioConsole *console, MmioCycleCounter *counter);
+
+#endif //INC_8BIT_CPU_EMULATOR_MMIO_H
@@ -0,0 +1,106 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_OBSERVER_H
+#define INC_8BIT_CPU_EMULATOR_OBSERVER_H
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu.h"
+
+/**
+ * @file observer.h
+ * @brief Live, lock-free view of running CPUs.
+ *
+ * A StatePublisher is a seqlock-protected copy of a CPU's architectural
+ * state. The engine that runs the CPU (cpu_execute_observed(), or an
+ * Emulator with emu_set_publisher()) writes it at the start of the run,
+ * every `interval` basic blocks (retired JMP/JZ/JNZ) and at the end. Any
+ * number of monitor threads read it with state_snapshot_read() without
+ * locking or pausing the CPU: a reader that overlaps a publication sees an
+ * odd or changed sequence number and retries, so every snapshot it returns
+ * comes from a single publication.
+ *
+ * All fields are written and read with relaxed atomics between the
+ * sequence updates, so the seqlock is race-free under the C11 memory model.
+ */
+
+/** Default number of basic blocks between publications. */
+#define OBSERVER_DEFAULT_INTERVAL 4096
+
+/**
+ * @struct CpuSnapshot
+ * @brief One consistent publication.
+ */
+typedef struct {
+    uint32_t pc;
+    uint32_t registers[MAX_REGISTERS];
+    uint32_t address_registers[MAX_ADDRESS_REGISTERS];
+    bool zero_flag;
+    bool negative_flag;
+    bool running;                   /**< false once the run has ended */
+    CpuStopReason stop_reason;      /**< Why the run ended (CPU_STOP_NONE while running) */
+    uint64_t instructions_retired;
+    uint64_t published_ns;          /**< CLOCK_MONOTONIC time of the publication */
+    uint64_t publications;          /**< Publications so far, this one included */
+} CpuSnapshot;
+
+/**
+ * @struct StatePublisher
+ * @brief Seqlock cell one CPU publishes into. Initialize with state_publisher_init().
+ */
+typedef struct {
+    atomic_uint_fast64_t sequence;  /**< Odd while a publication is in progress */
+    _Atomic uint32_t pc;
+    _Atomic uint32_t registers[MAX_REGISTERS];
+    _Atomic uint32_t address_registers[MAX_ADDRESS_REGISTERS];
+    _Atomic uint32_t status;        /**< Flags, running and stop reason (see observer.c) */
+    _Atomic uint64_t instructions_retired;
+    _Atomic uint64_t published_ns;
+    uint32_t interval;              /**< Basic blocks between publications (read by the engine) */
+} StatePublisher;
+
+/**
+ * @brief Prepare `publisher`; nothing is published yet.
+ *
+ * @param interval Basic blocks between publications (0 = OBSERVER_DEFAULT_INTERVAL).
+ */
+void state_publisher_init(StatePublisher *publisher, uint32_t interval);
+
+/**
+ * @brief Publish the state of `cpu`. Only the thread running `cpu` may call it.
+ */
+void state_publish(StatePublisher *publisher, const CPU *cpu);
+
+/**
+ * @brief Copy the latest publication without blocking the publisher.
+ *
+ * @return false if nothing has been published yet.
+ */
+bool state_snapshot_read(const StatePublisher *publisher, CpuSnapshot *snapshot);
+
+/**
+ * @struct StateTopRow
+ * @brief One instance shown by state_top_print().
+ */
+typedef struct {
+    const char *name;                   /**< Label of the instance */
+    const StatePublisher *publisher;
+    CpuSnapshot previous;               /**< Snapshot of the previous refresh (rate column) */
+    bool has_previous;
+} StateTopRow;
+
+/**
+ * @brief Print a `top`-like table of the instances: state, PC, retired
+ *        instructions, MIPS since the previous refresh, R0-R3, flags and
+ *        the age of each snapshot, then a summary line.
+ *
+ * Each row's `previous` snapshot is replaced by the one just printed.
+ */
+void state_top_print(FILE *out, StateTopRow *rows, size_t count);
+
+#endif //INC_8BIT_CPU_EMULATOR_OBSERVER_H
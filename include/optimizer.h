@@ -0,0 +1,95 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_OPTIMIZER_H
+#define INC_8BIT_CPU_EMULATOR_OPTIMIZER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "assembler.h"
+#include "ram.h"
+
+/**
+ * @file optimizer.h
+ * @brief Post-assembly peephole optimizer over emitted machine code.
+ *
+ * The optimizer runs between assembly and execution. It decodes the
+ * assembled range, builds the control-flow graph of the program, applies
+ * rewrites that preserve the observable result (registers, memory and both
+ * flags at HALT/end of program), then re-lays the surviving instructions
+ * contiguously from the start address and relocates every jump target.
+ *
+ * Rewrites:
+ *  - constant folding: `LOADI Rx, a` followed by `OP Rx, imm` (or
+ *    `OP Rx, Rx`) in the same block becomes a single `LOADI Rx, a OP imm`.
+ *    LOADI sets the zero flag from the loaded value exactly as the ALU op
+ *    does from its result, so flags are unchanged. Division by a zero
+ *    immediate is never folded so the runtime fault is kept.
+ *  - identities: `ADD/SUB/OR/XOR Rx, 0`, `MLP/DIV Rx, 1`, `AND Rx, 0xFFFFFFFF`
+ *    leave Rx unchanged but still set the zero flag, so they are removed
+ *    only where the zero flag is dead (overwritten before any JZ/JNZ and
+ *    before the program ends).
+ *  - jumps to the next instruction are removed (jumps never touch flags).
+ *  - jump-to-jump chains are threaded to their final target.
+ *  - code unreachable from the start address is removed.
+ *
+ * The pass refuses to touch programs it cannot reason about: undecodable
+ * words inside the range, jumps into the middle of an instruction or out of
+ * the range, invalid register indices, or memory operands that may read or
+ * write the code itself.
+ */
+
+/**
+ * @struct OptimizerStats
+ * @brief What the optimizer changed and what it is estimated to save.
+ *
+ * Cycle estimates use a fixed per-opcode cost (see optimizer.c) and count
+ * each removed instruction once, i.e. they are static savings, not savings
+ * weighted by how often the code executes.
+ */
+typedef struct {
+    uint32_t instructions_before;
+    uint32_t instructions_after;
+    uint32_t words_before;
+    uint32_t words_after;
+    uint32_t constants_folded;     /**< LOADI + ALU pairs merged */
+    uint32_t identities_removed;   /**< No-op ALU instructions with a dead zero flag */
+    uint32_t jumps_to_next_removed;
+    uint32_t jumps_threaded;       /**< Jump targets redirected through a chain */
+    uint32_t unreachable_removed;
+    uint32_t passes;               /**< Iterations until no rewrite applied */
+    uint64_t estimated_cycles_saved;
+    bool skipped;                  /**< True if the program was left untouched as unsafe */
+} OptimizerStats;
+
+/**
+ * @brief Optimize an assembled range in place.
+ *
+ * On success the optimized code occupies [range->start_address,
+ * range->end_address) with `end_address` updated; the freed tail of the old
+ * range is zeroed. If the program is not safe to optimize it is left
+ * untouched, `stats->skipped` is set and the function still returns true.
+ *
+ * @param words Memory indexed by absolute address (e.g. ram->cells).
+ * @param limit Number of addressable words in `words`.
+ * @param range Range to optimize; updated with the new end address.
+ * @param stats Optional output for the optimization report (may be NULL).
+ * @return false only on invalid arguments or allocation failure.
+ */
+bool optimize_range(uint32_t *words, uint32_t limit, AssemblyRange *range, OptimizerStats *stats);
+
+/**
+ * @brief Optimize a program assembled into RAM.
+ *
+ * Convenience wrapper over optimize_range() targeting `ram->cells`.
+ */
+bool optimize_program(RAM *ram, AssemblyRange *range, OptimizerStats *stats);
+
+/**
+ * @brief Print an optimization report to stdout.
+ */
+void optimizer_print_stats(const OptimizerStats *stats);
+
+#endif //INC_8BIT_CPU_EMULATOR_OPTIMIZER_H
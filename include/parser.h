@@ -9,7 +9,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-#include "isa.h" /* for Label and MAX_LABELS */
+#include "isa.h" /* for Label */
 
 /**
  * @brief Generic failure return value used by parser functions.
@@ -44,12 +44,34 @@ int parse_address(const char *addr, bool literal_addr);
 int parse_address_register_from_parens(const char *addr, bool *is_literal);
 
 /* Labels */
+
+/**
+ * @struct LabelTable
+ * @brief Growable label table with a hash index for O(1) lookups.
+ *
+ * `entries` keeps labels in definition order; `buckets` is an
+ * open-addressing index (linear probing, power-of-two size) holding
+ * entry index + 1, with 0 marking an empty slot. Programs with tens of
+ * thousands of labels therefore assemble in linear time.
+ */
+typedef struct {
+	Label *entries;
+	size_t count;
+	size_t capacity;
+	uint32_t *buckets;
+	size_t bucket_count;
+} LabelTable;
+
+/** Initialize an empty label table (no allocation until the first label). */
+void label_table_init(LabelTable *labels);
+/** Release the memory owned by a label table and reset it. */
+void label_table_free(LabelTable *labels);
 /** Return true if the given line ends with ':' indicating a label. */
 bool is_label(const char *line);
-/** Add a label with resolved address to the labels array; returns 0 on success. */
-int add_label(const char *label_name, uint32_t addr, Label labels[], size_t *label_count);
+/** Add a label with resolved address to the table; returns 0 on success, FAILURE on duplicates, names over 63 characters or OOM. */
+int add_label(const char *label_name, uint32_t addr, LabelTable *labels);
 /** Find a label's resolved address; returns address or FAILURE if not found. */
-int find_label_addr(const char *label_name, Label labels[], size_t label_count);
+int find_label_addr(const char *label_name, const LabelTable *labels);
 
 #endif //INC_8BIT_CPU_EMULATOR_PARSER_H
 
@@ -0,0 +1,104 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_PERF_COUNTERS_H
+#define INC_8BIT_CPU_EMULATOR_PERF_COUNTERS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file perf_counters.h
+ * @brief Host hardware performance counters around a region of code (Linux perf_event_open).
+ *
+ * The counters are opened as one event group on the calling thread,
+ * user space only (so perf_event_paranoid <= 2 is enough), and read in a
+ * single syscall. Events the CPU or kernel does not provide are skipped;
+ * if none can be opened (no PMU in a VM, perf_event_paranoid = 3, seccomp,
+ * non-Linux build) perf_counters_open() returns false and callers fall
+ * back to wall-clock timing only.
+ *
+ * Typical use:
+ *
+ *     PerfCounters pc;
+ *     bool have_perf = perf_counters_open(&pc);
+ *     perf_counters_start(&pc);
+ *     cpu_run(...);
+ *     PerfSample s;
+ *     perf_counters_stop(&pc, &s);
+ *     perf_counters_close(&pc);
+ */
+
+/**
+ * @enum PerfCounter
+ * @brief Events collected by PerfCounters.
+ */
+typedef enum {
+    PERF_CYCLES,          /**< CPU cycles */
+    PERF_INSTRUCTIONS,    /**< Retired host instructions */
+    PERF_BRANCH_MISSES,   /**< Mispredicted branches */
+    PERF_L1D_MISSES,      /**< L1 data cache read misses */
+    PERF_LLC_MISSES,      /**< Last-level cache misses */
+    PERF_COUNTER_COUNT
+} PerfCounter;
+
+/**
+ * @struct PerfCounters
+ * @brief An open group of counters.
+ */
+typedef struct {
+    int leader;                         /**< Group leader fd, -1 if nothing is open */
+    int fds[PERF_COUNTER_COUNT];        /**< Event fds, -1 for unavailable events */
+    uint64_t ids[PERF_COUNTER_COUNT];   /**< Kernel event ids, used to match group reads */
+    int open_count;                     /**< Number of events opened */
+} PerfCounters;
+
+/**
+ * @struct PerfSample
+ * @brief Counter values for one measured region.
+ *
+ * When the kernel had to multiplex the group, values are scaled by
+ * time_enabled / time_running.
+ */
+typedef struct {
+    uint64_t values[PERF_COUNTER_COUNT];
+    bool valid[PERF_COUNTER_COUNT];     /**< false if the event was unavailable or never scheduled */
+} PerfSample;
+
+/**
+ * @brief Put `pc` in the closed state (start/stop/close become no-ops).
+ */
+void perf_counters_init(PerfCounters *pc);
+
+/**
+ * @brief Open every available event as a disabled group on the calling thread.
+ *
+ * @return true if at least one event could be opened.
+ */
+bool perf_counters_open(PerfCounters *pc);
+
+/**
+ * @brief Reset and enable the group. No-op if nothing is open.
+ */
+void perf_counters_start(PerfCounters *pc);
+
+/**
+ * @brief Disable the group and read it.
+ *
+ * @param sample Receives the values; every entry is invalid if nothing is open.
+ * @return false if the group could not be read.
+ */
+bool perf_counters_stop(PerfCounters *pc, PerfSample *sample);
+
+/**
+ * @brief Close all events.
+ */
+void perf_counters_close(PerfCounters *pc);
+
+/**
+ * @brief Short name of an event (e.g. "cycles", "branch-misses").
+ */
+const char *perf_counter_name(PerfCounter counter);
+
+#endif //INC_8BIT_CPU_EMULATOR_PERF_COUNTERS_H
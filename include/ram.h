@@ -16,6 +16,12 @@
  */
 #define RAM_SIZE 65536
 
+/** log2 of the number of words per dirty-tracking page. */
+#define RAM_PAGE_SHIFT 8
+
+/** Number of dirty-tracking pages (RAM_SIZE >> RAM_PAGE_SHIFT). */
+#define RAM_PAGES (RAM_SIZE >> RAM_PAGE_SHIFT)
+
 /**
  * @brief RAM instance holding the memory cells and synchronization primitive.
  *
@@ -26,9 +32,26 @@
  */
 typedef struct {
     uint32_t cells[RAM_SIZE];
+    uint64_t dirty[RAM_PAGES / 64]; /**< One bit per page written since ram_clear_dirty() */
     pthread_rwlock_t lock;
 } RAM;
 
+/**
+ * @brief Record that the page holding `address` was written.
+ *
+ * Called by the interpreter's STOREM handler so that hosts which run a
+ * program many times (emulator.h) can restore only the touched pages.
+ */
+static inline void ram_mark_dirty(RAM *ram, uint32_t address) {
+    uint32_t page = address >> RAM_PAGE_SHIFT;
+    ram->dirty[page >> 6] |= 1ull << (page & 63);
+}
+
+/**
+ * @brief Forget all dirty-page bits.
+ */
+void ram_clear_dirty(RAM *ram);
+
 /**
  * @brief Check whether a RAM address is within valid bounds.
  *
@@ -0,0 +1,228 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_SMP_H
+#define INC_8BIT_CPU_EMULATOR_SMP_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "assembler.h"
+#include "cpu.h"
+#include "ram.h"
+
+/**
+ * @file smp.h
+ * @brief Several CPUs sharing one RAM, with deterministic record/replay.
+ *
+ * smp_run() starts one thread per core. Every core runs the same program
+ * from the start of its range with the predecoding engine and its own
+ * registers; R7 holds the core index (0..cores-1) so the program can
+ * split the work. Cores communicate through LOADM/STOREM on the shared
+ * RAM.
+ *
+ * Free runs (SMP_FREE) add nothing to the engine, so their interleaving is
+ * whatever the host scheduler makes of it. Recorded runs order memory
+ * accesses page by page (RAM_PAGE_SHIFT): each LOADM/STOREM takes the
+ * page's spin lock, and when the page was last accessed by another core
+ * the access is an ownership transfer and is logged as
+ * (core, instructions retired by the core, page, accesses the page saw
+ * before). Accesses between transfers are implied by the owner's own
+ * instruction stream, so a run whose cores work on private pages logs
+ * almost nothing. Replay takes no locks: a core whose next access is a
+ * logged transfer waits until the page has seen the logged number of
+ * accesses, every other access goes straight through. Everything else a
+ * core does depends only on its registers and the values it loads, so
+ * the replay reproduces the recorded run bit for bit; the log stores a
+ * hash of the initial and final state to prove it.
+ *
+ * Instruction fetches are not ordered: code must not be modified while
+ * several cores run it. The RAM's dirty-page bits are not maintained
+ * reliably by concurrent cores.
+ */
+
+/** Largest number of cores of one run. */
+#define SMP_MAX_CORES 64
+
+/** Register that holds the core index when a core starts. */
+#define SMP_CORE_REGISTER (MAX_REGISTERS - 1)
+
+/**
+ * @enum SmpMode
+ * @brief How a multi-core run orders shared memory accesses.
+ */
+typedef enum {
+    SMP_FREE = 0,                /**< No ordering, no log (nondeterministic) */
+    SMP_RECORD,                  /**< Order accesses per page and log ownership transfers */
+    SMP_REPLAY                   /**< Reproduce a recorded run from its log */
+} SmpMode;
+
+/**
+ * @struct SmpTransfer
+ * @brief One logged change of the core accessing a page.
+ */
+typedef struct {
+    uint64_t instruction;        /**< Instructions the core had retired before the access */
+    uint64_t accesses;           /**< Accesses to the page by any core before it */
+    uint32_t page;
+} SmpTransfer;
+
+/**
+ * @struct SmpCoreLog
+ * @brief Transfers of one core, in its program order.
+ */
+typedef struct {
+    SmpTransfer *transfers;
+    size_t count;
+    size_t capacity;
+} SmpCoreLog;
+
+/**
+ * @struct SmpLog
+ * @brief Everything needed to replay a recorded run of a given program.
+ */
+typedef struct {
+    uint32_t cores;
+    uint64_t max_instructions;   /**< Per-core instruction limit of the recorded run */
+    uint64_t initial_hash;       /**< smp_state_hash() of RAM before the run */
+    uint64_t final_hash;         /**< smp_state_hash() of RAM and every core after it */
+    SmpCoreLog core[SMP_MAX_CORES];
+} SmpLog;
+
+/**
+ * @struct SmpPage
+ * @brief Ordering state of one RAM page, on its own cache line.
+ */
+typedef struct {
+    atomic_uint lock;            /**< Spin lock (record mode) */
+    uint32_t owner;              /**< Core index + 1 of the last accessor, 0 = none (record mode) */
+    _Atomic uint64_t accesses;   /**< LOADM/STOREM executed on the page so far */
+} __attribute__((aligned(64))) SmpPage;
+
+/**
+ * @struct SmpCore
+ * @brief Per-core view of a run, passed to cpu_execute_shared().
+ */
+typedef struct {
+    SmpMode mode;
+    uint32_t index;
+    SmpPage *pages;              /**< RAM_PAGES entries shared by every core */
+    SmpCoreLog *log;             /**< This core's transfers */
+    size_t next;                 /**< Replay: next transfer to wait for */
+    struct SmpShared *shared;    /**< Run-wide state private to smp.c */
+    bool failed;                 /**< Record: out of memory; replay: diverged */
+} SmpCore;
+
+/**
+ * @brief Log a transfer (record mode). Out of line: transfers are rare.
+ */
+void smp_record_transfer(SmpCore *core, uint64_t instruction, uint32_t page, uint64_t accesses);
+
+/**
+ * @brief Take a page lock that another core holds (record mode).
+ */
+void smp_lock_contended(SmpPage *page);
+
+/**
+ * @brief Wait until a logged transfer may proceed (replay mode).
+ *
+ * @return false (with an error logged) if the replay cannot match the log.
+ */
+bool smp_replay_wait(SmpCore *core, const SmpTransfer *transfer);
+
+/**
+ * @brief Order one LOADM/STOREM to `address` before it touches RAM.
+ *
+ * @return false if the run must stop (replay divergence).
+ */
+static inline bool smp_access_begin(SmpCore *core, const CPU *cpu, uint32_t address) {
+    SmpPage *page = &core->pages[address >> RAM_PAGE_SHIFT];
+    if (core->mode == SMP_RECORD) {
+        if (atomic_exchange_explicit(&page->lock, 1, memory_order_acquire))
+            smp_lock_contended(page);
+        if (page->owner != core->index + 1) {
+            page->owner = core->index + 1;
+            smp_record_transfer(core, cpu->instructions_retired, address >> RAM_PAGE_SHIFT,
+                                atomic_load_explicit(&page->accesses, memory_order_relaxed));
+        }
+        return true;
+    }
+    if (core->next < core->log->count && core->log->transfers[core->next].instruction == cpu->instructions_retired)
+        return smp_replay_wait(core, &core->log->transfers[core->next++]);
+    return true;
+}
+
+/**
+ * @brief Finish an access started with smp_access_begin().
+ */
+static inline void smp_access_end(SmpCore *core, uint32_t address) {
+    SmpPage *page = &core->pages[address >> RAM_PAGE_SHIFT];
+    /* Only the core that owns the page updates the count, so no read-modify-write is needed. */
+    uint64_t accesses = atomic_load_explicit(&page->accesses, memory_order_relaxed);
+    atomic_store_explicit(&page->accesses, accesses + 1, memory_order_release);
+    if (core->mode == SMP_RECORD)
+        atomic_store_explicit(&page->lock, 0, memory_order_release);
+}
+
+/**
+ * @brief Run `range` on `cores` CPUs sharing `ram`.
+ *
+ * @param max_instructions Per-core instruction limit (0 = none).
+ * @param mode SMP_FREE, SMP_RECORD (fills `log`) or SMP_REPLAY (reads `log`;
+ *             `cores` and `max_instructions` are taken from it).
+ * @param log Log to fill or replay; may be NULL for SMP_FREE.
+ * @param cpus Receives the final state of every core (SMP_MAX_CORES entries suffice).
+ * @return false (with an error logged) if the run could not be started, the
+ *         log could not be kept, or a replay did not reproduce the recording.
+ */
+bool smp_run(RAM *ram, AssemblyRange range, uint32_t cores, uint64_t max_instructions, SmpMode mode,
+             SmpLog *log, CPU *cpus);
+
+/**
+ * @brief 64-bit FNV-1a hash of RAM and the architectural state of `count` CPUs.
+ */
+uint64_t smp_state_hash(const RAM *ram, const CPU *cpus, uint32_t count);
+
+/**
+ * @brief Whether `log` was recorded from this program and initial RAM.
+ *
+ * smp_run() refuses to replay a log that does not match; callers can check
+ * first to tell that apart from a replay that diverged.
+ *
+ * @return false (with an error logged) if the initial hash differs.
+ */
+bool smp_log_matches(const SmpLog *log, const RAM *ram);
+
+/**
+ * @brief Number of transfers in a log.
+ */
+size_t smp_log_transfers(const SmpLog *log);
+
+/**
+ * @brief Write a log to `path`.
+ *
+ * Layout: little-endian words "C32S", version, cores, max_instructions
+ * (two words), initial and final hash (two words each); then per core
+ * its transfer count as a LEB128 varint and per transfer the varints
+ * instruction - previous instruction, page, accesses.
+ *
+ * @return false (with an error logged) on an I/O error.
+ */
+bool smp_log_write(const SmpLog *log, const char *path);
+
+/**
+ * @brief Read a log written by smp_log_write().
+ *
+ * @return false (with an error logged) on an I/O error or a malformed file.
+ */
+bool smp_log_read(SmpLog *log, const char *path);
+
+/**
+ * @brief Free the transfers of a log.
+ */
+void smp_log_free(SmpLog *log);
+
+#endif //INC_8BIT_CPU_EMULATOR_SMP_H
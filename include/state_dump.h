@@ -0,0 +1,70 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_STATE_DUMP_H
+#define INC_8BIT_CPU_EMULATOR_STATE_DUMP_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu.h"
+#include "ram.h"
+
+/**
+ * @file state_dump.h
+ * @brief Write the final machine state in text, JSON or binary form.
+ *
+ * Binary layout (all fields 32-bit little-endian):
+ *   word 0: STATE_DUMP_MAGIC ("C32S")
+ *   word 1: STATE_DUMP_VERSION
+ *   word 2: pc
+ *   word 3: flags (bit 0 zero, bit 1 negative, bit 2 running)
+ *   word 4: stop reason (CpuStopReason)
+ *   words 5-6: instructions retired (low, high)
+ *   words 7..14: R0..R7
+ *   words 15..22: A0..A7
+ *   word 23: first dumped RAM address
+ *   word 24: number of dumped RAM words (n)
+ *   words 25..: n RAM words
+ */
+
+#define STATE_DUMP_MAGIC   0x53323343u /* "C32S" */
+#define STATE_DUMP_VERSION 1u
+
+/**
+ * @enum DumpFormat
+ * @brief Output formats understood by state_dump_write().
+ */
+typedef enum {
+    DUMP_NONE,     /**< Write nothing */
+    DUMP_TEXT,     /**< Human-readable listing */
+    DUMP_JSON,     /**< One JSON object on a single line */
+    DUMP_BINARY    /**< Fixed little-endian layout described above */
+} DumpFormat;
+
+/**
+ * @brief Parse "none", "text", "json" or "binary".
+ *
+ * @return false (with an error logged) for anything else.
+ */
+bool dump_format_parse(const char *name, DumpFormat *format);
+
+/**
+ * @brief Write CPU state and the RAM words in [ram_start, ram_end).
+ *
+ * @param out Destination stream (opened in binary mode for DUMP_BINARY).
+ * @param format Output format.
+ * @param label Name of the run (e.g. the input file) for text/JSON; may be NULL.
+ * @param engine Engine name for text/JSON; may be NULL.
+ * @param cpu Final CPU state.
+ * @param ram RAM to dump from; may be NULL when the range is empty.
+ * @param ram_start First RAM address to include.
+ * @param ram_end One past the last RAM address (clamped to RAM_SIZE).
+ * @return false on a write error.
+ */
+bool state_dump_write(FILE *out, DumpFormat format, const char *label, const char *engine, const CPU *cpu,
+                      const RAM *ram, uint32_t ram_start, uint32_t ram_end);
+
+#endif //INC_8BIT_CPU_EMULATOR_STATE_DUMP_H
@@ -0,0 +1,118 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_TIMETRAVEL_H
+#define INC_8BIT_CPU_EMULATOR_TIMETRAVEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "assembler.h"
+#include "cpu.h"
+#include "ram.h"
+
+/**
+ * @file timetravel.h
+ * @brief Reverse execution through periodic checkpoints and re-execution.
+ *
+ * A TimeTravel session drives a CPU and RAM owned by the caller. Forward
+ * execution runs the predecoding engine in slices of `interval`
+ * instructions (cpu_continue()); at the end of each slice it saves a
+ * checkpoint: the CPU state and a copy of the RAM pages the slice stored
+ * to, found through the RAM's dirty-page bits. The first checkpoint holds
+ * all of RAM. Since execution is deterministic, the state at any earlier
+ * instruction is the nearest checkpoint before it plus re-executing the
+ * difference, which is how tt_seek(), tt_step_back() and
+ * tt_last_write() work; nothing is recorded per instruction.
+ *
+ * Checkpoint memory is bounded by `memory_limit`: when it is exceeded,
+ * every other checkpoint is merged into its successor and the interval
+ * doubles, so old history gets coarser instead of being dropped.
+ *
+ * The session clears the RAM's dirty bits at each checkpoint, so it must
+ * be the only user of them while it runs.
+ */
+
+/** Default slice length between checkpoints, in instructions. */
+#define TT_DEFAULT_INTERVAL (1u << 20)
+
+/** Default bound on checkpoint memory, in bytes. */
+#define TT_DEFAULT_MEMORY_LIMIT (64u << 20)
+
+/** Opaque time-travel session. */
+typedef struct TimeTravel TimeTravel;
+
+/**
+ * @struct TimeTravelStats
+ * @brief Current history size.
+ */
+typedef struct {
+    uint32_t checkpoints;        /**< Checkpoints kept, the initial one included */
+    size_t bytes;                /**< Memory held by checkpoints */
+    uint64_t interval;           /**< Current slice length in instructions */
+    uint64_t furthest;           /**< Highest instruction count reached so far */
+} TimeTravelStats;
+
+/**
+ * @brief Start a session at the beginning of `range`.
+ *
+ * Moves the PC to range.start_address, marks the CPU running and takes
+ * the initial checkpoint of `cpu` and all of `ram`.
+ *
+ * @param interval Instructions between checkpoints (0 = TT_DEFAULT_INTERVAL).
+ * @param memory_limit Checkpoint memory bound in bytes (0 = TT_DEFAULT_MEMORY_LIMIT).
+ * @return The session, or NULL (with an error logged) if memory runs out.
+ */
+TimeTravel *tt_create(CPU *cpu, RAM *ram, AssemblyRange range, uint64_t interval, size_t memory_limit);
+
+/**
+ * @brief Release the session (the CPU and RAM stay as they are). NULL is ignored.
+ */
+void tt_destroy(TimeTravel *tt);
+
+/**
+ * @brief Run forward, taking checkpoints on the way.
+ *
+ * @param max_instructions Stop after this many instructions (0 = until the program stops).
+ * @return Why the run ended (CPU_STOP_LIMIT when `max_instructions` ran out).
+ */
+CpuStopReason tt_run(TimeTravel *tt, uint64_t max_instructions);
+
+/**
+ * @brief Move to the state before instruction number `instruction` executes.
+ *
+ * Going back restores the nearest checkpoint and re-executes forward;
+ * going forward simply runs.
+ *
+ * @return false if the program stops before reaching `instruction`
+ *         (the machine is then left where it stopped).
+ */
+bool tt_seek(TimeTravel *tt, uint64_t instruction);
+
+/**
+ * @brief Undo the last `count` instructions (clamped at the start of the run).
+ */
+void tt_step_back(TimeTravel *tt, uint64_t count);
+
+/**
+ * @brief Go back to the most recent STOREM to `address`.
+ *
+ * Slices whose checkpoints show the address's page untouched are skipped
+ * without re-executing them; the others are replayed one instruction at
+ * a time. On success the machine is left just before the store, so the
+ * next instruction to execute is the store itself.
+ *
+ * @param instruction Receives the instruction number of the store.
+ * @return false if no earlier instruction stored to `address`; the machine
+ *         is then back where it was.
+ */
+bool tt_last_write(TimeTravel *tt, uint32_t address, uint64_t *instruction);
+
+/**
+ * @brief Current history size.
+ */
+void tt_stats(const TimeTravel *tt, TimeTravelStats *stats);
+
+#endif //INC_8BIT_CPU_EMULATOR_TIMETRAVEL_H
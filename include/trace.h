@@ -0,0 +1,268 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#ifndef INC_8BIT_CPU_EMULATOR_TRACE_H
+#define INC_8BIT_CPU_EMULATOR_TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "assembler.h"
+#include "cpu.h"
+#include "encoding.h"
+#include "ram.h"
+
+/**
+ * @file trace.h
+ * @brief Compact binary execution traces: recorder, reader and replayer.
+ *
+ * A trace holds the initial machine state and only what cannot be
+ * recomputed cheaply: the outcome of every conditional branch and every
+ * memory write. Everything else (PCs, register values) follows from
+ * re-executing the instructions, which is how trace_replay_step()
+ * reconstructs the full per-instruction state and checks it against the
+ * recorded events.
+ *
+ * File layout. The header is made of 32-bit little-endian words:
+ *   TRACE_MAGIC ("C32T"), TRACE_VERSION, flags (TRACE_FLAG_PACKED),
+ *   start and end address of the program range, initial PC,
+ *   MAX_REGISTERS registers, MAX_ADDRESS_REGISTERS address registers,
+ *   CPU flags (bit 0 zero, bit 1 negative), segment count, then per
+ *   segment its address, word count and words (every non-zero run of the
+ *   initial RAM).
+ * The events follow as a byte stream; integers are LEB128 varints and
+ * signed deltas are zigzag-encoded:
+ *   TRACE_TAG_BRANCHES count, ceil(count / 8) bytes of outcomes (bit i of
+ *                      the stream = i-th branch, 1 = taken)
+ *   TRACE_TAG_WRITE    address - previous write address,
+ *                      value - previous written value
+ *   TRACE_TAG_END      stop reason, instructions retired during the
+ *                      recorded run, final PC
+ *
+ * The recorder buffers events in memory and packs up to 64 branch
+ * outcomes per record, so the hot path is a shift and an OR per branch
+ * and a few bytes per store.
+ */
+
+#define TRACE_MAGIC         0x54323343u /* "C32T" */
+#define TRACE_VERSION       1u
+#define TRACE_FLAG_PACKED   0x00000001u
+
+#define TRACE_TAG_BRANCHES  0x01u
+#define TRACE_TAG_WRITE     0x02u
+#define TRACE_TAG_END       0x03u
+
+/** Bytes buffered by the recorder before they are written to the file. */
+#define TRACE_BUFFER_SIZE   (1u << 16)
+
+/** Room kept free in the buffer for one event (a tag and up to three varints). */
+#define TRACE_EVENT_MAX     32u
+
+/**
+ * @struct TraceWriter
+ * @brief Buffered trace recorder.
+ */
+typedef struct {
+    FILE *file;
+    uint8_t *buffer;             /**< TRACE_BUFFER_SIZE bytes */
+    size_t used;
+    uint64_t bits;               /**< Pending branch outcomes, oldest in bit 0 */
+    uint32_t bit_count;
+    uint32_t last_address;       /**< Previous write, the base of the next delta */
+    uint32_t last_value;
+    uint64_t base_instructions;  /**< instructions_retired when the trace was opened */
+    uint64_t branches;           /**< Branch outcomes recorded */
+    uint64_t writes;             /**< Writes recorded */
+    uint64_t bytes;              /**< Bytes written to the file so far */
+    bool failed;                 /**< An I/O error occurred; later output is dropped */
+} TraceWriter;
+
+/**
+ * @brief Create `path` and write the header: `range`, the CPU registers and flags and the non-zero RAM.
+ *
+ * The recorded run is expected to start at `range.start_address`, as every
+ * engine does.
+ *
+ * @return false (with an error logged) if the file cannot be written.
+ */
+bool trace_writer_open(TraceWriter *writer, const char *path, const CPU *cpu, const RAM *ram, AssemblyRange range);
+
+/**
+ * @brief Write the buffered bytes to the file (not the pending branch bits).
+ */
+void trace_writer_drain(TraceWriter *writer);
+
+/**
+ * @brief Emit the pending branch outcomes as one record.
+ */
+void trace_flush_branches(TraceWriter *writer);
+
+/**
+ * @brief Append an unsigned LEB128 varint; the caller guarantees the space.
+ */
+static inline void trace_put_varint(TraceWriter *writer, uint64_t value) {
+    while (value >= 0x80) {
+        writer->buffer[writer->used++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    writer->buffer[writer->used++] = (uint8_t)value;
+}
+
+/**
+ * @brief Record the outcome of one conditional branch.
+ */
+static inline void trace_branch(TraceWriter *writer, bool taken) {
+    writer->bits |= (uint64_t)taken << writer->bit_count;
+    if (++writer->bit_count == 64)
+        trace_flush_branches(writer);
+}
+
+/**
+ * @brief Record a store of `value` to `address`.
+ */
+static inline void trace_store(TraceWriter *writer, uint32_t address, uint32_t value) {
+    if (writer->bit_count)
+        trace_flush_branches(writer);
+    if (writer->used > TRACE_BUFFER_SIZE - TRACE_EVENT_MAX)
+        trace_writer_drain(writer);
+    int32_t address_delta = (int32_t)(address - writer->last_address);
+    int32_t value_delta = (int32_t)(value - writer->last_value);
+    writer->buffer[writer->used++] = TRACE_TAG_WRITE;
+    trace_put_varint(writer, ((uint32_t)address_delta << 1) ^ (uint32_t)(address_delta >> 31));
+    trace_put_varint(writer, ((uint32_t)value_delta << 1) ^ (uint32_t)(value_delta >> 31));
+    writer->last_address = address;
+    writer->last_value = value;
+    writer->writes++;
+}
+
+/**
+ * @brief Write the END record from `cpu`, flush everything and close the file.
+ *
+ * @return false (with an error logged) if any write failed.
+ */
+bool trace_writer_close(TraceWriter *writer, const CPU *cpu);
+
+/**
+ * @enum TraceEventKind
+ * @brief Events delivered by trace_reader_next().
+ */
+typedef enum {
+    TRACE_EVENT_BRANCH,          /**< One conditional branch outcome */
+    TRACE_EVENT_WRITE,           /**< One store */
+    TRACE_EVENT_END,             /**< End of the run */
+    TRACE_EVENT_ERROR            /**< Truncated or malformed stream */
+} TraceEventKind;
+
+/**
+ * @struct TraceEvent
+ * @brief One decoded event.
+ */
+typedef struct {
+    TraceEventKind kind;
+    bool taken;                  /**< BRANCH */
+    uint32_t address;            /**< WRITE */
+    uint32_t value;              /**< WRITE */
+    CpuStopReason stop;          /**< END */
+    uint64_t instructions;       /**< END */
+    uint32_t pc;                 /**< END */
+} TraceEvent;
+
+/**
+ * @struct TraceReader
+ * @brief Sequential reader of a trace file.
+ */
+typedef struct {
+    FILE *file;
+    uint8_t *buffer;             /**< TRACE_BUFFER_SIZE bytes */
+    size_t used;
+    size_t position;
+    uint64_t bits;               /**< Outcomes left in the current branch record, next in bit 0 */
+    uint32_t bits_left;
+    uint64_t record_bits_left;   /**< Outcomes of the current record not yet loaded into `bits` */
+    uint32_t last_address;
+    uint32_t last_value;
+    bool ended;                  /**< END was delivered */
+} TraceReader;
+
+/**
+ * @brief Open a trace and load its initial state.
+ *
+ * @param ram Receives the initial RAM (every other word zero).
+ * @param cpu Receives the initial CPU (running, PC at the recorded start).
+ * @param range Receives the program range and encoding.
+ * @return false (with an error logged) on an I/O error or a bad header.
+ */
+bool trace_reader_open(TraceReader *reader, const char *path, RAM *ram, CPU *cpu, AssemblyRange *range);
+
+/**
+ * @brief Decode the next event. After END or ERROR the same kind is returned again.
+ */
+TraceEventKind trace_reader_next(TraceReader *reader, TraceEvent *event);
+
+/**
+ * @brief Close the file and free the buffer.
+ */
+void trace_reader_close(TraceReader *reader);
+
+/**
+ * @enum TraceStepStatus
+ * @brief Outcome of trace_replay_step().
+ */
+typedef enum {
+    TRACE_STEP_OK,               /**< One instruction executed and matched the trace */
+    TRACE_STEP_END,              /**< The recorded run ended here (see TraceReplay::end) */
+    TRACE_STEP_DIVERGED,         /**< Re-execution disagrees with the trace */
+    TRACE_STEP_ERROR             /**< The trace is truncated or malformed */
+} TraceStepStatus;
+
+/**
+ * @struct TraceStep
+ * @brief What one replayed instruction did.
+ */
+typedef struct {
+    uint64_t index;              /**< Instructions retired before it */
+    uint32_t pc;
+    DecodedInstruction insn;
+    bool decoded;                /**< false if the PC held no valid instruction */
+    bool branch;                 /**< Conditional branch... */
+    bool taken;                  /**< ...and its outcome */
+    bool wrote;                  /**< Store... */
+    uint32_t address;            /**< ...to this address... */
+    uint32_t value;              /**< ...of this value */
+} TraceStep;
+
+/**
+ * @struct TraceReplay
+ * @brief Re-execution of a trace, checked event by event.
+ */
+typedef struct {
+    TraceReader reader;
+    RAM *ram;                    /**< Current memory (owned) */
+    CPU cpu;                     /**< Current CPU state */
+    AssemblyRange range;
+    TraceEvent next;             /**< Next unconsumed event */
+    TraceEvent end;              /**< The END event, once reached */
+} TraceReplay;
+
+/**
+ * @brief Open a trace for replay.
+ *
+ * @return false (with an error logged) if it cannot be read.
+ */
+bool trace_replay_open(TraceReplay *replay, const char *path);
+
+/**
+ * @brief Execute the next instruction and check it against the trace.
+ *
+ * On TRACE_STEP_DIVERGED the reason is logged as an error.
+ */
+TraceStepStatus trace_replay_step(TraceReplay *replay, TraceStep *step);
+
+/**
+ * @brief Release the replay.
+ */
+void trace_replay_close(TraceReplay *replay);
+
+#endif //INC_8BIT_CPU_EMULATOR_TRACE_H
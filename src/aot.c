@@ -0,0 +1,434 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "aot.h"
+
+#include <dlfcn.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "cfg.h"
+#include "encoding.h"
+#include "log.h"
+
+extern char **environ;
+
+/**
+ * @brief Read the monotonic clock in nanoseconds.
+ */
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Emit a statement that stops the program with a fault.
+ *
+ * Blocks add their whole instruction count to `retired` on entry, so a
+ * fault gives back the instructions that did not complete (`undo`).
+ */
+static void emit_fault(FILE *out, uint32_t pc, AotStatus status, uint32_t undo) {
+    fprintf(out, "    FAULT(0x%08Xu, %u, %u);\n", pc, (unsigned)status, undo);
+}
+
+/**
+ * @brief Emit a transfer of control to `block`, or to the exit when CFG_NONE.
+ */
+static void emit_goto(FILE *out, const ControlFlowGraph *cfg, uint32_t block) {
+    if (block == CFG_NONE)
+        fprintf(out, "{ *pc = 0x%08Xu; goto done; }\n", cfg->range.end_address);
+    else
+        fprintf(out, "goto L_%08X;\n", cfg->blocks[block].start_address);
+}
+
+/**
+ * @brief Emit the source operand of an ALU instruction, or a fault.
+ *
+ * @return false if a fault was emitted instead (the operand is unusable).
+ */
+static bool emit_alu_source(FILE *out, const DecodedInstruction *insn, uint32_t pc, uint32_t undo,
+                            char *src, size_t size) {
+    if (insn->mode == OPERAND_REGISTER) {
+        if (insn->operand >= MAX_REGISTERS) {
+            emit_fault(out, pc, AOT_STATUS_BAD_REGISTER, undo);
+            return false;
+        }
+        snprintf(src, size, "r%u", insn->operand);
+        return true;
+    }
+    if (insn->mode == OPERAND_NUMERIC) {
+        snprintf(src, size, "0x%08Xu", insn->operand);
+        return true;
+    }
+    emit_fault(out, pc, AOT_STATUS_BAD_MODE, undo);
+    return false;
+}
+
+/**
+ * @brief Emit the C address expression of a LOADM/STOREM operand, or a fault.
+ *
+ * Any mode other than ADDR_LITERAL is register-indirect, as in cpu_run().
+ *
+ * @return false if a fault was emitted instead.
+ */
+static bool emit_memory_address(FILE *out, const DecodedInstruction *insn, uint32_t pc, uint32_t undo,
+                                char *addr, size_t size) {
+    if (insn->mode == ADDR_LITERAL) {
+        if (insn->operand >= RAM_SIZE) {
+            emit_fault(out, pc, AOT_STATUS_BAD_LITERAL, undo);
+            return false;
+        }
+        snprintf(addr, size, "0x%08Xu", insn->operand);
+        return true;
+    }
+    if (insn->operand >= MAX_ADDRESS_REGISTERS) {
+        emit_fault(out, pc, AOT_STATUS_BAD_AREGISTER, undo);
+        return false;
+    }
+    fprintf(out, "    if (a%u >= %uu) FAULT(0x%08Xu, %u, %u);\n",
+            insn->operand, RAM_SIZE, pc, (unsigned)AOT_STATUS_BAD_ACCESS, undo);
+    snprintf(addr, size, "a%u", insn->operand);
+    return true;
+}
+
+/**
+ * @brief Emit one non-control-flow instruction.
+ *
+ * @param undo Instructions of the block not completed if this one faults.
+ */
+static void emit_instruction(FILE *out, const DecodedInstruction *insn, uint32_t pc, uint32_t undo) {
+    char operand[32];
+    uint32_t op = insn->opcode;
+
+    if (op == ISA_LOADA) {
+        if (insn->reg >= MAX_ADDRESS_REGISTERS)
+            emit_fault(out, pc, AOT_STATUS_BAD_AREGISTER, undo);
+        else if (insn->operand >= RAM_SIZE)
+            emit_fault(out, pc, AOT_STATUS_BAD_LITERAL, undo);
+        else
+            fprintf(out, "    a%u = 0x%08Xu;\n", insn->reg, insn->operand);
+        return;
+    }
+
+    if (insn->reg >= MAX_REGISTERS) {
+        emit_fault(out, pc, AOT_STATUS_BAD_REGISTER, undo);
+        return;
+    }
+
+    switch (op) {
+        case ISA_LOADI:
+            fprintf(out, "    r%u = 0x%08Xu; zf = %d;\n", insn->reg, insn->operand, insn->operand == 0);
+            return;
+        case ISA_LOADM:
+            if (emit_memory_address(out, insn, pc, undo, operand, sizeof(operand)))
+                fprintf(out, "    r%u = mem[%s]; zf = r%u == 0;\n", insn->reg, operand, insn->reg);
+            return;
+        case ISA_STOREM:
+            if (emit_memory_address(out, insn, pc, undo, operand, sizeof(operand)))
+                fprintf(out, "    mem[%s] = r%u;\n", operand, insn->reg);
+            return;
+        case ISA_CMP:
+            if (insn->operand >= MAX_REGISTERS) {
+                emit_fault(out, pc, AOT_STATUS_BAD_REGISTER, undo);
+                return;
+            }
+            fprintf(out, "    zf = r%u == r%u; nf = (int32_t)(r%u - r%u) < 0;\n",
+                    insn->reg, insn->operand, insn->reg, insn->operand);
+            return;
+        default:
+            break;
+    }
+
+    if (!emit_alu_source(out, insn, pc, undo, operand, sizeof(operand)))
+        return;
+
+    const char *assign;
+    switch (op) {
+        case ISA_ADD: assign = "+="; break;
+        case ISA_SUB: assign = "-="; break;
+        case ISA_MLP: assign = "*="; break;
+        case ISA_AND: assign = "&="; break;
+        case ISA_OR:  assign = "|="; break;
+        case ISA_XOR: assign = "^="; break;
+        case ISA_DIV:
+            assign = "/=";
+            if (insn->mode == OPERAND_NUMERIC && insn->operand == 0) {
+                emit_fault(out, pc, AOT_STATUS_DIV_ZERO, undo);
+                return;
+            }
+            if (insn->mode == OPERAND_REGISTER)
+                fprintf(out, "    if (%s == 0) FAULT(0x%08Xu, %u, %u);\n",
+                        operand, pc, (unsigned)AOT_STATUS_DIV_ZERO, undo);
+            break;
+        default:
+            return;
+    }
+    fprintf(out, "    r%u %s %s; zf = r%u == 0;\n", insn->reg, assign, operand, insn->reg);
+}
+
+/**
+ * @brief Translate an assembled range into a C translation unit.
+ */
+bool aot_translate(const uint32_t *words, uint32_t limit, AssemblyRange range, const char *symbol, FILE *out) {
+    if (!out) {
+        log_write(LOG_ERROR, "AOT: output stream is NULL");
+        return false;
+    }
+    if (!symbol)
+        symbol = AOT_DEFAULT_SYMBOL;
+
+    ControlFlowGraph cfg;
+    if (!cfg_build(&cfg, words, limit, range)) {
+        cfg_free(&cfg);
+        return false;
+    }
+
+    bool *is_target = calloc(cfg.block_count ? cfg.block_count : 1, sizeof(bool));
+    if (!is_target) {
+        cfg_free(&cfg);
+        log_write(LOG_ERROR, "AOT: out of memory");
+        return false;
+    }
+    for (uint32_t b = 0; b < cfg.block_count; b++) {
+        if (isa_is_jump(cfg.blocks[b].terminator) && cfg.blocks[b].succ[0] != CFG_NONE)
+            is_target[cfg.blocks[b].succ[0]] = true;
+    }
+
+    fprintf(out, "/* Generated from [0x%08X, 0x%08X) (%s encoding, %u instructions). Do not edit. */\n",
+            range.start_address, range.end_address, encoding_name(range.encoding), cfg.insn_count);
+    fprintf(out, "#include <stdint.h>\n\n");
+    fprintf(out, "#define FAULT(addr, code, undo) do { retired -= (undo); *pc = (addr); status = (code); goto done; } while (0)\n\n");
+    fprintf(out, "uint32_t %s(uint32_t *regs, uint32_t *aregs, uint32_t *mem, uint8_t *flags,\n", symbol);
+    fprintf(out, "    uint64_t *retired_out, uint32_t *pc) {\n");
+    for (uint32_t i = 0; i < MAX_REGISTERS; i++)
+        fprintf(out, "    uint32_t r%u = regs[%u];\n", i, i);
+    for (uint32_t i = 0; i < MAX_ADDRESS_REGISTERS; i++)
+        fprintf(out, "    uint32_t a%u = aregs[%u];\n", i, i);
+    fprintf(out, "    uint32_t zf = flags[0], nf = flags[1];\n");
+    fprintf(out, "    uint64_t retired = 0;\n");
+    fprintf(out, "    uint32_t status = %u;\n\n", (unsigned)AOT_STATUS_END);
+
+    if (cfg.block_count == 0)
+        fprintf(out, "    *pc = 0x%08Xu;\n    goto done;\n", range.end_address);
+
+    for (uint32_t b = 0; b < cfg.block_count; b++) {
+        const BasicBlock *block = &cfg.blocks[b];
+        if (is_target[b])
+            fprintf(out, "L_%08X:\n", block->start_address);
+        fprintf(out, "    retired += %u;\n", block->insn_count);
+
+        for (uint32_t i = 0; i < block->insn_count; i++) {
+            uint32_t index = block->first_insn + i;
+            const DecodedInstruction *insn = &cfg.insns[index];
+            uint32_t pc = cfg.insn_addresses[index];
+            uint32_t undo = block->insn_count - i;
+
+            switch (insn->opcode) {
+                case ISA_HALT:
+                    fprintf(out, "    *pc = 0x%08Xu; status = %u; goto done;\n", pc, (unsigned)AOT_STATUS_HALT);
+                    break;
+                case ISA_JMP:
+                    fprintf(out, "    ");
+                    emit_goto(out, &cfg, block->succ[0]);
+                    break;
+                case ISA_JZ: case ISA_JNZ:
+                    fprintf(out, "    if (%szf) ", insn->opcode == ISA_JZ ? "" : "!");
+                    emit_goto(out, &cfg, block->succ[0]);
+                    if (block->succ[1] == CFG_NONE) {
+                        fprintf(out, "    ");
+                        emit_goto(out, &cfg, CFG_NONE);
+                    }
+                    break;
+                default:
+                    emit_instruction(out, insn, pc, undo);
+                    if (i + 1 == block->insn_count && block->succ[0] == CFG_NONE) {
+                        fprintf(out, "    ");
+                        emit_goto(out, &cfg, CFG_NONE);
+                    }
+                    break;
+            }
+        }
+    }
+
+    fprintf(out, "\ndone:\n");
+    for (uint32_t i = 0; i < MAX_REGISTERS; i++)
+        fprintf(out, "    regs[%u] = r%u;\n", i, i);
+    for (uint32_t i = 0; i < MAX_ADDRESS_REGISTERS; i++)
+        fprintf(out, "    aregs[%u] = a%u;\n", i, i);
+    fprintf(out, "    flags[0] = (uint8_t)zf;\n    flags[1] = (uint8_t)nf;\n");
+    fprintf(out, "    *retired_out += retired;\n");
+    fprintf(out, "    return status;\n}\n");
+
+    free(is_target);
+    cfg_free(&cfg);
+    if (ferror(out)) {
+        log_write(LOG_ERROR, "AOT: failed writing generated source");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Compile a generated C file into a shared object with the system compiler.
+ */
+bool aot_compile(const char *c_path, const char *so_path) {
+    if (!c_path || !so_path) {
+        log_write(LOG_ERROR, "AOT: compile failed: NULL path(s) provided");
+        return false;
+    }
+
+    const char *cc = getenv("CC");
+    if (!cc || cc[0] == '\0')
+        cc = "cc";
+
+    char *argv[] = {
+        (char *)cc, "-O2", "-shared", "-fPIC", "-o", (char *)so_path, (char *)c_path, NULL
+    };
+    pid_t pid;
+    int rc = posix_spawnp(&pid, cc, NULL, NULL, argv, environ);
+    if (rc != 0) {
+        log_write(LOG_ERROR, "AOT: unable to start compiler '%s': %s", cc, strerror(rc));
+        return false;
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        log_write(LOG_ERROR, "AOT: compiler '%s' failed on %s", cc, c_path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief dlopen() a compiled program and resolve its entry point.
+ */
+bool aot_load(AotModule *module, const char *so_path, const char *symbol, AssemblyRange range) {
+    if (!module || !so_path) {
+        log_write(LOG_ERROR, "AOT: load failed: NULL argument(s) provided");
+        return false;
+    }
+    *module = (AotModule){ .range = range };
+
+    void *handle = dlopen(so_path, RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        log_write(LOG_ERROR, "AOT: dlopen failed: %s", dlerror());
+        return false;
+    }
+
+    void *entry = dlsym(handle, symbol ? symbol : AOT_DEFAULT_SYMBOL);
+    if (!entry) {
+        log_write(LOG_ERROR, "AOT: symbol lookup failed: %s", dlerror());
+        dlclose(handle);
+        return false;
+    }
+
+    module->handle = handle;
+    module->entry = (AotProgramFn)entry;
+    return true;
+}
+
+/**
+ * @brief Translate, compile and load a range using a temporary directory.
+ */
+bool aot_build(AotModule *module, const uint32_t *words, uint32_t limit, AssemblyRange range,
+               uint64_t *compile_ns) {
+    char dir[] = "/tmp/aot_XXXXXX";
+    if (!mkdtemp(dir)) {
+        log_write(LOG_ERROR, "AOT: unable to create a temporary directory");
+        return false;
+    }
+    char c_path[sizeof(dir) + 16];
+    char so_path[sizeof(dir) + 16];
+    snprintf(c_path, sizeof(c_path), "%s/program.c", dir);
+    snprintf(so_path, sizeof(so_path), "%s/program.so", dir);
+
+    uint64_t t0 = now_ns();
+    bool ok = false;
+    FILE *f = fopen(c_path, "w");
+    if (!f) {
+        log_write(LOG_ERROR, "AOT: unable to create %s", c_path);
+    } else {
+        ok = aot_translate(words, limit, range, AOT_DEFAULT_SYMBOL, f);
+        ok = (fclose(f) == 0) && ok;
+        ok = ok && aot_compile(c_path, so_path);
+    }
+    if (compile_ns)
+        *compile_ns = now_ns() - t0;
+
+    ok = ok && aot_load(module, so_path, AOT_DEFAULT_SYMBOL, range);
+
+    /* The mapping outlives the file, so nothing needs to stay on disk. */
+    unlink(c_path);
+    unlink(so_path);
+    rmdir(dir);
+    return ok;
+}
+
+/**
+ * @brief Describe an AotStatus fault for the error log.
+ */
+static const char *fault_message(uint32_t status) {
+    switch (status) {
+        case AOT_STATUS_BAD_REGISTER: return "Invalid register index";
+        case AOT_STATUS_BAD_AREGISTER: return "Invalid address register index";
+        case AOT_STATUS_BAD_LITERAL: return "Invalid literal address";
+        case AOT_STATUS_BAD_ACCESS: return "Memory access out of bounds";
+        case AOT_STATUS_DIV_ZERO: return "Division by zero";
+        case AOT_STATUS_BAD_MODE: return "Invalid operand mode";
+        default: return "Unknown fault";
+    }
+}
+
+/**
+ * @brief Run a loaded program against a CPU/RAM pair.
+ */
+bool aot_run(const AotModule *module, CPU *cpu, RAM *ram) {
+    if (!module || !module->entry || !cpu || !ram) {
+        log_write(LOG_ERROR, "AOT: run failed: NULL argument(s) provided");
+        return false;
+    }
+
+    uint8_t flags[2] = { cpu->zero_flag, cpu->negative_flag };
+    uint32_t pc = module->range.start_address;
+    cpu->pc = pc;
+    cpu->running = true;
+
+    uint32_t status = module->entry(cpu->registers, cpu->address_registers, ram->cells, flags,
+                                    &cpu->instructions_retired, &pc);
+
+    cpu->pc = pc;
+    cpu->zero_flag = flags[0] != 0;
+    cpu->negative_flag = flags[1] != 0;
+
+    switch (status) {
+        case AOT_STATUS_END:
+            cpu->stop_reason = CPU_STOP_END;
+            return true;
+        case AOT_STATUS_HALT:
+            cpu->running = false;
+            cpu->stop_reason = CPU_STOP_HALT;
+            return true;
+        default:
+            cpu->running = false;
+            cpu->stop_reason = status == AOT_STATUS_DIV_ZERO ? CPU_STOP_DIV_ZERO : CPU_STOP_FAULT;
+            log_write(LOG_ERROR, "%s at PC 0x%08X", fault_message(status), pc);
+            return false;
+    }
+}
+
+/**
+ * @brief Unload a module loaded by aot_load()/aot_build().
+ */
+void aot_unload(AotModule *module) {
+    if (!module)
+        return;
+    if (module->handle)
+        dlclose(module->handle);
+    *module = (AotModule){ 0 };
+}
@@ -0,0 +1,318 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "asmgen.h"
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "encoding.h"
+#include "isa.h"
+#include "log.h"
+#include "ram.h"
+
+/** Registers the body may use; R7 is the outer loop counter. */
+#define GEN_REGISTERS 7
+/** Address registers pointed into the data region. */
+#define GEN_ADDRESS_REGISTERS 4
+/** Branches jump to one of the next GEN_BRANCH_REACH labels. */
+#define GEN_BRANCH_REACH 4
+
+/**
+ * @struct Generator
+ * @brief Per-call generator state (no globals, so generation is reentrant).
+ */
+typedef struct {
+    uint64_t rng;            /**< splitmix64 state */
+    FILE *out;
+    AsmGenStats stats;
+    uint32_t data_base;
+    uint32_t memory_words;
+} Generator;
+
+/**
+ * @brief splitmix64: small, fast and good enough for program shapes.
+ */
+static uint64_t gen_next(Generator *gen) {
+    uint64_t z = (gen->rng += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Uniform value in [0, bound).
+ */
+static uint32_t gen_below(Generator *gen, uint32_t bound) {
+    return (uint32_t)(((gen_next(gen) >> 32) * (uint64_t)bound) >> 32);
+}
+
+/**
+ * @brief Uniform value in [0, 1).
+ */
+static double gen_unit(Generator *gen) {
+    return (double)(gen_next(gen) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static uint32_t gen_register(Generator *gen) {
+    return gen_below(gen, GEN_REGISTERS);
+}
+
+static uint32_t gen_data_address(Generator *gen) {
+    return gen->data_base + gen_below(gen, gen->memory_words);
+}
+
+/**
+ * @brief Write one instruction line and account for its size.
+ */
+static void gen_emit(Generator *gen, uint32_t opcode, bool has_immediate, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+static void gen_emit(Generator *gen, uint32_t opcode, bool has_immediate, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    fputs("    ", gen->out);
+    vfprintf(gen->out, fmt, args);
+    fputc('\n', gen->out);
+    va_end(args);
+    gen->stats.instructions++;
+    gen->stats.wide_words += instruction_length(opcode, has_immediate, ENCODING_WIDE);
+}
+
+static void gen_label(Generator *gen, const char *name) {
+    fprintf(gen->out, "%s:\n", name);
+    gen->stats.labels++;
+}
+
+/**
+ * @brief Write a forward branch to one of the next few labels (or `tail`).
+ */
+static void gen_branch(Generator *gen, uint32_t next_label, uint32_t label_count) {
+    uint32_t target = next_label + gen_below(gen, GEN_BRANCH_REACH);
+    char name[16];
+    if (target < label_count)
+        snprintf(name, sizeof(name), "L%u", target);
+    else
+        snprintf(name, sizeof(name), "tail");
+
+    uint32_t kind = gen_below(gen, 8);
+    if (kind == 0)
+        gen_emit(gen, ISA_JMP, false, "JMP %s", name);
+    else if (kind & 1)
+        gen_emit(gen, ISA_JZ, false, "JZ %s", name);
+    else
+        gen_emit(gen, ISA_JNZ, false, "JNZ %s", name);
+    gen->stats.branches++;
+}
+
+/**
+ * @brief Write one non-branch instruction drawn from the configured mix.
+ */
+static void gen_instruction(Generator *gen, const AsmGenMix *mix, uint32_t total_weight) {
+    static const char *const ALU_OPS[] = { "ADD", "SUB", "AND", "OR", "XOR" };
+    static const uint32_t ALU_OPCODES[] = { ISA_ADD, ISA_SUB, ISA_AND, ISA_OR, ISA_XOR };
+
+    uint32_t pick = gen_below(gen, total_weight);
+    uint32_t dst = gen_register(gen);
+    bool immediate = gen_below(gen, 2) == 0;
+
+    if (pick < mix->alu) {
+        uint32_t op = gen_below(gen, 5);
+        if (immediate)
+            gen_emit(gen, ALU_OPCODES[op], true, "%s R%u, %u", ALU_OPS[op], dst, gen_below(gen, 65536));
+        else
+            gen_emit(gen, ALU_OPCODES[op], false, "%s R%u, R%u", ALU_OPS[op], dst, gen_register(gen));
+        return;
+    }
+    pick -= mix->alu;
+
+    if (pick < mix->mul) {
+        if (immediate)
+            gen_emit(gen, ISA_MLP, true, "MLP R%u, %u", dst, 1 + gen_below(gen, 1000));
+        else
+            gen_emit(gen, ISA_MLP, false, "MLP R%u, R%u", dst, gen_register(gen));
+        return;
+    }
+    pick -= mix->mul;
+
+    if (pick < mix->div) {
+        gen_emit(gen, ISA_DIV, true, "DIV R%u, %u", dst, 1 + gen_below(gen, 255));
+        return;
+    }
+    pick -= mix->div;
+
+    if (pick < mix->load) {
+        if (immediate) {
+            gen_emit(gen, ISA_LOADM, true, "LOADM R%u, (0x%04X)", dst, gen_data_address(gen));
+        } else {
+            uint32_t areg = gen_below(gen, GEN_ADDRESS_REGISTERS);
+            /* Re-point the address register now and then so (An) accesses spread over the region. */
+            if (gen_below(gen, 4) == 0)
+                gen_emit(gen, ISA_LOADA, false, "LOADA A%u, 0x%04X", areg, gen_data_address(gen));
+            gen_emit(gen, ISA_LOADM, false, "LOADM R%u, (A%u)", dst, areg);
+        }
+        gen->stats.loads++;
+        return;
+    }
+    pick -= mix->load;
+
+    if (pick < mix->store) {
+        if (immediate)
+            gen_emit(gen, ISA_STOREM, true, "STOREM (0x%04X), R%u", gen_data_address(gen), dst);
+        else
+            gen_emit(gen, ISA_STOREM, false, "STOREM (A%u), R%u", gen_below(gen, GEN_ADDRESS_REGISTERS), dst);
+        gen->stats.stores++;
+        return;
+    }
+    pick -= mix->store;
+
+    if (pick < mix->cmp) {
+        gen_emit(gen, ISA_CMP, false, "CMP R%u, R%u", dst, gen_register(gen));
+        return;
+    }
+
+    gen_emit(gen, ISA_LOADI, false, "LOADI R%u, 0x%08X", dst, (uint32_t)gen_next(gen));
+}
+
+/**
+ * @brief Fill a configuration with the defaults used by the `asmgen` tool.
+ */
+void asmgen_default_config(AsmGenConfig *config) {
+    memset(config, 0, sizeof(*config));
+    config->seed = 1;
+    config->instructions = 4096;
+    config->labels = 256;
+    config->branch_density = 0.10;
+    config->memory_words = 4096;
+    config->data_base = 0;
+    config->iterations = 256;
+    config->origin = 0;
+    config->mix = (AsmGenMix){ .alu = 40, .mul = 5, .div = 3, .load = 15, .store = 10, .cmp = 10, .loadi = 7 };
+}
+
+/**
+ * @brief Write a program described by `config` to `out`.
+ */
+bool asmgen_write(const AsmGenConfig *config, FILE *out, AsmGenStats *stats) {
+    if (!config || !out) {
+        log_write(LOG_ERROR, "asmgen: NULL argument(s) provided");
+        return false;
+    }
+
+    const AsmGenMix *mix = &config->mix;
+    uint32_t total_weight = mix->alu + mix->mul + mix->div + mix->load + mix->store + mix->cmp + mix->loadi;
+    uint32_t data_base = config->data_base ? config->data_base : RAM_SIZE - config->memory_words;
+
+    if (config->instructions == 0 || config->iterations == 0) {
+        log_write(LOG_ERROR, "asmgen: instructions and iterations must be at least 1");
+        return false;
+    }
+    if (config->memory_words == 0 || config->memory_words > RAM_SIZE
+        || (uint64_t)data_base + config->memory_words > RAM_SIZE) {
+        log_write(LOG_ERROR, "asmgen: data region 0x%X + %u words does not fit in RAM", data_base,
+                  config->memory_words);
+        return false;
+    }
+    if (!(config->branch_density >= 0.0 && config->branch_density <= 1.0)) {
+        log_write(LOG_ERROR, "asmgen: branch density must be between 0 and 1");
+        return false;
+    }
+    if (total_weight == 0 && config->branch_density < 1.0) {
+        log_write(LOG_ERROR, "asmgen: instruction mix has no nonzero weight");
+        return false;
+    }
+
+    Generator gen = { .rng = config->seed, .out = out, .data_base = data_base,
+                      .memory_words = config->memory_words };
+    memset(&gen.stats, 0, sizeof(gen.stats));
+
+    fprintf(out, "; asmgen seed=%llu instructions=%u labels=%u branch_density=%.3f memory=%u@0x%04X iterations=%u\n",
+            (unsigned long long)config->seed, config->instructions, config->labels, config->branch_density,
+            config->memory_words, data_base, config->iterations);
+    fprintf(out, ".org 0x%04X\n", config->origin);
+    gen_label(&gen, "main");
+    gen_emit(&gen, ISA_LOADI, false, "LOADI R7, %u", config->iterations);
+    for (uint32_t a = 0; a < GEN_ADDRESS_REGISTERS; a++)
+        gen_emit(&gen, ISA_LOADA, false, "LOADA A%u, 0x%04X", a, gen_data_address(&gen));
+    uint64_t prologue = gen.stats.instructions;
+    gen_label(&gen, "outer");
+
+    uint32_t next_label = 0;
+    for (uint32_t i = 0; i < config->instructions; i++) {
+        while (next_label < config->labels
+               && (uint64_t)next_label * config->instructions / config->labels == i) {
+            fprintf(out, "L%u:\n", next_label++);
+            gen.stats.labels++;
+        }
+        if (gen_unit(&gen) < config->branch_density)
+            gen_branch(&gen, next_label, config->labels);
+        else
+            gen_instruction(&gen, mix, total_weight);
+    }
+    /* With more labels than instructions the remainder land on the tail. */
+    while (next_label < config->labels) {
+        fprintf(out, "L%u:\n", next_label++);
+        gen.stats.labels++;
+    }
+    uint64_t body = gen.stats.instructions - prologue;
+
+    gen_label(&gen, "tail");
+    gen_emit(&gen, ISA_SUB, true, "SUB R7, 1");
+    gen_emit(&gen, ISA_JNZ, false, "JNZ outer");
+    gen_emit(&gen, ISA_HALT, false, "HALT");
+
+    gen.stats.dynamic_upper = prologue + (uint64_t)config->iterations * (body + 2) + 1;
+
+    if (config->origin + gen.stats.wide_words > data_base && config->origin < data_base + config->memory_words)
+        log_write(LOG_WARN, "asmgen: program (%llu words) overlaps the data region at 0x%04X; "
+                  "it can be assembled but not executed",
+                  (unsigned long long)gen.stats.wide_words, data_base);
+
+    if (stats)
+        *stats = gen.stats;
+    if (ferror(out)) {
+        log_write(LOG_ERROR, "asmgen: write error");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse a mix specification such as "alu=40,mul=5,div=0".
+ */
+bool asmgen_parse_mix(const char *spec, AsmGenMix *mix) {
+    struct { const char *name; uint32_t *weight; } classes[] = {
+        { "alu", &mix->alu }, { "mul", &mix->mul }, { "div", &mix->div }, { "load", &mix->load },
+        { "store", &mix->store }, { "cmp", &mix->cmp }, { "loadi", &mix->loadi },
+    };
+
+    const char *p = spec;
+    while (*p) {
+        const char *eq = strchr(p, '=');
+        if (!eq) {
+            log_write(LOG_ERROR, "asmgen: expected class=weight in mix '%s'", spec);
+            return false;
+        }
+        size_t len = (size_t)(eq - p);
+        uint32_t *weight = NULL;
+        for (size_t c = 0; c < sizeof(classes) / sizeof(classes[0]); c++) {
+            if (strlen(classes[c].name) == len && strncmp(classes[c].name, p, len) == 0)
+                weight = classes[c].weight;
+        }
+        if (!weight) {
+            log_write(LOG_ERROR, "asmgen: unknown instruction class '%.*s'", (int)len, p);
+            return false;
+        }
+        char *end = NULL;
+        unsigned long value = strtoul(eq + 1, &end, 10);
+        if (end == eq + 1 || (*end != ',' && *end != '\0') || value > 1000000) {
+            log_write(LOG_ERROR, "asmgen: bad weight for '%.*s'", (int)len, p);
+            return false;
+        }
+        *weight = (uint32_t)value;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return true;
+}
@@ -6,6 +6,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include "assembler.h"
+#include "encoding.h"
 
 #include <stdarg.h>
 #include <errno.h>
@@ -24,6 +25,7 @@ static void initialize_assembly(AssemblyRange *range) {
     range->start_address = 0;
     range->end_address = 0;
     range->error = false;
+    range->encoding = ENCODING_WIDE;
 }
 
 /**
@@ -45,22 +47,90 @@ static AssemblyRange assemble_error(FILE *file) {
     range.start_address = 0;
     range.end_address = 0;
     range.error = true;
+    range.encoding = ENCODING_WIDE;
     return range;
 }
 
 /**
- * @brief Emit a 32-bit word into RAM at the CPU's current PC and increment PC.
+ * @brief Release the two-pass assembler's working state and signal an error.
  *
- * This helper centralizes writing a value into RAM and advancing the
- * program counter. It expects `ram` and `cpu` to be valid and that CPU's
- * `pc` points to a writable location in `ram->cells`.
+ * @param lines Source lines read by assemble_into() (freed along with the array).
+ * @param lines_count Number of entries in `lines`.
+ * @param labels Label table to release.
+ * @param file Source file to close; may be NULL.
+ * @return AssemblyRange with `error == true`.
+ */
+static AssemblyRange assemble_abort(char **lines, size_t lines_count, LabelTable *labels, FILE *file) {
+    for (size_t j = 0; j < lines_count; ++j) free(lines[j]);
+    free(lines);
+    label_table_free(labels);
+    return assemble_error(file);
+}
+
+/**
+ * @struct Emitter
+ * @brief Write cursor over the caller-provided output buffer.
+ *
+ * All assembler state lives on the stack of a single assemble_into() call,
+ * so independent files can be assembled concurrently from different threads
+ * as long as each call gets its own output buffer.
+ */
+typedef struct {
+    uint32_t *words;    /**< Output buffer indexed by absolute word address */
+    uint32_t capacity;  /**< Number of words available in `words` */
+    uint32_t pc;        /**< Address of the next word to be written */
+    bool overflow;      /**< Set when an emit fell outside the buffer */
+    InstructionEncoding encoding; /**< Layout used by emit_instruction() */
+} Emitter;
+
+/**
+ * @brief Emit a 32-bit word at the emitter's cursor and advance the cursor.
+ *
+ * This helper centralizes writing a value into the output buffer. Writes
+ * past `capacity` are dropped and flag the emitter as overflowed so the
+ * caller can abort assembly instead of corrupting memory.
  *
- * @param ram Pointer to RAM to write into.
- * @param cpu Pointer to CPU whose PC will be updated.
- * @param value 32-bit value to write into the current PC slot.
+ * @param out Emitter to write into.
+ * @param value 32-bit value to write into the current cursor slot.
  */
-static void emit(RAM *ram, CPU *cpu, uint32_t value) {
-    ram->cells[cpu->pc++] = value;
+static void emit(Emitter *out, uint32_t value) {
+    if (out->pc >= out->capacity) {
+        if (!out->overflow) {
+            log_write(LOG_ERROR, "Assembled code exceeds output buffer at address 0x%08X", out->pc);
+        }
+        out->overflow = true;
+        out->pc++;
+        return;
+    }
+    out->words[out->pc++] = value;
+}
+
+/**
+ * @brief Encode one instruction in the emitter's encoding and emit its words.
+ *
+ * Field meanings follow DecodedInstruction (see encoding.h); the encoder
+ * takes care of the operand order of each layout (for example STOREM puts
+ * the address before the register in the wide layout).
+ *
+ * @param out Emitter to write into.
+ * @param opcode ISA opcode.
+ * @param reg Primary register field.
+ * @param mode AddrMode / OperandType, 0 where not applicable.
+ * @param operand Source register, immediate, address or jump target.
+ * @return true on success, false if the instruction cannot be encoded.
+ */
+static bool emit_instruction(Emitter *out, uint32_t opcode, uint32_t reg, uint32_t mode, uint32_t operand) {
+    DecodedInstruction insn = { .opcode = opcode, .reg = reg, .mode = mode, .operand = operand };
+    uint32_t words[4];
+    uint32_t count = encode_instruction(&insn, out->encoding, words);
+    if (count == 0) {
+        log_write(LOG_ERROR, "Unable to encode %s in %s encoding", opcode_mnemonic(opcode), encoding_name(out->encoding));
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        emit(out, words[i]);
+    }
+    return true;
 }
 
 /**
@@ -138,10 +208,9 @@ static bool require_all_not_failure(
  * @brief Handle generic arithmetic instruction (e.g., ADD, SUB, AND...).
  *
  * Parses two register operands, validates them and emits the opcode followed
- * by destination and source register indices into RAM.
+ * by destination and source register indices.
  *
- * @param ram Destination RAM.
- * @param cpu CPU context (used for emitting at cpu->pc).
+ * @param out Emitter receiving the encoded words.
  * @param line_num Source line number for logging.
  * @param opcode The numeric ISA opcode to emit.
  * @param op1 Destination operand text (e.g., "R0").
@@ -149,7 +218,7 @@ static bool require_all_not_failure(
  * @return true on success (operands parsed and emitted), false on error.
  */
 static bool handle_arithmetic_instruction(
-    RAM *ram, CPU *cpu,
+    Emitter *out,
     size_t line_num,
     uint32_t opcode,
     char *op1, char *op2
@@ -165,14 +234,13 @@ static bool handle_arithmetic_instruction(
         return false;
     }
 
-    int src_reg = parse_register(op2);
+    /* Only tokens starting with 'R' are register sources (same rule as the
+       sizing pass); anything else is an immediate and must not be reported
+       as a malformed register. */
+    int src_reg = op2 && op2[0] == 'R' ? parse_register(op2) : FAILURE;
     if (src_reg != FAILURE) {
-        /* Register-source encoding: opcode, dst, mode=OPERAND_REGISTER, operand=src_reg */
-        emit(ram, cpu, opcode);
-        emit(ram, cpu, (uint32_t)dst);
-        emit(ram, cpu, OPERAND_REGISTER);
-        emit(ram, cpu, (uint32_t)src_reg);
-        return true;
+        /* Register-source form: mode=OPERAND_REGISTER, operand=src_reg */
+        return emit_instruction(out, opcode, (uint32_t)dst, OPERAND_REGISTER, (uint32_t)src_reg);
     }
 
     /* Otherwise treat op2 as an immediate numeric value. Accept optional '#' prefix. */
@@ -198,11 +266,7 @@ static bool handle_arithmetic_instruction(
         }
     }
 
-    emit(ram, cpu, opcode);
-    emit(ram, cpu, (uint32_t)dst);
-    emit(ram, cpu, OPERAND_NUMERIC);
-    emit(ram, cpu, (uint32_t)sval);
-    return true;
+    return emit_instruction(out, opcode, (uint32_t)dst, OPERAND_NUMERIC, (uint32_t)sval);
 }
 
 /**
@@ -211,15 +275,14 @@ static bool handle_arithmetic_instruction(
  * Syntax: LOADI Rn, #imm   or LOADI Rn, imm
  * Emits:  ISA_LOADI, reg_index, immediate_value
  *
- * @param ram Destination RAM.
- * @param cpu CPU context for emitting.
+ * @param out Emitter receiving the encoded words.
  * @param line_num Source line (for logging).
  * @param op1 Destination register token.
  * @param op2 Immediate token (may start with '#').
  * @return true on success, false on parse error.
  */
 static bool handle_loadi_instruction(
-    RAM *ram, CPU *cpu,
+    Emitter *out,
     size_t line_num,
     char *op1, char *op2
 ) {
@@ -240,11 +303,7 @@ static bool handle_loadi_instruction(
 
     uint32_t imm = (uint32_t) strtol(op2, NULL, 0);
 
-    emit(ram, cpu, ISA_LOADI);
-    emit(ram, cpu, (uint32_t) register_index);
-    emit(ram, cpu, imm);
-
-    return true;
+    return emit_instruction(out, ISA_LOADI, (uint32_t) register_index, 0, imm);
 }
 
 /**
@@ -258,7 +317,7 @@ static bool handle_loadi_instruction(
  * validated before being emitted.
  */
 static bool handle_loada_instruction(
-    RAM *ram, CPU *cpu,
+    Emitter *out,
     size_t line_num,
     char *op1, char *op2
 ) {
@@ -288,11 +347,7 @@ static bool handle_loada_instruction(
         return false;
     }
 
-    emit(ram, cpu, ISA_LOADA);
-    emit(ram, cpu, (uint32_t)addr_reg);
-    emit(ram, cpu, (uint32_t)addr_lit);
-
-    return true;
+    return emit_instruction(out, ISA_LOADA, (uint32_t)addr_reg, 0, (uint32_t)addr_lit);
 }
 
 /**
@@ -307,7 +362,7 @@ static bool handle_loada_instruction(
  * and set `is_literal` accordingly.
  */
 static bool handle_loadm_instruction(
-    RAM *ram, CPU *cpu,
+    Emitter *out,
     size_t line_num,
     char *op1, char *op2
 ) {
@@ -345,12 +400,8 @@ static bool handle_loadm_instruction(
         }
     }
 
-    emit(ram, cpu, ISA_LOADM);
-    emit(ram, cpu, (uint32_t)register_index);
-    emit(ram, cpu, is_literal ? ADDR_LITERAL : ADDR_REGISTER);
-    emit(ram, cpu, (uint32_t)addr);
-
-    return true;
+    return emit_instruction(out, ISA_LOADM, (uint32_t)register_index,
+                            is_literal ? ADDR_LITERAL : ADDR_REGISTER, (uint32_t)addr);
 }
 
 /**
@@ -363,7 +414,7 @@ static bool handle_loadm_instruction(
  * and finally the register index to store.
  */
 static bool handle_storem_instruction(
-    RAM *ram, CPU *cpu,
+    Emitter *out,
     size_t line_num,
     char *op1, char *op2
 ) {
@@ -403,12 +454,8 @@ static bool handle_storem_instruction(
         }
     }
 
-    emit(ram, cpu, ISA_STOREM);
-    emit(ram, cpu, (uint32_t)addr);
-    emit(ram, cpu, is_literal ? ADDR_LITERAL : ADDR_REGISTER);
-    emit(ram, cpu, (uint32_t) register_index);
-
-    return true;
+    return emit_instruction(out, ISA_STOREM, (uint32_t) register_index,
+                            is_literal ? ADDR_LITERAL : ADDR_REGISTER, (uint32_t)addr);
 }
 
 /**
@@ -423,7 +470,7 @@ static bool handle_storem_instruction(
  * operands before emission.
  */
 static bool handle_cmp_instruction(
-    RAM *ram, CPU *cpu,
+    Emitter *out,
     size_t line_num,
     char *op1, char *op2
 ) {
@@ -452,11 +499,7 @@ static bool handle_cmp_instruction(
         return false;
     }
 
-    emit(ram, cpu, ISA_CMP);
-    emit(ram, cpu, (uint32_t)dst_index);
-    emit(ram, cpu, (uint32_t)src_index);
-
-    return true;
+    return emit_instruction(out, ISA_CMP, (uint32_t)dst_index, OPERAND_REGISTER, (uint32_t)src_index);
 }
 
 /**
@@ -464,15 +507,14 @@ static bool handle_cmp_instruction(
  *
  * This helper resolves the operand `op1` which may be a numeric literal
  * (0xNNNN) or a label name. On success it emits the opcode and resolved
- * address into RAM (using `emit`) and returns true.
+ * address into the output buffer (using `emit`) and returns true.
  */
 static bool handle_jmp_instructions(
-    RAM *ram, CPU *cpu,
+    Emitter *out,
     size_t line_num,
     int opcode,
     char *op1,
-    Label *labels,
-    size_t label_count
+    const LabelTable *labels
 ) {
     if (!require_one_operand(line_num, op1))
         return false;
@@ -482,7 +524,7 @@ static bool handle_jmp_instructions(
     if (op1[0] == '0' && (op1[1] == 'x' || op1[1] == 'X')) {
         addr = parse_address(op1, true);
     } else {
-        addr = find_label_addr(op1, labels, label_count);
+        addr = find_label_addr(op1, labels);
     }
 
     if (addr == FAILURE) {
@@ -490,57 +532,68 @@ static bool handle_jmp_instructions(
         return false;
     }
 
-    emit(ram, cpu, opcode);
-    emit(ram, cpu, (uint32_t)addr);
-    return true;
+    return emit_instruction(out, (uint32_t)opcode, 0, 0, (uint32_t)addr);
 }
 
 
 /**
- * @brief Assemble the source file into RAM.
+ * @brief Assemble an open source stream into a caller-provided word buffer.
  *
- * The assembler reads the source file line-by-line, strips whitespace and
+ * The assembler reads the source line-by-line, strips whitespace and
  * comments, handles directives (for example .org via parse_directive),
- * records labels, and emits opcodes and operands into `ram->cells` using
- * the CPU's `pc` as the write cursor.
+ * records labels, and emits opcodes and operands into `buffer` using a
+ * local write cursor. Words are placed at their absolute addresses, so a
+ * buffer of RAM_SIZE words mirrors the RAM layout exactly.
  *
- * This function performs two-pass style responsibilities in a single pass
- * for simplicity: it stores labels as they are encountered and emits code
- * immediately. The caller must provide an initialized `RAM` and `CPU`.
+ * The function keeps no global or static mutable state (tokenization uses
+ * strtok_r and the label table is owned by the call), so it is safe to call
+ * concurrently from several threads with distinct buffers.
  *
- * @param ram Pointer to initialized RAM where code will be written.
- * @param cpu CPU context used for program counter and label insertion.
- * @param file_path Path to assembly source to open.
+ * @param buffer Output buffer indexed by absolute word address.
+ * @param capacity Number of words available in `buffer`.
+ * @param file Source stream; always closed before returning.
+ * @param name Source name used in error messages.
+ * @param encoding Instruction layout to emit (see encoding.h).
+ * @param labels_out If non-NULL, receives the label table on success
+ *                   (otherwise it is released here).
  * @return AssemblyRange indicating the start and end addresses of the
  *         emitted code; on error the returned range has `error == true`.
  */
-AssemblyRange assemble(RAM *ram, CPU *cpu, const char *file_path) {
-    if (!ram || !cpu || !file_path) {
-        log_write(LOG_ERROR, "Assemble failed: NULL argument(s) provided");
-        return assemble_error(NULL);
-    }
-
-    FILE *file = fopen(file_path, "r");
-    if (!file) {
-        log_write(LOG_ERROR, "Unable to open assembly file: %s", file_path);
-        return assemble_error(NULL);
-    }
-
+static AssemblyRange assemble_stream(uint32_t *buffer, uint32_t capacity, FILE *file, const char *name,
+                                     InstructionEncoding encoding, LabelTable *labels_out) {
     AssemblyRange range;
     initialize_assembly(&range);
 
-    Label labels[MAX_LABELS];
-    size_t label_count = 0;
+    range.encoding = encoding;
+
+    Emitter out = { .words = buffer, .capacity = capacity, .pc = 0, .overflow = false, .encoding = encoding };
+
+    LabelTable labels;
+    label_table_init(&labels);
 
     size_t opcode_table_size = sizeof(opcode_table) / sizeof(opcode_table[0]);
 
     /* Read file lines into memory for two-pass processing */
     char **lines = NULL;
     size_t lines_count = 0;
+    size_t lines_capacity = 0;
     char buf[1024];
     while (fgets(buf, sizeof(buf), file)) {
-        lines = realloc(lines, sizeof(*lines) * (lines_count + 1));
+        if (lines_count == lines_capacity) {
+            size_t new_capacity = lines_capacity ? lines_capacity * 2 : 256;
+            char **grown = realloc(lines, sizeof(*lines) * new_capacity);
+            if (!grown) {
+                log_write(LOG_ERROR, "Out of memory reading %s", name);
+                return assemble_abort(lines, lines_count, &labels, file);
+            }
+            lines = grown;
+            lines_capacity = new_capacity;
+        }
         lines[lines_count] = strdup(buf);
+        if (!lines[lines_count]) {
+            log_write(LOG_ERROR, "Out of memory reading %s", name);
+            return assemble_abort(lines, lines_count, &labels, file);
+        }
         lines_count++;
     }
 
@@ -573,9 +626,10 @@ AssemblyRange assemble(RAM *ram, CPU *cpu, const char *file_path) {
             char tmp_dir[1024];
             strncpy(tmp_dir, line, sizeof(tmp_dir)-1);
             tmp_dir[sizeof(tmp_dir)-1] = '\0';
-            char *tok = strtok(tmp_dir, " \t");
+            char *dir_save = NULL;
+            char *tok = strtok_r(tmp_dir, " \t", &dir_save);
             if (tok && strcmp(tok, ".org") == 0) {
-                char *arg = strtok(NULL, " \t");
+                char *arg = strtok_r(NULL, " \t", &dir_save);
                 if (arg) {
                     long v = strtol(arg, NULL, 0);
                     directive_val = (int)v;
@@ -595,7 +649,8 @@ AssemblyRange assemble(RAM *ram, CPU *cpu, const char *file_path) {
         char tmp[1024];
         strncpy(tmp, line, sizeof(tmp) - 1);
         tmp[sizeof(tmp)-1] = '\0';
-        char *first_tok = strtok(tmp, " ,\t");
+        char *tok_save = NULL;
+        char *first_tok = strtok_r(tmp, " ,\t", &tok_save);
         if (!first_tok)
             continue;
 
@@ -610,63 +665,53 @@ AssemblyRange assemble(RAM *ram, CPU *cpu, const char *file_path) {
             size_t copy_len = (ftlen - 1 < sizeof(label_name)-1) ? ftlen - 1 : sizeof(label_name)-1;
             strncpy(label_name, first_tok, copy_len);
             label_name[copy_len] = '\0';
-            if (add_label(label_name, pc_cursor, labels, &label_count) == FAILURE) {
+            if (add_label(label_name, pc_cursor, &labels) == FAILURE) {
                 log_write(LOG_ERROR, "Failed to add label: %s", label_name);
-                for (size_t j = 0; j < lines_count; ++j) free(lines[j]);
-                free(lines);
-                fclose(file);
-                return assemble_error(NULL);
+                return assemble_abort(lines, lines_count, &labels, file);
             }
             log_write(LOG_DEBUG, "Found label '%s' at word address %u (first pass)", label_name, pc_cursor);
 
             /* check if instruction follows on the same line */
-            char *rest = strtok(NULL, " ,\t");
+            char *rest = strtok_r(NULL, " ,\t", &tok_save);
             if (!rest)
                 continue; /* label-only line */
             mn = rest;
             /* capture possible operands for first-pass sizing */
-            fp_op1 = strtok(NULL, " ,\t");
-            fp_op2 = strtok(NULL, " ,\t");
+            fp_op1 = strtok_r(NULL, " ,\t", &tok_save);
+            fp_op2 = strtok_r(NULL, " ,\t", &tok_save);
          } else {
              mn = first_tok;
             /* capture operands when label not present */
-            fp_op1 = strtok(NULL, " ,\t");
-            fp_op2 = strtok(NULL, " ,\t");
+            fp_op1 = strtok_r(NULL, " ,\t", &tok_save);
+            fp_op2 = strtok_r(NULL, " ,\t", &tok_save);
          }
 
 
          int opcode = get_opcode(mn, opcode_table_size);
          if (opcode == FAILURE) {
             log_write(LOG_ERROR, "[Line %zu] Invalid mnemonic: %s", i + 1, mn);
-            for (size_t j = 0; j < lines_count; ++j) free(lines[j]);
-            free(lines);
-            fclose(file);
-            return assemble_error(NULL);
+            return assemble_abort(lines, lines_count, &labels, file);
          }
 
-        /* instruction sizes (words)
-           Note: some arithmetic-like opcodes can take either a register or a numeric
-           source operand. If the source is numeric we emit an extra mode + literal
-           word, so we must account for that here. We use the captured fp_op2 token
-           to decide sizing. */
+        /* Instruction sizes (words) depend on the encoding and, for
+           LOADM/STOREM/ALU ops, on whether the operand is a literal or a
+           register. The captured operand tokens decide that here. */
+        bool has_immediate = false;
         switch (opcode) {
-             case ISA_LOADI: pc_cursor += 3; break;
-             case ISA_LOADA: pc_cursor += 3; break;
-             case ISA_LOADM: pc_cursor += 4; break;
-             case ISA_STOREM: pc_cursor += 4; break;
+            case ISA_LOADM:
+                has_immediate = fp_op2 && strncmp(fp_op2, "(A", 2) != 0;
+                break;
+            case ISA_STOREM:
+                has_immediate = fp_op1 && strncmp(fp_op1, "(A", 2) != 0;
+                break;
             case ISA_ADD: case ISA_SUB: case ISA_MLP: case ISA_DIV:
             case ISA_AND: case ISA_OR: case ISA_XOR:
-                /* Emit: opcode, dst, mode_flag, operand -> always 4 words */
-                pc_cursor += 4;
+                has_immediate = fp_op2 && fp_op2[0] != 'R';
                 break;
-             case ISA_JMP: case ISA_JZ: case ISA_JNZ:
-                 pc_cursor += 2; break;
-             case ISA_HALT:
-                 pc_cursor += 1; break;
-             default:
-                 /* Conservative: assume 1 word to avoid skipping labels */
-                 pc_cursor += 1; break;
-         }
+            default:
+                break;
+        }
+        pc_cursor += instruction_length((uint32_t)opcode, has_immediate, encoding);
      }
 
     /* If start wasn't set by a directive, default to 0 */
@@ -675,7 +720,7 @@ AssemblyRange assemble(RAM *ram, CPU *cpu, const char *file_path) {
     }
 
     /* Second pass: emit instructions, resolving labels */
-    cpu->pc = range.start_address;
+    out.pc = range.start_address;
 
     for (size_t i = 0; i < lines_count; ++i) {
         char *line = lines[i];
@@ -707,9 +752,10 @@ AssemblyRange assemble(RAM *ram, CPU *cpu, const char *file_path) {
             char tmp_dir[1024];
             strncpy(tmp_dir, text, sizeof(tmp_dir)-1);
             tmp_dir[sizeof(tmp_dir)-1] = '\0';
-            char *tok = strtok(tmp_dir, " \t");
+            char *dir_save = NULL;
+            char *tok = strtok_r(tmp_dir, " \t", &dir_save);
             if (tok && strcmp(tok, ".org") == 0) {
-                char *arg = strtok(NULL, " \t");
+                char *arg = strtok_r(NULL, " \t", &dir_save);
                 if (arg) {
                     long v = strtol(arg, NULL, 0);
                     directive_val = (int)v;
@@ -717,7 +763,7 @@ AssemblyRange assemble(RAM *ram, CPU *cpu, const char *file_path) {
             }
         }
         if (directive_val != FAILURE) {
-            cpu->pc = (uint32_t)directive_val;
+            out.pc = (uint32_t)directive_val;
             continue;
         }
 
@@ -725,9 +771,10 @@ AssemblyRange assemble(RAM *ram, CPU *cpu, const char *file_path) {
         char work[1024];
         strncpy(work, text, sizeof(work)-1);
         work[sizeof(work)-1] = '\0';
-        char *mnemonic = strtok(work, " ,\t");
-        char *op1 = strtok(NULL, " ,\t");
-        char *op2 = strtok(NULL, " ,\t");
+        char *work_save = NULL;
+        char *mnemonic = strtok_r(work, " ,\t", &work_save);
+        char *op1 = strtok_r(NULL, " ,\t", &work_save);
+        char *op2 = strtok_r(NULL, " ,\t", &work_save);
 
         if (!mnemonic)
             continue;
@@ -735,38 +782,31 @@ AssemblyRange assemble(RAM *ram, CPU *cpu, const char *file_path) {
         int opcode = get_opcode(mnemonic, opcode_table_size);
         if (opcode == FAILURE) {
             log_write(LOG_ERROR, "[Line %zu] Invalid mnemonic: %s", i + 1, mnemonic);
-            for (size_t j = 0; j < lines_count; ++j) free(lines[j]);
-            free(lines);
-            fclose(file);
-            return assemble_error(NULL);
+            return assemble_abort(lines, lines_count, &labels, file);
         }
 
         switch (opcode) {
             case ISA_LOADI:
-                if (!handle_loadi_instruction(ram, cpu, i + 1, op1, op2)) {
-                    for (size_t j = 0; j < lines_count; ++j) free(lines[j]); free(lines); fclose(file);
-                    return assemble_error(NULL);
+                if (!handle_loadi_instruction(&out, i + 1, op1, op2)) {
+                    return assemble_abort(lines, lines_count, &labels, file);
                 }
                 break;
 
             case ISA_LOADA:
-                if (!handle_loada_instruction(ram, cpu, i + 1, op1, op2)) {
-                    for (size_t j = 0; j < lines_count; ++j) free(lines[j]); free(lines); fclose(file);
-                    return assemble_error(NULL);
+                if (!handle_loada_instruction(&out, i + 1, op1, op2)) {
+                    return assemble_abort(lines, lines_count, &labels, file);
                 }
                 break;
 
             case ISA_LOADM:
-                if (!handle_loadm_instruction(ram, cpu, i + 1, op1, op2)) {
-                    for (size_t j = 0; j < lines_count; ++j) free(lines[j]); free(lines); fclose(file);
-                    return assemble_error(NULL);
+                if (!handle_loadm_instruction(&out, i + 1, op1, op2)) {
+                    return assemble_abort(lines, lines_count, &labels, file);
                 }
                 break;
 
             case ISA_STOREM:
-                if (!handle_storem_instruction(ram, cpu, i + 1, op1, op2)) {
-                    for (size_t j = 0; j < lines_count; ++j) free(lines[j]); free(lines); fclose(file);
-                    return assemble_error(NULL);
+                if (!handle_storem_instruction(&out, i + 1, op1, op2)) {
+                    return assemble_abort(lines, lines_count, &labels, file);
                 }
                 break;
 
@@ -777,44 +817,170 @@ AssemblyRange assemble(RAM *ram, CPU *cpu, const char *file_path) {
             case ISA_AND:
             case ISA_OR:
             case ISA_XOR:
-                if (!handle_arithmetic_instruction(ram, cpu, i + 1, opcode, op1, op2)) {
-                    for (size_t j = 0; j < lines_count; ++j) free(lines[j]); free(lines); fclose(file);
-                    return assemble_error(NULL);
+                if (!handle_arithmetic_instruction(&out, i + 1, opcode, op1, op2)) {
+                    return assemble_abort(lines, lines_count, &labels, file);
                 }
                 break;
 
             case ISA_CMP:
-                if (!handle_cmp_instruction(ram, cpu, i + 1, op1, op2)) {
-                    for (size_t j = 0; j < lines_count; ++j) free(lines[j]); free(lines); fclose(file);
-                    return assemble_error(NULL);
+                if (!handle_cmp_instruction(&out, i + 1, op1, op2)) {
+                    return assemble_abort(lines, lines_count, &labels, file);
                 }
                 break;
 
             case ISA_JMP:
             case ISA_JZ:
             case ISA_JNZ: {
-                if (!handle_jmp_instructions(ram, cpu, i + 1, opcode, op1, labels, label_count)) {
-                    for (size_t j = 0; j < lines_count; ++j) free(lines[j]); free(lines); fclose(file);
-                    return assemble_error(NULL);
+                if (!handle_jmp_instructions(&out, i + 1, opcode, op1, &labels)) {
+                    return assemble_abort(lines, lines_count, &labels, file);
                 }
                 break;
             }
 
             case ISA_HALT:
-                emit(ram, cpu, ISA_HALT);
+                if (!emit_instruction(&out, ISA_HALT, 0, 0, 0)) {
+                    return assemble_abort(lines, lines_count, &labels, file);
+                }
                 break;
 
             default:
                 log_write(LOG_ERROR, "[Line %zu] Unhandled opcode %s", i + 1, mnemonic);
-                for (size_t j = 0; j < lines_count; ++j) free(lines[j]); free(lines); fclose(file);
-                return assemble_error(NULL);
+                return assemble_abort(lines, lines_count, &labels, file);
+        }
+
+        if (out.overflow) {
+            log_write(LOG_ERROR, "[Line %zu] Instruction does not fit in %u-word output buffer", i + 1, capacity);
+            return assemble_abort(lines, lines_count, &labels, file);
         }
     }
 
-    range.end_address = cpu->pc;
+    range.end_address = out.pc;
 
     for (size_t j = 0; j < lines_count; ++j) free(lines[j]);
     free(lines);
+    if (labels_out)
+        *labels_out = labels;
+    else
+        label_table_free(&labels);
     fclose(file);
     return range;
 }
+
+/**
+ * @brief Assemble the source file into a caller-provided word buffer.
+ *
+ * Opens `file_path` and hands it to assemble_stream(); see there for the
+ * layout of `buffer` and the thread-safety guarantees.
+ *
+ * @param buffer Output buffer indexed by absolute word address.
+ * @param capacity Number of words available in `buffer`.
+ * @param file_path Path to assembly source to open.
+ * @param encoding Instruction layout to emit (see encoding.h).
+ * @return AssemblyRange indicating the start and end addresses of the
+ *         emitted code; on error the returned range has `error == true`.
+ */
+AssemblyRange assemble_into(uint32_t *buffer, uint32_t capacity, const char *file_path,
+                            InstructionEncoding encoding) {
+    if (!buffer || !file_path) {
+        log_write(LOG_ERROR, "Assemble failed: NULL argument(s) provided");
+        return assemble_error(NULL);
+    }
+
+    FILE *file = fopen(file_path, "r");
+    if (!file) {
+        log_write(LOG_ERROR, "Unable to open assembly file: %s", file_path);
+        return assemble_error(NULL);
+    }
+    return assemble_stream(buffer, capacity, file, file_path, encoding, NULL);
+}
+
+/**
+ * @brief Assemble a source file and hand its label table to the caller.
+ *
+ * Same as assemble_into(); on success `labels` owns every label defined by
+ * the source (release it with label_table_free()), on failure it is empty.
+ *
+ * @param buffer Output buffer indexed by absolute word address.
+ * @param capacity Number of words available in `buffer`.
+ * @param file_path Path to assembly source to open.
+ * @param encoding Instruction layout to emit (see encoding.h).
+ * @param labels Receives the label table.
+ * @return AssemblyRange indicating the start and end addresses of the
+ *         emitted code; on error the returned range has `error == true`.
+ */
+AssemblyRange assemble_into_labels(uint32_t *buffer, uint32_t capacity, const char *file_path,
+                                   InstructionEncoding encoding, LabelTable *labels) {
+    label_table_init(labels);
+    if (!buffer || !file_path) {
+        log_write(LOG_ERROR, "Assemble failed: NULL argument(s) provided");
+        return assemble_error(NULL);
+    }
+
+    FILE *file = fopen(file_path, "r");
+    if (!file) {
+        log_write(LOG_ERROR, "Unable to open assembly file: %s", file_path);
+        return assemble_error(NULL);
+    }
+    return assemble_stream(buffer, capacity, file, file_path, encoding, labels);
+}
+
+/**
+ * @brief Assemble source text held in memory into a caller-provided buffer.
+ *
+ * Same contract as assemble_into(), for hosts that keep programs in memory
+ * rather than on disk. `source` does not need to be NUL-terminated.
+ *
+ * @param buffer Output buffer indexed by absolute word address.
+ * @param capacity Number of words available in `buffer`.
+ * @param source Assembly source text.
+ * @param length Number of bytes in `source`.
+ * @param encoding Instruction layout to emit (see encoding.h).
+ * @return AssemblyRange indicating the start and end addresses of the
+ *         emitted code; on error the returned range has `error == true`.
+ */
+AssemblyRange assemble_source(uint32_t *buffer, uint32_t capacity, const char *source, size_t length,
+                              InstructionEncoding encoding) {
+    if (!buffer || !source) {
+        log_write(LOG_ERROR, "Assemble failed: NULL argument(s) provided");
+        return assemble_error(NULL);
+    }
+    if (length == 0) {
+        log_write(LOG_ERROR, "Assemble failed: empty source");
+        return assemble_error(NULL);
+    }
+
+    /* "r" mode never writes through the buffer, so dropping const is safe. */
+    FILE *file = fmemopen((void *)source, length, "r");
+    if (!file) {
+        log_write(LOG_ERROR, "Unable to open in-memory assembly source");
+        return assemble_error(NULL);
+    }
+    return assemble_stream(buffer, capacity, file, "<memory>", encoding, NULL);
+}
+
+/**
+ * @brief Assemble the source file into RAM.
+ *
+ * Thin wrapper over assemble_into() that targets `ram->cells` with the
+ * wide encoding and leaves the CPU's `pc` at the end of the emitted code,
+ * matching the behaviour callers relied on before assembly was decoupled
+ * from RAM/CPU.
+ *
+ * @param ram Pointer to initialized RAM where code will be written.
+ * @param cpu CPU whose program counter is set to the end of the emitted code.
+ * @param file_path Path to assembly source to open.
+ * @return AssemblyRange indicating the start and end addresses of the
+ *         emitted code; on error the returned range has `error == true`.
+ */
+AssemblyRange assemble(RAM *ram, CPU *cpu, const char *file_path) {
+    if (!ram || !cpu || !file_path) {
+        log_write(LOG_ERROR, "Assemble failed: NULL argument(s) provided");
+        return assemble_error(NULL);
+    }
+
+    AssemblyRange range = assemble_into(ram->cells, RAM_SIZE, file_path, ENCODING_WIDE);
+    if (!range.error) {
+        cpu->pc = range.end_address;
+    }
+    return range;
+}
@@ -0,0 +1,227 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "../include/batch_assembler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "log.h"
+#include "ram.h"
+
+/**
+ * @struct BatchJob
+ * @brief State shared by all workers of one batch_assemble() call.
+ *
+ * Workers claim the next file index with an atomic fetch-add; every other
+ * field is either read-only or written at a distinct index of `images`.
+ */
+typedef struct {
+    const char *const *file_paths;
+    size_t count;
+    AssemblyImage *images;
+    InstructionEncoding encoding;
+    atomic_size_t next_index;
+} BatchJob;
+
+/**
+ * @brief Read the monotonic clock in nanoseconds.
+ */
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Assemble a single file into a worker's scratch buffer and copy out the image.
+ *
+ * Only the words of the assembled range are cleared afterwards, so gaps of
+ * the next file stay zero without wiping all RAM_SIZE words per file. A
+ * failed file reports an empty range after writing part of its code, so
+ * then the whole buffer is cleared.
+ *
+ * @param scratch RAM_SIZE-word buffer owned by the calling worker.
+ * @param file_path Source file to assemble.
+ * @param encoding Instruction layout to emit.
+ * @param image Output image for this file.
+ */
+static void assemble_one(uint32_t *scratch, const char *file_path, InstructionEncoding encoding,
+                         AssemblyImage *image) {
+    image->file_path = file_path;
+    image->words = NULL;
+    image->word_count = 0;
+
+    uint64_t t0 = now_ns();
+    image->range = assemble_into(scratch, RAM_SIZE, file_path, encoding);
+
+    if (!image->range.error && image->range.end_address > image->range.start_address) {
+        uint32_t word_count = image->range.end_address - image->range.start_address;
+        image->words = malloc(sizeof(uint32_t) * word_count);
+        if (!image->words) {
+            log_write(LOG_ERROR, "Batch: out of memory copying image for %s", file_path);
+            image->range.error = true;
+        } else {
+            memcpy(image->words, &scratch[image->range.start_address], sizeof(uint32_t) * word_count);
+            image->word_count = word_count;
+        }
+    }
+    image->elapsed_ns = now_ns() - t0;
+
+    if (image->range.error)
+        memset(scratch, 0, sizeof(uint32_t) * RAM_SIZE);
+    else if (image->range.end_address > image->range.start_address)
+        memset(&scratch[image->range.start_address], 0,
+               sizeof(uint32_t) * (image->range.end_address - image->range.start_address));
+}
+
+/**
+ * @brief Worker thread body: claim files until the job list is exhausted.
+ *
+ * @param arg Pointer to the shared BatchJob.
+ * @return NULL.
+ */
+static void *batch_worker(void *arg) {
+    BatchJob *job = arg;
+
+    uint32_t *scratch = calloc(RAM_SIZE, sizeof(uint32_t));
+    if (!scratch) {
+        log_write(LOG_ERROR, "Batch: unable to allocate worker scratch buffer");
+        return NULL;
+    }
+
+    for (;;) {
+        size_t index = atomic_fetch_add_explicit(&job->next_index, 1, memory_order_relaxed);
+        if (index >= job->count)
+            break;
+        assemble_one(scratch, job->file_paths[index], job->encoding, &job->images[index]);
+    }
+
+    free(scratch);
+    return NULL;
+}
+
+/**
+ * @brief Assemble `count` files concurrently using a pool of worker threads.
+ *
+ * Every image starts out marked as failed so files that were never claimed
+ * (for example because a worker could not allocate its scratch buffer) are
+ * reported as errors rather than as empty successes.
+ */
+bool batch_assemble(const char *const *file_paths, size_t count, size_t thread_count,
+                    InstructionEncoding encoding, AssemblyImage *images, BatchStats *stats) {
+    if (!file_paths || !images) {
+        log_write(LOG_ERROR, "Batch assemble failed: NULL argument(s) provided");
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        images[i] = (AssemblyImage){ .file_path = file_paths[i], .range = { .error = true } };
+    }
+
+    if (thread_count == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = online > 0 ? (size_t)online : 1;
+    }
+    if (thread_count > count)
+        thread_count = count > 0 ? count : 1;
+
+    BatchJob job = { .file_paths = file_paths, .count = count, .images = images, .encoding = encoding };
+    atomic_init(&job.next_index, 0);
+
+    pthread_t *threads = calloc(thread_count, sizeof(pthread_t));
+    if (!threads) {
+        log_write(LOG_ERROR, "Batch assemble failed: unable to allocate thread pool");
+        return false;
+    }
+
+    uint64_t t0 = now_ns();
+    size_t started = 0;
+    for (; started < thread_count; started++) {
+        if (pthread_create(&threads[started], NULL, batch_worker, &job) != 0) {
+            log_write(LOG_WARN, "Batch: could only start %zu of %zu worker threads", started, thread_count);
+            break;
+        }
+    }
+    if (started == 0) {
+        /* No worker could be started: assemble on the calling thread instead. */
+        batch_worker(&job);
+    }
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    uint64_t wall = now_ns() - t0;
+    free(threads);
+
+    BatchStats local = { .files_total = count, .thread_count = started ? started : 1, .wall_ns = wall };
+    for (size_t i = 0; i < count; i++) {
+        const AssemblyImage *image = &images[i];
+        local.busy_ns += image->elapsed_ns;
+        if (image->elapsed_ns > local.max_file_ns)
+            local.max_file_ns = image->elapsed_ns;
+        if (image->range.error) {
+            local.files_failed++;
+            continue;
+        }
+        local.words_emitted += image->word_count;
+        if (local.min_file_ns == 0 || image->elapsed_ns < local.min_file_ns)
+            local.min_file_ns = image->elapsed_ns;
+    }
+
+    if (stats)
+        *stats = local;
+    return local.files_failed == 0;
+}
+
+/**
+ * @brief Release the word buffers owned by an array of images.
+ */
+void batch_images_free(AssemblyImage *images, size_t count) {
+    if (!images)
+        return;
+    for (size_t i = 0; i < count; i++) {
+        free(images[i].words);
+        images[i].words = NULL;
+        images[i].word_count = 0;
+    }
+}
+
+/**
+ * @brief Print a per-file timing table (optional) and the aggregate stats.
+ *
+ * Throughput is reported against wall-clock time of the whole batch, while
+ * the mean per-file latency uses the summed busy time of all workers.
+ */
+void batch_print_stats(const AssemblyImage *images, size_t count, const BatchStats *stats, bool per_file) {
+    if (!stats)
+        return;
+
+    if (per_file && images) {
+        for (size_t i = 0; i < count; i++) {
+            const AssemblyImage *image = &images[i];
+            printf("%-6s %10.3f us %8u words  %s\n",
+                   image->range.error ? "FAIL" : "OK",
+                   (double)image->elapsed_ns / 1e3,
+                   image->word_count,
+                   image->file_path);
+        }
+    }
+
+    double wall_s = (double)stats->wall_ns / 1e9;
+    size_t ok = stats->files_total - stats->files_failed;
+    printf("Batch: %zu files (%zu ok, %zu failed) on %zu threads in %.3f ms\n",
+           stats->files_total, ok, stats->files_failed, stats->thread_count, (double)stats->wall_ns / 1e6);
+    printf("  per file: min %.3f us, mean %.3f us, max %.3f us\n",
+           (double)stats->min_file_ns / 1e3,
+           stats->files_total ? (double)stats->busy_ns / 1e3 / (double)stats->files_total : 0.0,
+           (double)stats->max_file_ns / 1e3);
+    printf("  throughput: %.1f files/s, %.1f words/s\n",
+           wall_s > 0 ? (double)stats->files_total / wall_s : 0.0,
+           wall_s > 0 ? (double)stats->words_emitted / wall_s : 0.0);
+}
@@ -0,0 +1,369 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "branch_sim.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "disasm.h"
+#include "encoding.h"
+#include "log.h"
+#include "ram.h"
+
+/** log2 of the bimodal and gshare table sizes. */
+#define COUNTER_TABLE_BITS 12
+#define COUNTER_TABLE_SIZE (1u << COUNTER_TABLE_BITS)
+#define COUNTER_TABLE_MASK (COUNTER_TABLE_SIZE - 1)
+
+/* TAGE-like predictor geometry. */
+#define TAGE_TABLES 4
+#define TAGE_INDEX_BITS 10
+#define TAGE_TAG_BITS 9
+#define TAGE_CTR_MAX 3               /* three-bit signed counters: taken when >= 0 */
+#define TAGE_CTR_MIN (-4)
+#define TAGE_USEFUL_MAX 3
+#define TAGE_USEFUL_RESET_PERIOD (1u << 18)
+
+static const uint32_t TAGE_HISTORY_LENGTHS[TAGE_TABLES] = { 5, 11, 22, 44 };
+
+typedef struct {
+    uint16_t tag;
+    int8_t ctr;
+    uint8_t useful;
+} TageEntry;
+
+struct TagePredictor {
+    uint8_t base[COUNTER_TABLE_SIZE];                        /**< Two-bit counters, PC-indexed */
+    TageEntry tables[TAGE_TABLES][1u << TAGE_INDEX_BITS];
+    uint32_t updates;                                        /**< Drives the periodic useful-bit decay */
+};
+
+static const char *const PREDICTOR_NAMES[BPRED_KIND_COUNT] = { "static", "bimodal", "gshare", "tage" };
+
+const char *branch_predictor_name(BranchPredictorKind kind) {
+    return kind < BPRED_KIND_COUNT ? PREDICTOR_NAMES[kind] : "unknown";
+}
+
+bool branch_predictor_parse_list(const char *list, BranchPredictorKind *kinds, uint32_t *count) {
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "%s", list);
+    bool selected[BPRED_KIND_COUNT] = { false };
+    *count = 0;
+
+    char *save = NULL;
+    for (char *name = strtok_r(buffer, ",", &save); name; name = strtok_r(NULL, ",", &save)) {
+        bool found = false;
+        for (uint32_t k = 0; k < BPRED_KIND_COUNT; k++) {
+            bool all = strcasecmp(name, "all") == 0;
+            if (!all && strcasecmp(name, PREDICTOR_NAMES[k]) != 0)
+                continue;
+            found = true;
+            if (!selected[k]) {
+                selected[k] = true;
+                kinds[(*count)++] = (BranchPredictorKind)k;
+            }
+        }
+        if (!found) {
+            log_write(LOG_ERROR, "Unknown branch predictor '%s' (static, bimodal, gshare, tage or all)", name);
+            return false;
+        }
+    }
+    if (*count == 0) {
+        log_write(LOG_ERROR, "No branch predictor selected");
+        return false;
+    }
+    return true;
+}
+
+static bool counter_predict(uint8_t counter) {
+    return counter >= 2;
+}
+
+static void counter_train(uint8_t *counter, bool taken) {
+    if (taken && *counter < 3)
+        (*counter)++;
+    else if (!taken && *counter > 0)
+        (*counter)--;
+}
+
+/**
+ * @brief XOR-fold the newest `length` history bits down to `bits` bits.
+ */
+static uint32_t fold_history(uint64_t history, uint32_t length, uint32_t bits) {
+    uint64_t h = length < 64 ? history & ((1ull << length) - 1) : history;
+    uint32_t folded = 0;
+    while (h) {
+        folded ^= (uint32_t)(h & ((1u << bits) - 1));
+        h >>= bits;
+    }
+    return folded;
+}
+
+static uint32_t tage_index(uint32_t pc, uint64_t history, uint32_t table) {
+    uint32_t length = TAGE_HISTORY_LENGTHS[table];
+    return (pc ^ (pc >> TAGE_INDEX_BITS) ^ fold_history(history, length, TAGE_INDEX_BITS) ^ table)
+         & ((1u << TAGE_INDEX_BITS) - 1);
+}
+
+static uint16_t tage_tag(uint32_t pc, uint64_t history, uint32_t table) {
+    uint32_t length = TAGE_HISTORY_LENGTHS[table];
+    uint32_t tag = pc ^ fold_history(history, length, TAGE_TAG_BITS)
+                 ^ (fold_history(history, length, TAGE_TAG_BITS - 1) << 1);
+    return (uint16_t)(tag & ((1u << TAGE_TAG_BITS) - 1));
+}
+
+/**
+ * @brief Predict with the TAGE-like predictor and train it with the outcome.
+ *
+ * The provider is the matching entry with the longest history; the
+ * alternate prediction comes from the next matching table or the base
+ * predictor. A misprediction allocates one entry in a longer table whose
+ * useful counter is zero, or ages those entries if none is free.
+ *
+ * @return The prediction made before training.
+ */
+static bool tage_predict_train(TagePredictor *tage, uint32_t pc, uint64_t history, bool taken) {
+    uint32_t index[TAGE_TABLES];
+    uint16_t tag[TAGE_TABLES];
+    int provider = -1;
+    int alternate = -1;
+    for (int t = TAGE_TABLES - 1; t >= 0; t--) {
+        index[t] = tage_index(pc, history, (uint32_t)t);
+        tag[t] = tage_tag(pc, history, (uint32_t)t);
+        if (tage->tables[t][index[t]].tag == tag[t]) {
+            if (provider < 0)
+                provider = t;
+            else if (alternate < 0)
+                alternate = t;
+        }
+    }
+
+    uint8_t *base = &tage->base[pc & COUNTER_TABLE_MASK];
+    bool base_prediction = counter_predict(*base);
+    bool alternate_prediction = alternate >= 0 ? tage->tables[alternate][index[alternate]].ctr >= 0 : base_prediction;
+    bool prediction = base_prediction;
+
+    if (provider >= 0) {
+        TageEntry *entry = &tage->tables[provider][index[provider]];
+        prediction = entry->ctr >= 0;
+        if (prediction != alternate_prediction) {
+            if (prediction == taken && entry->useful < TAGE_USEFUL_MAX)
+                entry->useful++;
+            else if (prediction != taken && entry->useful > 0)
+                entry->useful--;
+        }
+        if (taken && entry->ctr < TAGE_CTR_MAX)
+            entry->ctr++;
+        else if (!taken && entry->ctr > TAGE_CTR_MIN)
+            entry->ctr--;
+    } else {
+        counter_train(base, taken);
+    }
+
+    if (prediction != taken && provider < TAGE_TABLES - 1) {
+        bool allocated = false;
+        for (int t = provider + 1; t < TAGE_TABLES && !allocated; t++) {
+            TageEntry *entry = &tage->tables[t][index[t]];
+            if (entry->useful == 0) {
+                entry->tag = tag[t];
+                entry->ctr = taken ? 0 : -1;
+                allocated = true;
+            }
+        }
+        for (int t = provider + 1; t < TAGE_TABLES && !allocated; t++) {
+            TageEntry *entry = &tage->tables[t][index[t]];
+            entry->useful--;
+        }
+    }
+
+    if (++tage->updates % TAGE_USEFUL_RESET_PERIOD == 0) {
+        for (uint32_t t = 0; t < TAGE_TABLES; t++) {
+            for (uint32_t i = 0; i < (1u << TAGE_INDEX_BITS); i++)
+                tage->tables[t][i].useful >>= 1;
+        }
+    }
+    return prediction;
+}
+
+bool branch_sim_init(BranchSim *sim, const BranchPredictorKind *kinds, uint32_t count, uint32_t penalty_cycles,
+                     AssemblyRange range) {
+    memset(sim, 0, sizeof(*sim));
+    sim->range = range;
+    sim->penalty_cycles = penalty_cycles;
+    uint32_t size = range.end_address > range.start_address ? range.end_address - range.start_address : 0;
+    bool ok = count > 0 && count <= BPRED_KIND_COUNT;
+    sim->per_pc = calloc(size ? size : 1, sizeof(BranchPcStats));
+    ok = ok && sim->per_pc;
+
+    for (uint32_t i = 0; ok && i < count; i++) {
+        BranchPredictorKind kind = kinds[i];
+        sim->kinds[sim->count++] = kind;
+        sim->pc_mispredicts[kind] = calloc(size ? size : 1, sizeof(uint64_t));
+        ok = sim->pc_mispredicts[kind] != NULL;
+        if (ok && kind == BPRED_BIMODAL) {
+            sim->bimodal = malloc(COUNTER_TABLE_SIZE);
+            ok = sim->bimodal != NULL;
+            if (ok)
+                memset(sim->bimodal, 1, COUNTER_TABLE_SIZE);
+        } else if (ok && kind == BPRED_GSHARE) {
+            sim->gshare = malloc(COUNTER_TABLE_SIZE);
+            ok = sim->gshare != NULL;
+            if (ok)
+                memset(sim->gshare, 1, COUNTER_TABLE_SIZE);
+        } else if (ok && kind == BPRED_TAGE) {
+            sim->tage = calloc(1, sizeof(TagePredictor));
+            ok = sim->tage != NULL;
+            if (ok) {
+                memset(sim->tage->base, 1, sizeof(sim->tage->base));
+                for (uint32_t t = 0; t < TAGE_TABLES; t++) {
+                    for (uint32_t e = 0; e < (1u << TAGE_INDEX_BITS); e++)
+                        sim->tage->tables[t][e].tag = UINT16_MAX;  /* never matches a 9-bit tag */
+                }
+            }
+        }
+    }
+    if (!ok) {
+        log_write(LOG_ERROR, "Cannot set up the branch predictors (bad selection or out of memory)");
+        branch_sim_free(sim);
+        return false;
+    }
+    return true;
+}
+
+void branch_sim_free(BranchSim *sim) {
+    free(sim->bimodal);
+    free(sim->gshare);
+    free(sim->tage);
+    free(sim->per_pc);
+    for (uint32_t k = 0; k < BPRED_KIND_COUNT; k++) {
+        free(sim->pc_mispredicts[k]);
+        sim->pc_mispredicts[k] = NULL;
+    }
+    sim->bimodal = NULL;
+    sim->gshare = NULL;
+    sim->tage = NULL;
+    sim->per_pc = NULL;
+    sim->count = 0;
+}
+
+void branch_sim_record(BranchSim *sim, uint32_t pc, uint32_t target, bool taken) {
+    uint32_t offset = pc - sim->range.start_address;
+    bool in_range = pc >= sim->range.start_address && offset < sim->range.end_address - sim->range.start_address;
+    sim->totals.executed++;
+    sim->totals.taken += taken;
+    if (in_range) {
+        sim->per_pc[offset].executed++;
+        sim->per_pc[offset].taken += taken;
+    }
+
+    for (uint32_t i = 0; i < sim->count; i++) {
+        BranchPredictorKind kind = sim->kinds[i];
+        bool prediction;
+        switch (kind) {
+            case BPRED_STATIC:
+                prediction = target <= pc;
+                break;
+            case BPRED_BIMODAL: {
+                uint8_t *counter = &sim->bimodal[pc & COUNTER_TABLE_MASK];
+                prediction = counter_predict(*counter);
+                counter_train(counter, taken);
+                break;
+            }
+            case BPRED_GSHARE: {
+                uint8_t *counter = &sim->gshare[(pc ^ (uint32_t)sim->history) & COUNTER_TABLE_MASK];
+                prediction = counter_predict(*counter);
+                counter_train(counter, taken);
+                break;
+            }
+            case BPRED_TAGE:
+                prediction = tage_predict_train(sim->tage, pc, sim->history, taken);
+                break;
+            default:
+                prediction = taken;
+                break;
+        }
+        if (prediction != taken) {
+            sim->mispredicts[kind]++;
+            if (in_range)
+                sim->pc_mispredicts[kind][offset]++;
+        }
+    }
+    sim->history = (sim->history << 1) | (taken ? 1u : 0u);
+}
+
+static double percent(uint64_t part, uint64_t whole) {
+    return whole ? 100.0 * (double)part / (double)whole : 0.0;
+}
+
+/** One branch of the per-PC table. */
+typedef struct {
+    uint32_t offset;
+    uint64_t mispredicts;        /**< Summed over the selected predictors (sort key) */
+} BranchRow;
+
+static int compare_rows(const void *a, const void *b) {
+    const BranchRow *x = a;
+    const BranchRow *y = b;
+    if (x->mispredicts != y->mispredicts)
+        return x->mispredicts > y->mispredicts ? -1 : 1;
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+void branch_sim_print(const BranchSim *sim, const uint32_t *words, uint32_t top, FILE *out) {
+    fprintf(out, "branches: %llu conditional, %.1f%% taken, penalty %u cycles per mispredict\n",
+            (unsigned long long)sim->totals.executed, percent(sim->totals.taken, sim->totals.executed),
+            sim->penalty_cycles);
+    fprintf(out, "  %-10s %12s %9s %14s\n", "predictor", "mispredicts", "accuracy", "penalty");
+    for (uint32_t i = 0; i < sim->count; i++) {
+        BranchPredictorKind kind = sim->kinds[i];
+        uint64_t misses = sim->mispredicts[kind];
+        fprintf(out, "  %-10s %12llu %8.2f%% %14llu\n", branch_predictor_name(kind), (unsigned long long)misses,
+                100.0 - percent(misses, sim->totals.executed),
+                (unsigned long long)(misses * sim->penalty_cycles));
+    }
+
+    uint32_t size = sim->range.end_address > sim->range.start_address
+        ? sim->range.end_address - sim->range.start_address : 0;
+    BranchRow *rows = malloc((size ? size : 1) * sizeof(BranchRow));
+    if (!rows)
+        return;
+    uint32_t used = 0;
+    for (uint32_t offset = 0; offset < size; offset++) {
+        if (!sim->per_pc[offset].executed)
+            continue;
+        uint64_t misses = 0;
+        for (uint32_t i = 0; i < sim->count; i++)
+            misses += sim->pc_mispredicts[sim->kinds[i]][offset];
+        rows[used++] = (BranchRow){ offset, misses };
+    }
+    qsort(rows, used, sizeof(BranchRow), compare_rows);
+    if (used > top)
+        used = top;
+
+    if (used) {
+        fprintf(out, "  %-10s %-18s %10s %7s", "pc", "instruction", "executed", "taken");
+        for (uint32_t i = 0; i < sim->count; i++)
+            fprintf(out, " %8s", branch_predictor_name(sim->kinds[i]));
+        fputc('\n', out);
+    }
+    for (uint32_t r = 0; r < used; r++) {
+        uint32_t offset = rows[r].offset;
+        uint32_t pc = sim->range.start_address + offset;
+        const BranchPcStats *stats = &sim->per_pc[offset];
+        char text[64] = "?";
+        DecodedInstruction insn;
+        if (decode_instruction(words, RAM_SIZE, pc, sim->range.encoding, &insn))
+            format_instruction(&insn, text, sizeof(text));
+        fprintf(out, "  0x%08X %-18s %10llu %6.1f%%", pc, text, (unsigned long long)stats->executed,
+                percent(stats->taken, stats->executed));
+        for (uint32_t i = 0; i < sim->count; i++) {
+            uint64_t misses = sim->pc_mispredicts[sim->kinds[i]][offset];
+            fprintf(out, " %7.1f%%", 100.0 - percent(misses, stats->executed));
+        }
+        fputc('\n', out);
+    }
+    free(rows);
+}
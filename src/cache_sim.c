@@ -0,0 +1,309 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "cache_sim.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "disasm.h"
+#include "encoding.h"
+#include "log.h"
+#include "ram.h"
+
+/** Bytes per guest word. */
+#define WORD_BYTES 4u
+
+static bool is_power_of_two(uint32_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+static uint32_t log2_u32(uint32_t value) {
+    uint32_t shift = 0;
+    while ((1u << shift) < value)
+        shift++;
+    return shift;
+}
+
+void cache_config_default(CacheConfig *config) {
+    config->size_bytes = 4096;
+    config->line_bytes = 32;
+    config->ways = 4;
+    config->replacement = CACHE_REPLACE_LRU;
+}
+
+/**
+ * @brief Check that the geometry is usable; log the first problem found.
+ */
+static bool cache_config_valid(const CacheConfig *config) {
+    if (!is_power_of_two(config->size_bytes) || !is_power_of_two(config->line_bytes)
+        || !is_power_of_two(config->ways)) {
+        log_write(LOG_ERROR, "Cache size, line size and ways must be powers of two");
+        return false;
+    }
+    if (config->line_bytes < WORD_BYTES || config->ways > 64) {
+        log_write(LOG_ERROR, "Cache lines must hold at least one word and ways must not exceed 64");
+        return false;
+    }
+    if ((uint64_t)config->line_bytes * config->ways > config->size_bytes) {
+        log_write(LOG_ERROR, "Cache of %u bytes cannot hold %u ways of %u-byte lines", config->size_bytes,
+                  config->ways, config->line_bytes);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse a byte count with an optional k/m suffix.
+ */
+static bool parse_bytes(const char *text, uint32_t *value) {
+    char *end = NULL;
+    unsigned long long parsed = strtoull(text, &end, 0);
+    if (end == text)
+        return false;
+    if (*end == 'k' || *end == 'K') {
+        parsed <<= 10;
+        end++;
+    } else if (*end == 'm' || *end == 'M') {
+        parsed <<= 20;
+        end++;
+    }
+    if (*end != '\0' || parsed > UINT32_MAX)
+        return false;
+    *value = (uint32_t)parsed;
+    return true;
+}
+
+bool cache_config_parse(const char *spec, CacheConfig *config) {
+    cache_config_default(config);
+    if (strcasecmp(spec, "default") == 0)
+        return true;
+
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", spec);
+    char *save = NULL;
+    for (char *item = strtok_r(buffer, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        char *value = strchr(item, '=');
+        if (!value) {
+            log_write(LOG_ERROR, "Cache option '%s' must be KEY=VALUE", item);
+            return false;
+        }
+        *value++ = '\0';
+        bool ok;
+        if (strcasecmp(item, "size") == 0) {
+            ok = parse_bytes(value, &config->size_bytes);
+        } else if (strcasecmp(item, "line") == 0) {
+            ok = parse_bytes(value, &config->line_bytes);
+        } else if (strcasecmp(item, "ways") == 0) {
+            ok = parse_bytes(value, &config->ways);
+        } else if (strcasecmp(item, "policy") == 0) {
+            ok = true;
+            if (strcasecmp(value, "lru") == 0)
+                config->replacement = CACHE_REPLACE_LRU;
+            else if (strcasecmp(value, "plru") == 0)
+                config->replacement = CACHE_REPLACE_PLRU;
+            else
+                ok = false;
+        } else {
+            log_write(LOG_ERROR, "Unknown cache option '%s' (size, line, ways, policy)", item);
+            return false;
+        }
+        if (!ok) {
+            log_write(LOG_ERROR, "Invalid value '%s' for cache option '%s'", value, item);
+            return false;
+        }
+    }
+    return cache_config_valid(config);
+}
+
+bool cache_sim_init(CacheSim *sim, const CacheConfig *config, AssemblyRange range) {
+    memset(sim, 0, sizeof(*sim));
+    if (!cache_config_valid(config))
+        return false;
+
+    sim->config = *config;
+    sim->range = range;
+    sim->line_shift = log2_u32(config->line_bytes / WORD_BYTES);
+    uint32_t sets = config->size_bytes / (config->line_bytes * config->ways);
+    sim->set_mask = sets - 1;
+
+    size_t slots = (size_t)sets * config->ways;
+    uint32_t size = range.end_address > range.start_address ? range.end_address - range.start_address : 0;
+    sim->lines = malloc(slots * sizeof(uint32_t));
+    sim->dirty = calloc(slots, 1);
+    sim->stamps = calloc(slots, sizeof(uint64_t));
+    sim->plru = calloc(sets, sizeof(uint64_t));
+    sim->per_pc = calloc(size ? size : 1, sizeof(CachePcStats));
+    if (!sim->lines || !sim->dirty || !sim->stamps || !sim->plru || !sim->per_pc) {
+        log_write(LOG_ERROR, "Out of memory allocating the cache model");
+        cache_sim_free(sim);
+        return false;
+    }
+    for (size_t i = 0; i < slots; i++)
+        sim->lines[i] = CACHE_LINE_INVALID;
+    return true;
+}
+
+void cache_sim_free(CacheSim *sim) {
+    free(sim->lines);
+    free(sim->dirty);
+    free(sim->stamps);
+    free(sim->plru);
+    free(sim->per_pc);
+    sim->lines = NULL;
+    sim->dirty = NULL;
+    sim->stamps = NULL;
+    sim->plru = NULL;
+    sim->per_pc = NULL;
+}
+
+/**
+ * @brief Pick the way to replace in `set`: an empty way first, else by policy.
+ */
+static uint32_t choose_victim(const CacheSim *sim, uint32_t set) {
+    const uint32_t ways = sim->config.ways;
+    const uint32_t *lines = &sim->lines[set * ways];
+    for (uint32_t way = 0; way < ways; way++) {
+        if (lines[way] == CACHE_LINE_INVALID)
+            return way;
+    }
+
+    if (sim->config.replacement == CACHE_REPLACE_LRU) {
+        const uint64_t *stamps = &sim->stamps[set * ways];
+        uint32_t victim = 0;
+        for (uint32_t way = 1; way < ways; way++) {
+            if (stamps[way] < stamps[victim])
+                victim = way;
+        }
+        return victim;
+    }
+
+    /* Follow the tree bits, which point towards the less recently used half. */
+    uint64_t bits = sim->plru[set];
+    uint32_t node = 1;
+    uint32_t victim = 0;
+    for (uint32_t half = ways >> 1; half; half >>= 1) {
+        bool right = (bits >> node) & 1u;
+        if (right)
+            victim |= half;
+        node = 2 * node + right;
+    }
+    return victim;
+}
+
+void cache_sim_fill(CacheSim *sim, uint32_t set, uint32_t line, bool write) {
+    uint32_t way = choose_victim(sim, set);
+    uint32_t slot = set * sim->config.ways + way;
+    if (sim->lines[slot] != CACHE_LINE_INVALID && sim->dirty[slot])
+        sim->totals.writebacks++;
+    sim->lines[slot] = line;
+    sim->dirty[slot] = write;
+    cache_sim_touch(sim, set, way);
+}
+
+void cache_sim_flush(CacheSim *sim) {
+    size_t slots = (size_t)(sim->set_mask + 1) * sim->config.ways;
+    for (size_t i = 0; i < slots; i++) {
+        if (sim->lines[i] != CACHE_LINE_INVALID && sim->dirty[i]) {
+            sim->totals.writebacks++;
+            sim->dirty[i] = 0;
+        }
+    }
+}
+
+static double percent(uint64_t part, uint64_t whole) {
+    return whole ? 100.0 * (double)part / (double)whole : 0.0;
+}
+
+/** One row of a report table: index plus its statistics. */
+typedef struct {
+    uint32_t index;
+    CachePcStats stats;
+} CacheRow;
+
+/** Most misses first, then most accesses, then lowest index. */
+static int compare_rows(const void *a, const void *b) {
+    const CacheRow *x = a;
+    const CacheRow *y = b;
+    if (x->stats.misses != y->stats.misses)
+        return x->stats.misses > y->stats.misses ? -1 : 1;
+    if (x->stats.accesses != y->stats.accesses)
+        return x->stats.accesses > y->stats.accesses ? -1 : 1;
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+void cache_sim_print(const CacheSim *sim, const CodeRegionMap *regions, const uint32_t *words, uint32_t top,
+                     FILE *out) {
+    const CacheConfig *config = &sim->config;
+    const CacheCounters *t = &sim->totals;
+    fprintf(out, "dcache: %u B, %u B lines, %u-way %s, %u sets, write-back/write-allocate\n", config->size_bytes,
+            config->line_bytes, config->ways, config->replacement == CACHE_REPLACE_LRU ? "LRU" : "PLRU",
+            sim->set_mask + 1);
+    uint64_t accesses = t->reads + t->writes;
+    uint64_t misses = t->read_misses + t->write_misses;
+    fprintf(out, "  accesses %llu, misses %llu (%.2f%%): reads %llu (%.2f%% miss), writes %llu (%.2f%% miss), "
+                 "writebacks %llu\n",
+            (unsigned long long)accesses, (unsigned long long)misses, percent(misses, accesses),
+            (unsigned long long)t->reads, percent(t->read_misses, t->reads), (unsigned long long)t->writes,
+            percent(t->write_misses, t->writes), (unsigned long long)t->writebacks);
+
+    uint32_t size = sim->range.end_address > sim->range.start_address
+        ? sim->range.end_address - sim->range.start_address : 0;
+    uint32_t row_capacity = size > (regions ? regions->count : 0) ? size : (regions ? regions->count : 0);
+    CacheRow *rows = malloc((row_capacity ? row_capacity : 1) * sizeof(CacheRow));
+    if (!rows)
+        return;
+
+    if (regions) {
+        uint32_t used = 0;
+        for (uint32_t r = 0; r < regions->count; r++)
+            rows[r] = (CacheRow){ r, { 0, 0 } };
+        for (uint32_t offset = 0; offset < size; offset++) {
+            const CachePcStats *stats = &sim->per_pc[offset];
+            if (!stats->accesses)
+                continue;
+            CacheRow *row = &rows[regions->region_of[offset]];
+            row->stats.accesses += stats->accesses;
+            row->stats.misses += stats->misses;
+        }
+        for (uint32_t r = 0; r < regions->count; r++) {
+            if (rows[r].stats.accesses)
+                rows[used++] = rows[r];
+        }
+        qsort(rows, used, sizeof(CacheRow), compare_rows);
+        fprintf(out, "  %-24s %12s %12s %7s\n", "region", "accesses", "misses", "miss%");
+        for (uint32_t i = 0; i < used; i++) {
+            fprintf(out, "  %-24s %12llu %12llu %6.2f%%\n", regions->regions[rows[i].index].name,
+                    (unsigned long long)rows[i].stats.accesses, (unsigned long long)rows[i].stats.misses,
+                    percent(rows[i].stats.misses, rows[i].stats.accesses));
+        }
+    }
+    if (sim->outside.accesses) {
+        fprintf(out, "  %-24s %12llu %12llu %6.2f%%\n", "<outside range>",
+                (unsigned long long)sim->outside.accesses, (unsigned long long)sim->outside.misses,
+                percent(sim->outside.misses, sim->outside.accesses));
+    }
+
+    uint32_t used = 0;
+    for (uint32_t offset = 0; offset < size; offset++) {
+        if (sim->per_pc[offset].accesses)
+            rows[used++] = (CacheRow){ offset, sim->per_pc[offset] };
+    }
+    qsort(rows, used, sizeof(CacheRow), compare_rows);
+    if (used > top)
+        used = top;
+    if (used)
+        fprintf(out, "  %-10s %-28s %12s %12s %7s\n", "pc", "instruction", "accesses", "misses", "miss%");
+    for (uint32_t i = 0; i < used; i++) {
+        uint32_t pc = sim->range.start_address + rows[i].index;
+        char text[64] = "?";
+        DecodedInstruction insn;
+        if (decode_instruction(words, RAM_SIZE, pc, sim->range.encoding, &insn))
+            format_instruction(&insn, text, sizeof(text));
+        fprintf(out, "  0x%08X %-28s %12llu %12llu %6.2f%%\n", pc, text, (unsigned long long)rows[i].stats.accesses,
+                (unsigned long long)rows[i].stats.misses, percent(rows[i].stats.misses, rows[i].stats.accesses));
+    }
+    free(rows);
+}
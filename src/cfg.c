@@ -0,0 +1,777 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "../include/cfg.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "disasm.h"
+#include "log.h"
+
+/**
+ * @brief Allocate `count` elements of `size` bytes (at least one element).
+ */
+static void *cfg_alloc(size_t count, size_t size) {
+    return malloc((count ? count : 1) * size);
+}
+
+/**
+ * @brief Decode the instructions reachable from the entry and record where each starts.
+ *
+ * Starting at start_address, follows every fall-through and jump target
+ * with an explicit worklist; words never reached are data (e.g. .org gaps)
+ * and are not decoded. The instructions are then listed in address order.
+ *
+ * @param index_of Receives, per address offset (span + 1 entries), the
+ *        index of the instruction starting there or CFG_NONE; the entry for
+ *        end_address holds insn_count.
+ */
+static bool decode_range(ControlFlowGraph *cfg, const uint32_t *words, uint32_t limit, uint32_t *index_of) {
+    AssemblyRange range = cfg->range;
+    uint32_t span = range.end_address - range.start_address;
+
+    cfg->insns = cfg_alloc(span, sizeof(DecodedInstruction));
+    cfg->insn_addresses = cfg_alloc(span, sizeof(uint32_t));
+    uint32_t *work = cfg_alloc(span, sizeof(uint32_t));
+    if (!cfg->insns || !cfg->insn_addresses || !work) {
+        free(work);
+        log_write(LOG_ERROR, "CFG: out of memory decoding %u words", span);
+        return false;
+    }
+    for (uint32_t i = 0; i <= span; i++)
+        index_of[i] = CFG_NONE;
+
+    /* Pass 1: mark reachable instruction starts, decoding each once into its own slot. */
+    uint32_t queued = 0;
+    if (span > 0) {
+        index_of[0] = 0;
+        work[queued++] = range.start_address;
+    }
+    bool ok = true;
+    while (ok && queued > 0) {
+        uint32_t pc = work[--queued];
+        DecodedInstruction insn;
+        if (!decode_instruction(words, limit, pc, range.encoding, &insn)) {
+            log_write(LOG_ERROR, "CFG: invalid instruction 0x%08X at 0x%08X", words[pc], pc);
+            ok = false;
+            break;
+        }
+        if (insn.length > range.end_address - pc) {
+            log_write(LOG_ERROR, "CFG: instruction at 0x%08X overruns the range end 0x%08X", pc,
+                      range.end_address);
+            ok = false;
+            break;
+        }
+        cfg->insns[pc - range.start_address] = insn;
+
+        uint32_t next[2];
+        uint32_t count = 0;
+        if (insn.opcode != ISA_HALT && insn.opcode != ISA_JMP)
+            next[count++] = pc + insn.length;
+        if (isa_is_jump(insn.opcode)) {
+            uint32_t target = insn.operand;
+            if (target < range.start_address || target > range.end_address) {
+                log_write(LOG_ERROR, "CFG: jump at 0x%08X targets 0x%08X, which is outside the range", pc, target);
+                ok = false;
+                break;
+            }
+            next[count++] = target;
+        }
+        for (uint32_t k = 0; k < count; k++) {
+            uint32_t offset = next[k] - range.start_address;
+            if (offset < span && index_of[offset] == CFG_NONE) {
+                index_of[offset] = 0;
+                work[queued++] = next[k];
+            }
+        }
+    }
+    free(work);
+    if (!ok)
+        return false;
+
+    /* Pass 2: compact in address order; reachable instructions must not overlap. */
+    uint32_t n = 0;
+    uint32_t covered = range.start_address;
+    for (uint32_t offset = 0; offset < span; offset++) {
+        if (index_of[offset] == CFG_NONE)
+            continue;
+        uint32_t pc = range.start_address + offset;
+        if (pc < covered) {
+            log_write(LOG_ERROR, "CFG: code at 0x%08X starts inside the instruction at 0x%08X", pc,
+                      cfg->insn_addresses[n - 1]);
+            return false;
+        }
+        cfg->insns[n] = cfg->insns[offset];
+        index_of[offset] = n;
+        cfg->insn_addresses[n++] = pc;
+        covered = pc + cfg->insns[n - 1].length;
+    }
+    index_of[span] = n;
+    cfg->insn_count = n;
+    return true;
+}
+
+/**
+ * @brief Split the instruction stream into basic blocks and connect them.
+ */
+static bool build_blocks(ControlFlowGraph *cfg, const uint32_t *index_of) {
+    uint32_t n = cfg->insn_count;
+    uint32_t start = cfg->range.start_address;
+    bool *leader = calloc(n ? n : 1, sizeof(bool));
+    uint32_t *block_of_insn = cfg_alloc(n, sizeof(uint32_t));
+    if (!leader || !block_of_insn) {
+        free(leader);
+        free(block_of_insn);
+        log_write(LOG_ERROR, "CFG: out of memory splitting blocks");
+        return false;
+    }
+
+    leader[0] = true;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t op = cfg->insns[i].opcode;
+        if (isa_is_jump(op)) {
+            uint32_t target = index_of[cfg->insns[i].operand - start];
+            if (target < n)
+                leader[target] = true;
+        }
+        if ((isa_is_jump(op) || op == ISA_HALT) && i + 1 < n)
+            leader[i + 1] = true;
+    }
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < n; i++)
+        count += leader[i];
+
+    cfg->blocks = calloc(count, sizeof(BasicBlock));
+    if (!cfg->blocks) {
+        free(leader);
+        free(block_of_insn);
+        log_write(LOG_ERROR, "CFG: out of memory allocating %u blocks", count);
+        return false;
+    }
+    cfg->block_count = count;
+
+    uint32_t b = CFG_NONE;
+    for (uint32_t i = 0; i < n; i++) {
+        if (leader[i]) {
+            b = b == CFG_NONE ? 0 : b + 1;
+            cfg->blocks[b] = (BasicBlock){
+                .start_address = cfg->insn_addresses[i],
+                .first_insn = i,
+                .succ = { CFG_NONE, CFG_NONE },
+                .idom = CFG_NONE,
+                .loop = CFG_NONE,
+            };
+        }
+        BasicBlock *block = &cfg->blocks[b];
+        block->insn_count++;
+        block->end_address = cfg->insn_addresses[i] + cfg->insns[i].length;
+        block->terminator = cfg->insns[i].opcode;
+        block_of_insn[i] = b;
+        for (uint32_t a = cfg->insn_addresses[i]; a < block->end_address; a++)
+            cfg->block_of[a - start] = b;
+    }
+
+    for (b = 0; b < count; b++) {
+        BasicBlock *block = &cfg->blocks[b];
+        const DecodedInstruction *last = &cfg->insns[block->first_insn + block->insn_count - 1];
+        uint32_t next = b + 1 < count ? b + 1 : CFG_NONE;
+        uint32_t target = CFG_NONE;
+        if (isa_is_jump(last->opcode)) {
+            uint32_t t = index_of[last->operand - start];
+            target = t < n ? block_of_insn[t] : CFG_NONE;
+        }
+
+        switch (last->opcode) {
+            case ISA_HALT:
+                break;
+            case ISA_JMP:
+                block->succ[0] = target;
+                block->exits = target == CFG_NONE;
+                break;
+            case ISA_JZ: case ISA_JNZ:
+                block->succ[0] = target;
+                block->succ[1] = next;
+                block->exits = target == CFG_NONE || next == CFG_NONE;
+                break;
+            default:
+                block->succ[0] = next;
+                block->exits = next == CFG_NONE;
+                break;
+        }
+    }
+
+    free(leader);
+    free(block_of_insn);
+    return true;
+}
+
+/**
+ * @brief Return true if edge slot `k` of `block` names a distinct successor.
+ *
+ * A conditional jump to the next block lists the same successor twice; it
+ * is one edge for predecessor lists and traversals.
+ */
+static bool is_distinct_succ(const BasicBlock *block, int k) {
+    if (block->succ[k] == CFG_NONE)
+        return false;
+    return k == 0 || block->succ[1] != block->succ[0];
+}
+
+/**
+ * @brief Fill predecessor lists with a counting sort over all edges.
+ */
+static bool build_preds(ControlFlowGraph *cfg) {
+    uint32_t count = cfg->block_count;
+    uint32_t edges = 0;
+    for (uint32_t b = 0; b < count; b++) {
+        for (int k = 0; k < 2; k++) {
+            if (is_distinct_succ(&cfg->blocks[b], k)) {
+                cfg->blocks[cfg->blocks[b].succ[k]].pred_count++;
+                edges++;
+            }
+        }
+    }
+
+    cfg->preds = cfg_alloc(edges, sizeof(uint32_t));
+    if (!cfg->preds) {
+        log_write(LOG_ERROR, "CFG: out of memory allocating %u edges", edges);
+        return false;
+    }
+
+    uint32_t offset = 0;
+    for (uint32_t b = 0; b < count; b++) {
+        cfg->blocks[b].pred_first = offset;
+        offset += cfg->blocks[b].pred_count;
+        cfg->blocks[b].pred_count = 0;
+    }
+    for (uint32_t b = 0; b < count; b++) {
+        for (int k = 0; k < 2; k++) {
+            if (!is_distinct_succ(&cfg->blocks[b], k))
+                continue;
+            BasicBlock *succ = &cfg->blocks[cfg->blocks[b].succ[k]];
+            cfg->preds[succ->pred_first + succ->pred_count++] = b;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Number reachable blocks in DFS preorder and collect reverse postorder.
+ *
+ * @param pre Receives the 1-based preorder number per block (0 = unreachable).
+ * @param vertex Receives the block for each preorder number.
+ * @param dfs_parent Receives the DFS-tree parent per preorder number.
+ * @return Number of reachable blocks.
+ */
+static uint32_t depth_first_search(ControlFlowGraph *cfg, uint32_t *pre, uint32_t *vertex, uint32_t *dfs_parent,
+                                   uint32_t *stack, uint8_t *next_edge) {
+    uint32_t count = cfg->block_count;
+    uint32_t numbered = 0;
+    uint32_t post = count;
+    uint32_t top = 0;
+
+    memset(pre, 0, sizeof(uint32_t) * count);
+    memset(next_edge, 0, count);
+    if (count == 0)
+        return 0;
+
+    pre[0] = ++numbered;
+    vertex[numbered] = 0;
+    dfs_parent[numbered] = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        uint32_t b = stack[top - 1];
+        BasicBlock *block = &cfg->blocks[b];
+        if (next_edge[b] < 2) {
+            int k = next_edge[b]++;
+            if (!is_distinct_succ(block, k))
+                continue;
+            uint32_t s = block->succ[k];
+            if (pre[s] == 0) {
+                pre[s] = ++numbered;
+                vertex[numbered] = s;
+                dfs_parent[numbered] = pre[b];
+                stack[top++] = s;
+            }
+            continue;
+        }
+        block->reachable = true;
+        cfg->rpo[--post] = b;
+        top--;
+    }
+
+    /* Postorder was written from the back; slide it to the front. */
+    uint32_t reachable = count - post;
+    memmove(cfg->rpo, &cfg->rpo[post], sizeof(uint32_t) * reachable);
+    return reachable;
+}
+
+/**
+ * @brief Path-compressing EVAL of Lengauer-Tarjan, done iteratively.
+ */
+static uint32_t lt_eval(uint32_t v, uint32_t *ancestor, uint32_t *label, const uint32_t *semi, uint32_t *path) {
+    if (ancestor[v] == 0)
+        return v;
+
+    uint32_t depth = 0;
+    for (uint32_t x = v; ancestor[ancestor[x]] != 0; x = ancestor[x])
+        path[depth++] = x;
+    while (depth > 0) {
+        uint32_t x = path[--depth];
+        uint32_t a = ancestor[x];
+        if (semi[label[a]] < semi[label[x]])
+            label[x] = label[a];
+        ancestor[x] = ancestor[a];
+    }
+    return label[v];
+}
+
+/**
+ * @brief Compute immediate dominators with Lengauer-Tarjan (simple linking).
+ *
+ * Works on preorder numbers 1..n; 0 is the null vertex.
+ */
+static bool compute_dominators(ControlFlowGraph *cfg, const uint32_t *pre, const uint32_t *vertex,
+                               const uint32_t *dfs_parent, uint32_t n) {
+    size_t size = (size_t)n + 1;
+    uint32_t *semi = cfg_alloc(size, sizeof(uint32_t));
+    uint32_t *label = cfg_alloc(size, sizeof(uint32_t));
+    uint32_t *ancestor = cfg_alloc(size, sizeof(uint32_t));
+    uint32_t *idom = cfg_alloc(size, sizeof(uint32_t));
+    uint32_t *bucket = cfg_alloc(size, sizeof(uint32_t));
+    uint32_t *bucket_next = cfg_alloc(size, sizeof(uint32_t));
+    uint32_t *path = cfg_alloc(size, sizeof(uint32_t));
+    bool ok = semi && label && ancestor && idom && bucket && bucket_next && path;
+
+    if (ok) {
+        for (uint32_t v = 0; v <= n; v++) {
+            semi[v] = v;
+            label[v] = v;
+            ancestor[v] = 0;
+            idom[v] = 0;
+            bucket[v] = 0;
+        }
+
+        for (uint32_t w = n; w >= 2; w--) {
+            const BasicBlock *block = &cfg->blocks[vertex[w]];
+            for (uint32_t k = 0; k < block->pred_count; k++) {
+                uint32_t v = pre[cfg->preds[block->pred_first + k]];
+                if (v == 0)
+                    continue;
+                uint32_t u = lt_eval(v, ancestor, label, semi, path);
+                if (semi[u] < semi[w])
+                    semi[w] = semi[u];
+            }
+            bucket_next[w] = bucket[semi[w]];
+            bucket[semi[w]] = w;
+
+            uint32_t p = dfs_parent[w];
+            ancestor[w] = p;
+            for (uint32_t v = bucket[p]; v != 0; v = bucket_next[v]) {
+                uint32_t u = lt_eval(v, ancestor, label, semi, path);
+                idom[v] = semi[u] < semi[v] ? u : p;
+            }
+            bucket[p] = 0;
+        }
+        for (uint32_t w = 2; w <= n; w++) {
+            if (idom[w] != semi[w])
+                idom[w] = idom[idom[w]];
+            cfg->blocks[vertex[w]].idom = vertex[idom[w]];
+        }
+    } else {
+        log_write(LOG_ERROR, "CFG: out of memory computing dominators");
+    }
+
+    free(semi);
+    free(label);
+    free(ancestor);
+    free(idom);
+    free(bucket);
+    free(bucket_next);
+    free(path);
+    return ok;
+}
+
+/**
+ * @brief Number the dominator tree so dominance is an interval test.
+ */
+static bool number_dominator_tree(ControlFlowGraph *cfg) {
+    uint32_t count = cfg->block_count;
+    uint32_t *child_first = calloc((size_t)count + 1, sizeof(uint32_t));
+    uint32_t *children = cfg_alloc(count, sizeof(uint32_t));
+    uint32_t *stack = cfg_alloc(count, sizeof(uint32_t));
+    uint32_t *next_child = cfg_alloc(count, sizeof(uint32_t));
+    if (!child_first || !children || !stack || !next_child) {
+        free(child_first);
+        free(children);
+        free(stack);
+        free(next_child);
+        log_write(LOG_ERROR, "CFG: out of memory numbering the dominator tree");
+        return false;
+    }
+
+    for (uint32_t b = 0; b < count; b++) {
+        if (cfg->blocks[b].idom != CFG_NONE)
+            child_first[cfg->blocks[b].idom + 1]++;
+    }
+    for (uint32_t b = 0; b < count; b++)
+        child_first[b + 1] += child_first[b];
+    for (uint32_t b = 0; b < count; b++)
+        next_child[b] = child_first[b];
+    for (uint32_t b = 0; b < count; b++) {
+        uint32_t d = cfg->blocks[b].idom;
+        if (d != CFG_NONE)
+            children[next_child[d]++] = b;
+    }
+    for (uint32_t b = 0; b < count; b++)
+        next_child[b] = child_first[b];
+
+    uint32_t clock = 0;
+    uint32_t top = 0;
+    if (count > 0 && cfg->blocks[0].reachable) {
+        cfg->blocks[0].dom_pre = clock++;
+        stack[top++] = 0;
+    }
+    while (top > 0) {
+        uint32_t b = stack[top - 1];
+        if (next_child[b] < child_first[b + 1]) {
+            uint32_t c = children[next_child[b]++];
+            cfg->blocks[c].dom_pre = clock++;
+            stack[top++] = c;
+        } else {
+            cfg->blocks[b].dom_post = clock++;
+            top--;
+        }
+    }
+
+    free(child_first);
+    free(children);
+    free(stack);
+    free(next_child);
+    return true;
+}
+
+/**
+ * @brief Union-find FIND with path halving.
+ */
+static uint32_t uf_find(uint32_t *parent, uint32_t x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+/**
+ * @brief Build the natural-loop nesting forest.
+ *
+ * Headers are visited in decreasing DFS preorder, so a loop nested in
+ * another is always discovered first. Each discovered body is collapsed
+ * into its header with union-find, letting an enclosing loop step over the
+ * whole inner loop through its header's predecessors.
+ */
+static bool find_loops(ControlFlowGraph *cfg, const uint32_t *vertex, uint32_t n) {
+    uint32_t count = cfg->block_count;
+    uint32_t *rep = cfg_alloc(count, sizeof(uint32_t));
+    uint32_t *loop_of_header = cfg_alloc(count, sizeof(uint32_t));
+    uint32_t *stamp = cfg_alloc(count, sizeof(uint32_t));
+    uint32_t *work = cfg_alloc(count, sizeof(uint32_t));
+    cfg->loops = cfg_alloc(count, sizeof(NaturalLoop));
+    if (!rep || !loop_of_header || !stamp || !work || !cfg->loops) {
+        free(rep);
+        free(loop_of_header);
+        free(stamp);
+        free(work);
+        log_write(LOG_ERROR, "CFG: out of memory finding loops");
+        return false;
+    }
+    for (uint32_t b = 0; b < count; b++) {
+        rep[b] = b;
+        loop_of_header[b] = CFG_NONE;
+        stamp[b] = CFG_NONE;
+    }
+
+    for (uint32_t i = n; i >= 1; i--) {
+        uint32_t h = vertex[i];
+        const BasicBlock *header = &cfg->blocks[h];
+        uint32_t loop = cfg->loop_count;
+        uint32_t queued = 0;
+        uint32_t back_edges = 0;
+
+        for (uint32_t k = 0; k < header->pred_count; k++) {
+            uint32_t p = cfg->preds[header->pred_first + k];
+            if (!cfg->blocks[p].reachable || !cfg_dominates(cfg, h, p))
+                continue;
+            back_edges++;
+            uint32_t r = uf_find(rep, p);
+            if (r != h && stamp[r] != loop) {
+                stamp[r] = loop;
+                work[queued++] = r;
+            }
+        }
+        if (back_edges == 0)
+            continue;
+
+        cfg->loop_count++;
+        loop_of_header[h] = loop;
+        cfg->blocks[h].loop = loop;
+        uint32_t body = 1;
+
+        for (uint32_t q = 0; q < queued; q++) {
+            uint32_t w = work[q];
+            if (loop_of_header[w] != CFG_NONE) {
+                cfg->loops[loop_of_header[w]].parent = loop;
+                body += cfg->loops[loop_of_header[w]].block_count;
+            } else {
+                cfg->blocks[w].loop = loop;
+                body++;
+            }
+
+            const BasicBlock *block = &cfg->blocks[w];
+            for (uint32_t k = 0; k < block->pred_count; k++) {
+                uint32_t p = cfg->preds[block->pred_first + k];
+                if (!cfg->blocks[p].reachable)
+                    continue;
+                uint32_t r = uf_find(rep, p);
+                if (r == h || stamp[r] == loop)
+                    continue;
+                stamp[r] = loop;
+                work[queued++] = r;
+            }
+        }
+        for (uint32_t q = 0; q < queued; q++)
+            rep[work[q]] = h;
+
+        cfg->loops[loop] = (NaturalLoop){
+            .header = h,
+            .parent = CFG_NONE,
+            .block_count = body,
+            .back_edges = back_edges,
+        };
+    }
+
+    /* Parents are discovered after their children, so walk outermost first. */
+    for (uint32_t l = cfg->loop_count; l-- > 0;) {
+        NaturalLoop *loop = &cfg->loops[l];
+        loop->depth = loop->parent == CFG_NONE ? 1 : cfg->loops[loop->parent].depth + 1;
+    }
+    for (uint32_t b = 0; b < count; b++) {
+        if (cfg->blocks[b].loop != CFG_NONE)
+            cfg->blocks[b].loop_depth = cfg->loops[cfg->blocks[b].loop].depth;
+    }
+
+    free(rep);
+    free(loop_of_header);
+    free(stamp);
+    free(work);
+    return true;
+}
+
+/**
+ * @brief Build the CFG, dominator tree and loop forest for a range.
+ */
+bool cfg_build(ControlFlowGraph *cfg, const uint32_t *words, uint32_t limit, AssemblyRange range) {
+    if (!cfg) {
+        log_write(LOG_ERROR, "CFG: output pointer is NULL");
+        return false;
+    }
+    *cfg = (ControlFlowGraph){ .range = range };
+
+    if (!words || range.error || range.end_address < range.start_address || range.end_address > limit) {
+        log_write(LOG_ERROR, "CFG: invalid range [0x%08X, 0x%08X)", range.start_address, range.end_address);
+        return false;
+    }
+
+    uint32_t span = range.end_address - range.start_address;
+    uint32_t *index_of = cfg_alloc((size_t)span + 1, sizeof(uint32_t));
+    cfg->block_of = cfg_alloc(span, sizeof(uint32_t));
+    if (!index_of || !cfg->block_of) {
+        free(index_of);
+        log_write(LOG_ERROR, "CFG: out of memory for a %u-word range", span);
+        return false;
+    }
+    for (uint32_t i = 0; i < span; i++)
+        cfg->block_of[i] = CFG_NONE;
+
+    bool ok = decode_range(cfg, words, limit, index_of);
+    if (ok && cfg->insn_count == 0) {
+        free(index_of);
+        return true;
+    }
+    ok = ok && build_blocks(cfg, index_of);
+    free(index_of);
+    ok = ok && build_preds(cfg);
+    if (!ok)
+        return false;
+
+    uint32_t count = cfg->block_count;
+    size_t size = (size_t)count + 1;
+    uint32_t *pre = cfg_alloc(count, sizeof(uint32_t));
+    uint32_t *vertex = cfg_alloc(size, sizeof(uint32_t));
+    uint32_t *dfs_parent = cfg_alloc(size, sizeof(uint32_t));
+    uint32_t *stack = cfg_alloc(count, sizeof(uint32_t));
+    uint8_t *next_edge = cfg_alloc(count, sizeof(uint8_t));
+    cfg->rpo = cfg_alloc(count, sizeof(uint32_t));
+    ok = pre && vertex && dfs_parent && stack && next_edge && cfg->rpo;
+    if (!ok)
+        log_write(LOG_ERROR, "CFG: out of memory traversing %u blocks", count);
+
+    if (ok) {
+        uint32_t n = depth_first_search(cfg, pre, vertex, dfs_parent, stack, next_edge);
+        cfg->reachable_count = n;
+        ok = compute_dominators(cfg, pre, vertex, dfs_parent, n)
+             && number_dominator_tree(cfg)
+             && find_loops(cfg, vertex, n);
+    }
+
+    free(pre);
+    free(vertex);
+    free(dfs_parent);
+    free(stack);
+    free(next_edge);
+    return ok;
+}
+
+/**
+ * @brief Release every array owned by the CFG and reset it.
+ */
+void cfg_free(ControlFlowGraph *cfg) {
+    if (!cfg)
+        return;
+    free(cfg->insns);
+    free(cfg->insn_addresses);
+    free(cfg->blocks);
+    free(cfg->preds);
+    free(cfg->rpo);
+    free(cfg->loops);
+    free(cfg->block_of);
+    *cfg = (ControlFlowGraph){ 0 };
+}
+
+/**
+ * @brief Return the block containing `address`, or CFG_NONE if outside the range.
+ */
+uint32_t cfg_block_at(const ControlFlowGraph *cfg, uint32_t address) {
+    if (!cfg || !cfg->block_of || address < cfg->range.start_address || address >= cfg->range.end_address)
+        return CFG_NONE;
+    return cfg->block_of[address - cfg->range.start_address];
+}
+
+/**
+ * @brief Return true if block `a` dominates block `b`.
+ */
+bool cfg_dominates(const ControlFlowGraph *cfg, uint32_t a, uint32_t b) {
+    if (!cfg || a >= cfg->block_count || b >= cfg->block_count)
+        return false;
+    const BasicBlock *x = &cfg->blocks[a];
+    const BasicBlock *y = &cfg->blocks[b];
+    if (!x->reachable || !y->reachable)
+        return false;
+    return x->dom_pre <= y->dom_pre && y->dom_post <= x->dom_post;
+}
+
+/**
+ * @brief Return true if `block` belongs to `loop` (directly or via a nested loop).
+ */
+bool cfg_loop_contains(const ControlFlowGraph *cfg, uint32_t loop, uint32_t block) {
+    if (!cfg || block >= cfg->block_count)
+        return false;
+    for (uint32_t l = cfg->blocks[block].loop; l != CFG_NONE; l = cfg->loops[l].parent) {
+        if (l == loop)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Write the CFG in Graphviz DOT format.
+ */
+void cfg_write_dot(const ControlFlowGraph *cfg, FILE *out, bool with_instructions) {
+    if (!cfg || !out)
+        return;
+
+    fprintf(out, "digraph cfg {\n");
+    fprintf(out, "    node [shape=box, fontname=\"monospace\"];\n");
+
+    bool any_exit = false;
+    for (uint32_t b = 0; b < cfg->block_count; b++) {
+        const BasicBlock *block = &cfg->blocks[b];
+        any_exit = any_exit || block->exits;
+
+        fprintf(out, "    b%u [label=\"B%u [0x%04X, 0x%04X)", b, b, block->start_address, block->end_address);
+        if (block->loop != CFG_NONE && cfg->loops[block->loop].header == b)
+            fprintf(out, "\\lloop L%u header, depth %u", block->loop, block->loop_depth);
+        fprintf(out, "\\l");
+        if (with_instructions) {
+            for (uint32_t i = 0; i < block->insn_count; i++) {
+                char text[64];
+                format_instruction(&cfg->insns[block->first_insn + i], text, sizeof(text));
+                fprintf(out, "0x%04X: %s\\l", cfg->insn_addresses[block->first_insn + i], text);
+            }
+        }
+        fprintf(out, "\"");
+        if (!block->reachable)
+            fprintf(out, ", style=dashed, color=gray");
+        else if (block->loop != CFG_NONE && cfg->loops[block->loop].header == b)
+            fprintf(out, ", style=filled, fillcolor=lightblue");
+        fprintf(out, "];\n");
+    }
+    if (any_exit)
+        fprintf(out, "    exit [shape=doublecircle];\n");
+
+    for (uint32_t b = 0; b < cfg->block_count; b++) {
+        const BasicBlock *block = &cfg->blocks[b];
+        bool conditional = block->terminator == ISA_JZ || block->terminator == ISA_JNZ;
+        for (int k = 0; k < 2; k++) {
+            uint32_t s = block->succ[k];
+            if (s == CFG_NONE)
+                continue;
+            bool back_edge = cfg_dominates(cfg, s, b);
+            fprintf(out, "    b%u -> b%u", b, s);
+            if (conditional || back_edge) {
+                fprintf(out, " [");
+                if (conditional)
+                    fprintf(out, "label=\"%s\"%s", k == 0 ? "T" : "F", back_edge ? ", " : "");
+                if (back_edge)
+                    fprintf(out, "style=bold, color=red");
+                fprintf(out, "]");
+            }
+            fprintf(out, ";\n");
+        }
+        if (block->exits)
+            fprintf(out, "    b%u -> exit [style=dashed];\n", b);
+    }
+    fprintf(out, "}\n");
+}
+
+/**
+ * @brief Print block, edge and loop counts plus per-loop details.
+ */
+void cfg_print_summary(const ControlFlowGraph *cfg, FILE *out) {
+    if (!cfg || !out)
+        return;
+
+    uint32_t edges = 0;
+    uint32_t max_depth = 0;
+    for (uint32_t b = 0; b < cfg->block_count; b++) {
+        edges += cfg->blocks[b].pred_count;
+        if (cfg->blocks[b].loop_depth > max_depth)
+            max_depth = cfg->blocks[b].loop_depth;
+    }
+
+    fprintf(out, "CFG: %u instructions, %u blocks (%u reachable), %u edges, %u loops (max depth %u)\n",
+            cfg->insn_count, cfg->block_count, cfg->reachable_count, edges, cfg->loop_count, max_depth);
+    for (uint32_t l = 0; l < cfg->loop_count; l++) {
+        const NaturalLoop *loop = &cfg->loops[l];
+        fprintf(out, "  loop L%u: header B%u @0x%04X, depth %u, %u blocks, %u back edges",
+                l, loop->header, cfg->blocks[loop->header].start_address, loop->depth,
+                loop->block_count, loop->back_edges);
+        if (loop->parent != CFG_NONE)
+            fprintf(out, ", inside L%u", loop->parent);
+        fprintf(out, "\n");
+    }
+}
@@ -0,0 +1,79 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "code_regions.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+
+/**
+ * @brief Order labels by address, keeping definition order for equal addresses.
+ */
+static int compare_labels(const void *a, const void *b) {
+    const Label *x = *(const Label *const *)a;
+    const Label *y = *(const Label *const *)b;
+    if (x->address != y->address)
+        return x->address < y->address ? -1 : 1;
+    return x < y ? -1 : (x > y);
+}
+
+static void add_region(CodeRegionMap *map, const char *name, uint32_t start) {
+    CodeRegion *region = &map->regions[map->count++];
+    snprintf(region->name, sizeof(region->name), "%s", name);
+    region->start_address = start;
+    region->end_address = map->range.end_address;
+    if (map->count > 1)
+        map->regions[map->count - 2].end_address = start;
+}
+
+bool code_regions_build(CodeRegionMap *map, AssemblyRange range, const LabelTable *labels) {
+    memset(map, 0, sizeof(*map));
+    map->range = range;
+    uint32_t size = range.end_address > range.start_address ? range.end_address - range.start_address : 0;
+    size_t label_count = labels ? labels->count : 0;
+
+    const Label **sorted = calloc(label_count ? label_count : 1, sizeof(*sorted));
+    map->regions = calloc(label_count + 1, sizeof(CodeRegion));
+    map->region_of = calloc(size ? size : 1, sizeof(uint32_t));
+    if (!sorted || !map->regions || !map->region_of) {
+        log_write(LOG_ERROR, "Out of memory building label regions");
+        free(sorted);
+        code_regions_free(map);
+        return false;
+    }
+
+    size_t inside = 0;
+    for (size_t i = 0; i < label_count; i++) {
+        const Label *label = &labels->entries[i];
+        if (label->address >= range.start_address && label->address < range.end_address)
+            sorted[inside++] = label;
+    }
+    qsort(sorted, inside, sizeof(*sorted), compare_labels);
+
+    if (inside == 0 || sorted[0]->address != range.start_address)
+        add_region(map, inside ? "<entry>" : "<program>", range.start_address);
+    for (size_t i = 0; i < inside; i++) {
+        if (i > 0 && sorted[i]->address == sorted[i - 1]->address)
+            continue;
+        add_region(map, sorted[i]->name, sorted[i]->address);
+    }
+    free(sorted);
+
+    for (uint32_t r = 0; r < map->count; r++) {
+        for (uint32_t a = map->regions[r].start_address; a < map->regions[r].end_address; a++)
+            map->region_of[a - range.start_address] = r;
+    }
+    return true;
+}
+
+void code_regions_free(CodeRegionMap *map) {
+    free(map->regions);
+    free(map->region_of);
+    map->regions = NULL;
+    map->region_of = NULL;
+    map->count = 0;
+}
@@ -0,0 +1,84 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "coverage.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/shm.h>
+
+#include "log.h"
+
+bool coverage_map_init(CoverageMap *map) {
+    map->shared = false;
+    map->bits = calloc(COVERAGE_MAP_SIZE, 1);
+    if (!map->bits) {
+        log_write(LOG_ERROR, "Out of memory allocating the coverage bitmap");
+        return false;
+    }
+    return true;
+}
+
+bool coverage_map_attach_shm(CoverageMap *map, int shm_id) {
+    map->bits = NULL;
+    map->shared = false;
+
+    struct shmid_ds info;
+    if (shmctl(shm_id, IPC_STAT, &info) != 0) {
+        log_write(LOG_ERROR, "No shared memory segment with id %d", shm_id);
+        return false;
+    }
+    if (info.shm_segsz < COVERAGE_MAP_SIZE) {
+        log_write(LOG_ERROR, "Shared memory segment %d has %zu bytes; the coverage bitmap needs %u", shm_id,
+                  (size_t)info.shm_segsz, COVERAGE_MAP_SIZE);
+        return false;
+    }
+    void *bits = shmat(shm_id, NULL, 0);
+    if (bits == (void *)-1) {
+        log_write(LOG_ERROR, "Unable to attach shared memory segment %d", shm_id);
+        return false;
+    }
+    map->bits = bits;
+    map->shared = true;
+    return true;
+}
+
+void coverage_map_free(CoverageMap *map) {
+    if (map->shared)
+        shmdt(map->bits);
+    else
+        free(map->bits);
+    map->bits = NULL;
+    map->shared = false;
+}
+
+void coverage_map_reset(CoverageMap *map) {
+    memset(map->bits, 0, COVERAGE_MAP_SIZE);
+}
+
+uint32_t coverage_map_count(const CoverageMap *map) {
+    /* Scan eight counters at a time; most of a typical map is zero. */
+    const uint64_t *words = (const uint64_t *)map->bits;
+    uint32_t count = 0;
+    for (uint32_t w = 0; w < COVERAGE_MAP_SIZE / 8; w++) {
+        if (!words[w])
+            continue;
+        for (uint32_t b = 0; b < 8; b++)
+            count += map->bits[w * 8 + b] != 0;
+    }
+    return count;
+}
+
+bool coverage_map_write(const CoverageMap *map, const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        log_write(LOG_ERROR, "Unable to open coverage file: %s", path);
+        return false;
+    }
+    bool ok = fwrite(map->bits, 1, COVERAGE_MAP_SIZE, file) == COVERAGE_MAP_SIZE;
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+        log_write(LOG_ERROR, "Unable to write coverage file: %s", path);
+    return ok;
+}
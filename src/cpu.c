@@ -32,6 +32,9 @@ void cpu_init(CPU *cpu) {
     cpu->running = false;
     cpu->zero_flag = false;
     cpu->negative_flag = false;
+    cpu->instructions_retired = 0;
+    cpu->stop_reason = CPU_STOP_NONE;
+    cpu->cycles = 0;
     log_write(LOG_INFO, "CPU initialized: PC=0, all registers cleared, running=false");
 }
 
@@ -75,4 +78,27 @@ void cpu_print(const CPU cpu) {
     log_write(LOG_DEBUG, "  Zero flag: %s", cpu.zero_flag ? "true" : "false");
     log_write(LOG_DEBUG, "  Negative flag: %s", cpu.negative_flag ? "true" : "false");
     log_write(LOG_DEBUG, "  Running: %s", cpu.running ? "true" : "false");
-}
\ No newline at end of file
+    log_write(LOG_DEBUG, "  Instructions retired: %llu", (unsigned long long)cpu.instructions_retired);
+}
+
+/**
+ * @brief Short lowercase name of a stop reason.
+ *
+ * @param reason Stop reason to name.
+ * @return Static string; "unknown" for values outside the enum.
+ */
+const char *cpu_stop_reason_name(CpuStopReason reason) {
+    switch (reason) {
+        case CPU_STOP_NONE:                return "none";
+        case CPU_STOP_HALT:                return "halt";
+        case CPU_STOP_END:                 return "end";
+        case CPU_STOP_LIMIT:               return "limit";
+        case CPU_STOP_INVALID_INSTRUCTION: return "invalid_instruction";
+        case CPU_STOP_DIV_ZERO:            return "div_zero";
+        case CPU_STOP_FAULT:               return "fault";
+        case CPU_STOP_ERROR:               return "error";
+        case CPU_STOP_BREAKPOINT:          return "breakpoint";
+        case CPU_STOP_WATCHPOINT:          return "watchpoint";
+        default:                           return "unknown";
+    }
+}
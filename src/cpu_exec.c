@@ -8,6 +8,10 @@
 #include "isa.h"
 #include "../include/validation.h"
 #include "../include/assembler.h" // for OPERAND_REGISTER / OPERAND_NUMERIC
+#include "../include/encoding.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
 
 #define INVALID_REGISTER_INDEX_ERROR_MESSAGE "Invalid register index"
 #define INVALID_ADDRESS_REGISTER_INDEX_ERROR_MESSAGE "Invalid address index"
@@ -28,26 +32,12 @@ static void increase_pc(CPU *cpu, const uint32_t skip) {
     cpu->pc += skip;
 }
 
-/**
- * @brief Read a 32-bit word from RAM at cpu->pc + skip.
- *
- * This helper computes the RAM index as `cpu->pc + skip`, validates that
- * the index is within `RAM_SIZE`, logs an error and returns 0 on out-of-
- * bounds access. The returned value is the 32-bit word stored in RAM.
- *
- * @param ram Pointer to the RAM object.
- * @param cpu Pointer to the CPU (used for pc).
- * @param skip Offset (in 32-bit words) from the current pc to read.
- * @return The 32-bit word at the computed RAM index, or 0 on error.
+/*
+ * Instruction handlers receive the instruction already decoded by
+ * decode_instruction() (see encoding.h), so they are shared by the wide and
+ * packed encodings. The "Opcode layout" sections below describe the wide
+ * encoding; `insn->length` gives the actual size to advance the PC by.
  */
-static uint32_t get_value_in_ram(RAM *ram, CPU *cpu, uint32_t skip) {
-    uint32_t idx = cpu->pc + skip;
-    if (idx >= RAM_SIZE) {
-        log_write(LOG_ERROR, "RAM access out of bounds: 0x%08X", idx);
-        return 0;
-    }
-    return ram->cells[idx];
-}
 
 /**
  * @brief Execute LOADI instruction (LOAD immediate into register).
@@ -60,13 +50,12 @@ static uint32_t get_value_in_ram(RAM *ram, CPU *cpu, uint32_t skip) {
  * Semantics: cpu->registers[register_index] = value
  * Side-effects: advances PC by 3 words. Validates register index.
  *
- * @param ram RAM containing instruction operands (read-only for LOADI)
  * @param cpu CPU state to update (registers, pc)
  * @return true on success, false on error (cpu->running will be set false)
  */
-static bool handle_loadi_execution(RAM *ram, CPU *cpu) {
-    uint32_t register_index = get_value_in_ram(ram, cpu, 1);
-    uint32_t value = get_value_in_ram(ram, cpu, 2);
+static bool handle_loadi_execution(CPU *cpu, const DecodedInstruction *insn) {
+    uint32_t register_index = insn->reg;
+    uint32_t value = insn->operand;
 
     if (!is_reg_index_valid_runtime(register_index, cpu)) {
         return false;
@@ -74,7 +63,7 @@ static bool handle_loadi_execution(RAM *ram, CPU *cpu) {
 
     cpu->registers[register_index] = value;
     cpu->zero_flag = (value == 0);
-    increase_pc(cpu, 3);
+    increase_pc(cpu, insn->length);
 
     return true;
 }
@@ -91,13 +80,12 @@ static bool handle_loadi_execution(RAM *ram, CPU *cpu) {
  * Validates address-register index and that the literal address fits in RAM.
  * Advances PC by 3 words.
  *
- * @param ram RAM containing the operands
  * @param cpu CPU state to update
  * @return true on success, false on error
  */
-static bool handle_loada_execution(RAM *ram, CPU *cpu) {
-    uint32_t address_index = get_value_in_ram(ram, cpu, 1);
-    uint32_t address_literal = get_value_in_ram(ram, cpu, 2);
+static bool handle_loada_execution(CPU *cpu, const DecodedInstruction *insn) {
+    uint32_t address_index = insn->reg;
+    uint32_t address_literal = insn->operand;
 
     if (!is_addr_index_valid_runtime(address_index, cpu))
         return false;
@@ -106,7 +94,7 @@ static bool handle_loada_execution(RAM *ram, CPU *cpu) {
         return false;
 
     cpu->address_registers[address_index] = address_literal;
-    increase_pc(cpu, 3);
+    increase_pc(cpu, insn->length);
 
     return true;
 }
@@ -126,14 +114,23 @@ static bool handle_loada_execution(RAM *ram, CPU *cpu) {
  * The read value is stored into cpu->registers[register_index].
  * Validates register/index/address bounds and advances PC by 4 words.
  *
+ * With a cache model (cpu_execute_cached()) the access is also simulated,
+ * and with a device bus (cpu_execute_mapped()) a target in a device page
+ * is read from the device instead of RAM; every other engine passes
+ * constant NULLs, so the hooks compile away.
+ *
  * @param ram RAM to read from
  * @param cpu CPU state to update and validate
+ * @param cache Data cache model, or NULL
+ * @param mmio Device bus, or NULL
  * @return true on success, false on error
  */
-static bool handle_loadm_execution(RAM *ram, CPU *cpu) {
-    uint32_t register_index = get_value_in_ram(ram, cpu, 1);
-    uint32_t mode = get_value_in_ram(ram, cpu, 2);      // ADDR_LITERAL or ADDR_REGISTER
-    uint32_t operand = get_value_in_ram(ram, cpu, 3);   // literal address or address-register index
+static inline __attribute__((always_inline)) bool loadm_execution(RAM *ram, CPU *cpu,
+                                                                  const DecodedInstruction *insn,
+                                                                  CacheSim *cache, const MmioBus *mmio) {
+    uint32_t register_index = insn->reg;
+    uint32_t mode = insn->mode;         // ADDR_LITERAL or ADDR_REGISTER
+    uint32_t operand = insn->operand;   // literal address or address-register index
 
     if (!is_reg_index_valid_runtime(register_index, cpu)) {
         return false;
@@ -158,14 +155,38 @@ static bool handle_loadm_execution(RAM *ram, CPU *cpu) {
         return false;
     }
 
-    uint32_t val = ram->cells[target_address];
+    if (cache)
+        cache_sim_access(cache, cpu->pc, target_address, false);
+
+    uint32_t val;
+    const MmioDevice *device = mmio ? mmio_lookup(mmio, target_address) : NULL;
+    if (device) {
+        if (!mmio_read(device, cpu, target_address, &val)) {
+            cpu->stop_reason = CPU_STOP_FAULT;
+            return false;
+        }
+    } else {
+        val = ram->cells[target_address];
+    }
     cpu->registers[register_index] = val;
     cpu->zero_flag = (val == 0);
-    increase_pc(cpu, 4);
+    increase_pc(cpu, insn->length);
 
     return true;
 }
 
+static bool handle_loadm_execution(RAM *ram, CPU *cpu, const DecodedInstruction *insn) {
+    return loadm_execution(ram, cpu, insn, NULL, NULL);
+}
+
+static bool handle_loadm_cached(RAM *ram, CPU *cpu, const DecodedInstruction *insn, CacheSim *cache) {
+    return loadm_execution(ram, cpu, insn, cache, NULL);
+}
+
+static bool handle_loadm_mapped(RAM *ram, CPU *cpu, const DecodedInstruction *insn, const MmioBus *mmio) {
+    return loadm_execution(ram, cpu, insn, NULL, mmio);
+}
+
 /**
  * @brief Execute STOREM instruction (store register into memory).
  *
@@ -179,14 +200,21 @@ static bool handle_loadm_execution(RAM *ram, CPU *cpu) {
  * store cpu->registers[register_index] into RAM[target_address]. Validates
  * indices and bounds and advances PC by 4 words.
  *
+ * The cache and device hooks work as for LOADM; a store to a device
+ * leaves RAM and its dirty bits alone.
+ *
  * @param ram RAM to write into
  * @param cpu CPU state containing registers and address registers
+ * @param cache Data cache model, or NULL
+ * @param mmio Device bus, or NULL
  * @return true on success, false on error
  */
-static bool handle_storem_execution(RAM *ram, CPU *cpu) {
-    uint32_t address = get_value_in_ram(ram, cpu, 1);
-    uint32_t mode = get_value_in_ram(ram, cpu, 2);
-    uint32_t register_index = get_value_in_ram(ram, cpu, 3);
+static inline __attribute__((always_inline)) bool storem_execution(RAM *ram, CPU *cpu,
+                                                                   const DecodedInstruction *insn,
+                                                                   CacheSim *cache, const MmioBus *mmio) {
+    uint32_t address = insn->operand;
+    uint32_t mode = insn->mode;
+    uint32_t register_index = insn->reg;
 
     if (!is_reg_index_valid_runtime(register_index, cpu)) {
         return false;
@@ -209,12 +237,42 @@ static bool handle_storem_execution(RAM *ram, CPU *cpu) {
         return false;
     }
 
+    if (cache)
+        cache_sim_access(cache, cpu->pc, target_address, true);
+
+    const MmioDevice *device = mmio ? mmio_lookup(mmio, target_address) : NULL;
+    if (device) {
+        if (!mmio_write(device, cpu, target_address, (uint32_t)cpu->registers[register_index])) {
+            cpu->stop_reason = CPU_STOP_FAULT;
+            return false;
+        }
+        increase_pc(cpu, insn->length);
+        return true;
+    }
+
     ram->cells[target_address] = (uint32_t)cpu->registers[register_index];
-    increase_pc(cpu, 4);
+    /* A debugger watchpoint (debugger.h) faults on this store and stops the
+       CPU from its signal handler; the fence (no instruction is emitted)
+       makes the engine re-read the CPU state afterwards. */
+    atomic_signal_fence(memory_order_seq_cst);
+    ram_mark_dirty(ram, target_address);
+    increase_pc(cpu, insn->length);
 
     return true;
 }
 
+static bool handle_storem_execution(RAM *ram, CPU *cpu, const DecodedInstruction *insn) {
+    return storem_execution(ram, cpu, insn, NULL, NULL);
+}
+
+static bool handle_storem_cached(RAM *ram, CPU *cpu, const DecodedInstruction *insn, CacheSim *cache) {
+    return storem_execution(ram, cpu, insn, cache, NULL);
+}
+
+static bool handle_storem_mapped(RAM *ram, CPU *cpu, const DecodedInstruction *insn, const MmioBus *mmio) {
+    return storem_execution(ram, cpu, insn, NULL, mmio);
+}
+
 /**
  * @brief Execute ADD instruction (R[dst] += R[src]).
  *
@@ -226,14 +284,13 @@ static bool handle_storem_execution(RAM *ram, CPU *cpu) {
  * Performs 32-bit addition, stores result in destination register and
  * advances PC by 3 words. Registers are validated.
  *
- * @param ram Unused for ADD but kept for uniform handler signature
  * @param cpu CPU state to read/write registers
  * @return true on success, false on error
  */
-static bool handle_add_execution(RAM *ram, CPU *cpu) {
-    uint32_t dst_index = get_value_in_ram(ram, cpu, 1);
-    uint32_t mode = get_value_in_ram(ram, cpu, 2);
-    uint32_t operand = get_value_in_ram(ram, cpu, 3);
+static bool handle_add_execution(CPU *cpu, const DecodedInstruction *insn) {
+    uint32_t dst_index = insn->reg;
+    uint32_t mode = insn->mode;
+    uint32_t operand = insn->operand;
 
     if (!is_reg_index_valid_runtime(dst_index, cpu))
         return false;
@@ -254,7 +311,7 @@ static bool handle_add_execution(RAM *ram, CPU *cpu) {
     uint32_t res = a + src_value;
     cpu->registers[dst_index] = res;
     cpu->zero_flag = (res == 0);
-    increase_pc(cpu, 4);
+    increase_pc(cpu, insn->length);
     return true;
 }
 
@@ -263,10 +320,10 @@ static bool handle_add_execution(RAM *ram, CPU *cpu) {
  *
  * Similar layout to ADD. Performs 32-bit subtraction and updates PC.
  */
-static bool handle_sub_execution(RAM *ram, CPU *cpu) {
-    uint32_t dst_index = get_value_in_ram(ram, cpu, 1);
-    uint32_t mode = get_value_in_ram(ram, cpu, 2);
-    uint32_t operand = get_value_in_ram(ram, cpu, 3);
+static bool handle_sub_execution(CPU *cpu, const DecodedInstruction *insn) {
+    uint32_t dst_index = insn->reg;
+    uint32_t mode = insn->mode;
+    uint32_t operand = insn->operand;
 
     if (!is_reg_index_valid_runtime(dst_index, cpu))
         return false;
@@ -287,7 +344,7 @@ static bool handle_sub_execution(RAM *ram, CPU *cpu) {
     uint32_t res = a - src_value;
     cpu->registers[dst_index] = res;
     cpu->zero_flag = (res == 0);
-    increase_pc(cpu, 4);
+    increase_pc(cpu, insn->length);
     return true;
 }
 
@@ -297,10 +354,10 @@ static bool handle_sub_execution(RAM *ram, CPU *cpu) {
  * Performs multiplication of two 32-bit registers. The low 32 bits of the
  * 64-bit product are stored in the destination register. PC is advanced by 3.
  */
-static bool handle_mlp_execution(RAM *ram, CPU *cpu) {
-    uint32_t dst_index = get_value_in_ram(ram, cpu, 1);
-    uint32_t mode = get_value_in_ram(ram, cpu, 2);
-    uint32_t operand = get_value_in_ram(ram, cpu, 3);
+static bool handle_mlp_execution(CPU *cpu, const DecodedInstruction *insn) {
+    uint32_t dst_index = insn->reg;
+    uint32_t mode = insn->mode;
+    uint32_t operand = insn->operand;
 
     if (!is_reg_index_valid_runtime(dst_index, cpu))
         return false;
@@ -322,7 +379,7 @@ static bool handle_mlp_execution(RAM *ram, CPU *cpu) {
     uint32_t prod = (uint32_t)(wide & 0xFFFFFFFFu); /* low 32 bits */
     cpu->registers[dst_index] = prod;
     cpu->zero_flag = (prod == 0);
-    increase_pc(cpu, 4);
+    increase_pc(cpu, insn->length);
     return true;
 }
 
@@ -331,10 +388,10 @@ static bool handle_mlp_execution(RAM *ram, CPU *cpu) {
  *
  * Performs integer division; division-by-zero_flag stops the CPU and logs an error.
  */
-static bool handle_div_execution(RAM *ram, CPU *cpu) {
-    uint32_t dst_index = get_value_in_ram(ram, cpu, 1);
-    uint32_t mode = get_value_in_ram(ram, cpu, 2);
-    uint32_t operand = get_value_in_ram(ram, cpu, 3);
+static bool handle_div_execution(CPU *cpu, const DecodedInstruction *insn) {
+    uint32_t dst_index = insn->reg;
+    uint32_t mode = insn->mode;
+    uint32_t operand = insn->operand;
 
     if (!is_reg_index_valid_runtime(dst_index, cpu))
         return false;
@@ -354,6 +411,7 @@ static bool handle_div_execution(RAM *ram, CPU *cpu) {
     if (divisor == 0) {
         log_write(LOG_ERROR, "Division by zero at PC 0x%08X", cpu->pc);
         cpu->running = false;
+        cpu->stop_reason = CPU_STOP_DIV_ZERO;
         return false;
     }
 
@@ -361,17 +419,17 @@ static bool handle_div_execution(RAM *ram, CPU *cpu) {
     uint32_t quotient = dividend / divisor;
     cpu->registers[dst_index] = quotient;
     cpu->zero_flag = (quotient == 0);
-    increase_pc(cpu, 4);
+    increase_pc(cpu, insn->length);
     return true;
 }
 
 /**
  * @brief Execute AND instruction (bitwise AND: R[dst] = R[dst] & R[src]).
  */
-static bool handle_and_execution(RAM *ram, CPU *cpu) {
-    uint32_t dst_index = get_value_in_ram(ram, cpu, 1);
-    uint32_t mode = get_value_in_ram(ram, cpu, 2);
-    uint32_t operand = get_value_in_ram(ram, cpu, 3);
+static bool handle_and_execution(CPU *cpu, const DecodedInstruction *insn) {
+    uint32_t dst_index = insn->reg;
+    uint32_t mode = insn->mode;
+    uint32_t operand = insn->operand;
 
     if (!is_reg_index_valid_runtime(dst_index, cpu))
         return false;
@@ -391,17 +449,17 @@ static bool handle_and_execution(RAM *ram, CPU *cpu) {
     uint32_t res = cpu->registers[dst_index] & src_value;
     cpu->registers[dst_index] = res;
     cpu->zero_flag = res == 0;
-    increase_pc(cpu, 4);
+    increase_pc(cpu, insn->length);
     return true;
 }
 
 /**
  * @brief Execute OR instruction (bitwise OR: R[dst] = R[dst] | R[src]).
  */
-static bool handle_or_execution(RAM *ram, CPU *cpu) {
-    uint32_t dst_index = get_value_in_ram(ram, cpu, 1);
-    uint32_t mode = get_value_in_ram(ram, cpu, 2);
-    uint32_t operand = get_value_in_ram(ram, cpu, 3);
+static bool handle_or_execution(CPU *cpu, const DecodedInstruction *insn) {
+    uint32_t dst_index = insn->reg;
+    uint32_t mode = insn->mode;
+    uint32_t operand = insn->operand;
 
     if (!is_reg_index_valid_runtime(dst_index, cpu))
         return false;
@@ -421,17 +479,17 @@ static bool handle_or_execution(RAM *ram, CPU *cpu) {
     uint32_t res = cpu->registers[dst_index] | src_value;
     cpu->registers[dst_index] = res;
     cpu->zero_flag = res == 0;
-    increase_pc(cpu, 4);
+    increase_pc(cpu, insn->length);
     return true;
 }
 
 /**
  * @brief Execute XOR instruction (bitwise XOR: R[dst] = R[dst] ^ R[src]).
  */
-static bool handle_xor_execution(RAM *ram, CPU *cpu) {
-    uint32_t dst_index = get_value_in_ram(ram, cpu, 1);
-    uint32_t mode = get_value_in_ram(ram, cpu, 2);
-    uint32_t operand = get_value_in_ram(ram, cpu, 3);
+static bool handle_xor_execution(CPU *cpu, const DecodedInstruction *insn) {
+    uint32_t dst_index = insn->reg;
+    uint32_t mode = insn->mode;
+    uint32_t operand = insn->operand;
 
     if (!is_reg_index_valid_runtime(dst_index, cpu))
         return false;
@@ -451,7 +509,7 @@ static bool handle_xor_execution(RAM *ram, CPU *cpu) {
     uint32_t res = cpu->registers[dst_index] ^ src_value;
     cpu->registers[dst_index] = res;
     cpu->zero_flag = res == 0;
-    increase_pc(cpu, 4);
+    increase_pc(cpu, insn->length);
     return true;
 }
 
@@ -465,8 +523,8 @@ static bool handle_xor_execution(RAM *ram, CPU *cpu) {
  * Semantics: PC := target (no automatic increment). The target is validated
  * as a literal RAM address; invalid targets halt the CPU with an error.
  */
-static bool handle_jmp_execution(RAM *ram, CPU *cpu) {
-    uint32_t target = get_value_in_ram(ram, cpu, 1);
+static bool handle_jmp_execution(CPU *cpu, const DecodedInstruction *insn) {
+    uint32_t target = insn->operand;
 
     if (!is_addr_literal_valid_runtime(target, cpu)) {
         return false;
@@ -486,25 +544,42 @@ static bool handle_jmp_execution(RAM *ram, CPU *cpu) {
  *
  * If the CPU zero flag is set the PC is assigned to the target (no increment).
  * Otherwise the PC advances by 2 words (opcode + operand).
+ *
+ * With branch predictors (cpu_execute_predicted()) the outcome is also fed
+ * to the models; every other engine passes a constant NULL.
+ *
+ * @param branches Branch predictor models, or NULL
  */
-static bool handle_jz_execution(RAM *ram, CPU *cpu) {
-    uint32_t target = get_value_in_ram(ram, cpu, 1);
+static inline __attribute__((always_inline)) bool jz_execution(CPU *cpu, const DecodedInstruction *insn,
+                                                               BranchSim *branches) {
+    uint32_t target = insn->operand;
 
     if (!is_addr_literal_valid_runtime(target, cpu)) {
         return false;
     }
 
+    if (branches)
+        branch_sim_record(branches, cpu->pc, target, cpu->zero_flag);
+
     if (cpu->zero_flag) {
         log_write(LOG_DEBUG, "JZ taken (zero=true): PC 0x%08X -> 0x%08X", cpu->pc, target);
         cpu->pc = target;
     } else {
-        log_write(LOG_DEBUG, "JZ not taken (zero=false): PC 0x%08X -> 0x%08X", cpu->pc, cpu->pc + 2);
-        increase_pc(cpu, 2);
+        log_write(LOG_DEBUG, "JZ not taken (zero=false): PC 0x%08X -> 0x%08X", cpu->pc, cpu->pc + insn->length);
+        increase_pc(cpu, insn->length);
     }
 
     return true;
 }
 
+static bool handle_jz_execution(CPU *cpu, const DecodedInstruction *insn) {
+    return jz_execution(cpu, insn, NULL);
+}
+
+static bool handle_jz_predicted(CPU *cpu, const DecodedInstruction *insn, BranchSim *branches) {
+    return jz_execution(cpu, insn, branches);
+}
+
 /**
  * @brief Execute JNZ (jump if zero flag not set).
  *
@@ -514,25 +589,41 @@ static bool handle_jz_execution(RAM *ram, CPU *cpu) {
  *
  * If the CPU zero flag is clear the PC is assigned to the target (no increment).
  * Otherwise the PC advances by 2 words (opcode + operand).
+ *
+ * The predictor hook works as for JZ.
+ *
+ * @param branches Branch predictor models, or NULL
  */
-static bool handle_jnz_execution(RAM *ram, CPU *cpu) {
-    uint32_t target = get_value_in_ram(ram, cpu, 1);
+static inline __attribute__((always_inline)) bool jnz_execution(CPU *cpu, const DecodedInstruction *insn,
+                                                                BranchSim *branches) {
+    uint32_t target = insn->operand;
 
     if (!is_addr_literal_valid_runtime(target, cpu)) {
         return false;
     }
 
+    if (branches)
+        branch_sim_record(branches, cpu->pc, target, !cpu->zero_flag);
+
     if (!cpu->zero_flag) {
         log_write(LOG_DEBUG, "JNZ taken (zero=false): PC 0x%08X -> 0x%08X", cpu->pc, target);
         cpu->pc = target;
     } else {
-        log_write(LOG_DEBUG, "JNZ not taken (zero=true): PC 0x%08X -> 0x%08X", cpu->pc, cpu->pc + 2);
-        increase_pc(cpu, 2);
+        log_write(LOG_DEBUG, "JNZ not taken (zero=true): PC 0x%08X -> 0x%08X", cpu->pc, cpu->pc + insn->length);
+        increase_pc(cpu, insn->length);
     }
 
     return true;
 }
 
+static bool handle_jnz_execution(CPU *cpu, const DecodedInstruction *insn) {
+    return jnz_execution(cpu, insn, NULL);
+}
+
+static bool handle_jnz_predicted(CPU *cpu, const DecodedInstruction *insn, BranchSim *branches) {
+    return jnz_execution(cpu, insn, branches);
+}
+
 /**
  * @brief Execute CMP instruction (compare two registers and set flags).
  *
@@ -544,9 +635,9 @@ static bool handle_jnz_execution(RAM *ram, CPU *cpu) {
  * Semantics: compute (int32_t)R[A] - (int32_t)R[B] and set cpu->zero_flag and
  * cpu->negative_flag accordingly. No registers are modified. Advances PC by 3.
  */
-static bool handle_cmp_execution(RAM *ram, CPU *cpu) {
-    uint32_t a_index = get_value_in_ram(ram, cpu, 1);
-    uint32_t b_index = get_value_in_ram(ram, cpu, 2);
+static bool handle_cmp_execution(CPU *cpu, const DecodedInstruction *insn) {
+    uint32_t a_index = insn->reg;
+    uint32_t b_index = insn->operand;
 
     if (!is_reg_index_valid_runtime(a_index, cpu))
         return false;
@@ -560,116 +651,695 @@ static bool handle_cmp_execution(RAM *ram, CPU *cpu) {
     cpu->zero_flag = (diff == 0);
     cpu->negative_flag = (diff < 0);
 
-    increase_pc(cpu, 3);
+    increase_pc(cpu, insn->length);
     return true;
 }
 
 /**
- * @brief Execute instructions from RAM between assembly_range.start_address and end_address.
+ * @brief Execute one decoded instruction with the shared handlers.
  *
- * The CPU fetches a 32-bit opcode at the current PC and dispatches on the
- * instruction. Operands are read using `get_value_in_ram` at subsequent
- * word offsets. The function updates `cpu->pc` as instructions are executed
- * and sets `cpu->running` to false when execution ends (HALT) or an error
- * occurs (invalid opcode, bad register index, memory fault, division by
- * zero_flag, etc.).
+ * Used by the switch and predecoded engines; forced inline so each engine
+ * gets its own copy of the dispatch switch. `cache`, `branches` and
+ * `mmio` are constant NULL except in cpu_execute_cached(),
+ * cpu_execute_predicted() and cpu_execute_mapped(), so only those engines
+ * pay for their models or devices.
  *
- * @param cpu Pointer to CPU state (pc, registers, address_registers, running).
- * @param ram Pointer to RAM containing the loaded program and data.
- * @param assembly_range Start and end addresses describing the loaded program in RAM.
+ * @return true if the instruction completed (HALT included), false on a fault.
  */
-bool cpu_run(CPU *cpu, RAM *ram, AssemblyRange assembly_range) {
-    cpu->pc = assembly_range.start_address;
+static inline __attribute__((always_inline)) bool execute_decoded(RAM *ram, CPU *cpu,
+                                                                  const DecodedInstruction *insn,
+                                                                  CacheSim *cache, BranchSim *branches,
+                                                                  const MmioBus *mmio) {
+    switch (insn->opcode) {
+        case ISA_LOADI:  return handle_loadi_execution(cpu, insn);
+        case ISA_LOADA:  return handle_loada_execution(cpu, insn);
+        case ISA_LOADM:
+            if (mmio)
+                return handle_loadm_mapped(ram, cpu, insn, mmio);
+            return cache ? handle_loadm_cached(ram, cpu, insn, cache) : handle_loadm_execution(ram, cpu, insn);
+        case ISA_STOREM:
+            if (mmio)
+                return handle_storem_mapped(ram, cpu, insn, mmio);
+            return cache ? handle_storem_cached(ram, cpu, insn, cache) : handle_storem_execution(ram, cpu, insn);
+        case ISA_ADD:    return handle_add_execution(cpu, insn);
+        case ISA_SUB:    return handle_sub_execution(cpu, insn);
+        case ISA_MLP:    return handle_mlp_execution(cpu, insn);
+        case ISA_DIV:    return handle_div_execution(cpu, insn);
+        case ISA_AND:    return handle_and_execution(cpu, insn);
+        case ISA_OR:     return handle_or_execution(cpu, insn);
+        case ISA_XOR:    return handle_xor_execution(cpu, insn);
+        case ISA_JMP:    return handle_jmp_execution(cpu, insn);
+        case ISA_JZ:
+            return branches ? handle_jz_predicted(cpu, insn, branches) : handle_jz_execution(cpu, insn);
+        case ISA_JNZ:
+            return branches ? handle_jnz_predicted(cpu, insn, branches) : handle_jnz_execution(cpu, insn);
+        case ISA_CMP:    return handle_cmp_execution(cpu, insn);
+        case ISA_HALT:
+            cpu->running = false;
+            cpu->stop_reason = CPU_STOP_HALT;
+            return true;
+        default:
+            log_write(LOG_ERROR, "Invalid instruction 0x%08X", insn->opcode);
+            cpu->stop_reason = CPU_STOP_INVALID_INSTRUCTION;
+            return false;
+    }
+}
+
+/**
+ * @brief Prologue of a run that continues from the current PC.
+ *
+ * @return Value of instructions_retired at which the run must stop
+ *         (UINT64_MAX when `max_instructions` is 0).
+ */
+static uint64_t run_resume(CPU *cpu, uint64_t max_instructions) {
     cpu->running = true;
+    cpu->stop_reason = CPU_STOP_NONE;
+    if (max_instructions == 0 || max_instructions > UINT64_MAX - cpu->instructions_retired)
+        return UINT64_MAX;
+    return cpu->instructions_retired + max_instructions;
+}
+
+/**
+ * @brief Common prologue of every engine: start at the beginning of the range.
+ */
+static uint64_t run_begin(CPU *cpu, AssemblyRange range, uint64_t max_instructions) {
+    cpu->pc = range.start_address;
+    return run_resume(cpu, max_instructions);
+}
+
+/**
+ * @brief Stop the CPU after a fault, keeping a more specific reason if a handler set one.
+ */
+static CpuStopReason run_fault(CPU *cpu, CpuStopReason reason) {
+    cpu->running = false;
+    if (cpu->stop_reason == CPU_STOP_NONE)
+        cpu->stop_reason = reason;
+    return cpu->stop_reason;
+}
+
+/**
+ * @brief Stop the CPU on a word that does not decode as an instruction.
+ *
+ * A breakpoint trap (ISA_TRAP) stops the same way but is not logged: the
+ * debugger that patched it in turns the stop into CPU_STOP_BREAKPOINT.
+ */
+static CpuStopReason run_undecodable(CPU *cpu, uint32_t opcode) {
+    if (opcode != ISA_TRAP)
+        log_write(LOG_ERROR, "Invalid instruction 0x%08X at PC 0x%08X", opcode, cpu->pc);
+    return run_fault(cpu, CPU_STOP_INVALID_INSTRUCTION);
+}
+
+/**
+ * @brief Record that the instruction limit was reached (the CPU keeps running).
+ */
+static CpuStopReason run_limit(CPU *cpu) {
+    cpu->stop_reason = CPU_STOP_LIMIT;
+    return CPU_STOP_LIMIT;
+}
+
+/**
+ * @brief Record a normal end of run: HALT, or PC reaching the end of the range.
+ */
+static CpuStopReason run_finish(CPU *cpu) {
+    if (cpu->running)
+        cpu->stop_reason = CPU_STOP_END;
+    return cpu->stop_reason;
+}
+
+/**
+ * @brief Execute the instruction at PC and nothing else.
+ *
+ * Unlike the engines it does not move the PC to the start of the range
+ * first, so repeated calls continue where the previous one stopped.
+ */
+CpuStopReason cpu_step(CPU *cpu, RAM *ram, AssemblyRange assembly_range) {
+    if (!cpu->running)
+        return cpu->stop_reason;
+    cpu->stop_reason = CPU_STOP_NONE;
+    if (cpu->pc == assembly_range.end_address)
+        return run_finish(cpu);
+
+    DecodedInstruction insn;
+    if (!decode_instruction(ram->cells, RAM_SIZE, cpu->pc, assembly_range.encoding, &insn)) {
+        return run_undecodable(cpu, insn.opcode);
+    }
+    if (!execute_decoded(ram, cpu, &insn, NULL, NULL, NULL))
+        return run_fault(cpu, CPU_STOP_FAULT);
+    cpu->instructions_retired++;
+
+    if (!cpu->running || cpu->pc == assembly_range.end_address)
+        return run_finish(cpu);
+    return CPU_STOP_NONE;
+}
+
+/**
+ * @brief Switch-dispatch engine: decode at PC, then switch on the opcode.
+ */
+CpuStopReason cpu_execute(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions) {
+    uint64_t stop_at = run_begin(cpu, assembly_range, max_instructions);
+
+    while (cpu->running && cpu->pc != assembly_range.end_address) {
+        if (cpu->instructions_retired == stop_at)
+            return run_limit(cpu);
+
+        DecodedInstruction insn;
+        if (!decode_instruction(ram->cells, RAM_SIZE, cpu->pc, assembly_range.encoding, &insn)) {
+            return run_undecodable(cpu, insn.opcode);
+        }
+        if (!execute_decoded(ram, cpu, &insn, NULL, NULL, NULL))
+            return run_fault(cpu, CPU_STOP_FAULT);
+
+        cpu->instructions_retired++;
+    }
+
+    return run_finish(cpu);
+}
+
+#if defined(__GNUC__)
+
+/**
+ * @brief Threaded-dispatch engine.
+ *
+ * Every handler ends with its own copy of the fetch/decode/dispatch
+ * sequence and an indirect `goto` through a label table (GNU "labels as
+ * values"), so the host branch predictor sees one indirect branch per
+ * guest opcode instead of a single shared switch jump.
+ */
+CpuStopReason cpu_execute_threaded(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions) {
+    /* decode_instruction() only succeeds for opcodes listed here, so no slot
+       reached through THREADED_DISPATCH() is ever NULL. */
+    static const void *const dispatch[256] = {
+        [ISA_LOADI]  = &&op_loadi,
+        [ISA_LOADA]  = &&op_loada,
+        [ISA_LOADM]  = &&op_loadm,
+        [ISA_STOREM] = &&op_storem,
+        [ISA_ADD]    = &&op_add,
+        [ISA_SUB]    = &&op_sub,
+        [ISA_MLP]    = &&op_mlp,
+        [ISA_DIV]    = &&op_div,
+        [ISA_AND]    = &&op_and,
+        [ISA_OR]     = &&op_or,
+        [ISA_XOR]    = &&op_xor,
+        [ISA_JMP]    = &&op_jmp,
+        [ISA_JZ]     = &&op_jz,
+        [ISA_JNZ]    = &&op_jnz,
+        [ISA_CMP]    = &&op_cmp,
+        [ISA_HALT]   = &&op_halt,
+    };
+
+    const uint32_t end = assembly_range.end_address;
+    const InstructionEncoding encoding = assembly_range.encoding;
+    uint64_t stop_at = run_begin(cpu, assembly_range, max_instructions);
+    DecodedInstruction insn;
+
+#define THREADED_DISPATCH()                                                              \
+    do {                                                                                 \
+        if (cpu->pc == end)                                                              \
+            return run_finish(cpu);                                                      \
+        if (cpu->instructions_retired == stop_at)                                        \
+            return run_limit(cpu);                                                       \
+        if (!decode_instruction(ram->cells, RAM_SIZE, cpu->pc, encoding, &insn))         \
+            goto bad_decode;                                                             \
+        goto *dispatch[insn.opcode];                                                     \
+    } while (0)
+
+#define THREADED_OP(label, call)                                                         \
+    label:                                                                               \
+        if (!(call))                                                                     \
+            return run_fault(cpu, CPU_STOP_FAULT);                                       \
+        cpu->instructions_retired++;                                                     \
+        THREADED_DISPATCH();
+
+    THREADED_DISPATCH();
+
+    THREADED_OP(op_loadi, handle_loadi_execution(cpu, &insn))
+    THREADED_OP(op_loada, handle_loada_execution(cpu, &insn))
+    THREADED_OP(op_loadm, handle_loadm_execution(ram, cpu, &insn))
+    THREADED_OP(op_storem, handle_storem_execution(ram, cpu, &insn))
+    THREADED_OP(op_add, handle_add_execution(cpu, &insn))
+    THREADED_OP(op_sub, handle_sub_execution(cpu, &insn))
+    THREADED_OP(op_mlp, handle_mlp_execution(cpu, &insn))
+    THREADED_OP(op_div, handle_div_execution(cpu, &insn))
+    THREADED_OP(op_and, handle_and_execution(cpu, &insn))
+    THREADED_OP(op_or, handle_or_execution(cpu, &insn))
+    THREADED_OP(op_xor, handle_xor_execution(cpu, &insn))
+    THREADED_OP(op_jmp, handle_jmp_execution(cpu, &insn))
+    THREADED_OP(op_jz, handle_jz_execution(cpu, &insn))
+    THREADED_OP(op_jnz, handle_jnz_execution(cpu, &insn))
+    THREADED_OP(op_cmp, handle_cmp_execution(cpu, &insn))
+
+#undef THREADED_OP
+#undef THREADED_DISPATCH
+
+op_halt:
+    cpu->running = false;
+    cpu->stop_reason = CPU_STOP_HALT;
+    cpu->instructions_retired++;
+    return CPU_STOP_HALT;
+
+bad_decode:
+    return run_undecodable(cpu, insn.opcode);
+}
+
+#else
+
+CpuStopReason cpu_execute_threaded(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions) {
+    return cpu_execute(cpu, ram, assembly_range, max_instructions);
+}
+
+#endif
+
+/**
+ * @brief Drop cached decodes that a store to `address` may have changed.
+ *
+ * An instruction is at most 4 words long, so only entries starting in
+ * [address - 3, address] can contain the written word.
+ */
+static void invalidate_decoded(DecodedInstruction *cache, uint32_t start, uint32_t size, uint32_t address) {
+    if (address < start || address - start >= size)
+        return;
+    uint32_t last = address - start;
+    uint32_t first = last >= 3 ? last - 3 : 0;
+    for (uint32_t i = first; i <= last; i++)
+        cache[i].length = 0;
+}
+
+/**
+ * @struct ExecHooks
+ * @brief Models, recorders and devices predecoded_run() drives.
+ *
+ * Each cpu_execute_* variant sets the one hook it exists for and leaves the
+ * rest NULL.
+ */
+typedef struct {
+    CacheSim *data_cache;        /**< Data cache model fed every LOADM/STOREM */
+    BranchSim *branches;         /**< Branch predictors fed every JZ/JNZ */
+    CoverageMap *coverage;       /**< Edge coverage bitmap */
+    TraceWriter *trace;          /**< Branch outcome and store trace */
+    SmpCore *smp;                /**< Orders LOADM/STOREM against the other cores */
+    StatePublisher *publisher;   /**< Publishes the state every few basic blocks */
+    MemoryHeatmap *heatmap;      /**< Counts fetches and LOADM/STOREM per bucket */
+    const MmioBus *mmio;         /**< Devices behind LOADM/STOREM in their pages */
+} ExecHooks;
+
+/**
+ * @brief Body of the predecoding engine, optionally feeding a cache model,
+ *        branch predictors, an edge coverage bitmap, an execution trace or
+ *        a memory heatmap, ordering its memory accesses against other
+ *        cores, publishing its state for monitors every few basic blocks,
+ *        or sending LOADM/STOREM in device pages to memory-mapped devices.
+ *
+ * Keeps a decode cache indexed by the word offset inside the program
+ * range. Each instruction is decoded the first time the PC reaches it and
+ * reused afterwards, so loops skip the decoder entirely. Stores into the
+ * program range invalidate the affected entries, which keeps
+ * self-modifying code correct. Code outside the range is decoded on every
+ * visit, like the switch engine. Forced inline so the copy without models
+ * has no trace of them.
+ */
+static inline __attribute__((always_inline)) CpuStopReason predecoded_run(CPU *cpu, RAM *ram,
+                                                                          AssemblyRange assembly_range,
+                                                                          uint64_t max_instructions,
+                                                                          const ExecHooks *hooks, bool resume) {
+    /* Read once: after inlining each copy sees its literal and drops the unused hooks. */
+    CacheSim *const data_cache = hooks->data_cache;
+    BranchSim *const branches = hooks->branches;
+    CoverageMap *const coverage = hooks->coverage;
+    TraceWriter *const trace = hooks->trace;
+    SmpCore *const smp = hooks->smp;
+    StatePublisher *const publisher = hooks->publisher;
+    MemoryHeatmap *const heatmap = hooks->heatmap;
+    const MmioBus *const mmio = hooks->mmio;
+    const uint32_t start = assembly_range.start_address;
+    const uint32_t size = assembly_range.end_address > start ? assembly_range.end_address - start : 0;
+
+    /* length == 0 marks an entry that has not been decoded yet. */
+    DecodedInstruction *cache = calloc(size ? size : 1, sizeof(DecodedInstruction));
+    if (!cache) {
+        if (data_cache || branches || coverage || trace || smp || publisher || heatmap || mmio || resume) {
+            log_write(LOG_ERROR, "Predecode cache allocation failed");
+            cpu->running = false;
+            cpu->stop_reason = CPU_STOP_ERROR;
+            return CPU_STOP_ERROR;
+        }
+        log_write(LOG_WARN, "Predecode cache allocation failed; using the switch engine");
+        return cpu_execute(cpu, ram, assembly_range, max_instructions);
+    }
+
+    uint64_t stop_at = resume ? run_resume(cpu, max_instructions) : run_begin(cpu, assembly_range, max_instructions);
+    CpuStopReason reason;
+    uint32_t blocks_to_publish = publisher ? publisher->interval : 0;
+    if (publisher)
+        state_publish(publisher, cpu);
 
     while (cpu->running && cpu->pc != assembly_range.end_address) {
-        uint32_t instruction = get_value_in_ram(ram, cpu, 0);
-
-        switch (instruction) {
-            case ISA_LOADI:
-                if (!handle_loadi_execution(ram, cpu))
-                    return false;
-                break;
-
-            case ISA_LOADA:
-                if (!handle_loada_execution(ram, cpu))
-                    return false;
-                break;
-
-            case ISA_LOADM:
-                if (!handle_loadm_execution(ram, cpu))
-                    return false;
-                break;
-
-            case ISA_STOREM:
-                if (!handle_storem_execution(ram, cpu))
-                    return false;
-                break;
-
-            case ISA_ADD:
-                if (!handle_add_execution(ram, cpu))
-                    return false;
-                break;
-
-            case ISA_SUB:
-                if (!handle_sub_execution(ram, cpu))
-                    return false;
-                break;
-
-            case ISA_MLP:
-                if (!handle_mlp_execution(ram, cpu))
-                    return false;
-                break;
-
-            case ISA_DIV:
-                if (!handle_div_execution(ram, cpu))
-                    return false;
-                break;
-
-            case ISA_AND:
-                if (!handle_and_execution(ram, cpu))
-                    return false;
-                break;
-
-            case ISA_OR:
-                if (!handle_or_execution(ram, cpu))
-                    return false;
-                break;
-
-            case ISA_XOR:
-                if (!handle_xor_execution(ram, cpu))
-                    return false;
-                break;
-
-            case ISA_JMP:
-                if (!handle_jmp_execution(ram, cpu))
-                    return false;
-                break;
-
-            case ISA_JZ:
-                if (!handle_jz_execution(ram, cpu))
-                    return false;
-                break;
-
-            case ISA_JNZ:
-                if (!handle_jnz_execution(ram, cpu))
-                    return false;
-                break;
-
-            case ISA_CMP:
-                if (!handle_cmp_execution(ram, cpu))
-                    return false;
-                break;
-
-            case ISA_HALT:
-                cpu->running = false;
-                break;
-            default:
-                log_write(LOG_ERROR, "Invalid instruction 0x%08X", instruction);
-                cpu->running = false;
+        if (cpu->instructions_retired == stop_at) {
+            reason = run_limit(cpu);
+            goto out;
+        }
+
+        DecodedInstruction scratch;
+        DecodedInstruction *insn = &scratch;
+        uint32_t offset = cpu->pc - start;
+        bool cached = offset < size;
+        if (cached)
+            insn = &cache[offset];
+        if ((!cached || insn->length == 0)
+            && !decode_instruction(ram->cells, RAM_SIZE, cpu->pc, assembly_range.encoding, insn)) {
+            insn->length = 0;
+            reason = run_undecodable(cpu, insn->opcode);
+            goto out;
+        }
+
+        uint32_t pc = cpu->pc;
+        if (heatmap)
+            heatmap_fetch(heatmap, pc, cpu->instructions_retired);
+        /* LOADM and STOREM are consecutive opcodes; an invalid target faults without touching RAM. */
+        uint32_t shared_address = RAM_SIZE;
+        if (smp && (uint32_t)(insn->opcode - ISA_LOADM) <= ISA_STOREM - ISA_LOADM) {
+            if (insn->mode == ADDR_LITERAL)
+                shared_address = insn->operand;
+            else if (insn->operand < MAX_ADDRESS_REGISTERS)
+                shared_address = cpu->address_registers[insn->operand];
+            if (shared_address < RAM_SIZE && !smp_access_begin(smp, cpu, shared_address)) {
+                reason = run_fault(cpu, CPU_STOP_ERROR);
+                goto out;
+            }
+        }
+        bool executed = execute_decoded(ram, cpu, insn, data_cache, branches, mmio);
+        if (smp && shared_address < RAM_SIZE)
+            smp_access_end(smp, shared_address);
+        if (!executed) {
+            reason = run_fault(cpu, CPU_STOP_FAULT);
+            goto out;
+        }
+        /* JMP, JZ and JNZ are consecutive opcodes: one compare selects them. */
+        if (coverage && (uint32_t)(insn->opcode - ISA_JMP) <= ISA_JNZ - ISA_JMP)
+            coverage_edge(coverage, pc, cpu->pc);
+        if (trace && (uint32_t)(insn->opcode - ISA_JZ) <= ISA_JNZ - ISA_JZ)
+            trace_branch(trace, (insn->opcode == ISA_JZ) == cpu->zero_flag);
+        /* LOADM only writes a general register, so the address register still holds its target. */
+        if (heatmap && (uint32_t)(insn->opcode - ISA_LOADM) <= ISA_STOREM - ISA_LOADM) {
+            uint32_t target = insn->mode == ADDR_LITERAL ? insn->operand : cpu->address_registers[insn->operand];
+            heatmap_access(heatmap, target, pc, cpu->instructions_retired,
+                           insn->opcode == ISA_STOREM ? HEATMAP_WRITE : HEATMAP_READ);
+        }
+        if (insn->opcode == ISA_STOREM) {
+            uint32_t target = insn->mode == ADDR_LITERAL ? insn->operand : cpu->address_registers[insn->operand];
+            invalidate_decoded(cache, start, size, target);
+            if (trace)
+                trace_store(trace, target, ram->cells[target]);
+        }
+
+        cpu->instructions_retired++;
+        if (publisher && (uint32_t)(insn->opcode - ISA_JMP) <= ISA_JNZ - ISA_JMP && --blocks_to_publish == 0) {
+            state_publish(publisher, cpu);
+            blocks_to_publish = publisher->interval;
+        }
+    }
+    reason = run_finish(cpu);
+
+out:
+    if (publisher)
+        state_publish(publisher, cpu);
+    free(cache);
+    return reason;
+}
+
+/**
+ * @brief Predecoding engine (see predecoded_run()).
+ */
+CpuStopReason cpu_execute_predecoded(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions) {
+    return predecoded_run(cpu, ram, assembly_range, max_instructions, &(ExecHooks){ 0 }, false);
+}
+
+/**
+ * @brief Predecoding engine with every LOADM/STOREM fed to a data cache model.
+ */
+CpuStopReason cpu_execute_cached(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                 CacheSim *cache) {
+    return predecoded_run(cpu, ram, assembly_range, max_instructions, &(ExecHooks){ .data_cache = cache }, false);
+}
+
+/**
+ * @brief Predecoding engine with every JZ/JNZ fed to branch predictor models.
+ */
+CpuStopReason cpu_execute_predicted(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                    BranchSim *branches) {
+    return predecoded_run(cpu, ram, assembly_range, max_instructions, &(ExecHooks){ .branches = branches }, false);
+}
+
+/**
+ * @brief Predecoding engine recording every branch edge in a coverage bitmap.
+ */
+CpuStopReason cpu_execute_covered(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                  CoverageMap *coverage) {
+    return predecoded_run(cpu, ram, assembly_range, max_instructions, &(ExecHooks){ .coverage = coverage }, false);
+}
+
+/**
+ * @brief Predecoding engine recording branch outcomes and stores in a trace.
+ */
+CpuStopReason cpu_execute_traced(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                 TraceWriter *trace) {
+    return predecoded_run(cpu, ram, assembly_range, max_instructions, &(ExecHooks){ .trace = trace }, false);
+}
+
+/**
+ * @brief Predecoding engine continuing from the current PC.
+ */
+CpuStopReason cpu_continue(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions) {
+    return predecoded_run(cpu, ram, assembly_range, max_instructions, &(ExecHooks){ 0 }, true);
+}
+
+/**
+ * @brief Predecoding engine publishing its state every `publisher->interval` basic blocks.
+ */
+CpuStopReason cpu_execute_observed(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                   StatePublisher *publisher) {
+    return predecoded_run(cpu, ram, assembly_range, max_instructions, &(ExecHooks){ .publisher = publisher }, false);
+}
+
+/**
+ * @brief Predecoding engine counting every fetch and LOADM/STOREM in a memory heatmap.
+ */
+CpuStopReason cpu_execute_heatmapped(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                     MemoryHeatmap *heatmap) {
+    return predecoded_run(cpu, ram, assembly_range, max_instructions, &(ExecHooks){ .heatmap = heatmap }, false);
+}
+
+/**
+ * @brief Predecoding engine sending LOADM/STOREM in device pages to memory-mapped devices.
+ */
+CpuStopReason cpu_execute_mapped(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                 const MmioBus *mmio) {
+    return predecoded_run(cpu, ram, assembly_range, max_instructions, &(ExecHooks){ .mmio = mmio }, false);
+}
+
+/**
+ * @brief Predecoding engine ordering every LOADM/STOREM against the other cores of an SMP run.
+ */
+CpuStopReason cpu_execute_shared(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                 SmpCore *core) {
+    return predecoded_run(cpu, ram, assembly_range, max_instructions, &(ExecHooks){ .smp = core }, false);
+}
+
+/**
+ * @struct TimedEntry
+ * @brief Decode cache entry of the timed engine.
+ *
+ * `suffix_cycles` is the static cost from this instruction to the end of
+ * its block. It does not depend on where the block was entered, so a jump
+ * into the middle of a block charges exactly the part that will run.
+ */
+typedef struct {
+    DecodedInstruction insn;
+    uint64_t suffix_cycles;  /**< Static cycles from here to the end of the block */
+    uint32_t region;         /**< Label region (0 without a profile) */
+    bool costed;             /**< insn, suffix_cycles and last are valid */
+    bool last;               /**< Last instruction of its block */
+} TimedEntry;
+
+static bool is_block_terminator(uint32_t opcode) {
+    return opcode == ISA_JMP || opcode == ISA_JZ || opcode == ISA_JNZ || opcode == ISA_HALT;
+}
+
+/**
+ * @brief Decode and cost the block that starts at `offset`.
+ *
+ * Blocks end after a jump or HALT, at the end of the range, before a new
+ * label region and before a word that does not decode. The walk also
+ * stops at an entry that is already costed and reuses its suffix.
+ *
+ * @return false if the first instruction does not decode.
+ */
+static bool timed_cost_block(TimedEntry *cache, uint32_t size, const RAM *ram, AssemblyRange range,
+                             uint32_t offset, const CycleModel *model, const uint32_t *region_of) {
+    uint64_t total = 0;
+    uint32_t count = 0;
+    uint32_t at = offset;
+    uint32_t previous = offset;
+
+    while (true) {
+        TimedEntry *entry = &cache[at];
+        if (entry->costed) {
+            total += entry->suffix_cycles;
+            break;
+        }
+        if (!decode_instruction(ram->cells, RAM_SIZE, range.start_address + at, range.encoding, &entry->insn)) {
+            if (count == 0)
                 return false;
+            cache[previous].last = true;
+            break;
         }
+        uint32_t next = at + entry->insn.length;
+        entry->region = region_of ? region_of[at] : 0;
+        entry->last = is_block_terminator(entry->insn.opcode) || next >= size
+                   || (region_of && region_of[next] != entry->region);
+        total += cycle_model_cost(model, entry->insn.opcode);
+        count++;
+        if (entry->last)
+            break;
+        previous = at;
+        at = next;
     }
 
+    /* Second pass: hand out the suffix sums front to back. */
+    at = offset;
+    for (uint32_t i = 0; i < count; i++) {
+        TimedEntry *entry = &cache[at];
+        entry->suffix_cycles = total;
+        entry->costed = true;
+        total -= cycle_model_cost(model, entry->insn.opcode);
+        at += entry->insn.length;
+    }
     return true;
 }
+
+/**
+ * @brief Add (or, with `refund`, take back) cycles of one region.
+ */
+static void timed_account(CPU *cpu, CycleProfile *profile, uint32_t region, uint64_t cycles, bool refund) {
+    if (refund)
+        cpu->cycles -= cycles;
+    else
+        cpu->cycles += cycles;
+    if (!profile)
+        return;
+    uint64_t *counter = region == CODE_REGION_NONE ? &profile->outside_cycles : &profile->cycles[region];
+    if (refund)
+        *counter -= cycles;
+    else
+        *counter += cycles;
+}
+
+/**
+ * @brief Timed engine: predecoded execution plus a cycle estimate.
+ *
+ * Entering a block charges its precomputed static cost in one add (see
+ * TimedEntry); a taken JMP/JZ/JNZ adds the model's penalty. When a run
+ * stops inside a block (limit, fault) the cost of the instructions that
+ * did not retire is taken back, so `cpu->cycles` always covers exactly
+ * the retired instructions. A store into the program range drops every
+ * cost (decodes and block boundaries may change) and re-costs from the
+ * next instruction. Code outside the range is costed per instruction.
+ */
+CpuStopReason cpu_execute_timed(CPU *cpu, RAM *ram, AssemblyRange assembly_range, uint64_t max_instructions,
+                                const CycleModel *model, CycleProfile *profile) {
+    const uint32_t start = assembly_range.start_address;
+    const uint32_t size = assembly_range.end_address > start ? assembly_range.end_address - start : 0;
+    const uint32_t *region_of = profile ? profile->regions->region_of : NULL;
+
+    TimedEntry *cache = calloc(size ? size : 1, sizeof(TimedEntry));
+    if (!cache) {
+        log_write(LOG_ERROR, "Timed engine: out of memory for the decode cache");
+        cpu->running = false;
+        cpu->stop_reason = CPU_STOP_ERROR;
+        return CPU_STOP_ERROR;
+    }
+
+    uint64_t stop_at = run_begin(cpu, assembly_range, max_instructions);
+    bool block_start = true;
+    CpuStopReason reason;
+
+    while (cpu->running && cpu->pc != assembly_range.end_address) {
+        uint32_t offset = cpu->pc - start;
+        bool in_range = offset < size;
+        TimedEntry scratch;
+        TimedEntry *entry = in_range ? &cache[offset] : &scratch;
+
+        if (cpu->instructions_retired == stop_at) {
+            if (!block_start)
+                timed_account(cpu, profile, entry->region, entry->suffix_cycles, true);
+            reason = run_limit(cpu);
+            goto out;
+        }
+
+        if (!in_range) {
+            if (!decode_instruction(ram->cells, RAM_SIZE, cpu->pc, assembly_range.encoding, &scratch.insn)) {
+                reason = run_undecodable(cpu, scratch.insn.opcode);
+                goto out;
+            }
+            scratch.suffix_cycles = cycle_model_cost(model, scratch.insn.opcode);
+            scratch.region = CODE_REGION_NONE;
+            scratch.last = true;
+            timed_account(cpu, profile, CODE_REGION_NONE, scratch.suffix_cycles, false);
+        } else if (block_start) {
+            if (!entry->costed && !timed_cost_block(cache, size, ram, assembly_range, offset, model, region_of)) {
+                reason = run_undecodable(cpu, entry->insn.opcode);
+                goto out;
+            }
+            timed_account(cpu, profile, entry->region, entry->suffix_cycles, false);
+        }
+
+        uint32_t pc = cpu->pc;
+        if (!execute_decoded(ram, cpu, &entry->insn, NULL, NULL, NULL)) {
+            timed_account(cpu, profile, entry->region, entry->suffix_cycles, true);
+            reason = run_fault(cpu, CPU_STOP_FAULT);
+            goto out;
+        }
+        block_start = entry->last;
+        cpu->instructions_retired++;
+
+        uint32_t opcode = entry->insn.opcode;
+        if ((opcode == ISA_JMP || opcode == ISA_JZ || opcode == ISA_JNZ) && cpu->pc != pc + entry->insn.length)
+            timed_account(cpu, profile, entry->region, model->branch_taken_cycles, false);
+        if (opcode == ISA_STOREM) {
+            uint32_t target = entry->insn.mode == ADDR_LITERAL ? entry->insn.operand
+                                                               : cpu->address_registers[entry->insn.operand];
+            if (target >= start && target - start < size) {
+                if (!block_start) {
+                    const TimedEntry *next = &cache[cpu->pc - start];
+                    timed_account(cpu, profile, next->region, next->suffix_cycles, true);
+                }
+                for (uint32_t i = 0; i < size; i++)
+                    cache[i].costed = false;
+                block_start = true;
+            }
+        }
+    }
+    reason = run_finish(cpu);
+
+out:
+    free(cache);
+    return reason;
+}
+
+/**
+ * @brief Execute instructions from RAM between assembly_range.start_address and end_address.
+ *
+ * Thin wrapper over cpu_execute() without an instruction limit. The CPU
+ * decodes the instruction at the current PC according to
+ * `assembly_range.encoding` (wide or packed) and dispatches on the opcode.
+ * The function updates `cpu->pc` as instructions are executed
+ * and sets `cpu->running` to false when execution ends (HALT) or an error
+ * occurs (invalid opcode, bad register index, memory fault, division by
+ * zero_flag, etc.). `cpu->stop_reason` tells which.
+ *
+ * @param cpu Pointer to CPU state (pc, registers, address_registers, running).
+ * @param ram Pointer to RAM containing the loaded program and data.
+ * @param assembly_range Start and end addresses describing the loaded program in RAM.
+ */
+bool cpu_run(CPU *cpu, RAM *ram, AssemblyRange assembly_range) {
+    return !cpu_stop_is_error(cpu_execute(cpu, ram, assembly_range, 0));
+}
@@ -0,0 +1,155 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "cycle_model.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "log.h"
+
+void cycle_model_default(CycleModel *model) {
+    memset(model, 0, sizeof(*model));
+    snprintf(model->name, sizeof(model->name), "default");
+    for (size_t i = 0; i < sizeof(opcode_table) / sizeof(opcode_table[0]); i++)
+        model->opcode_cycles[opcode_table[i].opcode] = 1;
+    model->opcode_cycles[ISA_MLP] = 3;
+    model->opcode_cycles[ISA_DIV] = 20;
+    model->memory_cycles = 2;
+    model->branch_taken_cycles = 2;
+}
+
+/**
+ * @brief Parse a cost value (decimal or 0x hex) no larger than CYCLE_COST_MAX.
+ */
+static bool parse_cost(const char *text, uint32_t *value) {
+    char *end = NULL;
+    errno = 0;
+    unsigned long parsed = strtoul(text, &end, 0);
+    if (errno != 0 || end == text || *end != '\0' || text[0] == '-' || parsed > CYCLE_COST_MAX)
+        return false;
+    *value = (uint32_t)parsed;
+    return true;
+}
+
+/**
+ * @brief Return the cost slot named by `key`, or NULL if the key is unknown.
+ */
+static uint32_t *cost_slot(CycleModel *model, const char *key) {
+    if (strcasecmp(key, "memory") == 0)
+        return &model->memory_cycles;
+    if (strcasecmp(key, "branch_taken") == 0)
+        return &model->branch_taken_cycles;
+    for (size_t i = 0; i < sizeof(opcode_table) / sizeof(opcode_table[0]); i++) {
+        if (strcasecmp(key, opcode_table[i].mnemonic) == 0)
+            return &model->opcode_cycles[opcode_table[i].opcode];
+    }
+    return NULL;
+}
+
+bool cycle_model_load(CycleModel *model, const char *path) {
+    cycle_model_default(model);
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        log_write(LOG_ERROR, "Unable to open cycle model: %s", path);
+        return false;
+    }
+
+    char line[256];
+    size_t line_number = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        line_number++;
+        line[strcspn(line, "#;\r\n")] = '\0';
+
+        char *save = NULL;
+        char *key = strtok_r(line, " \t", &save);
+        if (!key)
+            continue;
+        char *value = strtok_r(NULL, " \t", &save);
+        if (!value || strtok_r(NULL, " \t", &save)) {
+            log_write(LOG_ERROR, "%s:%zu: expected KEY VALUE", path, line_number);
+            ok = false;
+        } else if (strcasecmp(key, "name") == 0) {
+            snprintf(model->name, sizeof(model->name), "%s", value);
+        } else {
+            uint32_t *slot = cost_slot(model, key);
+            if (!slot) {
+                log_write(LOG_ERROR, "%s:%zu: unknown key '%s'", path, line_number, key);
+                ok = false;
+            } else if (!parse_cost(value, slot)) {
+                log_write(LOG_ERROR, "%s:%zu: invalid cost '%s' (0..%u)", path, line_number, value, CYCLE_COST_MAX);
+                ok = false;
+            }
+        }
+    }
+    fclose(file);
+
+    if (!ok)
+        cycle_model_default(model);
+    return ok;
+}
+
+bool cycle_profile_init(CycleProfile *profile, const CodeRegionMap *regions) {
+    memset(profile, 0, sizeof(*profile));
+    profile->regions = regions;
+    profile->cycles = calloc(regions->count ? regions->count : 1, sizeof(uint64_t));
+    if (!profile->cycles) {
+        log_write(LOG_ERROR, "Out of memory allocating cycle counters");
+        return false;
+    }
+    return true;
+}
+
+void cycle_profile_free(CycleProfile *profile) {
+    free(profile->cycles);
+    profile->cycles = NULL;
+}
+
+/** One report row: region index and its cycles. */
+typedef struct {
+    uint32_t region;
+    uint64_t cycles;
+} RegionRow;
+
+static int compare_rows(const void *a, const void *b) {
+    const RegionRow *x = a;
+    const RegionRow *y = b;
+    if (x->cycles != y->cycles)
+        return x->cycles > y->cycles ? -1 : 1;
+    return (x->region > y->region) - (x->region < y->region);
+}
+
+void cycle_profile_print(const CycleProfile *profile, const CycleModel *model, const CPU *cpu, FILE *out) {
+    double cpi = cpu->instructions_retired ? (double)cpu->cycles / (double)cpu->instructions_retired : 0.0;
+    fprintf(out, "cycles: %llu (model %s), %llu instructions, %.2f CPI\n", (unsigned long long)cpu->cycles,
+            model->name, (unsigned long long)cpu->instructions_retired, cpi);
+
+    const CodeRegionMap *map = profile->regions;
+    RegionRow *rows = malloc((map->count ? map->count : 1) * sizeof(RegionRow));
+    if (!rows)
+        return;
+    uint32_t used = 0;
+    for (uint32_t r = 0; r < map->count; r++) {
+        if (profile->cycles[r])
+            rows[used++] = (RegionRow){ r, profile->cycles[r] };
+    }
+    qsort(rows, used, sizeof(RegionRow), compare_rows);
+
+    fprintf(out, "  %-24s %-8s %-8s %14s %7s\n", "region", "start", "end", "cycles", "share");
+    for (uint32_t i = 0; i < used; i++) {
+        const CodeRegion *region = &map->regions[rows[i].region];
+        fprintf(out, "  %-24s 0x%06X 0x%06X %14llu %6.1f%%\n", region->name, region->start_address,
+                region->end_address, (unsigned long long)rows[i].cycles,
+                cpu->cycles ? 100.0 * (double)rows[i].cycles / (double)cpu->cycles : 0.0);
+    }
+    if (profile->outside_cycles) {
+        fprintf(out, "  %-24s %-8s %-8s %14llu %6.1f%%\n", "<outside range>", "-", "-",
+                (unsigned long long)profile->outside_cycles,
+                cpu->cycles ? 100.0 * (double)profile->outside_cycles / (double)cpu->cycles : 0.0);
+    }
+    free(rows);
+}
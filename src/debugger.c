@@ -0,0 +1,590 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "debugger.h"
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "cpu_exec.h"
+#include "disasm.h"
+#include "encoding.h"
+#include "log.h"
+
+/** Longest command line debugger_repl() reads. */
+#define DEBUGGER_LINE_MAX 256
+
+/** Words per row of the `mem` command. */
+#define DEBUGGER_MEM_ROW 8
+
+/**
+ * @struct Breakpoint
+ * @brief A patched trap and the word it replaced.
+ */
+typedef struct {
+    uint32_t address;
+    uint32_t original;
+} Breakpoint;
+
+/**
+ * @struct Watchpoint
+ * @brief A watched range of words.
+ */
+typedef struct {
+    uint32_t address;
+    uint32_t words;
+} Watchpoint;
+
+struct Debugger {
+    CPU cpu;
+    RAM *ram;                                   /**< Aligned to host pages so they can be protected */
+    AssemblyRange range;
+    size_t host_page;                           /**< 0 when watchpoints are unsupported */
+    Breakpoint breakpoints[DEBUGGER_MAX_BREAKPOINTS];
+    uint32_t breakpoint_count;
+    Watchpoint watchpoints[DEBUGGER_MAX_WATCHPOINTS];
+    uint32_t watchpoint_count;
+    volatile sig_atomic_t fault_pending;        /**< A protected page was written (set by the handler) */
+    WatchHit fault;                             /**< The store that faulted (filled by the handler) */
+    WatchHit hit;                               /**< Last store reported as CPU_STOP_WATCHPOINT */
+};
+
+/** Session whose watched pages are protected right now. */
+static Debugger *volatile watching;
+static struct sigaction saved_segv;
+static struct sigaction saved_bus;
+
+/**
+ * @brief SIGSEGV/SIGBUS handler: a guest store hit a write-protected page.
+ *
+ * Unprotects the page and returns, so the store is retried and completes;
+ * clearing `running` makes the engine stop once the STOREM has retired.
+ * Faults anywhere else get the previous disposition back and are retried
+ * under it.
+ */
+static void watch_fault(int signal, siginfo_t *info, void *context) {
+    (void)context;
+    Debugger *dbg = watching;
+    uintptr_t offset = UINTPTR_MAX;
+    if (dbg)
+        offset = (uintptr_t)info->si_addr - (uintptr_t)dbg->ram->cells;
+    if (offset >= RAM_SIZE * sizeof(uint32_t)) {
+        sigaction(signal, signal == SIGSEGV ? &saved_segv : &saved_bus, NULL);
+        return;
+    }
+
+    uintptr_t page = (uintptr_t)info->si_addr & ~(uintptr_t)(dbg->host_page - 1);
+    mprotect((void *)page, dbg->host_page, PROT_READ | PROT_WRITE);
+    uint32_t address = (uint32_t)(offset / sizeof(uint32_t));
+    dbg->fault.address = address;
+    dbg->fault.old_value = dbg->ram->cells[address];
+    /* The engine advances the PC only after the store. */
+    dbg->fault.pc = dbg->cpu.pc;
+    dbg->fault_pending = 1;
+    dbg->cpu.running = false;
+}
+
+/**
+ * @brief Apply `protection` to every host page backing a watched word.
+ */
+static void protect_watched(Debugger *dbg, int protection) {
+    uintptr_t mask = ~(uintptr_t)(dbg->host_page - 1);
+    for (uint32_t i = 0; i < dbg->watchpoint_count; i++) {
+        const Watchpoint *watch = &dbg->watchpoints[i];
+        uintptr_t first = (uintptr_t)&dbg->ram->cells[watch->address] & mask;
+        uintptr_t last = (uintptr_t)&dbg->ram->cells[watch->address + watch->words - 1] & mask;
+        if (mprotect((void *)first, last - first + dbg->host_page, protection) != 0)
+            log_write(LOG_WARN, "mprotect failed; the watchpoint at 0x%X may be missed", watch->address);
+    }
+}
+
+/**
+ * @brief Protect the watched pages and install the fault handler before the guest runs.
+ */
+static void arm_watchpoints(Debugger *dbg) {
+    if (dbg->watchpoint_count == 0)
+        return;
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = watch_fault;
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, &saved_segv);
+    sigaction(SIGBUS, &action, &saved_bus);
+    watching = dbg;
+    protect_watched(dbg, PROT_READ);
+}
+
+/**
+ * @brief Undo arm_watchpoints(), so the debugger itself can write RAM.
+ */
+static void disarm_watchpoints(Debugger *dbg) {
+    if (dbg->watchpoint_count == 0)
+        return;
+    protect_watched(dbg, PROT_READ | PROT_WRITE);
+    watching = NULL;
+    sigaction(SIGSEGV, &saved_segv, NULL);
+    sigaction(SIGBUS, &saved_bus, NULL);
+}
+
+static Breakpoint *find_breakpoint(Debugger *dbg, uint32_t address) {
+    for (uint32_t i = 0; i < dbg->breakpoint_count; i++)
+        if (dbg->breakpoints[i].address == address)
+            return &dbg->breakpoints[i];
+    return NULL;
+}
+
+static bool is_watched(const Debugger *dbg, uint32_t address) {
+    for (uint32_t i = 0; i < dbg->watchpoint_count; i++)
+        if (address - dbg->watchpoints[i].address < dbg->watchpoints[i].words)
+            return true;
+    return false;
+}
+
+Debugger *debugger_create(const uint32_t *image, AssemblyRange range) {
+    Debugger *dbg = calloc(1, sizeof(Debugger));
+    long page = sysconf(_SC_PAGESIZE);
+    size_t alignment = page > 0 ? (size_t)page : 4096;
+    void *memory = NULL;
+    if (!dbg || posix_memalign(&memory, alignment, sizeof(RAM)) != 0) {
+        log_write(LOG_ERROR, "Out of memory");
+        free(dbg);
+        return NULL;
+    }
+    dbg->ram = memory;
+    ram_init(dbg->ram);
+    memcpy(dbg->ram->cells, image, sizeof(dbg->ram->cells));
+    /* cells is the first member, so it starts on a page; the dirty bits must not share its last page. */
+    if (page > 0 && sizeof(dbg->ram->cells) % (size_t)page == 0)
+        dbg->host_page = (size_t)page;
+
+    dbg->range = range;
+    cpu_init(&dbg->cpu);
+    dbg->cpu.pc = range.start_address;
+    dbg->cpu.running = true;
+    return dbg;
+}
+
+void debugger_destroy(Debugger *dbg) {
+    if (!dbg)
+        return;
+    pthread_rwlock_destroy(&dbg->ram->lock);
+    free(dbg->ram);
+    free(dbg);
+}
+
+CPU *debugger_cpu(Debugger *dbg) {
+    return &dbg->cpu;
+}
+
+AssemblyRange debugger_range(const Debugger *dbg) {
+    return dbg->range;
+}
+
+/**
+ * @brief Find the instruction that covers `address` by decoding the program from its start.
+ *
+ * @return Its start address, or `address` itself when the sweep meets a
+ *         word that does not decode first (data, or memory out of use).
+ */
+static uint32_t instruction_covering(const Debugger *dbg, uint32_t address) {
+    uint32_t start = dbg->range.start_address;
+    uint32_t size = dbg->range.end_address - start;
+    uint32_t *words = malloc(size * sizeof(uint32_t));
+    if (!words || !debugger_read(dbg, start, size, words)) {
+        free(words);
+        return address;
+    }
+    uint32_t offset = 0;
+    uint32_t covering = address;
+    DecodedInstruction insn;
+    while (start + offset <= address && decode_instruction(words, size, offset, dbg->range.encoding, &insn)) {
+        if (start + offset + insn.length > address) {
+            covering = start + offset;
+            break;
+        }
+        offset += insn.length;
+    }
+    free(words);
+    return covering;
+}
+
+bool debugger_set_breakpoint(Debugger *dbg, uint32_t address) {
+    if (address < dbg->range.start_address || address >= dbg->range.end_address) {
+        log_write(LOG_ERROR, "Breakpoint 0x%X is outside the program [0x%X, 0x%X)", address,
+                  dbg->range.start_address, dbg->range.end_address);
+        return false;
+    }
+    uint32_t covering = instruction_covering(dbg, address);
+    if (covering != address) {
+        log_write(LOG_ERROR, "Breakpoint 0x%X is inside the instruction at 0x%X", address, covering);
+        return false;
+    }
+    if (find_breakpoint(dbg, address)) {
+        log_write(LOG_ERROR, "Breakpoint 0x%X is already set", address);
+        return false;
+    }
+    if (dbg->breakpoint_count == DEBUGGER_MAX_BREAKPOINTS) {
+        log_write(LOG_ERROR, "Too many breakpoints (at most %d)", DEBUGGER_MAX_BREAKPOINTS);
+        return false;
+    }
+    Breakpoint *breakpoint = &dbg->breakpoints[dbg->breakpoint_count++];
+    breakpoint->address = address;
+    breakpoint->original = dbg->ram->cells[address];
+    dbg->ram->cells[address] = ISA_TRAP;
+    return true;
+}
+
+bool debugger_clear_breakpoint(Debugger *dbg, uint32_t address) {
+    Breakpoint *breakpoint = find_breakpoint(dbg, address);
+    if (!breakpoint)
+        return false;
+    /* A guest store over the trap wins over the saved word. */
+    if (dbg->ram->cells[address] == ISA_TRAP)
+        dbg->ram->cells[address] = breakpoint->original;
+    *breakpoint = dbg->breakpoints[--dbg->breakpoint_count];
+    return true;
+}
+
+bool debugger_set_watchpoint(Debugger *dbg, uint32_t address, uint32_t words) {
+    if (!dbg->host_page) {
+        log_write(LOG_ERROR, "Watchpoints are not supported with this host page size");
+        return false;
+    }
+    if (words == 0 || address >= RAM_SIZE || words > RAM_SIZE - address) {
+        log_write(LOG_ERROR, "Watchpoint [0x%X, +%u) is outside RAM", address, words);
+        return false;
+    }
+    if (dbg->watchpoint_count == DEBUGGER_MAX_WATCHPOINTS) {
+        log_write(LOG_ERROR, "Too many watchpoints (at most %d)", DEBUGGER_MAX_WATCHPOINTS);
+        return false;
+    }
+    dbg->watchpoints[dbg->watchpoint_count++] = (Watchpoint){ address, words };
+    return true;
+}
+
+bool debugger_clear_watchpoint(Debugger *dbg, uint32_t address) {
+    for (uint32_t i = 0; i < dbg->watchpoint_count; i++)
+        if (dbg->watchpoints[i].address == address) {
+            dbg->watchpoints[i] = dbg->watchpoints[--dbg->watchpoint_count];
+            return true;
+        }
+    return false;
+}
+
+/**
+ * @brief Turn the engine's stop into the debugger's.
+ *
+ * A pending fault is a watchpoint if it hit a watched word; otherwise the
+ * store only shared a host page with one and the run may go on
+ * (CPU_STOP_NONE). A trap under a known breakpoint is CPU_STOP_BREAKPOINT.
+ * Both leave the CPU running.
+ */
+static CpuStopReason settle(Debugger *dbg, CpuStopReason reason) {
+    CPU *cpu = &dbg->cpu;
+    if (dbg->fault_pending) {
+        dbg->fault_pending = 0;
+        cpu->running = true;
+        if (!is_watched(dbg, dbg->fault.address)) {
+            cpu->stop_reason = cpu->pc == dbg->range.end_address ? CPU_STOP_END : CPU_STOP_NONE;
+            return cpu->stop_reason;
+        }
+        dbg->hit = dbg->fault;
+        dbg->hit.new_value = dbg->ram->cells[dbg->hit.address];
+        cpu->stop_reason = CPU_STOP_WATCHPOINT;
+        return CPU_STOP_WATCHPOINT;
+    }
+    if (reason == CPU_STOP_INVALID_INSTRUCTION && cpu->pc < RAM_SIZE && dbg->ram->cells[cpu->pc] == ISA_TRAP
+        && find_breakpoint(dbg, cpu->pc)) {
+        cpu->running = true;
+        cpu->stop_reason = CPU_STOP_BREAKPOINT;
+        return CPU_STOP_BREAKPOINT;
+    }
+    return reason;
+}
+
+/**
+ * @brief cpu_step() with the original word under a breakpoint at the PC put back for it.
+ */
+static CpuStopReason step_once(Debugger *dbg) {
+    Breakpoint *breakpoint = find_breakpoint(dbg, dbg->cpu.pc);
+    if (breakpoint)
+        dbg->ram->cells[breakpoint->address] = breakpoint->original;
+    arm_watchpoints(dbg);
+    CpuStopReason reason = cpu_step(&dbg->cpu, dbg->ram, dbg->range);
+    disarm_watchpoints(dbg);
+    if (breakpoint) {
+        /* The instruction may have stored over itself. */
+        breakpoint->original = dbg->ram->cells[breakpoint->address];
+        dbg->ram->cells[breakpoint->address] = ISA_TRAP;
+    }
+    return settle(dbg, reason);
+}
+
+CpuStopReason debugger_step(Debugger *dbg) {
+    return step_once(dbg);
+}
+
+CpuStopReason debugger_continue(Debugger *dbg, uint64_t max_instructions) {
+    CPU *cpu = &dbg->cpu;
+    uint64_t stop_at = UINT64_MAX;
+    if (max_instructions && max_instructions <= UINT64_MAX - cpu->instructions_retired)
+        stop_at = cpu->instructions_retired + max_instructions;
+
+    if (!cpu->running)
+        return cpu->stop_reason;
+    /* A run that ran out of instructions stopped before a breakpoint at the PC, which is still to be reported. */
+    bool step_over = cpu->stop_reason != CPU_STOP_LIMIT;
+    arm_watchpoints(dbg);
+    for (;;) {
+        if (cpu->instructions_retired >= stop_at) {
+            disarm_watchpoints(dbg);
+            cpu->stop_reason = CPU_STOP_LIMIT;
+            return CPU_STOP_LIMIT;
+        }
+        CpuStopReason reason;
+        if (step_over && find_breakpoint(dbg, cpu->pc)) {
+            disarm_watchpoints(dbg);
+            reason = step_once(dbg);
+            arm_watchpoints(dbg);
+        } else {
+            reason = cpu_continue(cpu, dbg->ram, dbg->range,
+                                  stop_at == UINT64_MAX ? 0 : stop_at - cpu->instructions_retired);
+            bool faulted = dbg->fault_pending;
+            reason = settle(dbg, reason);
+            /* A store next to a watched word: protect its page again and go on. */
+            if (faulted && reason == CPU_STOP_NONE)
+                mprotect((void *)((uintptr_t)&dbg->ram->cells[dbg->fault.address] & ~(uintptr_t)(dbg->host_page - 1)),
+                         dbg->host_page, PROT_READ);
+        }
+        if (reason != CPU_STOP_NONE) {
+            disarm_watchpoints(dbg);
+            return reason;
+        }
+        step_over = false;
+    }
+}
+
+const WatchHit *debugger_watch_hit(const Debugger *dbg) {
+    return &dbg->hit;
+}
+
+bool debugger_read(const Debugger *dbg, uint32_t address, uint32_t count, uint32_t *out) {
+    if (address > RAM_SIZE || count > RAM_SIZE - address)
+        return false;
+    memcpy(out, &dbg->ram->cells[address], count * sizeof(uint32_t));
+    for (uint32_t i = 0; i < dbg->breakpoint_count; i++)
+        if (dbg->breakpoints[i].address - address < count)
+            out[dbg->breakpoints[i].address - address] = dbg->breakpoints[i].original;
+    return true;
+}
+
+bool debugger_write(Debugger *dbg, uint32_t address, uint32_t count, const uint32_t *words) {
+    if (address > RAM_SIZE || count > RAM_SIZE - address)
+        return false;
+    memcpy(&dbg->ram->cells[address], words, count * sizeof(uint32_t));
+    for (uint32_t page = address >> RAM_PAGE_SHIFT; count && page <= (address + count - 1) >> RAM_PAGE_SHIFT; page++)
+        ram_mark_dirty(dbg->ram, page << RAM_PAGE_SHIFT);
+    for (uint32_t i = 0; i < dbg->breakpoint_count; i++) {
+        Breakpoint *breakpoint = &dbg->breakpoints[i];
+        if (breakpoint->address - address < count) {
+            breakpoint->original = dbg->ram->cells[breakpoint->address];
+            dbg->ram->cells[breakpoint->address] = ISA_TRAP;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Parse a number or a label name into an address.
+ */
+static bool parse_location(const LabelTable *labels, const char *token, uint32_t *address) {
+    char *end = NULL;
+    unsigned long value = strtoul(token, &end, 0);
+    if (end != token && *end == '\0' && value < RAM_SIZE) {
+        *address = (uint32_t)value;
+        return true;
+    }
+    if (labels) {
+        int found = find_label_addr(token, labels);
+        if (found != FAILURE) {
+            *address = (uint32_t)found;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Disassemble the instruction at `pc`, as the program wrote it.
+ */
+static void format_at(const Debugger *dbg, uint32_t pc, char *text, size_t size) {
+    uint32_t words[4];
+    uint32_t count = pc < RAM_SIZE ? (RAM_SIZE - pc < 4 ? RAM_SIZE - pc : 4) : 0;
+    DecodedInstruction insn;
+    if (count && debugger_read(dbg, pc, count, words)
+        && decode_instruction(words, count, 0, dbg->range.encoding, &insn))
+        format_instruction(&insn, text, size);
+    else
+        snprintf(text, size, "???");
+}
+
+static void print_registers(const CPU *cpu, FILE *out) {
+    fprintf(out, "PC=%08X Z=%d N=%d instructions=%llu\n", cpu->pc, cpu->zero_flag, cpu->negative_flag,
+            (unsigned long long)cpu->instructions_retired);
+    for (int i = 0; i < MAX_REGISTERS; i++)
+        fprintf(out, i + 1 < MAX_REGISTERS ? "R%d=%-10u " : "R%d=%u\n", i, cpu->registers[i]);
+    for (int i = 0; i < MAX_ADDRESS_REGISTERS; i++)
+        fprintf(out, i + 1 < MAX_ADDRESS_REGISTERS ? "A%d=%08X   " : "A%d=%08X\n", i, cpu->address_registers[i]);
+}
+
+/**
+ * @brief Say why a step or continue stopped and where the PC is.
+ */
+static void print_stop(const Debugger *dbg, CpuStopReason reason, FILE *out) {
+    const CPU *cpu = &dbg->cpu;
+    char text[64];
+    format_at(dbg, cpu->pc, text, sizeof(text));
+    switch (reason) {
+        case CPU_STOP_NONE:
+            break;
+        case CPU_STOP_WATCHPOINT:
+            fprintf(out, "watchpoint: [0x%X] %u -> %u by the STOREM at %08X\n", dbg->hit.address,
+                    dbg->hit.old_value, dbg->hit.new_value, dbg->hit.pc);
+            break;
+        case CPU_STOP_HALT:
+        case CPU_STOP_END:
+        case CPU_STOP_INVALID_INSTRUCTION:
+        case CPU_STOP_DIV_ZERO:
+        case CPU_STOP_FAULT:
+        case CPU_STOP_ERROR:
+            fprintf(out, "program stopped (%s) after %llu instructions at %08X\n", cpu_stop_reason_name(reason),
+                    (unsigned long long)cpu->instructions_retired, cpu->pc);
+            return;
+        default:
+            fprintf(out, "%s\n", cpu_stop_reason_name(reason));
+            break;
+    }
+    fprintf(out, "[%llu] %08X: %s\n", (unsigned long long)cpu->instructions_retired, cpu->pc, text);
+}
+
+static void print_memory(const Debugger *dbg, uint32_t address, uint32_t count, FILE *out) {
+    if (count > RAM_SIZE - address)
+        count = RAM_SIZE - address;
+    uint32_t row[DEBUGGER_MEM_ROW];
+    for (uint32_t done = 0; done < count; done += DEBUGGER_MEM_ROW) {
+        uint32_t n = count - done < DEBUGGER_MEM_ROW ? count - done : DEBUGGER_MEM_ROW;
+        debugger_read(dbg, address + done, n, row);
+        fprintf(out, "%08X:", address + done);
+        for (uint32_t i = 0; i < n; i++)
+            fprintf(out, " %08X", row[i]);
+        fprintf(out, "\n");
+    }
+}
+
+static void print_points(const Debugger *dbg, FILE *out) {
+    if (!dbg->breakpoint_count && !dbg->watchpoint_count)
+        fprintf(out, "no breakpoints or watchpoints\n");
+    for (uint32_t i = 0; i < dbg->breakpoint_count; i++) {
+        char text[64];
+        format_at(dbg, dbg->breakpoints[i].address, text, sizeof(text));
+        fprintf(out, "break %08X: %s\n", dbg->breakpoints[i].address, text);
+    }
+    for (uint32_t i = 0; i < dbg->watchpoint_count; i++)
+        fprintf(out, "watch %08X, %u words\n", dbg->watchpoints[i].address, dbg->watchpoints[i].words);
+}
+
+static void print_help(FILE *out) {
+    fprintf(out,
+            "break|b LOC        set a breakpoint (LOC: address or label)\n"
+            "delete|d LOC       remove a breakpoint\n"
+            "watch|w LOC [N]    stop after stores to N words at LOC (default 1)\n"
+            "unwatch LOC        remove a watchpoint\n"
+            "step|s [N]         execute N instructions (default 1)\n"
+            "continue|c [N]     run until a breakpoint, watchpoint or the end (at most N instructions)\n"
+            "regs|r             print PC, flags and registers\n"
+            "mem|x LOC [N]      print N words of memory (default 8)\n"
+            "info|i             list breakpoints and watchpoints\n"
+            "quit|q             leave the debugger\n");
+}
+
+static bool is_command(const char *word, const char *name, const char *alias) {
+    return strcmp(word, name) == 0 || (alias && strcmp(word, alias) == 0);
+}
+
+bool debugger_command(Debugger *dbg, const LabelTable *labels, const char *line, FILE *out) {
+    char buffer[DEBUGGER_LINE_MAX];
+    snprintf(buffer, sizeof(buffer), "%s", line);
+    char *save = NULL;
+    char *command = strtok_r(buffer, " \t\r\n", &save);
+    char *first = command ? strtok_r(NULL, " \t\r\n", &save) : NULL;
+    char *second = first ? strtok_r(NULL, " \t\r\n", &save) : NULL;
+    if (!command)
+        return true;
+
+    uint32_t address = 0;
+    uint64_t count = second ? strtoull(second, NULL, 0) : 0;
+    bool located = first && parse_location(labels, first, &address);
+
+    if (is_command(command, "quit", "q"))
+        return false;
+    if (is_command(command, "help", "h")) {
+        print_help(out);
+    } else if (is_command(command, "regs", "r")) {
+        print_registers(&dbg->cpu, out);
+    } else if (is_command(command, "info", "i")) {
+        print_points(dbg, out);
+    } else if (is_command(command, "step", "s") || is_command(command, "continue", "c")) {
+        uint64_t n = first ? strtoull(first, NULL, 0) : 0;
+        CpuStopReason reason;
+        if (command[0] == 's') {
+            uint64_t steps = n ? n : 1;
+            do
+                reason = debugger_step(dbg);
+            while (reason == CPU_STOP_NONE && --steps);
+        } else {
+            reason = debugger_continue(dbg, n);
+        }
+        print_stop(dbg, reason, out);
+    } else if (!is_command(command, "break", "b") && !is_command(command, "delete", "d")
+               && !is_command(command, "watch", "w") && !is_command(command, "unwatch", NULL)
+               && !is_command(command, "mem", "x")) {
+        fprintf(out, "unknown command '%s' (try help)\n", command);
+    } else if (!located) {
+        fprintf(out, "%s needs an address or label%s%s\n", command, first ? ", not " : "", first ? first : "");
+    } else if (is_command(command, "break", "b")) {
+        if (debugger_set_breakpoint(dbg, address))
+            fprintf(out, "breakpoint at %08X\n", address);
+    } else if (is_command(command, "delete", "d")) {
+        if (!debugger_clear_breakpoint(dbg, address))
+            fprintf(out, "no breakpoint at %08X\n", address);
+    } else if (is_command(command, "watch", "w")) {
+        uint32_t words = count ? (uint32_t)count : 1;
+        if (debugger_set_watchpoint(dbg, address, words))
+            fprintf(out, "watchpoint on %08X, %u words\n", address, words);
+    } else if (is_command(command, "unwatch", NULL)) {
+        if (!debugger_clear_watchpoint(dbg, address))
+            fprintf(out, "no watchpoint starts at %08X\n", address);
+    } else {
+        print_memory(dbg, address, count ? (uint32_t)count : DEBUGGER_MEM_ROW, out);
+    }
+    return true;
+}
+
+void debugger_repl(Debugger *dbg, const LabelTable *labels, FILE *in, FILE *out) {
+    bool prompt = isatty(fileno(in));
+    char line[DEBUGGER_LINE_MAX];
+    for (;;) {
+        if (prompt) {
+            fputs("(dbg) ", out);
+            fflush(out);
+        }
+        if (!fgets(line, sizeof(line), in) || !debugger_command(dbg, labels, line, out))
+            break;
+        fflush(out);
+    }
+}
@@ -0,0 +1,81 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "../include/disasm.h"
+
+/**
+ * @brief Format a LOADM/STOREM memory operand: "(A<n>)" or "(0xNNNN)".
+ */
+static int format_memory_operand(const DecodedInstruction *insn, char *buf, size_t size) {
+    if (insn->mode == ADDR_LITERAL)
+        return snprintf(buf, size, "(0x%04X)", insn->operand);
+    return snprintf(buf, size, "(A%u)", insn->operand);
+}
+
+/**
+ * @brief Format one decoded instruction as assembler text.
+ */
+int format_instruction(const DecodedInstruction *insn, char *buf, size_t size) {
+    const char *mn = opcode_mnemonic(insn->opcode);
+    char mem[24];
+
+    switch (insn->opcode) {
+        case ISA_LOADI:
+            return snprintf(buf, size, "%s R%u, %u", mn, insn->reg, insn->operand);
+        case ISA_LOADA:
+            return snprintf(buf, size, "%s A%u, 0x%04X", mn, insn->reg, insn->operand);
+        case ISA_LOADM:
+            format_memory_operand(insn, mem, sizeof(mem));
+            return snprintf(buf, size, "%s R%u, %s", mn, insn->reg, mem);
+        case ISA_STOREM:
+            format_memory_operand(insn, mem, sizeof(mem));
+            return snprintf(buf, size, "%s %s, R%u", mn, mem, insn->reg);
+        case ISA_ADD: case ISA_SUB: case ISA_MLP: case ISA_DIV:
+        case ISA_AND: case ISA_OR: case ISA_XOR:
+            if (insn->mode == OPERAND_NUMERIC)
+                return snprintf(buf, size, "%s R%u, %u", mn, insn->reg, insn->operand);
+            return snprintf(buf, size, "%s R%u, R%u", mn, insn->reg, insn->operand);
+        case ISA_CMP:
+            return snprintf(buf, size, "%s R%u, R%u", mn, insn->reg, insn->operand);
+        case ISA_JMP: case ISA_JZ: case ISA_JNZ:
+            return snprintf(buf, size, "%s 0x%04X", mn, insn->operand);
+        case ISA_HALT:
+            return snprintf(buf, size, "%s", mn);
+        default:
+            return snprintf(buf, size, ".word 0x%08X", insn->opcode);
+    }
+}
+
+/**
+ * @brief Disassemble an assembled range, one instruction per line.
+ */
+bool disassemble(const uint32_t *words, uint32_t limit, AssemblyRange range, FILE *out) {
+    bool all_valid = true;
+    uint32_t pc = range.start_address;
+
+    while (pc < range.end_address && pc < limit) {
+        DecodedInstruction insn;
+        char text[64];
+
+        if (!decode_instruction(words, limit, pc, range.encoding, &insn)) {
+            fprintf(out, "0x%04X: %08X                             .word 0x%08X\n", pc, words[pc], words[pc]);
+            all_valid = false;
+            pc++;
+            continue;
+        }
+
+        format_instruction(&insn, text, sizeof(text));
+        fprintf(out, "0x%04X:", pc);
+        for (uint32_t i = 0; i < 4; i++) {
+            if (i < insn.length)
+                fprintf(out, " %08X", words[pc + i]);
+            else
+                fprintf(out, "         ");
+        }
+        fprintf(out, "  %s\n", text);
+        pc += insn.length;
+    }
+
+    return all_valid;
+}
@@ -0,0 +1,402 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "emulator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "aot.h"
+#include "cpu_exec.h"
+#include "engine.h"
+#include "image.h"
+#include "metrics.h"
+#include "optimizer.h"
+
+/**
+ * @struct Emulator
+ * @brief Instance state behind the opaque handle.
+ */
+struct Emulator {
+    EmuConfig config;               /**< Copy of the creation config */
+    const ExecEngine *engine;       /**< Selected engine */
+    CPU cpu;                        /**< CPU of the most recent run */
+    RAM ram;                        /**< RAM of the most recent run */
+    uint32_t image[RAM_SIZE];       /**< Pristine program image every run starts from */
+    AssemblyRange range;            /**< Loaded program (error = true when none) */
+    AotModule module;               /**< Compiled program for translating engines */
+    bool module_loaded;             /**< Whether `module` holds a loaded program */
+    bool ram_stale;                 /**< RAM differs from `image` in untracked places */
+    CoverageMap *coverage;          /**< Edge bitmap of covered runs, or NULL */
+    StatePublisher *publisher;      /**< Live state of observed runs, or NULL */
+    const MmioBus *mmio;            /**< Devices of mapped runs, or NULL */
+};
+
+/**
+ * @brief Default log sink: WARN/ERROR lines on stderr.
+ */
+static void stderr_log_write(void *user, LogLevel level, const char *message) {
+    (void)user;
+    fprintf(stderr, "cpu_emulator: %s: %s\n", level == LOG_ERROR ? "error" : level == LOG_WARN ? "warning" : "note",
+            message);
+}
+
+void emu_config_default(EmuConfig *config) {
+    memset(config, 0, sizeof(*config));
+    config->engine = NULL;
+    config->max_instructions = 0;
+    config->encoding = ENCODING_WIDE;
+    config->optimize = false;
+    config->log.write = stderr_log_write;
+    config->log.user = NULL;
+    config->log.level_mask = LOG_LEVEL_BIT(LOG_WARN) | LOG_LEVEL_BIT(LOG_ERROR);
+}
+
+/**
+ * @brief Drop the loaded program (and its compiled module, if any).
+ */
+static void unload_program(Emulator *emu) {
+    if (emu->module_loaded) {
+        aot_unload(&emu->module);
+        emu->module_loaded = false;
+    }
+    emu->range.error = true;
+    emu->ram_stale = true;
+}
+
+Emulator *emu_create(const EmuConfig *config) {
+    EmuConfig defaults;
+    if (!config) {
+        emu_config_default(&defaults);
+        config = &defaults;
+    }
+
+    const LogSink *previous = log_set_thread_sink(&config->log);
+    Emulator *emu = NULL;
+    const ExecEngine *engine = config->engine ? engine_find(config->engine) : engine_default();
+    if (!engine)
+        goto done;
+    if (config->max_instructions && !engine->supports_limit) {
+        log_write(LOG_ERROR, "Engine %s does not support instruction limits", engine->name);
+        goto done;
+    }
+
+    emu = calloc(1, sizeof(*emu));
+    if (!emu) {
+        log_write(LOG_ERROR, "Out of memory creating an emulator instance");
+        goto done;
+    }
+    emu->config = *config;
+    emu->engine = engine;
+    emu->range.error = true;
+    emu->ram_stale = true;
+    ram_init(&emu->ram);
+    cpu_init(&emu->cpu);
+
+done:
+    log_set_thread_sink(previous);
+    return emu;
+}
+
+void emu_destroy(Emulator *emu) {
+    if (!emu)
+        return;
+    const LogSink *previous = log_set_thread_sink(&emu->config.log);
+    unload_program(emu);
+    pthread_rwlock_destroy(&emu->ram.lock);
+    free(emu);
+    log_set_thread_sink(previous);
+}
+
+/**
+ * @brief Finish loading a program whose words are already in `emu->image`.
+ *
+ * Runs the optimizer and builds the native module when configured to.
+ * Called with the instance's sink installed.
+ */
+static bool finish_load(Emulator *emu, AssemblyRange range) {
+    if (range.error) {
+        log_write(LOG_ERROR, "Failed to load program");
+        return false;
+    }
+    if (emu->config.optimize && !optimize_range(emu->image, RAM_SIZE, &range, NULL)) {
+        log_write(LOG_ERROR, "Optimization failed");
+        return false;
+    }
+    if (emu->engine->translates) {
+        if (!aot_build(&emu->module, emu->image, RAM_SIZE, range, NULL)) {
+            log_write(LOG_ERROR, "Compilation of the loaded program failed");
+            return false;
+        }
+        emu->module_loaded = true;
+    }
+    emu->range = range;
+    return true;
+}
+
+/**
+ * @brief Whether `path` ends with `suffix`.
+ */
+static bool has_suffix(const char *path, const char *suffix) {
+    size_t n = strlen(path), m = strlen(suffix);
+    return n >= m && strcmp(path + n - m, suffix) == 0;
+}
+
+bool emu_load_source(Emulator *emu, const char *source, size_t length) {
+    const LogSink *previous = log_set_thread_sink(&emu->config.log);
+    unload_program(emu);
+    memset(emu->image, 0, sizeof(emu->image));
+    bool ok = finish_load(emu, assemble_source(emu->image, RAM_SIZE, source, length, emu->config.encoding));
+    log_set_thread_sink(previous);
+    return ok;
+}
+
+bool emu_load_file(Emulator *emu, const char *path) {
+    const LogSink *previous = log_set_thread_sink(&emu->config.log);
+    unload_program(emu);
+    memset(emu->image, 0, sizeof(emu->image));
+    AssemblyRange range = has_suffix(path, ".asm")
+        ? assemble_into(emu->image, RAM_SIZE, path, emu->config.encoding)
+        : image_read(path, emu->image, RAM_SIZE);
+    bool ok = finish_load(emu, range);
+    log_set_thread_sink(previous);
+    return ok;
+}
+
+bool emu_load_words(Emulator *emu, const uint32_t *words, uint32_t limit, AssemblyRange range) {
+    if (words && range.end_address > limit) {
+        const LogSink *previous = log_set_thread_sink(&emu->config.log);
+        log_write(LOG_ERROR, "Program range [0x%08X, 0x%08X) exceeds the %u-word buffer", range.start_address,
+                  range.end_address, limit);
+        log_set_thread_sink(previous);
+        return false;
+    }
+    return emu_load_program(emu, words && range.start_address <= limit ? words + range.start_address : NULL, range);
+}
+
+bool emu_load_program(Emulator *emu, const uint32_t *code, AssemblyRange range) {
+    const LogSink *previous = log_set_thread_sink(&emu->config.log);
+    unload_program(emu);
+    memset(emu->image, 0, sizeof(emu->image));
+    bool ok = false;
+    if (!code || range.error || range.start_address > range.end_address || range.end_address > RAM_SIZE) {
+        log_write(LOG_ERROR, "Invalid program range [0x%08X, 0x%08X)", range.start_address, range.end_address);
+    } else {
+        memcpy(emu->image + range.start_address, code,
+               (size_t)(range.end_address - range.start_address) * sizeof(uint32_t));
+        ok = finish_load(emu, range);
+    }
+    log_set_thread_sink(previous);
+    return ok;
+}
+
+/**
+ * @brief Whether [address, address + count) lies inside RAM.
+ */
+static bool window_valid(uint32_t address, uint32_t count) {
+    return (uint64_t)address + count <= RAM_SIZE;
+}
+
+/**
+ * @brief Check that every window of `input` lies inside RAM.
+ */
+static bool input_valid(const EmuInput *input) {
+    if (!input)
+        return true;
+    bool ok = (!input->data || window_valid(input->data_address, input->data_count))
+           && (!input->output || window_valid(input->output_address, input->output_count))
+           && (input->patch_count == 0 || input->patches);
+    for (uint32_t i = 0; ok && i < input->patch_count; i++)
+        ok = input->patches[i].count == 0
+          || (input->patches[i].words && window_valid(input->patches[i].address, input->patches[i].count));
+    if (!ok)
+        log_write(LOG_ERROR, "Input or output window outside RAM");
+    return ok;
+}
+
+/**
+ * @brief Write `count` words at `address` and mark their pages dirty.
+ */
+static void patch_ram(Emulator *emu, uint32_t address, const uint32_t *words, uint32_t count) {
+    if (count == 0)
+        return;
+    memcpy(emu->ram.cells + address, words, (size_t)count * sizeof(uint32_t));
+    for (uint32_t page = address >> RAM_PAGE_SHIFT; page <= (address + count - 1) >> RAM_PAGE_SHIFT; page++)
+        ram_mark_dirty(&emu->ram, page << RAM_PAGE_SHIFT);
+}
+
+/**
+ * @brief Bring RAM back to the pristine image.
+ *
+ * The interpreter marks every page it stores to (ram_mark_dirty()), so
+ * after an interpreted run only those pages are copied back, which keeps
+ * the per-job cost independent of RAM_SIZE. After a load or a native run
+ * (translated code does not track writes) the whole image is copied.
+ */
+static void restore_image(Emulator *emu) {
+    if (emu->ram_stale) {
+        memcpy(emu->ram.cells, emu->image, sizeof(emu->image));
+        emu->ram_stale = false;
+    } else {
+        for (size_t w = 0; w < RAM_PAGES / 64; w++) {
+            for (uint64_t bits = emu->ram.dirty[w]; bits; bits &= bits - 1) {
+                size_t first = ((w << 6) + (size_t)__builtin_ctzll(bits)) << RAM_PAGE_SHIFT;
+                memcpy(emu->ram.cells + first, emu->image + first, sizeof(uint32_t) << RAM_PAGE_SHIFT);
+            }
+        }
+    }
+    ram_clear_dirty(&emu->ram);
+}
+
+/**
+ * @brief Count a finished run in the metrics registry (metrics.h).
+ *
+ * Called once per run, after the engine returns, and only while metrics
+ * are enabled. Dirty pages are not known after a native run.
+ */
+static void record_run_metrics(const Emulator *emu, CpuStopReason reason, const struct timespec *started) {
+    struct timespec ended;
+    clock_gettime(CLOCK_MONOTONIC, &ended);
+    metrics_observe(METRIC_RUN_SECONDS, (uint64_t)(ended.tv_sec - started->tv_sec) * 1000000000ull
+                                        + (uint64_t)ended.tv_nsec - (uint64_t)started->tv_nsec);
+    metrics_add(METRIC_INSTRUCTIONS, emu->cpu.instructions_retired);
+    metrics_add(METRIC_RUNS + reason, 1);
+    if (reason == CPU_STOP_DIV_ZERO)
+        metrics_add(METRIC_ERROR_DIV_ZERO, 1);
+    else if (reason == CPU_STOP_INVALID_INSTRUCTION)
+        metrics_add(METRIC_ERROR_INVALID_INSTRUCTION, 1);
+    if (!emu->ram_stale) {
+        uint64_t pages = 0;
+        for (size_t w = 0; w < RAM_PAGES / 64; w++)
+            pages += (uint64_t)__builtin_popcountll(emu->ram.dirty[w]);
+        metrics_observe(METRIC_RUN_DIRTY_PAGES, pages);
+    }
+}
+
+/**
+ * @brief One run from the pristine image; the instance's sink is installed.
+ */
+static CpuStopReason run_once(Emulator *emu, const EmuInput *input, EmuResult *result) {
+    CpuStopReason reason = CPU_STOP_ERROR;
+    cpu_init(&emu->cpu);
+    emu->cpu.stop_reason = CPU_STOP_ERROR;
+
+    if (emu->range.error) {
+        log_write(LOG_ERROR, "No program loaded");
+        goto done;
+    }
+    if (!input_valid(input))
+        goto done;
+
+    uint64_t limit = input && input->max_instructions ? input->max_instructions : emu->config.max_instructions;
+    if (limit && !emu->engine->supports_limit && !emu->coverage && !emu->publisher && !emu->mmio) {
+        log_write(LOG_ERROR, "Engine %s does not support instruction limits", emu->engine->name);
+        goto done;
+    }
+
+    restore_image(emu);
+    if (input) {
+        if (input->registers)
+            memcpy(emu->cpu.registers, input->registers, sizeof(emu->cpu.registers));
+        if (input->data)
+            patch_ram(emu, input->data_address, input->data, input->data_count);
+        for (uint32_t i = 0; i < input->patch_count; i++)
+            patch_ram(emu, input->patches[i].address, input->patches[i].words, input->patches[i].count);
+    }
+
+    bool measured = metrics_enabled();
+    struct timespec started;
+    if (measured)
+        clock_gettime(CLOCK_MONOTONIC, &started);
+
+    if (emu->mmio) {
+        reason = cpu_execute_mapped(&emu->cpu, &emu->ram, emu->range, limit, emu->mmio);
+    } else if (emu->coverage) {
+        reason = cpu_execute_covered(&emu->cpu, &emu->ram, emu->range, limit, emu->coverage);
+    } else if (emu->publisher) {
+        reason = cpu_execute_observed(&emu->cpu, &emu->ram, emu->range, limit, emu->publisher);
+    } else if (emu->module_loaded) {
+        aot_run(&emu->module, &emu->cpu, &emu->ram);
+        emu->ram_stale = true;
+        reason = emu->cpu.stop_reason;
+    } else {
+        reason = emu->engine->run(&emu->cpu, &emu->ram, emu->range, limit);
+    }
+    if (measured)
+        record_run_metrics(emu, reason, &started);
+
+    if (input && input->output)
+        memcpy(input->output, emu->ram.cells + input->output_address,
+               (size_t)input->output_count * sizeof(uint32_t));
+
+done:
+    if (result) {
+        result->stop = reason;
+        result->instructions = emu->cpu.instructions_retired;
+        result->pc = emu->cpu.pc;
+        memcpy(result->registers, emu->cpu.registers, sizeof(result->registers));
+        result->zero_flag = emu->cpu.zero_flag;
+        result->negative_flag = emu->cpu.negative_flag;
+    }
+    return reason;
+}
+
+bool emu_run(Emulator *emu, const EmuInput *input, EmuResult *result) {
+    const LogSink *previous = log_set_thread_sink(&emu->config.log);
+    CpuStopReason reason = run_once(emu, input, result);
+    log_set_thread_sink(previous);
+    return !cpu_stop_is_error(reason);
+}
+
+size_t emu_run_batch(Emulator *emu, const EmuInput *inputs, size_t count, EmuResult *results) {
+    const LogSink *previous = log_set_thread_sink(&emu->config.log);
+    size_t ok = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!cpu_stop_is_error(run_once(emu, inputs ? &inputs[i] : NULL, &results[i])))
+            ok++;
+    }
+    log_set_thread_sink(previous);
+    return ok;
+}
+
+size_t emu_assemble_run_batch(Emulator *emu, const char *const *sources, const size_t *lengths, size_t count,
+                              EmuResult *results) {
+    size_t ok = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!emu_load_source(emu, sources[i], lengths[i])) {
+            memset(&results[i], 0, sizeof(results[i]));
+            results[i].stop = CPU_STOP_ERROR;
+            continue;
+        }
+        if (emu_run(emu, NULL, &results[i]))
+            ok++;
+    }
+    return ok;
+}
+
+void emu_set_coverage(Emulator *emu, CoverageMap *map) {
+    emu->coverage = map;
+}
+
+void emu_set_publisher(Emulator *emu, StatePublisher *publisher) {
+    emu->publisher = publisher;
+}
+
+void emu_set_mmio(Emulator *emu, const MmioBus *bus) {
+    emu->mmio = bus;
+}
+
+const CPU *emu_cpu(const Emulator *emu) {
+    return &emu->cpu;
+}
+
+const RAM *emu_ram(const Emulator *emu) {
+    return &emu->ram;
+}
+
+AssemblyRange emu_program_range(const Emulator *emu) {
+    return emu->range;
+}
@@ -0,0 +1,143 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "../include/encoding.h"
+
+/**
+ * @brief Encode an instruction into one or more words.
+ *
+ * The wide layout reproduces the original assembler output word-for-word.
+ * The packed layout stores opcode, `reg`, the register form of `operand`
+ * and the IMM flag in one word and appends `operand` as a second word when
+ * the instruction carries an immediate, literal address or jump target.
+ */
+uint32_t encode_instruction(const DecodedInstruction *insn, InstructionEncoding encoding, uint32_t out[4]) {
+    const uint32_t op = insn->opcode;
+
+    if (encoding == ENCODING_PACKED) {
+        bool imm;
+        switch (op) {
+            case ISA_LOADI: case ISA_LOADA:
+            case ISA_JMP: case ISA_JZ: case ISA_JNZ:
+                imm = true;
+                break;
+            case ISA_LOADM: case ISA_STOREM:
+            case ISA_ADD: case ISA_SUB: case ISA_MLP: case ISA_DIV:
+            case ISA_AND: case ISA_OR: case ISA_XOR:
+                imm = insn->mode != 0;
+                break;
+            case ISA_CMP: case ISA_HALT:
+                imm = false;
+                break;
+            default:
+                return 0;
+        }
+
+        if (insn->reg > PACKED_FIELD_MASK)
+            return 0;
+        if (!imm && op != ISA_HALT && insn->operand > PACKED_FIELD_MASK)
+            return 0;
+
+        uint32_t word = op & PACKED_OPCODE_MASK;
+        if (op != ISA_HALT && !isa_is_jump(op))
+            word |= insn->reg << PACKED_REG_SHIFT;
+        if (imm) {
+            out[0] = word | PACKED_IMM_FLAG;
+            out[1] = insn->operand;
+            return 2;
+        }
+        if (op != ISA_HALT)
+            word |= insn->operand << PACKED_SRC_SHIFT;
+        out[0] = word;
+        return 1;
+    }
+
+    switch (op) {
+        case ISA_LOADI: case ISA_LOADA: case ISA_CMP:
+            out[0] = op;
+            out[1] = insn->reg;
+            out[2] = insn->operand;
+            return 3;
+        case ISA_LOADM:
+        case ISA_ADD: case ISA_SUB: case ISA_MLP: case ISA_DIV:
+        case ISA_AND: case ISA_OR: case ISA_XOR:
+            out[0] = op;
+            out[1] = insn->reg;
+            out[2] = insn->mode;
+            out[3] = insn->operand;
+            return 4;
+        case ISA_STOREM:
+            out[0] = op;
+            out[1] = insn->operand;
+            out[2] = insn->mode;
+            out[3] = insn->reg;
+            return 4;
+        case ISA_JMP: case ISA_JZ: case ISA_JNZ:
+            out[0] = op;
+            out[1] = insn->operand;
+            return 2;
+        case ISA_HALT:
+            out[0] = op;
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Size in words of an instruction without encoding it.
+ *
+ * Used by the assembler's first pass to place labels before operands are
+ * fully parsed.
+ */
+uint32_t instruction_length(uint32_t opcode, bool has_immediate, InstructionEncoding encoding) {
+    if (encoding == ENCODING_PACKED) {
+        switch (opcode) {
+            case ISA_LOADI: case ISA_LOADA:
+            case ISA_JMP: case ISA_JZ: case ISA_JNZ:
+                return 2;
+            case ISA_LOADM: case ISA_STOREM:
+            case ISA_ADD: case ISA_SUB: case ISA_MLP: case ISA_DIV:
+            case ISA_AND: case ISA_OR: case ISA_XOR:
+                return has_immediate ? 2 : 1;
+            case ISA_CMP: case ISA_HALT:
+                return 1;
+            default:
+                return 0;
+        }
+    }
+
+    switch (opcode) {
+        case ISA_LOADI: case ISA_LOADA: case ISA_CMP:
+            return 3;
+        case ISA_LOADM: case ISA_STOREM:
+        case ISA_ADD: case ISA_SUB: case ISA_MLP: case ISA_DIV:
+        case ISA_AND: case ISA_OR: case ISA_XOR:
+            return 4;
+        case ISA_JMP: case ISA_JZ: case ISA_JNZ:
+            return 2;
+        case ISA_HALT:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Return the assembler mnemonic for an opcode ("???" if unknown).
+ */
+const char *opcode_mnemonic(uint32_t opcode) {
+    for (size_t i = 0; i < sizeof(opcode_table) / sizeof(opcode_table[0]); i++) {
+        if (opcode_table[i].opcode == opcode)
+            return opcode_table[i].mnemonic;
+    }
+    return "???";
+}
+
+/**
+ * @brief Return a short lowercase name for an encoding ("wide"/"packed").
+ */
+const char *encoding_name(InstructionEncoding encoding) {
+    return encoding == ENCODING_PACKED ? "packed" : "wide";
+}
@@ -0,0 +1,86 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "engine.h"
+
+#include <strings.h>
+
+#include "aot.h"
+#include "cfg.h"
+#include "cpu_exec.h"
+#include "log.h"
+
+/**
+ * @brief JIT engine: translate, compile, load and run the range natively.
+ *
+ * Compilation time is part of the run. A limit is rejected because the
+ * generated code has no instruction budget. A range the translator cannot
+ * analyse (see cfg_build(): reachable code that does not decode, or a jump
+ * into the middle of an instruction) runs on the switch interpreter, which
+ * stops where the fault is actually reached.
+ */
+static CpuStopReason engine_run_jit(CPU *cpu, RAM *ram, AssemblyRange range, uint64_t max_instructions) {
+    cpu->stop_reason = CPU_STOP_ERROR;
+    if (max_instructions != 0) {
+        log_write(LOG_ERROR, "The jit engine does not support instruction limits");
+        return CPU_STOP_ERROR;
+    }
+
+    ControlFlowGraph cfg;
+    bool analysable = cfg_build(&cfg, ram->cells, RAM_SIZE, range);
+    cfg_free(&cfg);
+    if (!analysable) {
+        log_write(LOG_WARN, "JIT cannot translate this program; running it on the switch interpreter");
+        return cpu_execute(cpu, ram, range, max_instructions);
+    }
+
+    AotModule module;
+    if (!aot_build(&module, ram->cells, RAM_SIZE, range, NULL)) {
+        log_write(LOG_ERROR, "JIT compilation failed");
+        return CPU_STOP_ERROR;
+    }
+    aot_run(&module, cpu, ram);
+    aot_unload(&module);
+    return cpu->stop_reason;
+}
+
+/**
+ * @brief Timed engine with the built-in cost table (see cycle_model.h).
+ *
+ * The estimate accumulates in `cpu->cycles`; hosts that need another
+ * table or per-label cycles call cpu_execute_timed() directly.
+ */
+static CpuStopReason engine_run_timed(CPU *cpu, RAM *ram, AssemblyRange range, uint64_t max_instructions) {
+    CycleModel model;
+    cycle_model_default(&model);
+    return cpu_execute_timed(cpu, ram, range, max_instructions, &model, NULL);
+}
+
+static const ExecEngine ENGINES[] = {
+    { "switch",     "decode at PC, switch dispatch",               true,  false, cpu_execute },
+    { "threaded",   "computed-goto dispatch, one jump per handler", true,  false, cpu_execute_threaded },
+    { "predecoded", "decode cache over the program range",         true,  false, cpu_execute_predecoded },
+    { "jit",        "translate to C, compile with $CC and dlopen",  false, true,  engine_run_jit },
+    { "timed",      "predecoded plus a cycle estimate per block",   true,  false, engine_run_timed },
+};
+
+#define ENGINE_COUNT (sizeof(ENGINES) / sizeof(ENGINES[0]))
+
+const ExecEngine *engine_list(size_t *count) {
+    *count = ENGINE_COUNT;
+    return ENGINES;
+}
+
+const ExecEngine *engine_find(const char *name) {
+    for (size_t i = 0; i < ENGINE_COUNT; i++) {
+        if (strcasecmp(ENGINES[i].name, name) == 0)
+            return &ENGINES[i];
+    }
+    log_write(LOG_ERROR, "Unknown engine: %s", name);
+    return NULL;
+}
+
+const ExecEngine *engine_default(void) {
+    return &ENGINES[0];
+}
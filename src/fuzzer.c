@@ -0,0 +1,672 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "fuzzer.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "coverage.h"
+#include "emulator.h"
+#include "encoding.h"
+#include "log.h"
+#include "ram.h"
+
+/** Executions a worker batches before publishing its counters. */
+#define FUZZ_COUNTER_BATCH 256u
+
+/**
+ * @struct EntryList
+ * @brief Kept inputs of one kind.
+ *
+ * Storage is allocated up front, so entries never move: writers append
+ * under the fuzzer lock and publish with a release store of `count`, and
+ * workers read any index below an acquire load of it without locking.
+ */
+typedef struct {
+    uint32_t *words;             /**< capacity x input_words */
+    CpuStopReason *stops;        /**< Stop reason of each entry's first execution */
+    atomic_uint count;
+} EntryList;
+
+/** One bitmap entry hit by the last execution, with its count bucket. */
+typedef struct {
+    uint32_t index;
+    uint8_t bucket;
+} TouchedEntry;
+
+/**
+ * @struct FuzzWorker
+ * @brief Per-thread state: instance, bitmap, candidate list and RNG.
+ */
+typedef struct {
+    Fuzzer *fuzzer;
+    pthread_t thread;
+    bool started;
+    Emulator *emu;
+    CoverageMap coverage;
+    uint32_t *candidates;        /**< Bitmap entries read after every execution */
+    uint32_t candidate_count;
+    uint8_t *is_candidate;       /**< COVERAGE_MAP_SIZE flags mirroring `candidates` */
+    TouchedEntry *touched;       /**< Entries hit by the last execution */
+    uint32_t touched_count;
+    uint32_t since_scan;         /**< Executions since the last full scan */
+    uint32_t *input;             /**< Mutation buffer */
+    uint64_t rng;
+    uint64_t execs;              /**< Not yet added to the fuzzer's counters */
+    uint64_t crashes;
+    uint64_t timeouts;
+} FuzzWorker;
+
+struct Fuzzer {
+    FuzzConfig config;
+    AssemblyRange range;
+    uint32_t code_first_page;    /**< RAM pages holding the program */
+    uint32_t code_last_page;
+    uint32_t *static_candidates; /**< Edges of every branch in the program range */
+    uint32_t static_count;
+    FuzzWorker *workers;
+    size_t worker_count;
+    pthread_mutex_t lock;        /**< Serializes appends and updates of `seen` */
+    EntryList entries[FUZZ_KIND_COUNT];
+    atomic_uchar *seen[FUZZ_KIND_COUNT];  /**< Bucket bits seen per entry, per kind */
+    atomic_uint_fast64_t execs;
+    atomic_uint_fast64_t crashes;
+    atomic_uint_fast64_t timeouts;
+    atomic_uint edges;
+    atomic_bool stop;
+    double seconds;
+};
+
+void fuzz_config_default(FuzzConfig *config) {
+    memset(config, 0, sizeof(*config));
+    config->max_instructions = FUZZ_DEFAULT_BUDGET;
+    config->capacity = FUZZ_DEFAULT_CAPACITY;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief xorshift64* step.
+ */
+static uint64_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1Dull;
+}
+
+/**
+ * @brief Uniform value in [0, bound) (bound > 0).
+ */
+static uint32_t random_below(uint64_t *state, uint32_t bound) {
+    return (uint32_t)(((next_random(state) >> 32) * bound) >> 32);
+}
+
+/**
+ * @brief AFL's hit-count bucket of a counter value, as one bit.
+ */
+static uint8_t count_bucket(uint8_t count) {
+    if (count <= 3)
+        return (uint8_t)(count == 3 ? 4 : count);
+    if (count <= 7)
+        return 8;
+    if (count <= 15)
+        return 16;
+    if (count <= 31)
+        return 32;
+    if (count <= 127)
+        return 64;
+    return 128;
+}
+
+static uint32_t *entry_words(const Fuzzer *fuzzer, FuzzEntryKind kind, uint32_t index) {
+    return fuzzer->entries[kind].words + (size_t)index * fuzzer->config.input_words;
+}
+
+/**
+ * @brief Add `index` to the worker's candidate list unless it is there.
+ */
+static void add_candidate(FuzzWorker *worker, uint32_t index) {
+    if (worker->is_candidate[index])
+        return;
+    worker->is_candidate[index] = 1;
+    worker->candidates[worker->candidate_count++] = index;
+}
+
+/**
+ * @brief Collect the bitmap edges every branch of the program range can produce.
+ *
+ * The range is decoded linearly; words that do not decode are skipped one
+ * at a time, so data inside the range costs nothing but a few spurious
+ * candidates.
+ */
+static bool find_static_candidates(Fuzzer *fuzzer, const uint32_t *words) {
+    AssemblyRange range = fuzzer->range;
+    uint32_t size = range.end_address > range.start_address ? range.end_address - range.start_address : 0;
+    fuzzer->static_candidates = malloc(((size_t)size * 2 + 1) * sizeof(uint32_t));
+    if (!fuzzer->static_candidates)
+        return false;
+
+    uint32_t pc = range.start_address;
+    while (pc < range.end_address) {
+        DecodedInstruction insn;
+        if (!decode_instruction(words, RAM_SIZE, pc, range.encoding, &insn)) {
+            pc++;
+            continue;
+        }
+        if (insn.opcode == ISA_JMP || insn.opcode == ISA_JZ || insn.opcode == ISA_JNZ)
+            fuzzer->static_candidates[fuzzer->static_count++] = coverage_edge_index(pc, insn.operand);
+        if (insn.opcode == ISA_JZ || insn.opcode == ISA_JNZ)
+            fuzzer->static_candidates[fuzzer->static_count++] = coverage_edge_index(pc, pc + insn.length);
+        pc += insn.length;
+    }
+    return true;
+}
+
+static bool worker_init(Fuzzer *fuzzer, FuzzWorker *worker, const uint32_t *words, uint64_t seed) {
+    memset(worker, 0, sizeof(*worker));
+    worker->fuzzer = fuzzer;
+    worker->rng = seed ? seed : 1;
+
+    EmuConfig config;
+    emu_config_default(&config);
+    config.max_instructions = fuzzer->config.max_instructions;
+    config.log.write = NULL;
+    worker->emu = emu_create(&config);
+    if (!worker->emu || !coverage_map_init(&worker->coverage))
+        return false;
+    if (!emu_load_words(worker->emu, words, RAM_SIZE, fuzzer->range))
+        return false;
+    emu_set_coverage(worker->emu, &worker->coverage);
+
+    worker->candidates = malloc(COVERAGE_MAP_SIZE * sizeof(uint32_t));
+    worker->is_candidate = calloc(COVERAGE_MAP_SIZE, 1);
+    worker->touched = malloc(COVERAGE_MAP_SIZE * sizeof(TouchedEntry));
+    worker->input = malloc(fuzzer->config.input_words * sizeof(uint32_t));
+    if (!worker->candidates || !worker->is_candidate || !worker->touched || !worker->input)
+        return false;
+    for (uint32_t i = 0; i < fuzzer->static_count; i++)
+        add_candidate(worker, fuzzer->static_candidates[i]);
+    return true;
+}
+
+static void worker_free(FuzzWorker *worker) {
+    emu_destroy(worker->emu);
+    if (worker->coverage.bits)
+        coverage_map_free(&worker->coverage);
+    free(worker->candidates);
+    free(worker->is_candidate);
+    free(worker->touched);
+    free(worker->input);
+}
+
+Fuzzer *fuzzer_create(const FuzzConfig *config, const uint32_t *words, AssemblyRange range) {
+    if (range.error) {
+        log_write(LOG_ERROR, "Fuzzer: no program");
+        return NULL;
+    }
+    if (config->input_words == 0 || config->input_words > FUZZ_MAX_INPUT_WORDS
+        || (uint64_t)config->input_address + config->input_words > RAM_SIZE) {
+        log_write(LOG_ERROR, "Fuzzer: input window must hold 1..%u words inside RAM", FUZZ_MAX_INPUT_WORDS);
+        return NULL;
+    }
+
+    Fuzzer *fuzzer = calloc(1, sizeof(*fuzzer));
+    if (!fuzzer) {
+        log_write(LOG_ERROR, "Fuzzer: out of memory");
+        return NULL;
+    }
+    fuzzer->config = *config;
+    if (!fuzzer->config.max_instructions)
+        fuzzer->config.max_instructions = FUZZ_DEFAULT_BUDGET;
+    if (!fuzzer->config.capacity)
+        fuzzer->config.capacity = FUZZ_DEFAULT_CAPACITY;
+    if (!fuzzer->config.seed)
+        fuzzer->config.seed = now_ns();
+    if (!fuzzer->config.workers) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        fuzzer->config.workers = online > 0 ? (size_t)online : 1;
+    }
+    fuzzer->range = range;
+    fuzzer->code_first_page = range.start_address >> RAM_PAGE_SHIFT;
+    fuzzer->code_last_page = range.end_address > range.start_address
+        ? (range.end_address - 1) >> RAM_PAGE_SHIFT : fuzzer->code_first_page;
+    pthread_mutex_init(&fuzzer->lock, NULL);
+    atomic_init(&fuzzer->execs, 0);
+    atomic_init(&fuzzer->crashes, 0);
+    atomic_init(&fuzzer->timeouts, 0);
+    atomic_init(&fuzzer->edges, 0);
+    atomic_init(&fuzzer->stop, false);
+
+    bool ok = find_static_candidates(fuzzer, words);
+    size_t capacity = fuzzer->config.capacity;
+    for (int kind = 0; ok && kind < FUZZ_KIND_COUNT; kind++) {
+        EntryList *list = &fuzzer->entries[kind];
+        list->words = malloc(capacity * fuzzer->config.input_words * sizeof(uint32_t));
+        list->stops = malloc(capacity * sizeof(CpuStopReason));
+        atomic_init(&list->count, 0);
+        fuzzer->seen[kind] = calloc(COVERAGE_MAP_SIZE, sizeof(atomic_uchar));
+        ok = list->words && list->stops && fuzzer->seen[kind];
+    }
+
+    fuzzer->workers = ok ? calloc(fuzzer->config.workers, sizeof(FuzzWorker)) : NULL;
+    ok = ok && fuzzer->workers;
+    uint64_t rng = fuzzer->config.seed;
+    for (size_t i = 0; ok && i < fuzzer->config.workers; i++) {
+        ok = worker_init(fuzzer, &fuzzer->workers[i], words, next_random(&rng));
+        fuzzer->worker_count = i + 1;
+    }
+    if (!ok) {
+        log_write(LOG_ERROR, "Fuzzer: out of memory or program could not be loaded");
+        fuzzer_destroy(fuzzer);
+        return NULL;
+    }
+    return fuzzer;
+}
+
+void fuzzer_destroy(Fuzzer *fuzzer) {
+    if (!fuzzer)
+        return;
+    for (size_t i = 0; i < fuzzer->worker_count; i++)
+        worker_free(&fuzzer->workers[i]);
+    free(fuzzer->workers);
+    for (int kind = 0; kind < FUZZ_KIND_COUNT; kind++) {
+        free(fuzzer->entries[kind].words);
+        free(fuzzer->entries[kind].stops);
+        free(fuzzer->seen[kind]);
+    }
+    free(fuzzer->static_candidates);
+    pthread_mutex_destroy(&fuzzer->lock);
+    free(fuzzer);
+}
+
+/**
+ * @brief Whether the last execution stored into a page holding the program.
+ */
+static bool code_pages_dirty(const Fuzzer *fuzzer, const RAM *ram) {
+    for (uint32_t page = fuzzer->code_first_page; page <= fuzzer->code_last_page; page++) {
+        if (ram->dirty[page >> 6] & (1ull << (page & 63)))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Move one counter of the bitmap into the touched list and clear it.
+ */
+static inline void take_entry(FuzzWorker *worker, uint32_t index) {
+    uint8_t count = worker->coverage.bits[index];
+    if (!count)
+        return;
+    worker->coverage.bits[index] = 0;
+    worker->touched[worker->touched_count++] = (TouchedEntry){ index, count_bucket(count) };
+}
+
+/**
+ * @brief Read and clear the bitmap after an execution.
+ *
+ * @return true if some entry has a bucket bit not yet seen for `kind`.
+ */
+static bool collect_coverage(FuzzWorker *worker, FuzzEntryKind kind) {
+    Fuzzer *fuzzer = worker->fuzzer;
+    worker->touched_count = 0;
+
+    if (++worker->since_scan >= FUZZ_FULL_SCAN_PERIOD || code_pages_dirty(fuzzer, emu_ram(worker->emu))) {
+        worker->since_scan = 0;
+        const uint64_t *chunks = (const uint64_t *)worker->coverage.bits;
+        for (uint32_t c = 0; c < COVERAGE_MAP_SIZE / 8; c++) {
+            if (!chunks[c])
+                continue;
+            for (uint32_t index = c * 8; index < c * 8 + 8; index++) {
+                if (worker->coverage.bits[index])
+                    add_candidate(worker, index);
+                take_entry(worker, index);
+            }
+        }
+    } else {
+        for (uint32_t i = 0; i < worker->candidate_count; i++)
+            take_entry(worker, worker->candidates[i]);
+    }
+
+    const atomic_uchar *seen = fuzzer->seen[kind];
+    bool fresh = false;
+    for (uint32_t i = 0; i < worker->touched_count; i++) {
+        const TouchedEntry *entry = &worker->touched[i];
+        if (entry->bucket & ~atomic_load_explicit(&seen[entry->index], memory_order_relaxed))
+            fresh = true;
+    }
+    return fresh;
+}
+
+/**
+ * @brief Merge the touched buckets into `seen` and append the input if it adds any.
+ *
+ * @param force Append even without new bits (seeds).
+ */
+static void keep_input(FuzzWorker *worker, FuzzEntryKind kind, const uint32_t *input, CpuStopReason stop,
+                       bool force) {
+    Fuzzer *fuzzer = worker->fuzzer;
+    pthread_mutex_lock(&fuzzer->lock);
+    atomic_uchar *seen = fuzzer->seen[kind];
+    bool fresh = false;
+    for (uint32_t i = 0; i < worker->touched_count; i++) {
+        const TouchedEntry *entry = &worker->touched[i];
+        uint8_t old = atomic_load_explicit(&seen[entry->index], memory_order_relaxed);
+        if (!(entry->bucket & ~old))
+            continue;
+        fresh = true;
+        atomic_store_explicit(&seen[entry->index], (uint8_t)(old | entry->bucket), memory_order_relaxed);
+        if (!old && kind == FUZZ_CORPUS)
+            atomic_fetch_add_explicit(&fuzzer->edges, 1, memory_order_relaxed);
+    }
+
+    EntryList *list = &fuzzer->entries[kind];
+    uint32_t count = atomic_load_explicit(&list->count, memory_order_relaxed);
+    if ((fresh || force) && count < fuzzer->config.capacity) {
+        memcpy(entry_words(fuzzer, kind, count), input, fuzzer->config.input_words * sizeof(uint32_t));
+        list->stops[count] = stop;
+        atomic_store_explicit(&list->count, count + 1, memory_order_release);
+    }
+    pthread_mutex_unlock(&fuzzer->lock);
+}
+
+/**
+ * @brief Outcome class of a stop reason.
+ */
+static FuzzEntryKind kind_of(CpuStopReason stop) {
+    if (stop == CPU_STOP_LIMIT)
+        return FUZZ_TIMEOUT;
+    return cpu_stop_is_error(stop) ? FUZZ_CRASH : FUZZ_CORPUS;
+}
+
+/**
+ * @brief Run one input and keep it if it reached new coverage.
+ */
+static void execute_input(FuzzWorker *worker, const uint32_t *input, FuzzEntryKind force_kind, bool force) {
+    const Fuzzer *fuzzer = worker->fuzzer;
+    EmuInput run = {
+        .data = input,
+        .data_address = fuzzer->config.input_address,
+        .data_count = fuzzer->config.input_words,
+    };
+    EmuResult result;
+    emu_run(worker->emu, &run, &result);
+
+    FuzzEntryKind kind = kind_of(result.stop);
+    worker->execs++;
+    worker->crashes += kind == FUZZ_CRASH;
+    worker->timeouts += kind == FUZZ_TIMEOUT;
+
+    bool fresh = collect_coverage(worker, kind);
+    if (force)
+        keep_input(worker, force_kind, input, result.stop, true);
+    else if (fresh)
+        keep_input(worker, kind, input, result.stop, false);
+}
+
+/**
+ * @brief Add the worker's batched counters to the fuzzer's.
+ *
+ * @return Executions of the whole campaign so far.
+ */
+static uint64_t publish_counters(FuzzWorker *worker) {
+    Fuzzer *fuzzer = worker->fuzzer;
+    uint64_t total = atomic_fetch_add_explicit(&fuzzer->execs, worker->execs, memory_order_relaxed) + worker->execs;
+    atomic_fetch_add_explicit(&fuzzer->crashes, worker->crashes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&fuzzer->timeouts, worker->timeouts, memory_order_relaxed);
+    worker->execs = 0;
+    worker->crashes = 0;
+    worker->timeouts = 0;
+    return total;
+}
+
+bool fuzzer_add_seed(Fuzzer *fuzzer, const uint32_t *words, uint32_t count) {
+    FuzzWorker *worker = &fuzzer->workers[0];
+    uint32_t window = fuzzer->config.input_words;
+    if (atomic_load(&fuzzer->entries[FUZZ_CORPUS].count) >= fuzzer->config.capacity) {
+        log_write(LOG_ERROR, "Fuzzer: corpus is full");
+        return false;
+    }
+    memset(worker->input, 0, window * sizeof(uint32_t));
+    memcpy(worker->input, words, (count < window ? count : window) * sizeof(uint32_t));
+    execute_input(worker, worker->input, FUZZ_CORPUS, true);
+    publish_counters(worker);
+    return true;
+}
+
+static const uint32_t INTERESTING_WORDS[] = {
+    0, 1, 2, 7, 8, 16, 32, 64, 100, 127, 128, 255, 256, 512, 1000, 1024, 4096, 32767, 32768, 65535, 65536,
+    0x7FFFFFFFu, 0x80000000u, 0xFFFFFFFFu, 0xFFFFFFFEu, 0xFFFFFF80u, 0xFFFF8000u,
+};
+
+#define INTERESTING_COUNT (sizeof(INTERESTING_WORDS) / sizeof(INTERESTING_WORDS[0]))
+
+/**
+ * @brief Apply a stack of 2 to 16 random word-level mutations (AFL havoc style).
+ */
+static void mutate(FuzzWorker *worker, uint32_t *input) {
+    Fuzzer *fuzzer = worker->fuzzer;
+    uint32_t words = fuzzer->config.input_words;
+    uint64_t *rng = &worker->rng;
+    uint32_t ops = 2u << random_below(rng, 4);
+
+    for (uint32_t op = 0; op < ops; op++) {
+        uint32_t at = random_below(rng, words);
+        switch (random_below(rng, 8)) {
+            case 0:
+                input[at] ^= 1u << random_below(rng, 32);
+                break;
+            case 1:
+                input[at] = INTERESTING_WORDS[random_below(rng, INTERESTING_COUNT)];
+                break;
+            case 2:
+                input[at] += 1 + random_below(rng, 35);
+                break;
+            case 3:
+                input[at] -= 1 + random_below(rng, 35);
+                break;
+            case 4: {
+                uint32_t shift = 8 * random_below(rng, 4);
+                input[at] = (input[at] & ~(0xFFu << shift)) | (random_below(rng, 256) << shift);
+                break;
+            }
+            case 5:
+                input[at] = (uint32_t)next_random(rng);
+                break;
+            case 6: {
+                uint32_t from = random_below(rng, words);
+                uint32_t length = 1 + random_below(rng, words - (at > from ? at : from));
+                memmove(input + at, input + from, length * sizeof(uint32_t));
+                break;
+            }
+            default: {
+                /* Splice: copy a run from another corpus entry at the same offset. */
+                uint32_t count = atomic_load_explicit(&fuzzer->entries[FUZZ_CORPUS].count, memory_order_acquire);
+                const uint32_t *other = entry_words(fuzzer, FUZZ_CORPUS, random_below(rng, count));
+                uint32_t length = 1 + random_below(rng, words - at);
+                memcpy(input + at, other + at, length * sizeof(uint32_t));
+                break;
+            }
+        }
+    }
+}
+
+static void *worker_main(void *arg) {
+    FuzzWorker *worker = arg;
+    Fuzzer *fuzzer = worker->fuzzer;
+    size_t bytes = fuzzer->config.input_words * sizeof(uint32_t);
+
+    while (!atomic_load_explicit(&fuzzer->stop, memory_order_relaxed)) {
+        uint32_t count = atomic_load_explicit(&fuzzer->entries[FUZZ_CORPUS].count, memory_order_acquire);
+        memcpy(worker->input, entry_words(fuzzer, FUZZ_CORPUS, random_below(&worker->rng, count)), bytes);
+        mutate(worker, worker->input);
+        execute_input(worker, worker->input, FUZZ_CORPUS, false);
+
+        if (worker->execs == FUZZ_COUNTER_BATCH) {
+            uint64_t total = publish_counters(worker);
+            if (fuzzer->config.max_execs && total >= fuzzer->config.max_execs)
+                atomic_store(&fuzzer->stop, true);
+        }
+    }
+    publish_counters(worker);
+    return NULL;
+}
+
+bool fuzzer_run(Fuzzer *fuzzer, FuzzProgress progress, void *user) {
+    if (atomic_load(&fuzzer->entries[FUZZ_CORPUS].count) == 0) {
+        uint32_t zero = 0;
+        fuzzer_add_seed(fuzzer, &zero, 1);
+    }
+
+    uint64_t started = now_ns();
+    size_t running = 0;
+    for (size_t i = 0; i < fuzzer->worker_count; i++) {
+        FuzzWorker *worker = &fuzzer->workers[i];
+        worker->started = pthread_create(&worker->thread, NULL, worker_main, worker) == 0;
+        running += worker->started;
+    }
+    if (!running) {
+        log_write(LOG_ERROR, "Fuzzer: unable to start any worker thread");
+        return false;
+    }
+
+    uint64_t next_report = started + 1000000000ull;
+    while (!atomic_load(&fuzzer->stop)) {
+        struct timespec pause = { 0, 50 * 1000 * 1000 };
+        nanosleep(&pause, NULL);
+        uint64_t now = now_ns();
+        fuzzer->seconds = (double)(now - started) / 1e9;
+        if (fuzzer->config.max_seconds && fuzzer->seconds >= fuzzer->config.max_seconds)
+            atomic_store(&fuzzer->stop, true);
+        if (progress && now >= next_report) {
+            FuzzStats stats;
+            fuzzer_stats(fuzzer, &stats);
+            progress(user, &stats);
+            next_report = now + 1000000000ull;
+        }
+    }
+
+    for (size_t i = 0; i < fuzzer->worker_count; i++) {
+        if (fuzzer->workers[i].started)
+            pthread_join(fuzzer->workers[i].thread, NULL);
+        fuzzer->workers[i].started = false;
+    }
+    fuzzer->seconds = (double)(now_ns() - started) / 1e9;
+    return true;
+}
+
+void fuzzer_stop(Fuzzer *fuzzer) {
+    atomic_store(&fuzzer->stop, true);
+}
+
+void fuzzer_stats(const Fuzzer *fuzzer, FuzzStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->execs = atomic_load_explicit(&fuzzer->execs, memory_order_relaxed);
+    stats->crashes = atomic_load_explicit(&fuzzer->crashes, memory_order_relaxed);
+    stats->timeouts = atomic_load_explicit(&fuzzer->timeouts, memory_order_relaxed);
+    for (int kind = 0; kind < FUZZ_KIND_COUNT; kind++)
+        stats->kept[kind] = atomic_load_explicit(&fuzzer->entries[kind].count, memory_order_acquire);
+    stats->edges = atomic_load_explicit(&fuzzer->edges, memory_order_relaxed);
+    stats->seconds = fuzzer->seconds;
+}
+
+const uint32_t *fuzzer_entry(const Fuzzer *fuzzer, FuzzEntryKind kind, uint32_t index, CpuStopReason *stop) {
+    if (kind >= FUZZ_KIND_COUNT || index >= atomic_load(&fuzzer->entries[kind].count))
+        return NULL;
+    if (stop)
+        *stop = fuzzer->entries[kind].stops[index];
+    return entry_words(fuzzer, kind, index);
+}
+
+/**
+ * @brief Create `path` unless it already exists as a directory.
+ */
+static bool make_directory(const char *path) {
+    if (mkdir(path, 0755) == 0 || errno == EEXIST)
+        return true;
+    log_write(LOG_ERROR, "Unable to create directory: %s", path);
+    return false;
+}
+
+/**
+ * @brief Write `count` words as little-endian bytes.
+ */
+static bool write_words(const char *path, const uint32_t *words, uint32_t count) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        log_write(LOG_ERROR, "Unable to open %s", path);
+        return false;
+    }
+    bool ok = true;
+    for (uint32_t i = 0; ok && i < count; i++) {
+        unsigned char bytes[4] = {
+            (unsigned char)(words[i] & 0xFF),
+            (unsigned char)((words[i] >> 8) & 0xFF),
+            (unsigned char)((words[i] >> 16) & 0xFF),
+            (unsigned char)((words[i] >> 24) & 0xFF)
+        };
+        ok = fwrite(bytes, 1, sizeof(bytes), file) == sizeof(bytes);
+    }
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+        log_write(LOG_ERROR, "Unable to write %s", path);
+    return ok;
+}
+
+bool fuzzer_write_entries(const Fuzzer *fuzzer, const char *dir) {
+    static const char *const SUBDIRS[FUZZ_KIND_COUNT] = { "queue", "crashes", "timeouts" };
+    if (!make_directory(dir))
+        return false;
+
+    char path[4096];
+    for (int kind = 0; kind < FUZZ_KIND_COUNT; kind++) {
+        snprintf(path, sizeof(path), "%s/%s", dir, SUBDIRS[kind]);
+        if (!make_directory(path))
+            return false;
+        uint32_t count = atomic_load(&fuzzer->entries[kind].count);
+        for (uint32_t i = 0; i < count; i++) {
+            CpuStopReason stop = CPU_STOP_NONE;
+            const uint32_t *words = fuzzer_entry(fuzzer, (FuzzEntryKind)kind, i, &stop);
+            if (kind == FUZZ_CRASH)
+                snprintf(path, sizeof(path), "%s/%s/id-%06u-%s", dir, SUBDIRS[kind], i, cpu_stop_reason_name(stop));
+            else
+                snprintf(path, sizeof(path), "%s/%s/id-%06u", dir, SUBDIRS[kind], i);
+            if (!write_words(path, words, fuzzer->config.input_words))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool fuzz_read_input(const char *path, uint32_t *words, uint32_t capacity, uint32_t *count) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        log_write(LOG_ERROR, "Unable to open seed: %s", path);
+        return false;
+    }
+    unsigned char bytes[4];
+    *count = 0;
+    while (*count < capacity && fread(bytes, 1, sizeof(bytes), file) == sizeof(bytes)) {
+        words[(*count)++] = (uint32_t)bytes[0]
+                          | ((uint32_t)bytes[1] << 8)
+                          | ((uint32_t)bytes[2] << 16)
+                          | ((uint32_t)bytes[3] << 24);
+    }
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,677 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "gdb_stub.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "log.h"
+
+/** Registers in `g` packet order: pc, r0-r7, a0-a7, flags, instructions. */
+#define GDB_REG_PC 0
+#define GDB_REG_R0 1
+#define GDB_REG_A0 (GDB_REG_R0 + MAX_REGISTERS)
+#define GDB_REG_FLAGS (GDB_REG_A0 + MAX_ADDRESS_REGISTERS)
+#define GDB_REG_INSTRUCTIONS (GDB_REG_FLAGS + 1)
+#define GDB_REG_COUNT (GDB_REG_INSTRUCTIONS + 1)
+
+/** Bytes read from the socket at a time. */
+#define GDB_INPUT_BUFFER 4096
+
+/** Target description served through qXfer:features:read. */
+static const char TARGET_XML[] =
+    "<?xml version=\"1.0\"?>\n"
+    "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">\n"
+    "<target version=\"1.0\">\n"
+    "  <feature name=\"org.cpu32.core\">\n"
+    "    <flags id=\"cpu32_flags\" size=\"4\">\n"
+    "      <field name=\"Z\" start=\"0\" end=\"0\"/>\n"
+    "      <field name=\"N\" start=\"1\" end=\"1\"/>\n"
+    "    </flags>\n"
+    "    <reg name=\"pc\" bitsize=\"32\" type=\"code_ptr\" regnum=\"0\"/>\n"
+    "    <reg name=\"r0\" bitsize=\"32\" type=\"uint32\"/>\n"
+    "    <reg name=\"r1\" bitsize=\"32\" type=\"uint32\"/>\n"
+    "    <reg name=\"r2\" bitsize=\"32\" type=\"uint32\"/>\n"
+    "    <reg name=\"r3\" bitsize=\"32\" type=\"uint32\"/>\n"
+    "    <reg name=\"r4\" bitsize=\"32\" type=\"uint32\"/>\n"
+    "    <reg name=\"r5\" bitsize=\"32\" type=\"uint32\"/>\n"
+    "    <reg name=\"r6\" bitsize=\"32\" type=\"uint32\"/>\n"
+    "    <reg name=\"r7\" bitsize=\"32\" type=\"uint32\"/>\n"
+    "    <reg name=\"a0\" bitsize=\"32\" type=\"uint32\" group=\"address\"/>\n"
+    "    <reg name=\"a1\" bitsize=\"32\" type=\"uint32\" group=\"address\"/>\n"
+    "    <reg name=\"a2\" bitsize=\"32\" type=\"uint32\" group=\"address\"/>\n"
+    "    <reg name=\"a3\" bitsize=\"32\" type=\"uint32\" group=\"address\"/>\n"
+    "    <reg name=\"a4\" bitsize=\"32\" type=\"uint32\" group=\"address\"/>\n"
+    "    <reg name=\"a5\" bitsize=\"32\" type=\"uint32\" group=\"address\"/>\n"
+    "    <reg name=\"a6\" bitsize=\"32\" type=\"uint32\" group=\"address\"/>\n"
+    "    <reg name=\"a7\" bitsize=\"32\" type=\"uint32\" group=\"address\"/>\n"
+    "    <reg name=\"flags\" bitsize=\"32\" type=\"cpu32_flags\"/>\n"
+    "    <reg name=\"instructions\" bitsize=\"64\" type=\"uint64\" save-restore=\"no\"/>\n"
+    "  </feature>\n"
+    "</target>\n";
+
+/**
+ * @struct GdbConnection
+ * @brief One client: socket, input buffer and packet buffers.
+ */
+typedef struct {
+    Debugger *dbg;
+    int fd;
+    bool no_ack;                 /**< QStartNoAckMode accepted */
+    bool swbreak;                /**< GDB understands swbreak stop reasons */
+    uint8_t input[GDB_INPUT_BUFFER];
+    size_t input_pos;
+    size_t input_len;
+    char packet[GDB_STUB_PACKET_SIZE + 1];          /**< Payload of the last packet received */
+    size_t packet_len;
+    char reply[2 * GDB_STUB_PACKET_SIZE + 16];      /**< Payload being built (binary replies escape to 2x) */
+    char frame[2 * GDB_STUB_PACKET_SIZE + 32];      /**< "$payload#cs" */
+    uint32_t words[GDB_STUB_PACKET_SIZE / 4 + 2];   /**< Guest words of one memory transfer */
+    uint8_t bytes[GDB_STUB_PACKET_SIZE];            /**< Bytes of one memory transfer */
+} GdbConnection;
+
+static const char HEX[] = "0123456789abcdef";
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * @brief Parse hex digits at `*text` into `value`, advancing `*text`.
+ *
+ * @return false if there was no digit.
+ */
+static bool parse_hex(const char **text, uint64_t *value) {
+    const char *p = *text;
+    uint64_t result = 0;
+    while (hex_value(*p) >= 0)
+        result = (result << 4) | (uint64_t)hex_value(*p++);
+    if (p == *text)
+        return false;
+    *text = p;
+    *value = result;
+    return true;
+}
+
+/**
+ * @brief Append `size` bytes of `value` as little-endian hex.
+ */
+static size_t put_hex_le(char *out, uint64_t value, int size) {
+    for (int i = 0; i < size; i++) {
+        uint8_t byte = (uint8_t)(value >> (8 * i));
+        out[2 * i] = HEX[byte >> 4];
+        out[2 * i + 1] = HEX[byte & 0xF];
+    }
+    return (size_t)size * 2;
+}
+
+/**
+ * @brief Parse `size` bytes of little-endian hex.
+ */
+static bool get_hex_le(const char *text, int size, uint64_t *value) {
+    uint64_t result = 0;
+    for (int i = 0; i < size; i++) {
+        int high = hex_value(text[2 * i]);
+        int low = high >= 0 ? hex_value(text[2 * i + 1]) : -1;
+        if (low < 0)
+            return false;
+        result |= (uint64_t)(high << 4 | low) << (8 * i);
+    }
+    *value = result;
+    return true;
+}
+
+static bool write_all(int fd, const char *data, size_t size) {
+    while (size) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+        data += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+/**
+ * @brief Next byte from the client, blocking.
+ *
+ * @return The byte, or -1 once the connection is closed or fails.
+ */
+static int read_byte(GdbConnection *conn) {
+    if (conn->input_pos == conn->input_len) {
+        ssize_t got;
+        do
+            got = read(conn->fd, conn->input, sizeof(conn->input));
+        while (got < 0 && errno == EINTR);
+        if (got <= 0)
+            return -1;
+        conn->input_pos = 0;
+        conn->input_len = (size_t)got;
+    }
+    return conn->input[conn->input_pos++];
+}
+
+/**
+ * @brief Check, without blocking, whether GDB sent an interrupt (Ctrl-C, 0x03).
+ */
+static bool interrupt_pending(GdbConnection *conn) {
+    if (conn->input_pos == conn->input_len) {
+        struct pollfd pfd = { .fd = conn->fd, .events = POLLIN };
+        if (poll(&pfd, 1, 0) <= 0)
+            return false;
+        ssize_t got = read(conn->fd, conn->input, sizeof(conn->input));
+        if (got <= 0)
+            return false;
+        conn->input_pos = 0;
+        conn->input_len = (size_t)got;
+    }
+    if (conn->input[conn->input_pos] != 0x03)
+        return false;
+    conn->input_pos++;
+    return true;
+}
+
+/**
+ * @brief Frame and send `size` bytes of payload from conn->reply; wait for the ack.
+ */
+static bool send_packet(GdbConnection *conn, size_t size) {
+    uint8_t checksum = 0;
+    conn->frame[0] = '$';
+    memcpy(conn->frame + 1, conn->reply, size);
+    for (size_t i = 0; i < size; i++)
+        checksum += (uint8_t)conn->reply[i];
+    conn->frame[size + 1] = '#';
+    conn->frame[size + 2] = HEX[checksum >> 4];
+    conn->frame[size + 3] = HEX[checksum & 0xF];
+
+    for (;;) {
+        if (!write_all(conn->fd, conn->frame, size + 4))
+            return false;
+        if (conn->no_ack)
+            return true;
+        int ack;
+        do
+            ack = read_byte(conn);
+        while (ack >= 0 && ack != '+' && ack != '-');
+        if (ack != '-')
+            return ack == '+';
+    }
+}
+
+static bool send_text(GdbConnection *conn, const char *text) {
+    size_t size = strlen(text);
+    memcpy(conn->reply, text, size);
+    return send_packet(conn, size);
+}
+
+/**
+ * @brief Receive the next packet into conn->packet.
+ *
+ * Acks, stray interrupts and packets with a bad checksum (after a '-')
+ * are skipped.
+ *
+ * @return false once the connection is closed.
+ */
+static bool receive_packet(GdbConnection *conn) {
+    for (;;) {
+        int c;
+        do
+            c = read_byte(conn);
+        while (c >= 0 && c != '$');
+        if (c < 0)
+            return false;
+
+        size_t size = 0;
+        uint8_t checksum = 0;
+        bool overflow = false;
+        while ((c = read_byte(conn)) >= 0 && c != '#') {
+            checksum += (uint8_t)c;
+            if (size < GDB_STUB_PACKET_SIZE)
+                conn->packet[size++] = (char)c;
+            else
+                overflow = true;
+        }
+        int high = read_byte(conn);
+        int low = high >= 0 ? read_byte(conn) : -1;
+        if (low < 0)
+            return false;
+        bool valid = !overflow && hex_value((char)high) >= 0 && hex_value((char)low) >= 0
+                  && (uint8_t)(hex_value((char)high) << 4 | hex_value((char)low)) == checksum;
+        if (!conn->no_ack && !write_all(conn->fd, valid ? "+" : "-", 1))
+            return false;
+        if (valid || conn->no_ack) {
+            conn->packet[size] = '\0';
+            conn->packet_len = size;
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief Value and size in bytes of register `regno`.
+ */
+static bool read_register(const CPU *cpu, uint64_t regno, uint64_t *value, int *size) {
+    *size = 4;
+    if (regno == GDB_REG_PC)
+        *value = (uint64_t)cpu->pc * 4;
+    else if (regno >= GDB_REG_R0 && regno < GDB_REG_A0)
+        *value = cpu->registers[regno - GDB_REG_R0];
+    else if (regno >= GDB_REG_A0 && regno < GDB_REG_FLAGS)
+        *value = cpu->address_registers[regno - GDB_REG_A0];
+    else if (regno == GDB_REG_FLAGS)
+        *value = (uint64_t)cpu->zero_flag | (uint64_t)cpu->negative_flag << 1;
+    else if (regno == GDB_REG_INSTRUCTIONS) {
+        *value = cpu->instructions_retired;
+        *size = 8;
+    } else
+        return false;
+    return true;
+}
+
+static void write_register(CPU *cpu, uint64_t regno, uint64_t value) {
+    if (regno == GDB_REG_PC)
+        cpu->pc = (uint32_t)(value / 4);
+    else if (regno >= GDB_REG_R0 && regno < GDB_REG_A0)
+        cpu->registers[regno - GDB_REG_R0] = (uint32_t)value;
+    else if (regno >= GDB_REG_A0 && regno < GDB_REG_FLAGS)
+        cpu->address_registers[regno - GDB_REG_A0] = (uint32_t)value;
+    else if (regno == GDB_REG_FLAGS) {
+        cpu->zero_flag = value & 1;
+        cpu->negative_flag = (value >> 1) & 1;
+    } else if (regno == GDB_REG_INSTRUCTIONS)
+        cpu->instructions_retired = value;
+}
+
+/**
+ * @brief Copy GDB bytes [address, address + length) out of guest memory with one debugger_read().
+ */
+static bool read_memory(GdbConnection *conn, uint64_t address, uint32_t length) {
+    if (length == 0)
+        return true;
+    uint64_t first = address / 4;
+    uint64_t last = (address + length - 1) / 4;
+    if (last >= RAM_SIZE || !debugger_read(conn->dbg, (uint32_t)first, (uint32_t)(last - first + 1), conn->words))
+        return false;
+    for (uint32_t i = 0; i < length; i++) {
+        uint64_t byte = address + i;
+        conn->bytes[i] = (uint8_t)(conn->words[byte / 4 - first] >> (8 * (byte % 4)));
+    }
+    return true;
+}
+
+/**
+ * @brief Write conn->bytes to GDB bytes [address, address + length) with one read-modify-write.
+ */
+static bool write_memory(GdbConnection *conn, uint64_t address, uint32_t length) {
+    if (length == 0)
+        return true;
+    uint64_t first = address / 4;
+    uint64_t last = (address + length - 1) / 4;
+    uint32_t count = (uint32_t)(last - first + 1);
+    if (last >= RAM_SIZE || !debugger_read(conn->dbg, (uint32_t)first, count, conn->words))
+        return false;
+    for (uint32_t i = 0; i < length; i++) {
+        uint64_t byte = address + i;
+        uint32_t shift = 8 * (uint32_t)(byte % 4);
+        uint32_t *word = &conn->words[byte / 4 - first];
+        *word = (*word & ~(0xFFu << shift)) | (uint32_t)conn->bytes[i] << shift;
+    }
+    return debugger_write(conn->dbg, (uint32_t)first, count, conn->words);
+}
+
+/**
+ * @brief Parse "ADDR,LENGTH" and check that LENGTH fits one transfer.
+ */
+static bool parse_range(const char **text, uint64_t *address, uint64_t *length, uint64_t max_length) {
+    return parse_hex(text, address) && *(*text)++ == ',' && parse_hex(text, length) && *length <= max_length;
+}
+
+/**
+ * @brief Build the stop reply for how a resume ended.
+ */
+static void stop_reply(GdbConnection *conn, CpuStopReason reason, bool interrupted, char *out, size_t size) {
+    if (interrupted) {
+        snprintf(out, size, "S02");
+        return;
+    }
+    switch (reason) {
+        case CPU_STOP_HALT:
+        case CPU_STOP_END:
+            snprintf(out, size, "W00");
+            break;
+        case CPU_STOP_WATCHPOINT:
+            snprintf(out, size, "T05watch:%llx;", (unsigned long long)debugger_watch_hit(conn->dbg)->address * 4);
+            break;
+        case CPU_STOP_BREAKPOINT:
+            snprintf(out, size, conn->swbreak ? "T05swbreak:;" : "S05");
+            break;
+        case CPU_STOP_INVALID_INSTRUCTION:
+            snprintf(out, size, "S04");     /* SIGILL */
+            break;
+        case CPU_STOP_DIV_ZERO:
+            snprintf(out, size, "S08");     /* SIGFPE */
+            break;
+        case CPU_STOP_FAULT:
+            snprintf(out, size, "S0b");     /* SIGSEGV */
+            break;
+        case CPU_STOP_ERROR:
+            snprintf(out, size, "S06");     /* SIGABRT */
+            break;
+        default:
+            snprintf(out, size, "S05");     /* SIGTRAP: step done */
+            break;
+    }
+}
+
+/**
+ * @brief Resume for `c`/`s`/`vCont` and send the stop reply.
+ *
+ * A continue runs in slices of GDB_STUB_SLICE instructions so a Ctrl-C
+ * from GDB is noticed between them.
+ */
+static bool resume(GdbConnection *conn, bool step) {
+    CpuStopReason reason;
+    bool interrupted = false;
+    if (step) {
+        reason = debugger_step(conn->dbg);
+    } else {
+        while ((reason = debugger_continue(conn->dbg, GDB_STUB_SLICE)) == CPU_STOP_LIMIT)
+            if (interrupt_pending(conn)) {
+                interrupted = true;
+                break;
+            }
+    }
+    char text[64];
+    stop_reply(conn, reason, interrupted, text, sizeof(text));
+    return send_text(conn, text);
+}
+
+/**
+ * @brief Answer qXfer:features:read:target.xml:OFFSET,LENGTH.
+ */
+static size_t reply_target_xml(GdbConnection *conn, const char *args) {
+    uint64_t offset, length;
+    if (!parse_range(&args, &offset, &length, GDB_STUB_PACKET_SIZE - 1))
+        return (size_t)snprintf(conn->reply, sizeof(conn->reply), "E01");
+    size_t total = sizeof(TARGET_XML) - 1;
+    if (offset >= total)
+        return (size_t)snprintf(conn->reply, sizeof(conn->reply), "l");
+    size_t chunk = total - offset < length ? total - offset : length;
+    conn->reply[0] = offset + chunk < total ? 'm' : 'l';
+    memcpy(conn->reply + 1, TARGET_XML + offset, chunk);
+    return chunk + 1;
+}
+
+/**
+ * @brief Handle a Z/z packet: software breakpoints (0) and write watchpoints (2).
+ */
+static const char *handle_point(GdbConnection *conn, bool insert) {
+    const char *args = conn->packet + 1;
+    uint64_t type, address, length;
+    if (!parse_hex(&args, &type) || *args++ != ',' || !parse_hex(&args, &address) || *args++ != ','
+        || !parse_hex(&args, &length) || address / 4 >= RAM_SIZE)
+        return "E01";
+    uint32_t word = (uint32_t)(address / 4);
+    if (type == 0 || type == 1) {
+        if (insert)
+            return debugger_set_breakpoint(conn->dbg, word) ? "OK" : "E02";
+        return debugger_clear_breakpoint(conn->dbg, word) ? "OK" : "E02";
+    }
+    if (type == 2) {
+        uint64_t words = (address + (length ? length : 1) + 3) / 4 - word;
+        if (insert)
+            return debugger_set_watchpoint(conn->dbg, word, (uint32_t)words) ? "OK" : "E02";
+        return debugger_clear_watchpoint(conn->dbg, word) ? "OK" : "E02";
+    }
+    return "";
+}
+
+/**
+ * @brief Execute one packet.
+ *
+ * @return false when the session ends (detach, kill or a dead connection).
+ */
+static bool handle_packet(GdbConnection *conn) {
+    CPU *cpu = debugger_cpu(conn->dbg);
+    const char *packet = conn->packet;
+    const char *args = packet + 1;
+    char *reply = conn->reply;
+    size_t size = 0;
+    uint64_t address, length, value;
+
+    switch (packet[0]) {
+        case '?':
+            return send_text(conn, cpu->running ? "S05" : "W00");
+        case 'g':
+            for (uint64_t regno = 0; regno < GDB_REG_COUNT; regno++) {
+                int bytes;
+                read_register(cpu, regno, &value, &bytes);
+                size += put_hex_le(reply + size, value, bytes);
+            }
+            return send_packet(conn, size);
+        case 'G':
+            for (uint64_t regno = 0; regno < GDB_REG_COUNT; regno++) {
+                int bytes;
+                read_register(cpu, regno, &value, &bytes);
+                if (strlen(args) < (size_t)bytes * 2 || !get_hex_le(args, bytes, &value))
+                    return send_text(conn, "E01");
+                write_register(cpu, regno, value);
+                args += bytes * 2;
+            }
+            return send_text(conn, "OK");
+        case 'p': {
+            int bytes;
+            if (!parse_hex(&args, &address) || !read_register(cpu, address, &value, &bytes))
+                return send_text(conn, "E01");
+            return send_packet(conn, put_hex_le(reply, value, bytes));
+        }
+        case 'P': {
+            int bytes;
+            if (!parse_hex(&args, &address) || *args++ != '=' || !read_register(cpu, address, &value, &bytes)
+                || !get_hex_le(args, bytes, &value))
+                return send_text(conn, "E01");
+            write_register(cpu, address, value);
+            return send_text(conn, "OK");
+        }
+        case 'm':
+            if (!parse_range(&args, &address, &length, GDB_STUB_PACKET_SIZE / 2)
+                || !read_memory(conn, address, (uint32_t)length))
+                return send_text(conn, "E01");
+            for (uint32_t i = 0; i < length; i++)
+                size += put_hex_le(reply + size, conn->bytes[i], 1);
+            return send_packet(conn, size);
+        case 'x':
+            if (!parse_range(&args, &address, &length, GDB_STUB_PACKET_SIZE)
+                || !read_memory(conn, address, (uint32_t)length))
+                return send_text(conn, "E01");
+            reply[size++] = 'b';
+            for (uint32_t i = 0; i < length; i++) {
+                uint8_t byte = conn->bytes[i];
+                if (byte == '#' || byte == '$' || byte == '}' || byte == '*') {
+                    reply[size++] = '}';
+                    byte ^= 0x20;
+                }
+                reply[size++] = (char)byte;
+            }
+            return send_packet(conn, size);
+        case 'M':
+            if (!parse_range(&args, &address, &length, GDB_STUB_PACKET_SIZE / 2) || *args++ != ':'
+                || strlen(args) < length * 2)
+                return send_text(conn, "E01");
+            for (uint32_t i = 0; i < length; i++) {
+                if (!get_hex_le(args + 2 * i, 1, &value))
+                    return send_text(conn, "E01");
+                conn->bytes[i] = (uint8_t)value;
+            }
+            return send_text(conn, write_memory(conn, address, (uint32_t)length) ? "OK" : "E01");
+        case 'X': {
+            if (!parse_range(&args, &address, &length, GDB_STUB_PACKET_SIZE) || *args++ != ':')
+                return send_text(conn, "E01");
+            const char *end = conn->packet + conn->packet_len;
+            uint32_t count = 0;
+            while (args < end && count < length) {
+                uint8_t byte = (uint8_t)*args++;
+                if (byte == '}' && args < end)
+                    byte = (uint8_t)*args++ ^ 0x20;
+                conn->bytes[count++] = byte;
+            }
+            if (count != length)
+                return send_text(conn, "E01");
+            return send_text(conn, write_memory(conn, address, count) ? "OK" : "E01");
+        }
+        case 'c':
+        case 's':
+            if (parse_hex(&args, &address))
+                cpu->pc = (uint32_t)(address / 4);
+            return resume(conn, packet[0] == 's');
+        case 'Z':
+        case 'z':
+            return send_text(conn, handle_point(conn, packet[0] == 'Z'));
+        case 'H':
+        case 'T':
+            return send_text(conn, "OK");
+        case 'D':
+            send_text(conn, "OK");
+            return false;
+        case 'k':
+            return false;
+        case 'v':
+            if (strcmp(packet, "vCont?") == 0)
+                return send_text(conn, "vCont;c;C;s;S");
+            if (strncmp(packet, "vCont;", 6) == 0)
+                return resume(conn, packet[6] == 's' || packet[6] == 'S');
+            return send_text(conn, "");
+        case 'q':
+            if (strncmp(packet, "qSupported", 10) == 0) {
+                conn->swbreak = strstr(packet, "swbreak+") != NULL;
+                snprintf(reply, sizeof(conn->reply),
+                         "PacketSize=%x;qXfer:features:read+;QStartNoAckMode+;swbreak+;binary-upload+;"
+                         "vContSupported+",
+                         GDB_STUB_PACKET_SIZE);
+                return send_text(conn, reply);
+            }
+            if (strncmp(packet, "qXfer:features:read:target.xml:", 31) == 0)
+                return send_packet(conn, reply_target_xml(conn, packet + 31));
+            if (strcmp(packet, "qAttached") == 0)
+                return send_text(conn, "1");
+            if (strcmp(packet, "qC") == 0)
+                return send_text(conn, "QC1");
+            if (strcmp(packet, "qfThreadInfo") == 0)
+                return send_text(conn, "m1");
+            if (strcmp(packet, "qsThreadInfo") == 0)
+                return send_text(conn, "l");
+            return send_text(conn, "");
+        case 'Q':
+            if (strcmp(packet, "QStartNoAckMode") == 0) {
+                bool sent = send_text(conn, "OK");
+                conn->no_ack = true;
+                return sent;
+            }
+            return send_text(conn, "");
+        default:
+            return send_text(conn, "");
+    }
+}
+
+/**
+ * @brief Create the listening socket for "HOST:PORT", ":PORT" or a Unix socket path.
+ */
+static int open_listener(const char *address) {
+    int fd;
+    if (strchr(address, '/')) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (strlen(address) >= sizeof(addr.sun_path)) {
+            log_write(LOG_ERROR, "Socket path too long: %s", address);
+            return -1;
+        }
+        strcpy(addr.sun_path, address);
+        struct stat st;
+        if (stat(address, &st) == 0 && S_ISSOCK(st.st_mode))
+            unlink(address);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 1) != 0)) {
+            close(fd);
+            fd = -1;
+        }
+    } else {
+        const char *colon = strrchr(address, ':');
+        char host[64] = "127.0.0.1";
+        if (colon && colon != address && strncmp(address, "localhost:", 10) != 0) {
+            if ((size_t)(colon - address) >= sizeof(host)) {
+                log_write(LOG_ERROR, "Invalid GDB address: %s", address);
+                return -1;
+            }
+            memcpy(host, address, (size_t)(colon - address));
+            host[colon - address] = '\0';
+        }
+        char *end = NULL;
+        unsigned long port = strtoul(colon ? colon + 1 : address, &end, 10);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)port);
+        if (*end != '\0' || port == 0 || port > 65535 || inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+            log_write(LOG_ERROR, "Invalid GDB address: %s", address);
+            return -1;
+        }
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int one = 1;
+        if (fd >= 0)
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (fd >= 0 && (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 1) != 0)) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    if (fd < 0)
+        log_write(LOG_ERROR, "Unable to listen on %s: %s", address, strerror(errno));
+    return fd;
+}
+
+bool gdb_stub_serve(Debugger *dbg, const char *address) {
+    int listen_fd = open_listener(address);
+    if (listen_fd < 0)
+        return false;
+    GdbConnection *conn = calloc(1, sizeof(GdbConnection));
+    int fd = conn ? accept(listen_fd, NULL, NULL) : -1;
+    close(listen_fd);
+    if (strchr(address, '/'))
+        unlink(address);
+    if (fd < 0) {
+        log_write(LOG_ERROR, conn ? "accept failed: %s" : "Out of memory", strerror(errno));
+        free(conn);
+        return false;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    conn->dbg = dbg;
+    conn->fd = fd;
+    while (receive_packet(conn) && handle_packet(conn)) {
+    }
+    close(fd);
+    free(conn);
+    return true;
+}
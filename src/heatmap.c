@@ -0,0 +1,378 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "heatmap.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "log.h"
+
+/** Most cells in one line of a printed map; larger maps are folded. */
+#define HEATMAP_ROW_CELLS 64
+
+/** Most cells in a printed map (four rows). */
+#define HEATMAP_MAP_CELLS 256
+
+static const char *const kind_names[HEATMAP_KIND_COUNT] = { "read", "write", "fetch" };
+
+static bool is_power_of_two(uint32_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+static uint32_t log2_u32(uint32_t value) {
+    uint32_t shift = 0;
+    while ((1u << shift) < value)
+        shift++;
+    return shift;
+}
+
+void heatmap_config_default(HeatmapConfig *config) {
+    config->bucket_words = 1u << RAM_PAGE_SHIFT;
+    config->sample_period = 1;
+    config->window = HEATMAP_DEFAULT_WINDOW;
+}
+
+/**
+ * @brief Check that the configuration is usable; log the first problem found.
+ */
+static bool heatmap_config_valid(const HeatmapConfig *config) {
+    if (!is_power_of_two(config->bucket_words) || config->bucket_words > RAM_SIZE) {
+        log_write(LOG_ERROR, "Heatmap buckets must be a power of two of at most %u words", RAM_SIZE);
+        return false;
+    }
+    if (config->sample_period == 0 || config->sample_period > (1u << 30) || config->window == 0) {
+        log_write(LOG_ERROR, "Heatmap sample period (at most 2^30) and window must be positive");
+        return false;
+    }
+    return true;
+}
+
+bool heatmap_config_parse(const char *spec, HeatmapConfig *config) {
+    heatmap_config_default(config);
+    if (strcasecmp(spec, "default") == 0)
+        return true;
+
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", spec);
+    char *save = NULL;
+    for (char *item = strtok_r(buffer, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        char *value = strchr(item, '=');
+        if (!value) {
+            log_write(LOG_ERROR, "Heatmap option '%s' must be KEY=VALUE", item);
+            return false;
+        }
+        *value++ = '\0';
+        char *end = NULL;
+        unsigned long long parsed = strtoull(value, &end, 0);
+        bool ok = end != value && *end == '\0';
+        if (strcasecmp(item, "bucket") == 0) {
+            ok = ok && parsed <= UINT32_MAX;
+            config->bucket_words = (uint32_t)parsed;
+        } else if (strcasecmp(item, "sample") == 0) {
+            ok = ok && parsed <= UINT32_MAX;
+            config->sample_period = (uint32_t)parsed;
+        } else if (strcasecmp(item, "window") == 0) {
+            config->window = parsed;
+        } else {
+            log_write(LOG_ERROR, "Unknown heatmap option '%s' (bucket, sample, window)", item);
+            return false;
+        }
+        if (!ok) {
+            log_write(LOG_ERROR, "Invalid value '%s' for heatmap option '%s'", value, item);
+            return false;
+        }
+    }
+    return heatmap_config_valid(config);
+}
+
+/**
+ * @brief Draw the number of accesses until the next sample: uniform in
+ *        [1, 2 * period - 1], so the mean gap is the period.
+ */
+static uint32_t next_gap(MemoryHeatmap *map) {
+    uint32_t period = map->config.sample_period;
+    if (period == 1)
+        return 1;
+    map->random ^= map->random << 13;
+    map->random ^= map->random >> 7;
+    map->random ^= map->random << 17;
+    return 1 + (uint32_t)(map->random % (2ull * period - 1));
+}
+
+bool heatmap_init(MemoryHeatmap *map, const HeatmapConfig *config) {
+    memset(map, 0, sizeof(*map));
+    if (!heatmap_config_valid(config))
+        return false;
+
+    map->config = *config;
+    map->bucket_shift = log2_u32(config->bucket_words);
+    map->buckets = RAM_SIZE >> map->bucket_shift;
+    size_t words = (map->buckets + 63) / 64;
+    for (int kind = 0; kind < HEATMAP_KIND_COUNT; kind++)
+        map->counts[kind] = calloc(map->buckets, sizeof(uint64_t));
+    map->first_instruction = malloc(map->buckets * sizeof(uint64_t));
+    map->first_pc = calloc(map->buckets, sizeof(uint32_t));
+    map->first_address = calloc(map->buckets, sizeof(uint32_t));
+    map->first_kind = calloc(map->buckets, 1);
+    map->touched = calloc(words, sizeof(uint64_t));
+    map->window_touched = calloc(words, sizeof(uint64_t));
+    if (!map->counts[HEATMAP_READ] || !map->counts[HEATMAP_WRITE] || !map->counts[HEATMAP_FETCH]
+        || !map->first_instruction || !map->first_pc || !map->first_address || !map->first_kind || !map->touched
+        || !map->window_touched) {
+        log_write(LOG_ERROR, "Heatmap allocation failed");
+        heatmap_free(map);
+        return false;
+    }
+    for (uint32_t i = 0; i < map->buckets; i++)
+        map->first_instruction[i] = HEATMAP_UNTOUCHED;
+    map->random = 0x9E3779B97F4A7C15ull;
+    map->countdown = next_gap(map);
+    map->window_end = config->window;
+    return true;
+}
+
+void heatmap_free(MemoryHeatmap *map) {
+    for (int kind = 0; kind < HEATMAP_KIND_COUNT; kind++)
+        free(map->counts[kind]);
+    free(map->first_instruction);
+    free(map->first_pc);
+    free(map->first_address);
+    free(map->first_kind);
+    free(map->touched);
+    free(map->window_touched);
+    free(map->windows);
+    memset(map, 0, sizeof(*map));
+}
+
+void heatmap_first_touch(MemoryHeatmap *map, uint32_t address, uint32_t pc, uint64_t instruction,
+                         HeatmapKind kind) {
+    uint32_t bucket = address >> map->bucket_shift;
+    map->touched[bucket >> 6] |= 1ull << (bucket & 63);
+    map->touched_count++;
+    map->first_instruction[bucket] = instruction;
+    map->first_pc[bucket] = pc;
+    map->first_address[bucket] = address;
+    map->first_kind[bucket] = (uint8_t)kind;
+}
+
+void heatmap_sample(MemoryHeatmap *map, uint32_t bucket, HeatmapKind kind) {
+    map->counts[kind][bucket] += map->config.sample_period;
+    map->countdown = next_gap(map);
+}
+
+/**
+ * @brief Append the current window, ending at `end`, to the series and start an empty one.
+ *
+ * A failed allocation drops the window from the series (with a warning
+ * the first time) but keeps profiling.
+ */
+static void record_window(MemoryHeatmap *map, uint64_t end) {
+    size_t words = (map->buckets + 63) / 64;
+    uint32_t buckets = 0;
+    for (size_t i = 0; i < words; i++)
+        buckets += (uint32_t)__builtin_popcountll(map->window_touched[i]);
+    memset(map->window_touched, 0, words * sizeof(uint64_t));
+
+    if (map->window_count == map->window_capacity) {
+        size_t capacity = map->window_capacity ? map->window_capacity * 2 : 64;
+        HeatmapWindow *windows = realloc(map->windows, capacity * sizeof(HeatmapWindow));
+        if (!windows) {
+            if (!map->windows_truncated)
+                log_write(LOG_WARN, "Heatmap working-set series truncated (out of memory)");
+            map->windows_truncated = true;
+            return;
+        }
+        map->windows = windows;
+        map->window_capacity = capacity;
+    }
+    map->windows[map->window_count++] = (HeatmapWindow){
+        .end = end,
+        .buckets = buckets,
+        .cumulative = map->touched_count,
+    };
+}
+
+/**
+ * @brief Windows are aligned to multiples of `window` instructions; a run
+ *        continued from a later instruction skips the empty ones between.
+ */
+void heatmap_close_windows(MemoryHeatmap *map, uint64_t instruction) {
+    record_window(map, map->window_end);
+    map->window_end = (instruction / map->config.window + 1) * map->config.window;
+}
+
+void heatmap_finish(MemoryHeatmap *map, uint64_t instruction) {
+    if (instruction > map->window_end - map->config.window || map->window_count == 0)
+        record_window(map, instruction);
+    map->window_end = (instruction / map->config.window + 1) * map->config.window;
+}
+
+static uint64_t bucket_total(const MemoryHeatmap *map, uint32_t bucket) {
+    return map->counts[HEATMAP_READ][bucket] + map->counts[HEATMAP_WRITE][bucket]
+         + map->counts[HEATMAP_FETCH][bucket];
+}
+
+/** Heatmap the comparators below sort for (qsort has no context argument). */
+static const MemoryHeatmap *sort_map;
+
+static int compare_hottest(const void *a, const void *b) {
+    uint32_t a_bucket = *(const uint32_t *)a;
+    uint32_t b_bucket = *(const uint32_t *)b;
+    uint64_t left = bucket_total(sort_map, a_bucket);
+    uint64_t right = bucket_total(sort_map, b_bucket);
+    if (left != right)
+        return left < right ? 1 : -1;
+    return a_bucket < b_bucket ? -1 : a_bucket > b_bucket;
+}
+
+static int compare_first_touch(const void *a, const void *b) {
+    uint64_t left = sort_map->first_instruction[*(const uint32_t *)a];
+    uint64_t right = sort_map->first_instruction[*(const uint32_t *)b];
+    return left < right ? -1 : left > right ? 1 : 0;
+}
+
+/**
+ * @brief Print one map of `kind` with at most HEATMAP_MAP_CELLS cells.
+ *
+ * Each cell sums the buckets it folds; its character is the log2 of the
+ * count on a scale up to the hottest cell ('.' = never).
+ */
+static void print_map(const MemoryHeatmap *map, HeatmapKind kind, FILE *out) {
+    static const char levels[] = ":-=+*#%@";
+    uint32_t cells = map->buckets < HEATMAP_MAP_CELLS ? map->buckets : HEATMAP_MAP_CELLS;
+    uint32_t fold = map->buckets / cells;
+    uint64_t sums[HEATMAP_MAP_CELLS] = { 0 };
+    uint64_t hottest = 0;
+    for (uint32_t cell = 0; cell < cells; cell++) {
+        for (uint32_t i = 0; i < fold; i++)
+            sums[cell] += map->counts[kind][cell * fold + i];
+        if (sums[cell] > hottest)
+            hottest = sums[cell];
+    }
+
+    if (!hottest) {
+        fprintf(out, "  %s map: no accesses\n", kind_names[kind]);
+        return;
+    }
+    uint32_t top_level = 64 - (uint32_t)__builtin_clzll(hottest);
+    uint32_t cell_words = fold << map->bucket_shift;
+    fprintf(out, "  %s map (%u words per cell, '@' = %llu):\n", kind_names[kind], cell_words,
+            (unsigned long long)hottest);
+    for (uint32_t row = 0; row < cells; row += HEATMAP_ROW_CELLS) {
+        char line[HEATMAP_ROW_CELLS + 1];
+        uint32_t width = cells - row < HEATMAP_ROW_CELLS ? cells - row : HEATMAP_ROW_CELLS;
+        for (uint32_t i = 0; i < width; i++) {
+            uint64_t sum = sums[row + i];
+            uint32_t level = sum ? 64 - (uint32_t)__builtin_clzll(sum) : 0;
+            line[i] = sum ? levels[top_level > 1 ? (level - 1) * (sizeof(levels) - 2) / (top_level - 1) : 0] : '.';
+        }
+        line[width] = '\0';
+        fprintf(out, "    %04X %s\n", row * cell_words, line);
+    }
+}
+
+void heatmap_print(const MemoryHeatmap *map, uint32_t top, FILE *out) {
+    uint64_t totals[HEATMAP_KIND_COUNT] = { 0 };
+    for (uint32_t i = 0; i < map->buckets; i++)
+        for (int kind = 0; kind < HEATMAP_KIND_COUNT; kind++)
+            totals[kind] += map->counts[kind][i];
+
+    uint32_t words = map->config.bucket_words;
+    fprintf(out, "%s%llu reads, %llu writes, %llu fetches; %u of %u buckets of %u words touched (%u words, %u KiB)\n",
+            map->config.sample_period > 1 ? "~" : "", (unsigned long long)totals[HEATMAP_READ],
+            (unsigned long long)totals[HEATMAP_WRITE], (unsigned long long)totals[HEATMAP_FETCH], map->touched_count,
+            map->buckets, words, map->touched_count * words, map->touched_count * words * 4 / 1024);
+    if (map->config.sample_period > 1)
+        fprintf(out, "  counts estimated from about 1 in %u accesses; touched buckets are exact\n",
+                map->config.sample_period);
+
+    uint32_t peak = 0;
+    size_t peak_window = 0;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < map->window_count; i++) {
+        sum += map->windows[i].buckets;
+        if (map->windows[i].buckets > peak) {
+            peak = map->windows[i].buckets;
+            peak_window = i;
+        }
+    }
+    if (map->window_count) {
+        fprintf(out, "  working set per %llu instructions: peak %u buckets (%u words) ending at %llu, mean %.1f"
+                " over %zu windows\n", (unsigned long long)map->config.window, peak, peak * words,
+                (unsigned long long)map->windows[peak_window].end, (double)sum / (double)map->window_count,
+                map->window_count);
+    }
+
+    uint32_t *order = malloc(map->touched_count ? map->touched_count * sizeof(uint32_t) : 1);
+    if (!order) {
+        log_write(LOG_ERROR, "Heatmap report allocation failed");
+        return;
+    }
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < map->buckets && count < map->touched_count; i++)
+        if (map->first_instruction[i] != HEATMAP_UNTOUCHED)
+            order[count++] = i;
+    uint32_t shown = count < top ? count : top;
+
+    sort_map = map;
+    qsort(order, count, sizeof(uint32_t), compare_hottest);
+    fprintf(out, "  %-13s %12s %12s %12s\n", "hottest", "reads", "writes", "fetches");
+    for (uint32_t i = 0; i < shown; i++) {
+        uint32_t bucket = order[i];
+        fprintf(out, "  %04X-%04X     %12llu %12llu %12llu\n", bucket * words, bucket * words + words - 1,
+                (unsigned long long)map->counts[HEATMAP_READ][bucket],
+                (unsigned long long)map->counts[HEATMAP_WRITE][bucket],
+                (unsigned long long)map->counts[HEATMAP_FETCH][bucket]);
+    }
+
+    qsort(order, count, sizeof(uint32_t), compare_first_touch);
+    fprintf(out, "  %-13s %12s %8s %8s %s\n", "first touch", "instruction", "pc", "address", "kind");
+    for (uint32_t i = 0; i < shown; i++) {
+        uint32_t bucket = order[i];
+        fprintf(out, "  %04X-%04X     %12llu %08X %08X %s\n", bucket * words, bucket * words + words - 1,
+                (unsigned long long)map->first_instruction[bucket], map->first_pc[bucket],
+                map->first_address[bucket], kind_names[map->first_kind[bucket]]);
+    }
+    free(order);
+
+    for (int kind = 0; kind < HEATMAP_KIND_COUNT; kind++)
+        print_map(map, (HeatmapKind)kind, out);
+}
+
+bool heatmap_write_json(const MemoryHeatmap *map, const char *path) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        log_write(LOG_ERROR, "Unable to open heatmap file: %s", path);
+        return false;
+    }
+
+    fprintf(out, "{\n  \"bucket_words\": %u,\n  \"sample_period\": %u,\n  \"window\": %llu,\n  \"buckets\": [",
+            map->config.bucket_words, map->config.sample_period, (unsigned long long)map->config.window);
+    bool first = true;
+    for (uint32_t i = 0; i < map->buckets; i++) {
+        if (map->first_instruction[i] == HEATMAP_UNTOUCHED)
+            continue;
+        fprintf(out, "%s\n    {\"start\": %u, \"reads\": %llu, \"writes\": %llu, \"fetches\": %llu, "
+                "\"first_instruction\": %llu, \"first_pc\": %u, \"first_address\": %u, \"first_kind\": \"%s\"}",
+                first ? "" : ",", i * map->config.bucket_words, (unsigned long long)map->counts[HEATMAP_READ][i],
+                (unsigned long long)map->counts[HEATMAP_WRITE][i], (unsigned long long)map->counts[HEATMAP_FETCH][i],
+                (unsigned long long)map->first_instruction[i], map->first_pc[i], map->first_address[i],
+                kind_names[map->first_kind[i]]);
+        first = false;
+    }
+    fprintf(out, "\n  ],\n  \"working_set\": [");
+    for (size_t i = 0; i < map->window_count; i++)
+        fprintf(out, "%s\n    {\"end\": %llu, \"buckets\": %u, \"cumulative\": %u}", i ? "," : "",
+                (unsigned long long)map->windows[i].end, map->windows[i].buckets, map->windows[i].cumulative);
+    fprintf(out, "\n  ]\n}\n");
+
+    bool ok = !ferror(out);
+    if (fclose(out) != 0)
+        ok = false;
+    if (!ok)
+        log_write(LOG_ERROR, "Failed to write heatmap file: %s", path);
+    return ok;
+}
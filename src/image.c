@@ -0,0 +1,149 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "../include/image.h"
+
+#include <stdio.h>
+
+#include "log.h"
+
+#define IMAGE_HEADER_WORDS 5
+
+/**
+ * @brief Write one 32-bit value in little-endian byte order.
+ */
+static bool write_u32(FILE *file, uint32_t value) {
+    unsigned char bytes[4] = {
+        (unsigned char)(value & 0xFF),
+        (unsigned char)((value >> 8) & 0xFF),
+        (unsigned char)((value >> 16) & 0xFF),
+        (unsigned char)((value >> 24) & 0xFF)
+    };
+    return fwrite(bytes, 1, sizeof(bytes), file) == sizeof(bytes);
+}
+
+/**
+ * @brief Read one little-endian 32-bit value.
+ */
+static bool read_u32(FILE *file, uint32_t *value) {
+    unsigned char bytes[4];
+    if (fread(bytes, 1, sizeof(bytes), file) != sizeof(bytes))
+        return false;
+    *value = (uint32_t)bytes[0]
+           | ((uint32_t)bytes[1] << 8)
+           | ((uint32_t)bytes[2] << 16)
+           | ((uint32_t)bytes[3] << 24);
+    return true;
+}
+
+/**
+ * @brief Produce an AssemblyRange that signals a load error and close a file.
+ */
+static AssemblyRange image_error(FILE *file) {
+    if (file) {
+        fclose(file);
+    }
+    AssemblyRange range = { .start_address = 0, .end_address = 0, .error = true, .encoding = ENCODING_WIDE };
+    return range;
+}
+
+/**
+ * @brief Write the words of an assembled range to an image file.
+ */
+bool image_write(const char *path, const uint32_t *words, AssemblyRange range) {
+    if (!path || !words || range.error || range.end_address < range.start_address) {
+        log_write(LOG_ERROR, "Image write failed: invalid arguments");
+        return false;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        log_write(LOG_ERROR, "Unable to create image file: %s", path);
+        return false;
+    }
+
+    uint32_t flags = range.encoding == ENCODING_PACKED ? IMAGE_FLAG_PACKED : 0;
+    bool ok = write_u32(file, IMAGE_MAGIC)
+           && write_u32(file, IMAGE_VERSION)
+           && write_u32(file, flags)
+           && write_u32(file, range.start_address)
+           && write_u32(file, range.end_address);
+
+    for (uint32_t addr = range.start_address; ok && addr < range.end_address; addr++) {
+        ok = write_u32(file, words[addr]);
+    }
+
+    if (fclose(file) != 0)
+        ok = false;
+    if (!ok)
+        log_write(LOG_ERROR, "I/O error while writing image file: %s", path);
+    return ok;
+}
+
+/**
+ * @brief Read an image file into a word buffer at its absolute addresses.
+ */
+AssemblyRange image_read(const char *path, uint32_t *buffer, uint32_t capacity) {
+    if (!path || !buffer) {
+        log_write(LOG_ERROR, "Image read failed: NULL argument(s) provided");
+        return image_error(NULL);
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        log_write(LOG_ERROR, "Unable to open image file: %s", path);
+        return image_error(NULL);
+    }
+
+    uint32_t header[IMAGE_HEADER_WORDS];
+    for (size_t i = 0; i < IMAGE_HEADER_WORDS; i++) {
+        if (!read_u32(file, &header[i])) {
+            log_write(LOG_ERROR, "Image file truncated (header): %s", path);
+            return image_error(file);
+        }
+    }
+
+    if (header[0] != IMAGE_MAGIC || header[1] != IMAGE_VERSION) {
+        log_write(LOG_ERROR, "Not a version %u program image: %s", IMAGE_VERSION, path);
+        return image_error(file);
+    }
+    if (header[2] & ~IMAGE_FLAG_PACKED) {
+        log_write(LOG_ERROR, "Image uses unknown flags 0x%08X: %s", header[2], path);
+        return image_error(file);
+    }
+
+    AssemblyRange range = {
+        .start_address = header[3],
+        .end_address = header[4],
+        .error = false,
+        .encoding = (header[2] & IMAGE_FLAG_PACKED) ? ENCODING_PACKED : ENCODING_WIDE
+    };
+
+    if (range.end_address < range.start_address || range.end_address > capacity) {
+        log_write(LOG_ERROR, "Image range 0x%08X-0x%08X does not fit in memory: %s",
+                  range.start_address, range.end_address, path);
+        return image_error(file);
+    }
+
+    for (uint32_t addr = range.start_address; addr < range.end_address; addr++) {
+        if (!read_u32(file, &buffer[addr])) {
+            log_write(LOG_ERROR, "Image file truncated at word 0x%08X: %s", addr, path);
+            return image_error(file);
+        }
+    }
+
+    fclose(file);
+    return range;
+}
+
+/**
+ * @brief Load an image file into RAM.
+ */
+AssemblyRange image_load(RAM *ram, const char *path) {
+    if (!ram) {
+        log_write(LOG_ERROR, "Image load failed: RAM pointer is NULL");
+        return image_error(NULL);
+    }
+    return image_read(path, ram->cells, RAM_SIZE);
+}
@@ -0,0 +1,269 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "job_protocol.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/** Size of the fixed request header (type .. output_count). */
+#define REQUEST_HEADER_BYTES 28u
+/** Size of the fixed result header (type .. registers, plus output_count). */
+#define RESULT_HEADER_BYTES (28u + 4u * MAX_REGISTERS + 4u)
+
+void job_buffer_free(JobBuffer *buffer) {
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->length = buffer->capacity = 0;
+}
+
+bool job_buffer_append(JobBuffer *buffer, const void *bytes, size_t length) {
+    if (buffer->length + length > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity : 256;
+        while (capacity < buffer->length + length)
+            capacity *= 2;
+        uint8_t *grown = realloc(buffer->data, capacity);
+        if (!grown)
+            return false;
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+    if (length)
+        memcpy(buffer->data + buffer->length, bytes, length);
+    buffer->length += length;
+    return true;
+}
+
+void job_buffer_consume(JobBuffer *buffer, size_t count) {
+    if (count >= buffer->length) {
+        buffer->length = 0;
+        return;
+    }
+    memmove(buffer->data, buffer->data + count, buffer->length - count);
+    buffer->length -= count;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static bool append_u32(JobBuffer *out, uint32_t v) {
+    uint8_t bytes[4];
+    put_u32(bytes, v);
+    return job_buffer_append(out, bytes, sizeof(bytes));
+}
+
+static bool append_u64(JobBuffer *out, uint64_t v) {
+    return append_u32(out, (uint32_t)v) && append_u32(out, (uint32_t)(v >> 32));
+}
+
+static bool append_words(JobBuffer *out, const uint32_t *words, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (!append_u32(out, words[i]))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reserve the length prefix and return its offset.
+ */
+static size_t begin_frame(JobBuffer *out, bool *ok) {
+    size_t at = out->length;
+    *ok = append_u32(out, 0);
+    return at;
+}
+
+/**
+ * @brief Patch the length prefix written by begin_frame().
+ */
+static bool end_frame(JobBuffer *out, size_t at, bool ok) {
+    if (!ok) {
+        out->length = at;
+        return false;
+    }
+    put_u32(out->data + at, (uint32_t)(out->length - at - 4));
+    return true;
+}
+
+bool job_encode_request(JobBuffer *out, const JobRequest *request) {
+    bool ok;
+    size_t at = begin_frame(out, &ok);
+    uint8_t head[4] = { request->type, request->flags, (uint8_t)request->patch_count,
+                        (uint8_t)(request->patch_count >> 8) };
+    ok = ok && job_buffer_append(out, head, sizeof(head))
+            && append_u32(out, request->request_id)
+            && append_u64(out, request->max_instructions)
+            && append_u32(out, request->output_address)
+            && append_u32(out, request->output_count);
+    if (request->flags & JOB_FLAG_REGISTERS)
+        ok = ok && append_words(out, request->registers, MAX_REGISTERS);
+    for (uint16_t i = 0; ok && i < request->patch_count; i++) {
+        const JobPatch *patch = &request->patches[i];
+        ok = append_u32(out, patch->address) && append_u32(out, patch->count)
+          && append_words(out, patch->words, patch->count);
+    }
+    if (request->type == JOB_MSG_RUN_SOURCE) {
+        static const uint8_t zeros[3];
+        ok = ok && append_u32(out, request->source_length)
+                && job_buffer_append(out, request->source, request->source_length)
+                && job_buffer_append(out, zeros, (4 - request->source_length % 4) % 4);
+    } else {
+        ok = ok && append_u64(out, request->program_id);
+    }
+    return end_frame(out, at, ok);
+}
+
+bool job_encode_result(JobBuffer *out, const JobResult *result) {
+    bool ok;
+    size_t at = begin_frame(out, &ok);
+    uint8_t head[4] = { JOB_MSG_RESULT, result->status, result->stop,
+                        (uint8_t)((result->zero_flag ? 1u : 0u) | (result->negative_flag ? 2u : 0u)) };
+    ok = ok && job_buffer_append(out, head, sizeof(head))
+            && append_u32(out, result->request_id)
+            && append_u64(out, result->program_id)
+            && append_u64(out, result->instructions)
+            && append_u32(out, result->pc)
+            && append_words(out, result->registers, MAX_REGISTERS)
+            && append_u32(out, result->output ? result->output_count : 0);
+    if (result->output)
+        ok = ok && append_words(out, result->output, result->output_count);
+    return end_frame(out, at, ok);
+}
+
+/**
+ * @struct Reader
+ * @brief Bounds-checked cursor over a payload.
+ */
+typedef struct {
+    uint8_t *data;
+    size_t length;
+    size_t at;
+    bool ok;
+} Reader;
+
+static uint32_t read_u32(Reader *r) {
+    if (!r->ok || r->length - r->at < 4) {
+        r->ok = false;
+        return 0;
+    }
+    uint32_t v = get_u32(r->data + r->at);
+    r->at += 4;
+    return v;
+}
+
+static uint64_t read_u64(Reader *r) {
+    uint64_t lo = read_u32(r);
+    return lo | (uint64_t)read_u32(r) << 32;
+}
+
+/**
+ * @brief Convert `count` words in place to host order and return a pointer to them.
+ */
+static const uint32_t *read_words(Reader *r, uint32_t count) {
+    if (!r->ok || (r->length - r->at) / 4 < count) {
+        r->ok = false;
+        return NULL;
+    }
+    uint32_t *words = (uint32_t *)(void *)(r->data + r->at);
+    for (uint32_t i = 0; i < count; i++)
+        words[i] = get_u32(r->data + r->at + 4 * (size_t)i);
+    r->at += 4 * (size_t)count;
+    return words;
+}
+
+bool job_decode_request(uint8_t *payload, size_t length, JobRequest *request, JobPatch *patches,
+                        size_t patch_capacity) {
+    memset(request, 0, sizeof(*request));
+    if (length < REQUEST_HEADER_BYTES)
+        return false;
+
+    Reader r = { payload, length, 4, true };
+    request->type = payload[0];
+    request->flags = payload[1];
+    request->patch_count = (uint16_t)(payload[2] | payload[3] << 8);
+    request->request_id = read_u32(&r);
+    request->max_instructions = read_u64(&r);
+    request->output_address = read_u32(&r);
+    request->output_count = read_u32(&r);
+    if (request->type != JOB_MSG_RUN_SOURCE && request->type != JOB_MSG_RUN_PROGRAM)
+        return false;
+
+    if (request->flags & JOB_FLAG_REGISTERS) {
+        const uint32_t *regs = read_words(&r, MAX_REGISTERS);
+        if (regs)
+            memcpy(request->registers, regs, sizeof(request->registers));
+    }
+    if (request->patch_count > patch_capacity)
+        return false;
+    for (uint16_t i = 0; r.ok && i < request->patch_count; i++) {
+        patches[i].address = read_u32(&r);
+        patches[i].count = read_u32(&r);
+        patches[i].words = read_words(&r, patches[i].count);
+    }
+    request->patches = patches;
+
+    if (request->type == JOB_MSG_RUN_SOURCE) {
+        request->source_length = read_u32(&r);
+        if (r.ok && request->source_length <= r.length - r.at) {
+            request->source = (const char *)(r.data + r.at);
+            r.at += request->source_length;
+        } else {
+            r.ok = false;
+        }
+    } else {
+        request->program_id = read_u64(&r);
+    }
+    return r.ok;
+}
+
+bool job_decode_result(uint8_t *payload, size_t length, JobResult *result) {
+    memset(result, 0, sizeof(*result));
+    if (length < RESULT_HEADER_BYTES || payload[0] != JOB_MSG_RESULT)
+        return false;
+
+    Reader r = { payload, length, 4, true };
+    result->status = payload[1];
+    result->stop = payload[2];
+    result->zero_flag = payload[3] & 1u;
+    result->negative_flag = (payload[3] & 2u) != 0;
+    result->request_id = read_u32(&r);
+    result->program_id = read_u64(&r);
+    result->instructions = read_u64(&r);
+    result->pc = read_u32(&r);
+    const uint32_t *regs = read_words(&r, MAX_REGISTERS);
+    if (regs)
+        memcpy(result->registers, regs, sizeof(result->registers));
+    result->output_count = read_u32(&r);
+    result->output = read_words(&r, result->output_count);
+    return r.ok;
+}
+
+int job_frame_ready(const JobBuffer *buffer, uint32_t *payload_length) {
+    if (buffer->length < 4)
+        return 0;
+    *payload_length = get_u32(buffer->data);
+    if (*payload_length > JOB_MAX_PAYLOAD)
+        return -1;
+    return buffer->length - 4 >= *payload_length ? 1 : 0;
+}
+
+const char *job_status_name(JobStatus status) {
+    switch (status) {
+        case JOB_STATUS_OK:              return "ok";
+        case JOB_STATUS_BAD_REQUEST:     return "bad_request";
+        case JOB_STATUS_UNKNOWN_PROGRAM: return "unknown_program";
+        case JOB_STATUS_ASSEMBLY_FAILED: return "assembly_failed";
+        case JOB_STATUS_OVERLOADED:      return "overloaded";
+        case JOB_STATUS_INTERNAL:        return "internal";
+    }
+    return "unknown";
+}
@@ -0,0 +1,991 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#define _GNU_SOURCE
+
+#include "job_server.h"
+
+#include <string.h>
+
+#include "log.h"
+
+void job_server_config_default(JobServerConfig *config) {
+    memset(config, 0, sizeof(*config));
+    config->queue_capacity = 4096;
+    config->cache_entries = 256;
+}
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "emulator.h"
+#include "job_protocol.h"
+#include "metrics.h"
+
+#define MAX_EVENTS   64
+#define MAX_PATCHES  1024
+#define READ_CHUNK   65536
+
+/**
+ * @struct Connection
+ * @brief Client connection; owned by the I/O thread.
+ */
+typedef struct Connection {
+    int fd;
+    JobBuffer in;                /**< Bytes received but not yet parsed */
+    JobBuffer out;               /**< Encoded results not yet written */
+    size_t pending;              /**< Jobs submitted and not yet completed */
+    bool eof;                    /**< Peer finished sending; close once drained */
+    bool closed;                 /**< fd closed; retired when `pending` drops to 0 */
+    uint32_t events;             /**< epoll events currently registered */
+    bool flush_queued;           /**< On the flush list of drain_completions() */
+    struct Connection *flush_next;
+    struct Connection *prev, *next; /**< `next` links JobServer::retired once retired */
+} Connection;
+
+/**
+ * @struct Job
+ * @brief One request travelling from the I/O thread to a worker and back.
+ */
+typedef struct Job {
+    Connection *conn;
+    uint8_t *payload;            /**< Request payload (malloc'd, so suitably aligned) */
+    size_t length;
+    JobBuffer response;          /**< Encoded result frame */
+    uint64_t received_ns;        /**< When the request was parsed (0 unless metrics are enabled) */
+    struct Job *next;
+} Job;
+
+/**
+ * @struct CachedProgram
+ * @brief Assembled program in the shared cache.
+ */
+typedef struct {
+    uint64_t id;                 /**< Hash of source and encoding */
+    uint64_t serial;             /**< Unique per stored program; workers compare it to skip reloads */
+    char *source;                /**< Copy of the source, compared on every RUN_SOURCE hit */
+    size_t source_length;
+    InstructionEncoding encoding;
+    uint32_t *code;              /**< Words of [range.start_address, range.end_address) */
+    AssemblyRange range;
+    uint64_t last_used;          /**< Cache clock at the last lookup (LRU) */
+    unsigned refs;               /**< Workers currently loading from `code` */
+    bool used;
+} CachedProgram;
+
+/**
+ * @struct Worker
+ * @brief Worker thread with its warm emulator instance and scratch buffers.
+ */
+typedef struct {
+    JobServer *server;
+    pthread_t thread;
+    Emulator *emu;
+    uint64_t loaded_serial;      /**< CachedProgram::serial of the program loaded into `emu` */
+    bool has_loaded;
+    CachedProgram uncached;      /**< Program that could not be cached (its id was pinned by another) */
+    uint32_t *scratch;           /**< RAM_SIZE words for assembling sources, cleared before each */
+    uint32_t *output;            /**< Output window buffer */
+    uint32_t output_capacity;
+    JobPatch patches[MAX_PATCHES];
+    EmuPatch emu_patches[MAX_PATCHES];
+} Worker;
+
+struct JobServer {
+    JobServerConfig config;
+    int listen_fd;
+    int epoll_fd;
+    int done_fd;                 /**< eventfd: workers have completed jobs */
+    int stop_fd;                 /**< eventfd: job_server_stop() was called */
+
+    pthread_mutex_t queue_lock;
+    pthread_cond_t queue_cond;
+    Job **queue;                 /**< Ring buffer of submitted jobs */
+    size_t queue_head;
+    size_t queue_count;
+    bool stopping;
+
+    pthread_mutex_t done_lock;
+    Job *done_head;
+    Job *done_tail;
+
+    pthread_mutex_t cache_lock;
+    CachedProgram *cache;
+    uint64_t cache_clock;
+    uint64_t cache_serial;
+
+    Worker *workers;
+    size_t worker_count;
+    size_t workers_started;
+
+    Connection *connections;     /**< All open or draining connections */
+    Connection *retired;         /**< Unlinked, freed after the current epoll batch */
+    int64_t open_connections;    /**< Connections whose socket is still open */
+    uint64_t jobs_completed;
+    uint64_t jobs_rejected;
+    uint64_t connections_accepted;
+    atomic_uint_fast64_t cache_misses;
+};
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief FNV-1a over the source text and encoding: the program's cache key.
+ */
+static uint64_t program_hash(const char *source, size_t length, InstructionEncoding encoding) {
+    uint64_t hash = 14695981039346656037ull ^ (uint64_t)encoding;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)source[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/* ---- program cache (any thread, under cache_lock) ---- */
+
+static void program_free(CachedProgram *program) {
+    free(program->code);
+    free(program->source);
+    program->code = NULL;
+    program->source = NULL;
+}
+
+static bool program_matches(const CachedProgram *program, const char *source, size_t length,
+                            InstructionEncoding encoding) {
+    return program->encoding == encoding && program->source_length == length
+           && memcmp(program->source, source, length) == 0;
+}
+
+static CachedProgram *cache_lookup_locked(JobServer *server, uint64_t id) {
+    for (size_t i = 0; i < server->config.cache_entries; i++) {
+        CachedProgram *entry = &server->cache[i];
+        if (entry->used && entry->id == id)
+            return entry;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Find the program with `id` and pin it.
+ *
+ * With a `source`, an entry whose source or encoding differs (an FNV-1a
+ * collision) is not returned: the caller treats it as a miss.
+ */
+static CachedProgram *cache_find_locked(JobServer *server, uint64_t id, const char *source, size_t length,
+                                        InstructionEncoding encoding) {
+    CachedProgram *entry = cache_lookup_locked(server, id);
+    if (!entry || (source && !program_matches(entry, source, length, encoding)))
+        return NULL;
+    entry->refs++;
+    entry->last_used = ++server->cache_clock;
+    return entry;
+}
+
+/**
+ * @brief Look up a program and pin it until cache_release().
+ *
+ * `source` is NULL to look up by id alone (RUN_PROGRAM).
+ */
+static CachedProgram *cache_acquire(JobServer *server, uint64_t id, const char *source, size_t length,
+                                    InstructionEncoding encoding) {
+    pthread_mutex_lock(&server->cache_lock);
+    CachedProgram *entry = cache_find_locked(server, id, source, length, encoding);
+    pthread_mutex_unlock(&server->cache_lock);
+    return entry;
+}
+
+/**
+ * @brief Insert an assembled program and pin it.
+ *
+ * On success the cache owns `program`'s code and source. If another worker
+ * inserted the same program meanwhile, that entry is used and `program` is
+ * freed. The least recently used unpinned entry is evicted when the cache
+ * is full; a colliding program with the same id is replaced unless it is
+ * pinned. Returns NULL, leaving `program` to the caller, when nothing could
+ * be evicted. `program->serial` is assigned either way.
+ */
+static CachedProgram *cache_insert(JobServer *server, CachedProgram *program) {
+    pthread_mutex_lock(&server->cache_lock);
+    program->serial = ++server->cache_serial;
+    CachedProgram *entry = cache_find_locked(server, program->id, program->source, program->source_length,
+                                             program->encoding);
+    if (entry) {
+        pthread_mutex_unlock(&server->cache_lock);
+        program_free(program);
+        return entry;
+    }
+
+    /* Ids stay unique: a colliding entry can only be replaced. */
+    CachedProgram *victim = cache_lookup_locked(server, program->id);
+    if (victim) {
+        if (victim->refs)
+            victim = NULL;
+    } else {
+        for (size_t i = 0; i < server->config.cache_entries; i++) {
+            CachedProgram *candidate = &server->cache[i];
+            if (!candidate->used) {
+                victim = candidate;
+                break;
+            }
+            if (candidate->refs == 0 && (!victim || candidate->last_used < victim->last_used))
+                victim = candidate;
+        }
+    }
+    CachedProgram evicted = { 0 };
+    if (victim) {
+        if (victim->used)
+            evicted = *victim;
+        *victim = *program;
+        victim->used = true;
+        victim->refs = 1;
+        victim->last_used = ++server->cache_clock;
+    }
+    pthread_mutex_unlock(&server->cache_lock);
+
+    program_free(&evicted);
+    return victim;
+}
+
+static void cache_release(JobServer *server, CachedProgram *entry) {
+    pthread_mutex_lock(&server->cache_lock);
+    entry->refs--;
+    pthread_mutex_unlock(&server->cache_lock);
+}
+
+/* ---- workers ---- */
+
+static bool window_valid(uint32_t address, uint32_t count) {
+    return (uint64_t)address + count <= RAM_SIZE;
+}
+
+/**
+ * @brief Find or assemble the program a request refers to (pinned on success).
+ */
+static CachedProgram *resolve_program(Worker *worker, const JobRequest *request, JobResult *result) {
+    JobServer *server = worker->server;
+    if (request->type == JOB_MSG_RUN_PROGRAM) {
+        result->program_id = request->program_id;
+        CachedProgram *entry = cache_acquire(server, request->program_id, NULL, 0, ENCODING_WIDE);
+        metrics_add(entry ? METRIC_CACHE_HITS : METRIC_CACHE_MISSES, 1);
+        if (!entry)
+            result->status = JOB_STATUS_UNKNOWN_PROGRAM;
+        return entry;
+    }
+
+    InstructionEncoding encoding = request->flags & JOB_FLAG_PACKED ? ENCODING_PACKED : ENCODING_WIDE;
+    uint64_t id = program_hash(request->source, request->source_length, encoding);
+    result->program_id = id;
+    CachedProgram *entry = cache_acquire(server, id, request->source, request->source_length, encoding);
+    metrics_add(entry ? METRIC_CACHE_HITS : METRIC_CACHE_MISSES, 1);
+    if (entry)
+        return entry;
+
+    atomic_fetch_add(&server->cache_misses, 1);
+    /* .org gaps are not written: clear what earlier jobs (or malloc) left behind. */
+    memset(worker->scratch, 0, RAM_SIZE * sizeof(uint32_t));
+    AssemblyRange range = request->source_length
+        ? assemble_source(worker->scratch, RAM_SIZE, request->source, request->source_length, encoding)
+        : (AssemblyRange){ .error = true };
+    if (range.error) {
+        result->status = JOB_STATUS_ASSEMBLY_FAILED;
+        return NULL;
+    }
+    size_t words = range.end_address - range.start_address;
+    CachedProgram program = {
+        .id = id,
+        .source = malloc(request->source_length),
+        .source_length = request->source_length,
+        .encoding = encoding,
+        .code = malloc((words ? words : 1) * sizeof(uint32_t)),
+        .range = range,
+    };
+    if (!program.source || !program.code) {
+        program_free(&program);
+        result->status = JOB_STATUS_INTERNAL;
+        return NULL;
+    }
+    memcpy(program.source, request->source, request->source_length);
+    memcpy(program.code, worker->scratch + range.start_address, words * sizeof(uint32_t));
+    entry = cache_insert(server, &program);
+    if (entry)
+        return entry;
+
+    /* The colliding entry is pinned: run this program from the worker without caching it. */
+    program_free(&worker->uncached);
+    worker->uncached = program;
+    return &worker->uncached;
+}
+
+/**
+ * @brief Decode, run and encode one job.
+ */
+static void process_job(Worker *worker, Job *job) {
+    JobServer *server = worker->server;
+    JobRequest request;
+    JobResult result;
+    memset(&result, 0, sizeof(result));
+
+    bool decoded = job_decode_request(job->payload, job->length, &request, worker->patches, MAX_PATCHES);
+    result.request_id = request.request_id;
+    result.status = JOB_STATUS_BAD_REQUEST;
+    if (!decoded || (request.output_count && !window_valid(request.output_address, request.output_count)))
+        goto reply;
+    for (uint16_t i = 0; i < request.patch_count; i++) {
+        if (!window_valid(request.patches[i].address, request.patches[i].count))
+            goto reply;
+        worker->emu_patches[i] = (EmuPatch){ request.patches[i].address, request.patches[i].count,
+                                             request.patches[i].words };
+    }
+    if (request.output_count > worker->output_capacity) {
+        uint32_t *grown = realloc(worker->output, request.output_count * sizeof(uint32_t));
+        if (!grown) {
+            result.status = JOB_STATUS_INTERNAL;
+            goto reply;
+        }
+        worker->output = grown;
+        worker->output_capacity = request.output_count;
+    }
+
+    result.status = JOB_STATUS_OK;
+    CachedProgram *entry = resolve_program(worker, &request, &result);
+    if (!entry)
+        goto reply;
+    if (!worker->has_loaded || worker->loaded_serial != entry->serial) {
+        worker->has_loaded = emu_load_program(worker->emu, entry->code, entry->range);
+        worker->loaded_serial = entry->serial;
+    }
+    if (entry != &worker->uncached)
+        cache_release(server, entry);
+    if (!worker->has_loaded) {
+        result.status = JOB_STATUS_INTERNAL;
+        goto reply;
+    }
+
+    uint64_t cap = server->config.max_instructions;
+    EmuInput input = {
+        .registers = request.flags & JOB_FLAG_REGISTERS ? request.registers : NULL,
+        .patches = worker->emu_patches,
+        .patch_count = request.patch_count,
+        .output = request.output_count ? worker->output : NULL,
+        .output_address = request.output_address,
+        .output_count = request.output_count,
+        .max_instructions = request.max_instructions && (!cap || request.max_instructions < cap)
+                            ? request.max_instructions : cap,
+    };
+    EmuResult run;
+    emu_run(worker->emu, &input, &run);
+    result.stop = (uint8_t)run.stop;
+    result.instructions = run.instructions;
+    result.pc = run.pc;
+    memcpy(result.registers, run.registers, sizeof(result.registers));
+    result.zero_flag = run.zero_flag;
+    result.negative_flag = run.negative_flag;
+    result.output = input.output;
+    result.output_count = request.output_count;
+
+reply:
+    metrics_add(METRIC_JOBS + result.status, 1);
+    if (!job_encode_result(&job->response, &result))
+        log_write(LOG_ERROR, "Out of memory encoding a job result");
+}
+
+/**
+ * @brief Hand a finished job back to the I/O thread.
+ */
+static void complete_job(JobServer *server, Job *job) {
+    job->next = NULL;
+    pthread_mutex_lock(&server->done_lock);
+    if (server->done_tail)
+        server->done_tail->next = job;
+    else
+        server->done_head = job;
+    server->done_tail = job;
+    pthread_mutex_unlock(&server->done_lock);
+
+    uint64_t one = 1;
+    if (write(server->done_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        log_write(LOG_ERROR, "Failed to signal job completion: %s", strerror(errno));
+}
+
+static void *worker_main(void *arg) {
+    Worker *worker = arg;
+    JobServer *server = worker->server;
+    for (;;) {
+        pthread_mutex_lock(&server->queue_lock);
+        while (server->queue_count == 0 && !server->stopping)
+            pthread_cond_wait(&server->queue_cond, &server->queue_lock);
+        if (server->stopping) {
+            pthread_mutex_unlock(&server->queue_lock);
+            return NULL;
+        }
+        Job *job = server->queue[server->queue_head];
+        server->queue_head = (server->queue_head + 1) % server->config.queue_capacity;
+        server->queue_count--;
+        metrics_set_gauge(METRIC_QUEUE_DEPTH, (int64_t)server->queue_count);
+        pthread_mutex_unlock(&server->queue_lock);
+
+        process_job(worker, job);
+        free(job->payload);
+        job->payload = NULL;
+        complete_job(server, job);
+    }
+}
+
+/* ---- I/O thread ---- */
+
+static bool epoll_update(JobServer *server, int op, int fd, uint32_t events, void *ptr) {
+    struct epoll_event event = { .events = events, .data.ptr = ptr };
+    if (epoll_ctl(server->epoll_fd, op, fd, &event) != 0) {
+        log_write(LOG_ERROR, "epoll_ctl failed: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+static void connection_unlink(JobServer *server, Connection *conn) {
+    if (conn->prev)
+        conn->prev->next = conn->next;
+    else
+        server->connections = conn->next;
+    if (conn->next)
+        conn->next->prev = conn->prev;
+}
+
+static void connection_free(Connection *conn) {
+    job_buffer_free(&conn->in);
+    job_buffer_free(&conn->out);
+    free(conn);
+}
+
+/**
+ * @brief Unlink a connection no job refers to any more.
+ *
+ * Later events of the same epoll_wait() batch may still point at it, so it
+ * is only freed by free_retired() once the batch has been handled.
+ */
+static void connection_retire(JobServer *server, Connection *conn) {
+    connection_unlink(server, conn);
+    conn->next = server->retired;
+    server->retired = conn;
+}
+
+static void free_retired(JobServer *server) {
+    while (server->retired) {
+        Connection *conn = server->retired;
+        server->retired = conn->next;
+        connection_free(conn);
+    }
+}
+
+/**
+ * @brief Close the socket; the connection is retired once no job refers to it.
+ */
+static void connection_close(JobServer *server, Connection *conn) {
+    if (!conn->closed) {
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+        close(conn->fd);
+        conn->closed = true;
+        metrics_set_gauge(METRIC_OPEN_CONNECTIONS, --server->open_connections);
+    }
+    if (conn->pending == 0)
+        connection_retire(server, conn);
+}
+
+/**
+ * @brief Register interest matching the connection's state: input until the
+ *        peer finished sending, output while results are buffered.
+ */
+static void connection_update_events(JobServer *server, Connection *conn) {
+    uint32_t events = (conn->eof ? 0 : EPOLLIN | EPOLLRDHUP) | (conn->out.length ? EPOLLOUT : 0);
+    if (events != conn->events && epoll_update(server, EPOLL_CTL_MOD, conn->fd, events, conn))
+        conn->events = events;
+}
+
+/**
+ * @brief Write as much buffered output as the socket takes.
+ *
+ * @return false if the connection was closed.
+ */
+static bool connection_flush(JobServer *server, Connection *conn) {
+    size_t written = 0;
+    while (written < conn->out.length) {
+        ssize_t n = send(conn->fd, conn->out.data + written, conn->out.length - written, MSG_NOSIGNAL);
+        if (n > 0) {
+            written += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            connection_close(server, conn);
+            return false;
+        }
+    }
+    job_buffer_consume(&conn->out, written);
+
+    if (conn->eof && conn->pending == 0 && conn->out.length == 0) {
+        connection_close(server, conn);
+        return false;
+    }
+    connection_update_events(server, conn);
+    return true;
+}
+
+/**
+ * @brief Queue a job for the workers.
+ *
+ * @return false if the queue is full.
+ */
+static bool submit_job(JobServer *server, Job *job) {
+    pthread_mutex_lock(&server->queue_lock);
+    bool accepted = server->queue_count < server->config.queue_capacity;
+    if (accepted) {
+        size_t tail = (server->queue_head + server->queue_count) % server->config.queue_capacity;
+        server->queue[tail] = job;
+        server->queue_count++;
+        metrics_set_gauge(METRIC_QUEUE_DEPTH, (int64_t)server->queue_count);
+        pthread_cond_signal(&server->queue_cond);
+    }
+    pthread_mutex_unlock(&server->queue_lock);
+    return accepted;
+}
+
+/**
+ * @brief Reply immediately from the I/O thread (queue full, out of memory).
+ */
+static void reply_status(Connection *conn, const uint8_t *payload, uint32_t length, JobStatus status) {
+    JobResult result;
+    memset(&result, 0, sizeof(result));
+    result.status = (uint8_t)status;
+    metrics_add(METRIC_JOBS + status, 1);
+    if (length >= 8)
+        result.request_id = (uint32_t)payload[4] | (uint32_t)payload[5] << 8 | (uint32_t)payload[6] << 16
+                          | (uint32_t)payload[7] << 24;
+    job_encode_result(&conn->out, &result);
+}
+
+/**
+ * @brief Split buffered input into frames and submit them.
+ *
+ * @return false if the connection was closed (oversized frame).
+ */
+static bool connection_parse(JobServer *server, Connection *conn) {
+    size_t consumed = 0;
+    for (;;) {
+        JobBuffer view = { conn->in.data + consumed, conn->in.length - consumed, 0 };
+        uint32_t length;
+        int ready = job_frame_ready(&view, &length);
+        if (ready < 0) {
+            log_write(LOG_WARN, "Closing connection: frame of %u bytes exceeds the limit", length);
+            connection_close(server, conn);
+            return false;
+        }
+        if (ready == 0)
+            break;
+
+        const uint8_t *payload = view.data + 4;
+        consumed += 4 + (size_t)length;
+
+        Job *job = calloc(1, sizeof(*job));
+        if (job)
+            job->payload = malloc(length ? length : 1);
+        if (!job || !job->payload) {
+            if (job)
+                free(job);
+            reply_status(conn, payload, length, JOB_STATUS_INTERNAL);
+            continue;
+        }
+        memcpy(job->payload, payload, length);
+        job->length = length;
+        job->conn = conn;
+        if (metrics_enabled())
+            job->received_ns = monotonic_ns();
+        if (!submit_job(server, job)) {
+            reply_status(conn, payload, length, JOB_STATUS_OVERLOADED);
+            server->jobs_rejected++;
+            free(job->payload);
+            free(job);
+            continue;
+        }
+        conn->pending++;
+    }
+    job_buffer_consume(&conn->in, consumed);
+    return true;
+}
+
+static void connection_read(JobServer *server, Connection *conn) {
+    uint8_t chunk[READ_CHUNK];
+    for (;;) {
+        ssize_t n = recv(conn->fd, chunk, sizeof(chunk), 0);
+        if (n > 0) {
+            if (!job_buffer_append(&conn->in, chunk, (size_t)n)) {
+                log_write(LOG_ERROR, "Out of memory buffering client input");
+                connection_close(server, conn);
+                return;
+            }
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n < 0) {
+            connection_close(server, conn);
+            return;
+        }
+        /* Orderly shutdown of the sending side: answer what was sent, then close. */
+        conn->eof = true;
+        break;
+    }
+    if (connection_parse(server, conn))
+        connection_flush(server, conn);
+}
+
+static void accept_connections(JobServer *server) {
+    for (;;) {
+        int fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                log_write(LOG_WARN, "accept failed: %s", strerror(errno));
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        Connection *conn = calloc(1, sizeof(*conn));
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        conn->events = EPOLLIN | EPOLLRDHUP;
+        if (!epoll_update(server, EPOLL_CTL_ADD, fd, conn->events, conn)) {
+            close(fd);
+            free(conn);
+            continue;
+        }
+        conn->next = server->connections;
+        if (conn->next)
+            conn->next->prev = conn;
+        server->connections = conn;
+        server->connections_accepted++;
+        metrics_add(METRIC_CONNECTIONS, 1);
+        metrics_set_gauge(METRIC_OPEN_CONNECTIONS, ++server->open_connections);
+    }
+}
+
+/**
+ * @brief Move completed jobs' results to their connections.
+ */
+static void drain_completions(JobServer *server) {
+    uint64_t count;
+    if (read(server->done_fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+        log_write(LOG_WARN, "eventfd read failed: %s", strerror(errno));
+
+    pthread_mutex_lock(&server->done_lock);
+    Job *job = server->done_head;
+    server->done_head = server->done_tail = NULL;
+    pthread_mutex_unlock(&server->done_lock);
+
+    /* Append every result first, then flush each connection once. */
+    Connection *flush_list = NULL;
+    uint64_t now = job && job->received_ns ? monotonic_ns() : 0;
+    while (job) {
+        Job *next = job->next;
+        Connection *conn = job->conn;
+        conn->pending--;
+        server->jobs_completed++;
+        if (job->received_ns)
+            metrics_observe(METRIC_JOB_LATENCY, now - job->received_ns);
+        if (!conn->closed && !job_buffer_append(&conn->out, job->response.data, job->response.length))
+            log_write(LOG_ERROR, "Out of memory buffering a job result");
+        if (!conn->flush_queued) {
+            conn->flush_queued = true;
+            conn->flush_next = flush_list;
+            flush_list = conn;
+        }
+        job_buffer_free(&job->response);
+        free(job);
+        job = next;
+    }
+    while (flush_list) {
+        Connection *conn = flush_list;
+        flush_list = conn->flush_next;
+        conn->flush_queued = false;
+        if (conn->closed) {
+            if (conn->pending == 0)
+                connection_retire(server, conn);
+        } else {
+            connection_flush(server, conn);
+        }
+    }
+}
+
+bool job_server_run(JobServer *server) {
+    struct epoll_event events[MAX_EVENTS];
+    bool running = true;
+    while (running) {
+        int n = epoll_wait(server->epoll_fd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            log_write(LOG_ERROR, "epoll_wait failed: %s", strerror(errno));
+            return false;
+        }
+        for (int i = 0; i < n; i++) {
+            void *ptr = events[i].data.ptr;
+            if (ptr == &server->listen_fd) {
+                accept_connections(server);
+            } else if (ptr == &server->done_fd) {
+                drain_completions(server);
+            } else if (ptr == &server->stop_fd) {
+                running = false;
+            } else {
+                Connection *conn = ptr;
+                if (conn->closed)
+                    continue;   /* Closed by an earlier event of this batch */
+                if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                    /* Peer gone in both directions: results can no longer be delivered. */
+                    connection_close(server, conn);
+                    continue;
+                }
+                if ((events[i].events & EPOLLOUT) && !connection_flush(server, conn))
+                    continue;
+                if (events[i].events & (EPOLLIN | EPOLLRDHUP))
+                    connection_read(server, conn);
+            }
+        }
+        free_retired(server);
+    }
+    log_write(LOG_INFO, "Job server stopping: %llu jobs completed, %llu rejected, %llu connections, "
+              "%llu program cache misses", (unsigned long long)server->jobs_completed,
+              (unsigned long long)server->jobs_rejected, (unsigned long long)server->connections_accepted,
+              (unsigned long long)atomic_load(&server->cache_misses));
+    return true;
+}
+
+void job_server_stop(JobServer *server) {
+    uint64_t one = 1;
+    ssize_t ignored = write(server->stop_fd, &one, sizeof(one));
+    (void)ignored;
+}
+
+/**
+ * @brief Create the listening socket (replacing a stale socket file).
+ */
+static int open_listener(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        log_write(LOG_ERROR, "Socket path too long: %s", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    struct stat st;
+    if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+        unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        log_write(LOG_ERROR, "socket failed: %s", strerror(errno));
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        log_write(LOG_ERROR, "Unable to listen on %s: %s", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+JobServer *job_server_create(const JobServerConfig *config) {
+    if (!config->socket_path) {
+        log_write(LOG_ERROR, "Job server needs a socket path");
+        return NULL;
+    }
+    JobServer *server = calloc(1, sizeof(*server));
+    if (!server) {
+        log_write(LOG_ERROR, "Out of memory creating the job server");
+        return NULL;
+    }
+    server->config = *config;
+    if (server->config.workers == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        server->config.workers = cpus > 0 ? (size_t)cpus : 1;
+    }
+    if (server->config.queue_capacity == 0)
+        server->config.queue_capacity = 4096;
+    if (server->config.cache_entries == 0)
+        server->config.cache_entries = 256;
+    /* Every worker may pin one entry while loading; keep room for a new one. */
+    if (server->config.cache_entries <= server->config.workers)
+        server->config.cache_entries = server->config.workers + 1;
+
+    server->listen_fd = server->epoll_fd = server->done_fd = server->stop_fd = -1;
+    pthread_mutex_init(&server->queue_lock, NULL);
+    pthread_cond_init(&server->queue_cond, NULL);
+    pthread_mutex_init(&server->done_lock, NULL);
+    pthread_mutex_init(&server->cache_lock, NULL);
+    atomic_init(&server->cache_misses, 0);
+
+    server->queue = calloc(server->config.queue_capacity, sizeof(Job *));
+    server->cache = calloc(server->config.cache_entries, sizeof(CachedProgram));
+    server->workers = calloc(server->config.workers, sizeof(Worker));
+    if (!server->queue || !server->cache || !server->workers) {
+        log_write(LOG_ERROR, "Out of memory creating the job server");
+        goto fail;
+    }
+
+    /* Warm instances: every worker gets its CPU/RAM pair up front. */
+    EmuConfig emu_config;
+    emu_config_default(&emu_config);
+    emu_config.engine = config->engine;
+    if (config->verbose)
+        emu_config.log.level_mask = LOG_LEVELS_ALL;
+    else
+        emu_config.log.write = NULL;
+    for (size_t i = 0; i < server->config.workers; i++) {
+        Worker *worker = &server->workers[i];
+        worker->server = server;
+        worker->emu = emu_create(&emu_config);
+        worker->scratch = malloc(RAM_SIZE * sizeof(uint32_t));
+        if (!worker->emu || !worker->scratch) {
+            log_write(LOG_ERROR, "Unable to create worker instance %zu", i);
+            goto fail;
+        }
+        server->worker_count++;
+    }
+
+    server->listen_fd = open_listener(config->socket_path);
+    server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    server->done_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    server->stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (server->listen_fd < 0 || server->epoll_fd < 0 || server->done_fd < 0 || server->stop_fd < 0)
+        goto fail;
+    if (!epoll_update(server, EPOLL_CTL_ADD, server->listen_fd, EPOLLIN, &server->listen_fd)
+        || !epoll_update(server, EPOLL_CTL_ADD, server->done_fd, EPOLLIN, &server->done_fd)
+        || !epoll_update(server, EPOLL_CTL_ADD, server->stop_fd, EPOLLIN, &server->stop_fd))
+        goto fail;
+
+    for (size_t i = 0; i < server->worker_count; i++) {
+        if (pthread_create(&server->workers[i].thread, NULL, worker_main, &server->workers[i]) != 0) {
+            log_write(LOG_ERROR, "Unable to start worker thread %zu", i);
+            goto fail;
+        }
+        server->workers_started++;
+    }
+    metrics_set_gauge(METRIC_WORKERS, (int64_t)server->workers_started);
+    log_write(LOG_INFO, "Job server listening on %s with %zu workers", config->socket_path, server->worker_count);
+    return server;
+
+fail:
+    job_server_destroy(server);
+    return NULL;
+}
+
+void job_server_destroy(JobServer *server) {
+    if (!server)
+        return;
+
+    pthread_mutex_lock(&server->queue_lock);
+    server->stopping = true;
+    pthread_cond_broadcast(&server->queue_cond);
+    pthread_mutex_unlock(&server->queue_lock);
+    for (size_t i = 0; i < server->workers_started; i++)
+        pthread_join(server->workers[i].thread, NULL);
+
+    for (size_t i = 0; server->queue && i < server->queue_count; i++) {
+        Job *job = server->queue[(server->queue_head + i) % server->config.queue_capacity];
+        job->conn->pending--;
+        free(job->payload);
+        free(job);
+    }
+    for (Job *job = server->done_head; job;) {
+        Job *next = job->next;
+        job->conn->pending--;
+        job_buffer_free(&job->response);
+        free(job);
+        job = next;
+    }
+    while (server->connections) {
+        Connection *conn = server->connections;
+        if (!conn->closed)
+            close(conn->fd);
+        connection_unlink(server, conn);
+        connection_free(conn);
+    }
+    free_retired(server);
+
+    for (size_t i = 0; server->workers && i < server->worker_count; i++) {
+        emu_destroy(server->workers[i].emu);
+        free(server->workers[i].scratch);
+        free(server->workers[i].output);
+        program_free(&server->workers[i].uncached);
+    }
+    for (size_t i = 0; server->cache && i < server->config.cache_entries; i++)
+        program_free(&server->cache[i]);
+
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+        unlink(server->config.socket_path);
+    }
+    if (server->epoll_fd >= 0)
+        close(server->epoll_fd);
+    if (server->done_fd >= 0)
+        close(server->done_fd);
+    if (server->stop_fd >= 0)
+        close(server->stop_fd);
+
+    pthread_mutex_destroy(&server->queue_lock);
+    pthread_cond_destroy(&server->queue_cond);
+    pthread_mutex_destroy(&server->done_lock);
+    pthread_mutex_destroy(&server->cache_lock);
+    free(server->queue);
+    free(server->cache);
+    free(server->workers);
+    free(server);
+}
+
+#else /* !__linux__ */
+
+struct JobServer {
+    int unused;
+};
+
+JobServer *job_server_create(const JobServerConfig *config) {
+    (void)config;
+    log_write(LOG_ERROR, "The job server needs Linux (epoll, eventfd)");
+    return NULL;
+}
+
+bool job_server_run(JobServer *server) {
+    (void)server;
+    return false;
+}
+
+void job_server_stop(JobServer *server) {
+    (void)server;
+}
+
+void job_server_destroy(JobServer *server) {
+    (void)server;
+}
+
+#endif
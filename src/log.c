@@ -24,6 +24,9 @@ bool LOG_TRACE_SHOW = true;
 bool LOG_ERROR_SHOW = true;
 bool LOG_UNAUTHORIZED_SHOW = true;
 
+/* Sink overriding stdout for the current thread (see log_set_thread_sink) */
+static _Thread_local const LogSink *thread_sink = NULL;
+
 /**
  * @brief Map a LogLevel to a human-readable string.
  *
@@ -114,6 +117,75 @@ static bool should_show(const LogLevel level)
     }
 }
 
+/**
+ * @brief Enable or disable printing of messages for a log level.
+ *
+ * Updates the module-global flag consulted by should_show(). Drivers use
+ * this to silence per-instruction DEBUG output for batch or benchmark runs.
+ *
+ * @param level LogLevel to configure.
+ * @param enabled true to print messages of `level`, false to drop them.
+ */
+void log_set_enabled(const LogLevel level, const bool enabled)
+{
+    switch (level)
+    {
+    case LOG_INFO:
+        LOG_INFO_SHOW = enabled;
+        break;
+    case LOG_DEBUG:
+        LOG_DEBUG_SHOW = enabled;
+        break;
+    case LOG_WARN:
+        LOG_WARN_SHOW = enabled;
+        break;
+    case LOG_TRACE:
+        LOG_TRACE_SHOW = enabled;
+        break;
+    case LOG_ERROR:
+        LOG_ERROR_SHOW = enabled;
+        break;
+    case LOG_UNAUTHORIZED:
+        LOG_UNAUTHORIZED_SHOW = enabled;
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Route log_write() calls from this thread to `sink`.
+ *
+ * @param sink Sink to install, or NULL to go back to stdout.
+ * @return Previously installed sink (NULL if none).
+ */
+const LogSink *log_set_thread_sink(const LogSink *sink)
+{
+    const LogSink *previous = thread_sink;
+    thread_sink = sink;
+    return previous;
+}
+
+/**
+ * @brief Format a message and hand it to the thread's sink.
+ *
+ * Messages longer than the local buffer are truncated.
+ *
+ * @param sink Installed sink.
+ * @param level Log level for the message.
+ * @param fmt printf-style format string.
+ * @param args Arguments for `fmt`.
+ */
+static void sink_write(const LogSink *sink, const LogLevel level, const char *fmt, va_list args)
+{
+    if (!sink->write || !(sink->level_mask & LOG_LEVEL_BIT(level)))
+        return;
+
+    char message[1024];
+    vsnprintf(message, sizeof(message), fmt, args);
+    sink->write(sink->user, level, message);
+}
+
 /**
  * @brief Format and print a log message to stdout with timestamp and level.
  *
@@ -121,16 +193,30 @@ static bool should_show(const LogLevel level)
  * `should_show`. If so it prints an ISO-like timestamp, a colored level
  * tag, then the formatted message. Uses va_list/printf style formatting.
  *
+ * When a sink is installed on the calling thread the message goes there
+ * instead (see log_set_thread_sink()).
+ *
  * @param level Log level for the message.
  * @param fmt printf-style format string followed by optional arguments.
  */
 void log_write(const LogLevel level, const char *fmt, ...)
 {
+    const LogSink *sink = thread_sink;
+    if (sink)
+    {
+        va_list args;
+        va_start(args, fmt);
+        sink_write(sink, level, fmt, args);
+        va_end(args);
+        return;
+    }
+
     if (!should_show(level))
         return;
 
     time_t t = time(NULL);
-    struct tm tm = *localtime(&t);
+    struct tm tm;
+    localtime_r(&t, &tm);
 
     printf("%04d-%02d-%02d %02d:%02d:%02d %s[%s]%s ",
            tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
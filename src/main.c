@@ -1,67 +1,1417 @@
+#include <dirent.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "cpu.h"
 #include "ram.h"
+#include "log.h"
 #include "assembler.h"
+#include "batch_assembler.h"
+#include "branch_sim.h"
+#include "cache_sim.h"
+#include "code_regions.h"
+#include "disasm.h"
+#include "emulator.h"
+#include "coverage.h"
+#include "debugger.h"
+#include "gdb_stub.h"
+#include "heatmap.h"
+#include "smp.h"
+#include "trace.h"
 #include "cpu_exec.h"
+#include "cycle_model.h"
+#include "fuzzer.h"
+#include "optimizer.h"
+#include "engine.h"
+#include "image.h"
+#include "job_server.h"
+#include "metrics.h"
+#include "mmio.h"
+#include "observer.h"
+#include "state_dump.h"
+#include "timetravel.h"
 
 /**
- * @brief Simple program runner for the CPU emulator.
+ * @brief Process exit codes of the runner, one per way a run can end.
  *
- * This small CLI driver initializes RAM and CPU, assembles a hard-coded
- * input file into RAM, prints the assembled range and a hex dump of the
- * emitted words, executes the loaded program and then prints the final
- * CPU state. It also clears the assembled region before exiting.
+ * With several input files or engines the highest code wins.
+ */
+enum {
+    EXIT_RUN_OK               = 0, /**< Every run ended with HALT or at the end of its program */
+    EXIT_RUN_LOAD_ERROR       = 1, /**< A file could not be read, assembled or optimized */
+    EXIT_RUN_USAGE            = 2, /**< Bad command line */
+    EXIT_RUN_LIMIT            = 3, /**< The instruction limit was reached */
+    EXIT_RUN_INVALID_INSN     = 4, /**< Unknown opcode or malformed instruction */
+    EXIT_RUN_DIV_ZERO         = 5, /**< Division by zero */
+    EXIT_RUN_FAULT            = 6, /**< Bad register/operand or out-of-range memory access */
+    EXIT_RUN_ENGINE_ERROR     = 7, /**< An engine could not run the program (e.g. JIT build failed) */
+    EXIT_RUN_ENGINE_MISMATCH  = 8  /**< Engines compared with --engine a,b ended in different states */
+};
+
+/** Maximum number of engines compared in one invocation. */
+#define MAX_RUN_ENGINES 8
+
+/**
+ * @struct RunOptions
+ * @brief Parsed command line of the runner.
+ */
+typedef struct {
+    const ExecEngine *engines[MAX_RUN_ENGINES];
+    size_t engine_count;
+    uint64_t limit;                 /**< Instruction limit per run (0 = none) */
+    InstructionEncoding encoding;   /**< Encoding used when assembling .asm input */
+    bool optimize;
+    bool quiet;
+    bool stats;
+    bool cycles;                    /**< --cycles / --cycle-model: timed run with a per-label report */
+    CycleModel cycle_model;
+    bool dcache;                    /**< --dcache: cached run with a per-label/per-PC report */
+    CacheConfig cache_config;
+    BranchPredictorKind predictors[BPRED_KIND_COUNT];  /**< --bpred: predicted run with a per-branch report */
+    uint32_t predictor_count;
+    uint32_t mispredict_penalty;
+    const char *coverage_path;      /**< --coverage: write the edge bitmap of a covered run here */
+    int coverage_shm;               /**< --coverage-shm: System V segment holding the bitmap (-1 = none) */
+    const char *trace_path;         /**< --trace: record a traced run here */
+    bool heatmap;                   /**< --heatmap: profiled run with a memory access report */
+    HeatmapConfig heatmap_config;
+    const char *heatmap_path;       /**< --heatmap-file: also write the heatmap here as JSON */
+    const char *mmio_spec;          /**< --mmio: run once more with these devices mapped */
+    uint32_t cores;                 /**< --cores: run on this many CPUs sharing RAM (0 = off) */
+    const char *record_path;        /**< --record: log the interleaving of the multi-core run here */
+    const char *replay_path;        /**< --replay: reproduce the multi-core run logged here */
+    bool time_travel;               /**< --last-write / --step-back: checkpointed run, then go back */
+    bool last_write_given;
+    uint32_t last_write;            /**< --last-write: address whose last store to find */
+    uint64_t step_back;             /**< --step-back: instructions to undo from the end */
+    DumpFormat dump;
+    const char *dump_path;          /**< NULL = stdout */
+    bool dump_ram;                  /**< --dump-ram given */
+    uint32_t ram_start;
+    uint32_t ram_end;
+} RunOptions;
+
+/**
+ * @brief Batch mode: assemble many files concurrently and report timings.
+ *
+ * Usage: 32bit_cpu_emulator --batch [-j N] [--per-file] [--packed] file.asm...
+ *
+ * DEBUG/INFO logging is disabled because per-label debug lines from
+ * thousands of files would dominate the run time.
+ *
+ * @param argc Number of arguments following "--batch".
+ * @param argv Arguments following "--batch".
+ * @return 0 if every file assembled, 1 otherwise.
+ */
+static int run_batch(int argc, char **argv) {
+    size_t thread_count = 0;
+    bool per_file = false;
+    InstructionEncoding encoding = ENCODING_WIDE;
+    int first_file = 0;
+
+    while (first_file < argc && argv[first_file][0] == '-') {
+        if (strcmp(argv[first_file], "-j") == 0 && first_file + 1 < argc) {
+            thread_count = (size_t)strtoul(argv[first_file + 1], NULL, 10);
+            first_file += 2;
+        } else if (strcmp(argv[first_file], "--per-file") == 0) {
+            per_file = true;
+            first_file++;
+        } else if (strcmp(argv[first_file], "--packed") == 0) {
+            encoding = ENCODING_PACKED;
+            first_file++;
+        } else {
+            fprintf(stderr, "Unknown batch option: %s\n", argv[first_file]);
+            return 1;
+        }
+    }
+
+    size_t count = (size_t)(argc - first_file);
+    if (count == 0) {
+        fprintf(stderr, "Usage: --batch [-j N] [--per-file] [--packed] file.asm...\n");
+        return 1;
+    }
+
+    log_set_enabled(LOG_DEBUG, false);
+    log_set_enabled(LOG_INFO, false);
+
+    AssemblyImage *images = calloc(count, sizeof(AssemblyImage));
+    if (!images) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    BatchStats stats;
+    bool ok = batch_assemble((const char *const *)&argv[first_file], count, thread_count, encoding, images, &stats);
+    batch_print_stats(images, count, &stats, per_file);
+
+    batch_images_free(images, count);
+    free(images);
+    return ok ? 0 : 1;
+}
+
+/** Server stopped by SIGINT/SIGTERM in serve mode. */
+static JobServer *serving = NULL;
+
+static void stop_serving(int signal_number) {
+    (void)signal_number;
+    if (serving)
+        job_server_stop(serving);
+}
+
+/**
+ * @brief Daemon mode: serve emulator jobs on a Unix domain socket.
+ *
+ * Usage: 32bit_cpu_emulator --serve SOCKET [-j N] [-e ENGINE] [-n LIMIT]
+ *                           [--cache N] [--queue N] [-v]
+ *                           [--metrics HOST:PORT] [--metrics-file PATH] [--metrics-interval S]
+ *
+ * Runs until SIGINT or SIGTERM; see job_server.h for the model and
+ * job_protocol.h for the framing. `--metrics` serves Prometheus metrics
+ * (metrics.h) over HTTP and `--metrics-file` rewrites them to a textfile
+ * every S seconds (default 15).
+ *
+ * @param argc Number of arguments following "--serve".
+ * @param argv Arguments following "--serve".
+ * @return 0 after a clean shutdown, 1 on failure, 2 on a usage error.
+ */
+static int run_serve(int argc, char **argv) {
+    static const char *const usage =
+        "Usage: --serve SOCKET [-j N] [-e ENGINE] [-n LIMIT] [--cache N] [--queue N] [-v]\n"
+        "               [--metrics HOST:PORT] [--metrics-file PATH] [--metrics-interval S]\n";
+    JobServerConfig config;
+    job_server_config_default(&config);
+    const char *metrics_address = NULL;
+    const char *metrics_file = NULL;
+    unsigned metrics_interval = 0;
+    for (int i = 0; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "-v") == 0) {
+            config.verbose = true;
+            continue;
+        }
+        if (arg[0] != '-') {
+            config.socket_path = arg;
+            continue;
+        }
+        if (!value) {
+            fprintf(stderr, "Option %s needs a value\n", arg);
+            return 2;
+        }
+        if (strcmp(arg, "-j") == 0)
+            config.workers = (size_t)strtoul(value, NULL, 10);
+        else if (strcmp(arg, "-e") == 0 || strcmp(arg, "--engine") == 0)
+            config.engine = value;
+        else if (strcmp(arg, "-n") == 0 || strcmp(arg, "--limit") == 0)
+            config.max_instructions = strtoull(value, NULL, 0);
+        else if (strcmp(arg, "--cache") == 0)
+            config.cache_entries = (size_t)strtoul(value, NULL, 10);
+        else if (strcmp(arg, "--queue") == 0)
+            config.queue_capacity = (size_t)strtoul(value, NULL, 10);
+        else if (strcmp(arg, "--metrics") == 0)
+            metrics_address = value;
+        else if (strcmp(arg, "--metrics-file") == 0)
+            metrics_file = value;
+        else if (strcmp(arg, "--metrics-interval") == 0)
+            metrics_interval = (unsigned)strtoul(value, NULL, 10);
+        else {
+            fprintf(stderr, "Unknown serve option: %s\n", arg);
+            return 2;
+        }
+        i++;
+    }
+    if (!config.socket_path) {
+        fputs(usage, stderr);
+        return 2;
+    }
+
+    log_set_enabled(LOG_DEBUG, false);
+    MetricsExporter *exporter = NULL;
+    if (metrics_address || metrics_file) {
+        metrics_set_enabled(true);
+        exporter = metrics_exporter_start(metrics_address, metrics_file, metrics_interval);
+        if (!exporter)
+            return 1;
+    }
+    JobServer *server = job_server_create(&config);
+    if (!server) {
+        metrics_exporter_stop(exporter);
+        return 1;
+    }
+
+    serving = server;
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stop_serving;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    bool ok = job_server_run(server);
+    serving = NULL;
+    job_server_destroy(server);
+    metrics_exporter_stop(exporter);
+    return ok ? 0 : 1;
+}
+
+static bool has_suffix(const char *s, const char *suffix) {
+    size_t len = strlen(s);
+    size_t slen = strlen(suffix);
+    return len >= slen && strcmp(s + len - slen, suffix) == 0;
+}
+
+/** Fuzzer stopped by SIGINT/SIGTERM in fuzz mode. */
+static Fuzzer *fuzzing = NULL;
+
+static void stop_fuzzing(int signal_number) {
+    (void)signal_number;
+    if (fuzzing)
+        fuzzer_stop(fuzzing);
+}
+
+/**
+ * @brief Print one progress line of a fuzzing campaign.
+ */
+static void print_fuzz_progress(void *user, const FuzzStats *stats) {
+    (void)user;
+    fprintf(stderr, "%6.1f s: %llu execs (%.0f/s), corpus %u, edges %u, crashes %llu (%u kept), "
+                    "timeouts %llu (%u kept)\n",
+            stats->seconds, (unsigned long long)stats->execs,
+            stats->seconds > 0 ? (double)stats->execs / stats->seconds : 0.0, stats->kept[FUZZ_CORPUS],
+            stats->edges, (unsigned long long)stats->crashes, stats->kept[FUZZ_CRASH],
+            (unsigned long long)stats->timeouts, stats->kept[FUZZ_TIMEOUT]);
+}
+
+/**
+ * @brief Add every regular file of `dir` as a seed.
+ */
+static bool add_fuzz_seeds(Fuzzer *fuzzer, const char *dir) {
+    DIR *handle = opendir(dir);
+    if (!handle) {
+        log_write(LOG_ERROR, "Unable to open seed directory: %s", dir);
+        return false;
+    }
+    static uint32_t words[FUZZ_MAX_INPUT_WORDS];
+    char path[4096];
+    bool ok = true;
+    for (struct dirent *entry = readdir(handle); ok && entry; entry = readdir(handle)) {
+        if (entry->d_name[0] == '.')
+            continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        uint32_t count;
+        ok = fuzz_read_input(path, words, FUZZ_MAX_INPUT_WORDS, &count) && fuzzer_add_seed(fuzzer, words, count);
+    }
+    closedir(handle);
+    return ok;
+}
+
+/**
+ * @brief Fuzz mode: coverage-guided mutation of a program's input window.
+ *
+ * Usage: 32bit_cpu_emulator --fuzz --input ADDR:WORDS [-j N] [-n BUDGET]
+ *                           [--execs N] [--time S] [--seeds DIR] [--out DIR]
+ *                           [--seed N] [--packed] file.asm
+ *
+ * Runs until the exec or time limit, or SIGINT/SIGTERM; see fuzzer.h.
+ *
+ * @param argc Number of arguments following "--fuzz".
+ * @param argv Arguments following "--fuzz".
+ * @return 0 without crashes, 1 on failure, 2 on a usage error, 3 if crashes were found.
+ */
+static int run_fuzz(int argc, char **argv) {
+    static const char *const usage =
+        "Usage: --fuzz --input ADDR:WORDS [-j N] [-n BUDGET] [--execs N] [--time S] [--seeds DIR] [--out DIR]\n"
+        "              [--seed N] [--packed] file.asm\n";
+    FuzzConfig config;
+    fuzz_config_default(&config);
+    InstructionEncoding encoding = ENCODING_WIDE;
+    const char *path = NULL;
+    const char *seeds = NULL;
+    const char *out = NULL;
+    bool window_given = false;
+
+    for (int i = 0; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--packed") == 0) {
+            encoding = ENCODING_PACKED;
+            continue;
+        }
+        if (arg[0] != '-') {
+            path = arg;
+            continue;
+        }
+        if (!value) {
+            fprintf(stderr, "Option %s needs a value\n", arg);
+            return 2;
+        }
+        if (strcmp(arg, "--input") == 0) {
+            char *end = NULL;
+            config.input_address = (uint32_t)strtoul(value, &end, 0);
+            window_given = *end == ':';
+            if (window_given)
+                config.input_words = (uint32_t)strtoul(end + 1, NULL, 0);
+        } else if (strcmp(arg, "-j") == 0) {
+            config.workers = (size_t)strtoul(value, NULL, 10);
+        } else if (strcmp(arg, "-n") == 0 || strcmp(arg, "--limit") == 0) {
+            config.max_instructions = strtoull(value, NULL, 0);
+        } else if (strcmp(arg, "--execs") == 0) {
+            config.max_execs = strtoull(value, NULL, 0);
+        } else if (strcmp(arg, "--time") == 0) {
+            config.max_seconds = (uint32_t)strtoul(value, NULL, 0);
+        } else if (strcmp(arg, "--seed") == 0) {
+            config.seed = strtoull(value, NULL, 0);
+        } else if (strcmp(arg, "--seeds") == 0) {
+            seeds = value;
+        } else if (strcmp(arg, "--out") == 0) {
+            out = value;
+        } else {
+            fprintf(stderr, "Unknown fuzz option: %s\n", arg);
+            return 2;
+        }
+        i++;
+    }
+    if (!path || !window_given) {
+        fputs(usage, stderr);
+        return 2;
+    }
+
+    log_set_enabled(LOG_DEBUG, false);
+    log_set_enabled(LOG_INFO, false);
+    static RAM image;
+    ram_init(&image);
+    AssemblyRange range = has_suffix(path, ".asm") ? assemble_into(image.cells, RAM_SIZE, path, encoding)
+                                                   : image_read(path, image.cells, RAM_SIZE);
+    if (range.error) {
+        log_write(LOG_ERROR, "Failed to load %s", path);
+        return 1;
+    }
+
+    Fuzzer *fuzzer = fuzzer_create(&config, image.cells, range);
+    if (!fuzzer)
+        return 1;
+    if (seeds && !add_fuzz_seeds(fuzzer, seeds)) {
+        fuzzer_destroy(fuzzer);
+        return 1;
+    }
+
+    fuzzing = fuzzer;
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stop_fuzzing;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    bool ok = fuzzer_run(fuzzer, print_fuzz_progress, NULL);
+    fuzzing = NULL;
+    FuzzStats stats;
+    fuzzer_stats(fuzzer, &stats);
+    print_fuzz_progress(NULL, &stats);
+    if (ok && out)
+        ok = fuzzer_write_entries(fuzzer, out);
+    fuzzer_destroy(fuzzer);
+    if (!ok)
+        return 1;
+    return stats.crashes ? 3 : 0;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void print_usage(FILE *out, const char *argv0) {
+    fprintf(out,
+            "Usage: %s [options] file...\n"
+            "       %s --batch [-j N] [--per-file] [--packed] file.asm...\n"
+            "       %s --serve SOCKET [-j N] [-e ENGINE] [-n LIMIT] [--cache N] [--queue N] [-v]\n"
+            "             [--metrics HOST:PORT] [--metrics-file PATH] [--metrics-interval S]\n"
+            "       %s --fuzz --input ADDR:WORDS [-j N] [-n BUDGET] [--execs N] [--time S] [--seeds DIR]\n"
+            "             [--out DIR] [--seed N] [--packed] file.asm\n"
+            "       %s --debug [--packed] [--gdb ADDR] file\n"
+            "       %s --top [-j N] [-n LIMIT] [--interval MS] [--blocks N] [--packed] file...\n"
+            "Runs each file (.asm sources are assembled, anything else is loaded as a binary image).\n"
+            "  -e, --engine LIST    switch, threaded, predecoded, jit or timed; a comma-separated list runs\n"
+            "                       every engine and checks that they end in the same state\n"
+            "  -n, --limit N        stop after N instructions\n"
+            "  -O                   run the peephole optimizer before executing\n"
+            "      --packed         assemble with the packed encoding\n"
+            "  -q, --quiet          only print errors (and the dump, if requested)\n"
+            "  -v, --verbose        enable debug logging (every branch is logged)\n"
+            "      --stats          print instructions, time and MIPS per run to stderr\n"
+            "      --cycles         estimate guest cycles and print them per label region to stderr\n"
+            "      --cycle-model F  cost table for --cycles (implies it); see cycle_model.h\n"
+            "      --dcache SPEC    simulate a data cache (\"default\" or size=4k,line=32,ways=4,policy=lru|plru)\n"
+            "                       and print hit/miss rates per label and per PC to stderr\n"
+            "      --bpred LIST     simulate branch predictors (static, bimodal, gshare, tage or all) on JZ/JNZ\n"
+            "                       and print accuracy per predictor and per branch PC to stderr\n"
+            "      --mispredict-penalty N  cycles charged per misprediction (default 10)\n"
+            "      --coverage PATH  record AFL-style edge coverage and write the 64 KiB bitmap to PATH\n"
+            "      --coverage-shm ID  record edge coverage into System V shared memory segment ID\n"
+            "      --trace PATH     record branch outcomes and stores to PATH (inspect with trace_tool)\n"
+            "      --heatmap SPEC   count fetches, reads and writes per RAM bucket (\"default\" or\n"
+            "                       bucket=WORDS,sample=N,window=INSNS) and print heatmaps, the working set\n"
+            "                       over time and first touches to stderr\n"
+            "      --heatmap-file PATH  also write the heatmap as JSON to PATH (implies --heatmap default)\n"
+            "      --mmio LIST      run with memory-mapped devices, e.g. console@0xFF00,cycles@0xFE00\n"
+            "                       (console output goes to stdout)\n"
+            "      --cores N        also run on N CPUs sharing RAM (R7 = core index at start)\n"
+            "      --record LOG     with --cores, log the shared-memory interleaving to LOG\n"
+            "      --replay LOG     reproduce the multi-core run recorded in LOG and verify its final state\n"
+            "      --last-write A   run with checkpoints, then go back to the last store to address A\n"
+            "      --step-back N    run with checkpoints, then show the state N instructions before the end\n"
+            "      --dump FORMAT    final state as none, text, json or binary (default text, none with -q)\n"
+            "      --dump-file PATH write the dump to PATH instead of stdout\n"
+            "      --dump-ram A:B   include RAM words [A, B) in the dump (default: the program range)\n"
+            "      --list-engines   list the available engines\n"
+            "Exit status: 0 halt/end, 1 load error, 2 usage, 3 limit, 4 invalid instruction,\n"
+            "             5 division by zero, 6 fault, 7 engine error, 8 engine mismatch.\n",
+            argv0, argv0, argv0, argv0, argv0, argv0);
+}
+
+/**
+ * @brief Map a stop reason to the runner's exit code.
+ */
+static int exit_code_for(CpuStopReason reason) {
+    switch (reason) {
+        case CPU_STOP_HALT:
+        case CPU_STOP_END:                 return EXIT_RUN_OK;
+        case CPU_STOP_LIMIT:               return EXIT_RUN_LIMIT;
+        case CPU_STOP_INVALID_INSTRUCTION: return EXIT_RUN_INVALID_INSN;
+        case CPU_STOP_DIV_ZERO:            return EXIT_RUN_DIV_ZERO;
+        case CPU_STOP_FAULT:               return EXIT_RUN_FAULT;
+        default:                           return EXIT_RUN_ENGINE_ERROR;
+    }
+}
+
+/**
+ * @brief Debug mode: run one program under the interactive debugger.
+ *
+ * Usage: 32bit_cpu_emulator --debug [--packed] [--gdb ADDR] file
+ *
+ * Commands are read from stdin (see debugger_command()); labels of .asm
+ * sources can be used wherever an address is expected. With `--gdb` the
+ * session is served to one GDB connection on ADDR instead (see
+ * gdb_stub_serve()).
+ *
+ * @return 0 if the program is still running or ended normally when the
+ *         debugger quits, otherwise the exit code of how it stopped.
+ */
+static int run_debug(int argc, char **argv) {
+    InstructionEncoding encoding = ENCODING_WIDE;
+    const char *path = NULL;
+    const char *gdb_address = NULL;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--packed") == 0) {
+            encoding = ENCODING_PACKED;
+        } else if (strcmp(argv[i], "--gdb") == 0 && i + 1 < argc) {
+            gdb_address = argv[++i];
+        } else if (argv[i][0] == '-' || path) {
+            fputs("Usage: --debug [--packed] [--gdb ADDR] file\n", stderr);
+            return EXIT_RUN_USAGE;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (!path) {
+        fputs("Usage: --debug [--packed] [--gdb ADDR] file\n", stderr);
+        return EXIT_RUN_USAGE;
+    }
+
+    log_set_enabled(LOG_DEBUG, false);
+    log_set_enabled(LOG_INFO, false);
+    static RAM image;
+    LabelTable labels;
+    label_table_init(&labels);
+    AssemblyRange range = has_suffix(path, ".asm")
+                        ? assemble_into_labels(image.cells, RAM_SIZE, path, encoding, &labels)
+                        : image_read(path, image.cells, RAM_SIZE);
+    if (range.error) {
+        log_write(LOG_ERROR, "Failed to load %s", path);
+        return EXIT_RUN_LOAD_ERROR;
+    }
+    Debugger *dbg = debugger_create(image.cells, range);
+    if (!dbg) {
+        label_table_free(&labels);
+        return EXIT_RUN_LOAD_ERROR;
+    }
+
+    bool served = true;
+    if (gdb_address) {
+        fprintf(stderr, "Waiting for GDB on %s\n", gdb_address);
+        served = gdb_stub_serve(dbg, gdb_address);
+    } else {
+        debugger_repl(dbg, &labels, stdin, stdout);
+    }
+    const CPU *cpu = debugger_cpu(dbg);
+    int code = !served ? EXIT_RUN_ENGINE_ERROR
+             : cpu->running ? EXIT_RUN_OK : exit_code_for(cpu->stop_reason);
+    debugger_destroy(dbg);
+    label_table_free(&labels);
+    return code;
+}
+
+/**
+ * @struct TopInstance
+ * @brief One program instance of `--top`, run on its own thread.
+ */
+typedef struct {
+    Emulator *emu;
+    StatePublisher publisher;
+    EmuResult result;
+    char name[64];
+    pthread_t thread;
+    atomic_bool done;
+} TopInstance;
+
+static void *top_worker(void *arg) {
+    TopInstance *instance = arg;
+    emu_run(instance->emu, NULL, &instance->result);
+    atomic_store(&instance->done, true);
+    return NULL;
+}
+
+/**
+ * @brief Top mode: run programs concurrently and show their live state.
+ *
+ * Usage: 32bit_cpu_emulator --top [-j N] [-n LIMIT] [--interval MS] [--blocks N] [--packed] file...
+ *
+ * Every file is loaded into N Emulator instances (default 1), each run
+ * once on its own thread with a StatePublisher (observer.h). The main
+ * thread redraws a state_top_print() table every MS milliseconds (default
+ * 1000) without pausing them, and prints a final one when all are done.
+ *
+ * @return The highest exit code of the runs (see exit_code_for()).
+ */
+static int run_top(int argc, char **argv) {
+    static const char *const usage =
+        "Usage: --top [-j N] [-n LIMIT] [--interval MS] [--blocks N] [--packed] file...\n";
+    EmuConfig config;
+    emu_config_default(&config);
+    size_t copies = 1;
+    uint32_t interval_ms = 1000;
+    uint32_t blocks = 0;
+    int file_count = 0;
+
+    for (int i = 0; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--packed") == 0) {
+            config.encoding = ENCODING_PACKED;
+            continue;
+        }
+        if (arg[0] != '-') {
+            argv[file_count++] = argv[i];
+            continue;
+        }
+        if (!value) {
+            fprintf(stderr, "Option %s needs a value\n", arg);
+            return EXIT_RUN_USAGE;
+        }
+        if (strcmp(arg, "-j") == 0) {
+            copies = (size_t)strtoul(value, NULL, 10);
+        } else if (strcmp(arg, "-n") == 0 || strcmp(arg, "--limit") == 0) {
+            config.max_instructions = strtoull(value, NULL, 0);
+        } else if (strcmp(arg, "--interval") == 0) {
+            interval_ms = (uint32_t)strtoul(value, NULL, 10);
+        } else if (strcmp(arg, "--blocks") == 0) {
+            blocks = (uint32_t)strtoul(value, NULL, 0);
+        } else {
+            fprintf(stderr, "Unknown top option: %s\n", arg);
+            return EXIT_RUN_USAGE;
+        }
+        i++;
+    }
+    if (file_count == 0 || copies == 0 || interval_ms == 0) {
+        fputs(usage, stderr);
+        return EXIT_RUN_USAGE;
+    }
+
+    log_set_enabled(LOG_DEBUG, false);
+    log_set_enabled(LOG_INFO, false);
+    size_t count = (size_t)file_count * copies;
+    TopInstance *instances = calloc(count, sizeof(TopInstance));
+    StateTopRow *rows = calloc(count, sizeof(StateTopRow));
+    int code = EXIT_RUN_OK;
+    size_t started = 0;
+    if (!instances || !rows) {
+        log_write(LOG_ERROR, "Out of memory");
+        code = EXIT_RUN_LOAD_ERROR;
+        goto out;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        TopInstance *instance = &instances[i];
+        const char *path = argv[i / copies];
+        const char *slash = strrchr(path, '/');
+        snprintf(instance->name, sizeof(instance->name), copies > 1 ? "%s#%zu" : "%s",
+                 slash ? slash + 1 : path, i % copies);
+        state_publisher_init(&instance->publisher, blocks);
+        atomic_init(&instance->done, false);
+        instance->emu = emu_create(&config);
+        if (!instance->emu || !emu_load_file(instance->emu, path)) {
+            log_write(LOG_ERROR, "Failed to load %s", path);
+            code = EXIT_RUN_LOAD_ERROR;
+            goto out;
+        }
+        emu_set_publisher(instance->emu, &instance->publisher);
+        rows[i].name = instance->name;
+        rows[i].publisher = &instance->publisher;
+    }
+    for (; started < count; started++) {
+        if (pthread_create(&instances[started].thread, NULL, top_worker, &instances[started]) != 0) {
+            log_write(LOG_ERROR, "Unable to start thread %zu", started);
+            code = EXIT_RUN_ENGINE_ERROR;
+            break;
+        }
+    }
+
+    bool redraw = isatty(STDOUT_FILENO);
+    const struct timespec pause = { interval_ms / 1000, (long)(interval_ms % 1000) * 1000000L };
+    for (;;) {
+        size_t finished = 0;
+        for (size_t i = 0; i < started; i++)
+            finished += atomic_load(&instances[i].done);
+        if (finished == started)
+            break;
+        if (redraw)
+            fputs("\033[H\033[J", stdout);
+        state_top_print(stdout, rows, started);
+        if (!redraw)
+            putchar('\n');
+        fflush(stdout);
+        nanosleep(&pause, NULL);
+    }
+    if (redraw)
+        fputs("\033[H\033[J", stdout);
+    state_top_print(stdout, rows, started);
+
+out:
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(instances[i].thread, NULL);
+        int run_code = exit_code_for(instances[i].result.stop);
+        if (run_code > code)
+            code = run_code;
+    }
+    for (size_t i = 0; instances && i < count; i++)
+        emu_destroy(instances[i].emu);
+    free(rows);
+    free(instances);
+    return code;
+}
+
+/**
+ * @brief Parse a comma-separated engine list into `options`.
+ */
+static bool parse_engines(const char *list, RunOptions *options) {
+    char buffer[256];
+    strncpy(buffer, list, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    options->engine_count = 0;
+    char *save = NULL;
+    for (char *name = strtok_r(buffer, ",", &save); name; name = strtok_r(NULL, ",", &save)) {
+        const ExecEngine *engine = engine_find(name);
+        if (!engine)
+            return false;
+        if (options->engine_count == MAX_RUN_ENGINES) {
+            log_write(LOG_ERROR, "At most %d engines can be compared", MAX_RUN_ENGINES);
+            return false;
+        }
+        options->engines[options->engine_count++] = engine;
+    }
+    return options->engine_count > 0;
+}
+
+/**
+ * @brief Parse "START:END" (decimal or 0x hex) into a RAM range.
+ */
+static bool parse_ram_range(const char *text, RunOptions *options) {
+    char *colon = NULL;
+    unsigned long start = strtoul(text, &colon, 0);
+    if (!colon || *colon != ':') {
+        log_write(LOG_ERROR, "Expected --dump-ram START:END, got %s", text);
+        return false;
+    }
+    char *end_ptr = NULL;
+    unsigned long end = strtoul(colon + 1, &end_ptr, 0);
+    if (*end_ptr != '\0' || start > end || end > RAM_SIZE) {
+        log_write(LOG_ERROR, "Invalid RAM range %s (must satisfy START <= END <= %u)", text, RAM_SIZE);
+        return false;
+    }
+    options->dump_ram = true;
+    options->ram_start = (uint32_t)start;
+    options->ram_end = (uint32_t)end;
+    return true;
+}
+
+/**
+ * @brief Return true if two runs ended in exactly the same state.
+ */
+static bool same_final_state(const CPU *a, const RAM *ram_a, const CPU *b, const RAM *ram_b) {
+    return a->pc == b->pc
+        && a->zero_flag == b->zero_flag
+        && a->negative_flag == b->negative_flag
+        && a->running == b->running
+        && a->stop_reason == b->stop_reason
+        && a->instructions_retired == b->instructions_retired
+        && memcmp(a->registers, b->registers, sizeof(a->registers)) == 0
+        && memcmp(a->address_registers, b->address_registers, sizeof(a->address_registers)) == 0
+        && memcmp(ram_a->cells, ram_b->cells, sizeof(ram_a->cells)) == 0;
+}
+
+/**
+ * @brief Run the loaded image with the timed engine and print cycles per label region.
  *
- * @return exit code 0 on success.
+ * @return Exit code of the timed run.
  */
-int main(void) {
+static int report_cycles(const char *path, const RunOptions *options, const RAM *image, AssemblyRange range,
+                         const LabelTable *labels) {
+    static RAM ram;
+    CodeRegionMap regions;
+    CycleProfile profile;
+    if (!code_regions_build(&regions, range, labels))
+        return EXIT_RUN_LOAD_ERROR;
+    if (!cycle_profile_init(&profile, &regions)) {
+        code_regions_free(&regions);
+        return EXIT_RUN_LOAD_ERROR;
+    }
 
-    printf("=== CPU Emulator Starting ===\n");
-    printf("Hello, World!\n\n");
+    CPU cpu;
+    memcpy(ram.cells, image->cells, sizeof(image->cells));
+    cpu_init(&cpu);
+    CpuStopReason reason = cpu_execute_timed(&cpu, &ram, range, options->limit, &options->cycle_model, &profile);
+    fprintf(stderr, "%s [timed]: %s, ", path, cpu_stop_reason_name(reason));
+    cycle_profile_print(&profile, &options->cycle_model, &cpu, stderr);
 
-    printf("Step 1: Initializing RAM...\n");
-    RAM ram;
-    ram_init(&ram);
-    printf("RAM initialized successfully (size: %u cells).\n\n", RAM_SIZE);
+    cycle_profile_free(&profile);
+    code_regions_free(&regions);
+    return exit_code_for(reason);
+}
+
+/**
+ * @brief Run the loaded image with the data cache model and print its statistics.
+ *
+ * @return Exit code of the cached run.
+ */
+static int report_dcache(const char *path, const RunOptions *options, const RAM *image, AssemblyRange range,
+                         const LabelTable *labels) {
+    static RAM ram;
+    CodeRegionMap regions;
+    CacheSim cache;
+    if (!code_regions_build(&regions, range, labels))
+        return EXIT_RUN_LOAD_ERROR;
+    if (!cache_sim_init(&cache, &options->cache_config, range)) {
+        code_regions_free(&regions);
+        return EXIT_RUN_LOAD_ERROR;
+    }
 
-    printf("Step 2: Initializing CPU...\n");
     CPU cpu;
+    memcpy(ram.cells, image->cells, sizeof(image->cells));
     cpu_init(&cpu);
-    printf("CPU initialized successfully.\n");
-    printf("Initial CPU state:\n");
-    cpu_print(cpu);
-    printf("\n");
-
-    const char *input_file = "/home/dev/CLionProjects/32bit-cpu-emulator/asm-programs/add.asm";
-    printf("Step 3: Assembling program from file: %s\n", input_file);
-    AssemblyRange assembly_range = assemble(&ram, &cpu, input_file);
-    if (assembly_range.error) {
-        printf("ERROR: Assembly failed. Exiting.\n");
-        ram_free(&ram, 0, 0); // Free any partial allocation
-        return 1;
+    CpuStopReason reason = cpu_execute_cached(&cpu, &ram, range, options->limit, &cache);
+    cache_sim_flush(&cache);
+    fprintf(stderr, "%s [cached]: %s, ", path, cpu_stop_reason_name(reason));
+    cache_sim_print(&cache, &regions, image->cells, 10, stderr);
+
+    cache_sim_free(&cache);
+    code_regions_free(&regions);
+    return exit_code_for(reason);
+}
+
+/**
+ * @brief Run the loaded image with the branch predictor models and print their accuracy.
+ *
+ * @return Exit code of the predicted run.
+ */
+static int report_branches(const char *path, const RunOptions *options, const RAM *image, AssemblyRange range) {
+    static RAM ram;
+    BranchSim branches;
+    if (!branch_sim_init(&branches, options->predictors, options->predictor_count, options->mispredict_penalty,
+                         range))
+        return EXIT_RUN_LOAD_ERROR;
+
+    CPU cpu;
+    memcpy(ram.cells, image->cells, sizeof(image->cells));
+    cpu_init(&cpu);
+    CpuStopReason reason = cpu_execute_predicted(&cpu, &ram, range, options->limit, &branches);
+    fprintf(stderr, "%s [predicted]: %s, ", path, cpu_stop_reason_name(reason));
+    branch_sim_print(&branches, image->cells, 10, stderr);
+
+    branch_sim_free(&branches);
+    return exit_code_for(reason);
+}
+
+/**
+ * @brief Run the loaded image with edge coverage and export the bitmap.
+ *
+ * With --coverage-shm the counts are added to the shared segment as they
+ * happen; with --coverage the bitmap is written to the file afterwards.
+ *
+ * @return Exit code of the covered run.
+ */
+static int report_coverage(const char *path, const RunOptions *options, const RAM *image, AssemblyRange range) {
+    static RAM ram;
+    CoverageMap coverage;
+    bool ready = options->coverage_shm >= 0 ? coverage_map_attach_shm(&coverage, options->coverage_shm)
+                                            : coverage_map_init(&coverage);
+    if (!ready)
+        return EXIT_RUN_LOAD_ERROR;
+
+    CPU cpu;
+    memcpy(ram.cells, image->cells, sizeof(image->cells));
+    cpu_init(&cpu);
+    CpuStopReason reason = cpu_execute_covered(&cpu, &ram, range, options->limit, &coverage);
+    int code = exit_code_for(reason);
+    fprintf(stderr, "%s [covered]: %s, %u of %u bitmap entries hit\n", path, cpu_stop_reason_name(reason),
+            coverage_map_count(&coverage), COVERAGE_MAP_SIZE);
+    if (options->coverage_path && !coverage_map_write(&coverage, options->coverage_path))
+        code = code > EXIT_RUN_LOAD_ERROR ? code : EXIT_RUN_LOAD_ERROR;
+
+    coverage_map_free(&coverage);
+    return code;
+}
+
+/**
+ * @brief Run the loaded image with the trace recorder and report the trace size.
+ *
+ * @return Exit code of the traced run.
+ */
+static int report_trace(const char *path, const RunOptions *options, const RAM *image, AssemblyRange range) {
+    static RAM ram;
+    CPU cpu;
+    TraceWriter trace;
+    memcpy(ram.cells, image->cells, sizeof(image->cells));
+    cpu_init(&cpu);
+    if (!trace_writer_open(&trace, options->trace_path, &cpu, &ram, range))
+        return EXIT_RUN_LOAD_ERROR;
+
+    CpuStopReason reason = cpu_execute_traced(&cpu, &ram, range, options->limit, &trace);
+    int code = exit_code_for(reason);
+    if (!trace_writer_close(&trace, &cpu))
+        return code > EXIT_RUN_LOAD_ERROR ? code : EXIT_RUN_LOAD_ERROR;
+    fprintf(stderr, "%s [traced]: %s, %llu instructions, %llu branches, %llu writes, %llu bytes"
+            " (%.3f bytes/instruction)\n", path, cpu_stop_reason_name(reason), (unsigned long long)cpu.instructions_retired,
+            (unsigned long long)trace.branches, (unsigned long long)trace.writes, (unsigned long long)trace.bytes,
+            cpu.instructions_retired ? (double)trace.bytes / (double)cpu.instructions_retired : 0.0);
+    return code;
+}
+
+/**
+ * @brief Run the loaded image with the memory heatmap and print it.
+ *
+ * @return Exit code of the profiled run.
+ */
+static int report_heatmap(const char *path, const RunOptions *options, const RAM *image, AssemblyRange range) {
+    static RAM ram;
+    MemoryHeatmap heatmap;
+    if (!heatmap_init(&heatmap, &options->heatmap_config))
+        return EXIT_RUN_LOAD_ERROR;
+
+    CPU cpu;
+    memcpy(ram.cells, image->cells, sizeof(image->cells));
+    cpu_init(&cpu);
+    CpuStopReason reason = cpu_execute_heatmapped(&cpu, &ram, range, options->limit, &heatmap);
+    heatmap_finish(&heatmap, cpu.instructions_retired);
+    int code = exit_code_for(reason);
+    fprintf(stderr, "%s [heatmap]: %s, ", path, cpu_stop_reason_name(reason));
+    heatmap_print(&heatmap, 10, stderr);
+    if (options->heatmap_path && !heatmap_write_json(&heatmap, options->heatmap_path))
+        code = code > EXIT_RUN_LOAD_ERROR ? code : EXIT_RUN_LOAD_ERROR;
+
+    heatmap_free(&heatmap);
+    return code;
+}
+
+/**
+ * @brief Run the loaded image with the devices of --mmio mapped; the console writes to stdout.
+ *
+ * @return Exit code of the mapped run.
+ */
+static int report_mmio(const char *path, const RunOptions *options, const RAM *image, AssemblyRange range) {
+    static RAM ram;
+    static MmioConsole console;
+    MmioCycleCounter counter;
+    MmioBus bus;
+    mmio_console_init(&console, stdout);
+    mmio_cycle_counter_init(&counter);
+    mmio_bus_init(&bus);
+    if (!mmio_bus_parse(&bus, options->mmio_spec, &console, &counter))
+        return EXIT_RUN_USAGE;
+
+    CPU cpu;
+    memcpy(ram.cells, image->cells, sizeof(image->cells));
+    cpu_init(&cpu);
+    CpuStopReason reason = cpu_execute_mapped(&cpu, &ram, range, options->limit, &bus);
+    int code = exit_code_for(reason);
+    if (!mmio_console_flush(&console))
+        code = code > EXIT_RUN_LOAD_ERROR ? code : EXIT_RUN_LOAD_ERROR;
+    if (!options->quiet)
+        fprintf(stderr, "%s [mapped]: %s, %llu instructions, %llu console bytes\n", path, cpu_stop_reason_name(reason),
+                (unsigned long long)cpu.instructions_retired, (unsigned long long)console.written);
+    return code;
+}
+
+/**
+ * @brief Print where a time-travel session stands: instruction, PC, next instruction and registers.
+ */
+static void print_time_travel_position(const char *path, const char *what, const CPU *cpu, const RAM *ram,
+                                       AssemblyRange range, uint32_t ram_start, uint32_t ram_end) {
+    DecodedInstruction insn;
+    char text[64] = "???";
+    if (decode_instruction(ram->cells, RAM_SIZE, cpu->pc, range.encoding, &insn))
+        format_instruction(&insn, text, sizeof(text));
+    fprintf(stderr, "%s [time travel]: %s: instruction %llu, PC %08X: %s\n", path, what,
+            (unsigned long long)cpu->instructions_retired, cpu->pc, text);
+    state_dump_write(stderr, DUMP_TEXT, path, "time travel", cpu, ram, ram_start, ram_end);
+}
+
+/**
+ * @brief Run the loaded image with checkpoints, then step back or find the last write to an address.
+ *
+ * @return Exit code of the forward run.
+ */
+static int report_time_travel(const char *path, const RunOptions *options, const RAM *image, AssemblyRange range) {
+    static RAM ram;
+    CPU cpu;
+    memcpy(ram.cells, image->cells, sizeof(image->cells));
+    cpu_init(&cpu);
+    TimeTravel *tt = tt_create(&cpu, &ram, range, 0, 0);
+    if (!tt)
+        return EXIT_RUN_LOAD_ERROR;
+
+    uint64_t start = now_ns();
+    CpuStopReason reason = tt_run(tt, options->limit);
+    double seconds = (double)(now_ns() - start) / 1e9;
+    uint64_t end = cpu.instructions_retired;
+    TimeTravelStats stats;
+    tt_stats(tt, &stats);
+    fprintf(stderr, "%s [time travel]: %s after %llu instructions in %.3f s, %u checkpoints (%zu KiB, every %llu)\n",
+            path, cpu_stop_reason_name(reason), (unsigned long long)end, seconds, stats.checkpoints,
+            stats.bytes / 1024, (unsigned long long)stats.interval);
+
+    if (options->step_back) {
+        tt_step_back(tt, options->step_back);
+        char what[64];
+        snprintf(what, sizeof(what), "%llu before the end", (unsigned long long)(end - cpu.instructions_retired));
+        print_time_travel_position(path, what, &cpu, &ram, range, 0, 0);
+        tt_seek(tt, end);
+    }
+    if (options->last_write_given) {
+        uint64_t at;
+        if (tt_last_write(tt, options->last_write, &at)) {
+            char what[64];
+            snprintf(what, sizeof(what), "last write to 0x%X", options->last_write);
+            print_time_travel_position(path, what, &cpu, &ram, range, options->last_write, options->last_write + 1);
+        } else {
+            fprintf(stderr, "%s [time travel]: no instruction wrote to 0x%X\n", path, options->last_write);
+        }
+    }
+    tt_destroy(tt);
+    return exit_code_for(reason);
+}
+
+/**
+ * @brief Run the loaded image on several cores sharing RAM, optionally recording or replaying it.
+ *
+ * @return Highest exit code of the cores, EXIT_RUN_ENGINE_MISMATCH if a
+ *         replay did not reproduce its recording.
+ */
+static int report_smp(const char *path, const RunOptions *options, const RAM *image, AssemblyRange range) {
+    static RAM ram;
+    static SmpLog log;
+    CPU cpus[SMP_MAX_CORES];
+    SmpMode mode = options->replay_path ? SMP_REPLAY : options->record_path ? SMP_RECORD : SMP_FREE;
+    if (mode == SMP_REPLAY && !smp_log_read(&log, options->replay_path))
+        return EXIT_RUN_LOAD_ERROR;
+
+    memcpy(ram.cells, image->cells, sizeof(image->cells));
+    if (mode == SMP_REPLAY && !smp_log_matches(&log, &ram)) {
+        /* A log of another program is a bad input, not a divergence. */
+        smp_log_free(&log);
+        return EXIT_RUN_LOAD_ERROR;
+    }
+    uint64_t start = now_ns();
+    bool ok = smp_run(&ram, range, options->cores, options->limit, mode, &log, cpus);
+    double seconds = (double)(now_ns() - start) / 1e9;
+    uint32_t cores = mode == SMP_FREE || mode == SMP_RECORD ? options->cores : log.cores;
+
+    int code = EXIT_RUN_OK;
+    for (uint32_t i = 0; i < cores && (ok || mode != SMP_REPLAY); i++) {
+        int core_code = exit_code_for(cpus[i].stop_reason);
+        code = core_code > code ? core_code : code;
+        fprintf(stderr, "%s [core %u]: %s, %llu instructions\n", path, i, cpu_stop_reason_name(cpus[i].stop_reason),
+                (unsigned long long)cpus[i].instructions_retired);
+    }
+    if (mode == SMP_FREE && ok) {
+        fprintf(stderr, "%s [free]: %.3f s, final state %016llx\n", path, seconds,
+                (unsigned long long)smp_state_hash(&ram, cpus, cores));
+    } else if (mode == SMP_RECORD && ok) {
+        fprintf(stderr, "%s [record]: %zu ownership transfers in %.3f s, final state %016llx\n", path,
+                smp_log_transfers(&log), seconds, (unsigned long long)log.final_hash);
+        if (!smp_log_write(&log, options->record_path))
+            code = code > EXIT_RUN_LOAD_ERROR ? code : EXIT_RUN_LOAD_ERROR;
+    } else if (mode == SMP_REPLAY && ok) {
+        fprintf(stderr, "%s [replay]: reproduced %zu ownership transfers in %.3f s, final state %016llx\n", path,
+                smp_log_transfers(&log), seconds, (unsigned long long)log.final_hash);
+    } else if (!ok) {
+        code = mode == SMP_REPLAY ? EXIT_RUN_ENGINE_MISMATCH : EXIT_RUN_ENGINE_ERROR;
+    }
+    smp_log_free(&log);
+    return code;
+}
+
+/**
+ * @brief Load, optionally optimize and run one file with every selected engine.
+ *
+ * @return Exit code for this file (see the EXIT_RUN_* values).
+ */
+static int run_file(const char *path, const RunOptions *options, FILE *dump_out) {
+    /* The loaded image stays pristine; every engine starts from a copy. */
+    static RAM image;
+    static RAM ram;
+    static RAM first_ram;
+    ram_init(&image);
+
+    LabelTable labels;
+    label_table_init(&labels);
+    AssemblyRange range;
+    if (!has_suffix(path, ".asm"))
+        range = image_read(path, image.cells, RAM_SIZE);
+    else if (options->cycles || options->dcache)
+        range = assemble_into_labels(image.cells, RAM_SIZE, path, options->encoding, &labels);
+    else
+        range = assemble_into(image.cells, RAM_SIZE, path, options->encoding);
+    if (range.error) {
+        log_write(LOG_ERROR, "Failed to load %s", path);
+        return EXIT_RUN_LOAD_ERROR;
+    }
+    if (options->optimize) {
+        OptimizerStats opt_stats;
+        if (!optimize_program(&image, &range, &opt_stats)) {
+            log_write(LOG_ERROR, "Optimization of %s failed", path);
+            label_table_free(&labels);
+            return EXIT_RUN_LOAD_ERROR;
+        }
+        /* The optimizer moves code, so source labels no longer mark it. */
+        label_table_free(&labels);
+        if (!options->quiet)
+            optimizer_print_stats(&opt_stats);
+    }
+
+    int code = EXIT_RUN_OK;
+    CPU first_cpu;
+    for (size_t e = 0; e < options->engine_count; e++) {
+        const ExecEngine *engine = options->engines[e];
+        if (options->limit && !engine->supports_limit) {
+            log_write(LOG_ERROR, "Engine %s does not support --limit", engine->name);
+            code = code > EXIT_RUN_USAGE ? code : EXIT_RUN_USAGE;
+            continue;
+        }
+
+        CPU cpu;
+        memcpy(ram.cells, image.cells, sizeof(image.cells));
+        cpu_init(&cpu);
+        uint64_t t0 = now_ns();
+        CpuStopReason reason = engine->run(&cpu, &ram, range, options->limit);
+        uint64_t elapsed = now_ns() - t0;
+
+        int run_code = exit_code_for(reason);
+        if (run_code > code)
+            code = run_code;
+
+        if (options->stats) {
+            double mips = elapsed ? (double)cpu.instructions_retired * 1e3 / (double)elapsed : 0.0;
+            fprintf(stderr, "%s [%s]: %s, %llu instructions, %.3f ms, %.1f MIPS\n", path, engine->name,
+                    cpu_stop_reason_name(reason), (unsigned long long)cpu.instructions_retired,
+                    (double)elapsed / 1e6, mips);
+        }
+
+        if (e == 0) {
+            first_cpu = cpu;
+            if (options->engine_count > 1)
+                memcpy(first_ram.cells, ram.cells, sizeof(ram.cells));
+            uint32_t ram_start = options->dump_ram ? options->ram_start : range.start_address;
+            uint32_t ram_end = options->dump_ram ? options->ram_end : range.end_address;
+            if (!state_dump_write(dump_out, options->dump, path, engine->name, &cpu, &ram, ram_start, ram_end))
+                code = code > EXIT_RUN_LOAD_ERROR ? code : EXIT_RUN_LOAD_ERROR;
+        } else if (!same_final_state(&first_cpu, &first_ram, &cpu, &ram)) {
+            log_write(LOG_ERROR, "%s: engine %s ended in a different state than %s", path, engine->name,
+                      options->engines[0]->name);
+            code = EXIT_RUN_ENGINE_MISMATCH;
+        }
+    }
+
+    if (options->cycles) {
+        int cycles_code = report_cycles(path, options, &image, range, &labels);
+        if (cycles_code > code)
+            code = cycles_code;
+    }
+    if (options->dcache) {
+        int dcache_code = report_dcache(path, options, &image, range, &labels);
+        if (dcache_code > code)
+            code = dcache_code;
     }
-    printf("Assembly completed successfully.\n");
-    printf("Assembled program range: start=%u, end=%u\n", assembly_range.start_address, assembly_range.end_address);
-    printf("RAM dump of assembled program:\n");
-    uint32_t start = assembly_range.start_address;
-    uint32_t end = assembly_range.end_address;
-    for (size_t i = start; i < end; i++) {
-        printf("RAM[%zu] = 0x%04X\n", i, (unsigned)ram.cells[i]);
-    }
-    printf("\n");
-
-    printf("Step 4: Executing the assembled program...\n");
-    cpu_run(&cpu, &ram, assembly_range);
-    printf("Program execution completed.\n");
-    printf("Final CPU state:\n");
-    cpu_print(cpu);
-    printf("\n");
-
-    printf("Step 5: Cleaning up RAM...\n");
-    ram_free(&ram, start, end);
-    printf("RAM freed successfully.\n");
-
-    printf("=== Emulation Complete ===\n");
-    return 0;
-}
\ No newline at end of file
+    if (options->predictor_count) {
+        int branch_code = report_branches(path, options, &image, range);
+        if (branch_code > code)
+            code = branch_code;
+    }
+    if (options->coverage_path || options->coverage_shm >= 0) {
+        int coverage_code = report_coverage(path, options, &image, range);
+        if (coverage_code > code)
+            code = coverage_code;
+    }
+    if (options->trace_path) {
+        int trace_code = report_trace(path, options, &image, range);
+        if (trace_code > code)
+            code = trace_code;
+    }
+    if (options->heatmap) {
+        int heatmap_code = report_heatmap(path, options, &image, range);
+        if (heatmap_code > code)
+            code = heatmap_code;
+    }
+    if (options->mmio_spec) {
+        int mmio_code = report_mmio(path, options, &image, range);
+        if (mmio_code > code)
+            code = mmio_code;
+    }
+    if (options->time_travel) {
+        int time_travel_code = report_time_travel(path, options, &image, range);
+        if (time_travel_code > code)
+            code = time_travel_code;
+    }
+    if (options->cores || options->replay_path) {
+        int smp_code = report_smp(path, options, &image, range);
+        if (smp_code > code)
+            code = smp_code;
+    }
+    label_table_free(&labels);
+    return code;
+}
+
+/**
+ * @brief Command-line runner for the CPU emulator.
+ *
+ * Runs every input file with the selected engine(s) and reports the final
+ * state in the requested dump format; see print_usage() for the options
+ * and the EXIT_RUN_* values for the exit status. When invoked as
+ * `--batch ...` it assembles the given files concurrently instead (see
+ * run_batch()); `--serve ...` runs the job server (see run_serve()),
+ * `--fuzz ...` fuzzes a program's input window (see run_fuzz()),
+ * `--debug ...` runs one under the interactive debugger (see run_debug())
+ * and `--top ...` runs several concurrently under a live view (see run_top()).
+ *
+ * @return One of the EXIT_RUN_* codes.
+ */
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0) {
+        return run_batch(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--serve") == 0) {
+        return run_serve(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--fuzz") == 0) {
+        return run_fuzz(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--debug") == 0) {
+        return run_debug(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--top") == 0) {
+        return run_top(argc - 2, argv + 2);
+    }
+
+    RunOptions options = {
+        .engines = { engine_default() },
+        .engine_count = 1,
+        .encoding = ENCODING_WIDE,
+        .dump = DUMP_TEXT,
+    };
+    cycle_model_default(&options.cycle_model);
+    heatmap_config_default(&options.heatmap_config);
+    options.mispredict_penalty = BPRED_DEFAULT_PENALTY;
+    options.coverage_shm = -1;
+    bool dump_given = false;
+    bool verbose = false;
+    bool options_done = false;
+    const char *program = argv[0];
+    int file_count = 0; /* file operands are compacted to the front of argv */
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (options_done || arg[0] != '-' || arg[1] == '\0') {
+            argv[file_count++] = argv[i];
+            continue;
+        }
+        if (strcmp(arg, "--") == 0) {
+            options_done = true;
+            continue;
+        }
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        bool takes_value = strcmp(arg, "-e") == 0 || strcmp(arg, "--engine") == 0
+                        || strcmp(arg, "-n") == 0 || strcmp(arg, "--limit") == 0
+                        || strcmp(arg, "--dump") == 0 || strcmp(arg, "--dump-file") == 0
+                        || strcmp(arg, "--dump-ram") == 0 || strcmp(arg, "--cycle-model") == 0
+                        || strcmp(arg, "--dcache") == 0 || strcmp(arg, "--bpred") == 0
+                        || strcmp(arg, "--mispredict-penalty") == 0 || strcmp(arg, "--coverage") == 0
+                        || strcmp(arg, "--coverage-shm") == 0 || strcmp(arg, "--trace") == 0
+                        || strcmp(arg, "--heatmap") == 0 || strcmp(arg, "--heatmap-file") == 0
+                        || strcmp(arg, "--mmio") == 0
+                        || strcmp(arg, "--cores") == 0 || strcmp(arg, "--record") == 0
+                        || strcmp(arg, "--replay") == 0 || strcmp(arg, "--last-write") == 0
+                        || strcmp(arg, "--step-back") == 0;
+        if (takes_value && !value) {
+            fprintf(stderr, "Option %s needs a value\n", arg);
+            return EXIT_RUN_USAGE;
+        }
+
+        if (strcmp(arg, "-e") == 0 || strcmp(arg, "--engine") == 0) {
+            if (!parse_engines(value, &options))
+                return EXIT_RUN_USAGE;
+        } else if (strcmp(arg, "--aot") == 0) {
+            options.engines[0] = engine_find("jit");
+            options.engine_count = 1;
+        } else if (strcmp(arg, "-n") == 0 || strcmp(arg, "--limit") == 0) {
+            options.limit = strtoull(value, NULL, 0);
+        } else if (strcmp(arg, "-O") == 0) {
+            options.optimize = true;
+        } else if (strcmp(arg, "--packed") == 0) {
+            options.encoding = ENCODING_PACKED;
+        } else if (strcmp(arg, "-q") == 0 || strcmp(arg, "--quiet") == 0) {
+            options.quiet = true;
+        } else if (strcmp(arg, "-v") == 0 || strcmp(arg, "--verbose") == 0) {
+            verbose = true;
+        } else if (strcmp(arg, "--stats") == 0) {
+            options.stats = true;
+        } else if (strcmp(arg, "--cycles") == 0) {
+            options.cycles = true;
+        } else if (strcmp(arg, "--cycle-model") == 0) {
+            if (!cycle_model_load(&options.cycle_model, value))
+                return EXIT_RUN_LOAD_ERROR;
+            options.cycles = true;
+        } else if (strcmp(arg, "--dcache") == 0) {
+            if (!cache_config_parse(value, &options.cache_config))
+                return EXIT_RUN_USAGE;
+            options.dcache = true;
+        } else if (strcmp(arg, "--bpred") == 0) {
+            if (!branch_predictor_parse_list(value, options.predictors, &options.predictor_count))
+                return EXIT_RUN_USAGE;
+        } else if (strcmp(arg, "--mispredict-penalty") == 0) {
+            options.mispredict_penalty = (uint32_t)strtoul(value, NULL, 0);
+        } else if (strcmp(arg, "--coverage") == 0) {
+            options.coverage_path = value;
+        } else if (strcmp(arg, "--coverage-shm") == 0) {
+            char *end = NULL;
+            long id = strtol(value, &end, 0);
+            if (end == value || *end != '\0' || id < 0 || id > INT32_MAX) {
+                fprintf(stderr, "Invalid shared memory id: %s\n", value);
+                return EXIT_RUN_USAGE;
+            }
+            options.coverage_shm = (int)id;
+        } else if (strcmp(arg, "--trace") == 0) {
+            options.trace_path = value;
+        } else if (strcmp(arg, "--heatmap") == 0) {
+            if (!heatmap_config_parse(value, &options.heatmap_config))
+                return EXIT_RUN_USAGE;
+            options.heatmap = true;
+        } else if (strcmp(arg, "--heatmap-file") == 0) {
+            options.heatmap_path = value;
+            options.heatmap = true;
+        } else if (strcmp(arg, "--mmio") == 0) {
+            /* Check the list now; every run maps it again onto fresh device state. */
+            MmioBus bus;
+            MmioConsole console;
+            MmioCycleCounter counter;
+            mmio_bus_init(&bus);
+            if (!mmio_bus_parse(&bus, value, &console, &counter))
+                return EXIT_RUN_USAGE;
+            options.mmio_spec = value;
+        } else if (strcmp(arg, "--cores") == 0) {
+            options.cores = (uint32_t)strtoul(value, NULL, 0);
+            if (options.cores == 0 || options.cores > SMP_MAX_CORES) {
+                fprintf(stderr, "--cores must be between 1 and %d\n", SMP_MAX_CORES);
+                return EXIT_RUN_USAGE;
+            }
+        } else if (strcmp(arg, "--last-write") == 0) {
+            options.last_write = (uint32_t)strtoul(value, NULL, 0);
+            options.last_write_given = true;
+            options.time_travel = true;
+        } else if (strcmp(arg, "--step-back") == 0) {
+            options.step_back = strtoull(value, NULL, 0);
+            options.time_travel = true;
+        } else if (strcmp(arg, "--record") == 0) {
+            options.record_path = value;
+        } else if (strcmp(arg, "--replay") == 0) {
+            options.replay_path = value;
+        } else if (strcmp(arg, "--dump") == 0) {
+            if (!dump_format_parse(value, &options.dump))
+                return EXIT_RUN_USAGE;
+            dump_given = true;
+        } else if (strcmp(arg, "--dump-file") == 0) {
+            options.dump_path = value;
+        } else if (strcmp(arg, "--dump-ram") == 0) {
+            if (!parse_ram_range(value, &options))
+                return EXIT_RUN_USAGE;
+        } else if (strcmp(arg, "--list-engines") == 0) {
+            size_t count;
+            const ExecEngine *engines = engine_list(&count);
+            for (size_t e = 0; e < count; e++)
+                printf("%-11s %s%s\n", engines[e].name, engines[e].description,
+                       engines[e].supports_limit ? "" : " (no --limit)");
+            return EXIT_RUN_OK;
+        } else if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            print_usage(stdout, program);
+            return EXIT_RUN_OK;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            print_usage(stderr, program);
+            return EXIT_RUN_USAGE;
+        }
+        if (takes_value)
+            i++;
+    }
+
+    if (file_count == 0) {
+        print_usage(stderr, program);
+        return EXIT_RUN_USAGE;
+    }
+    if (options.quiet && !dump_given)
+        options.dump = DUMP_NONE;
+    if (options.record_path && (!options.cores || options.replay_path)) {
+        fprintf(stderr, "--record needs --cores and cannot be combined with --replay\n");
+        return EXIT_RUN_USAGE;
+    }
+
+    /* Per-instruction debug logging dominates run time; only --verbose turns it on. */
+    log_set_enabled(LOG_DEBUG, verbose);
+    log_set_enabled(LOG_INFO, verbose);
+    if (options.quiet)
+        log_set_enabled(LOG_WARN, false);
+
+    FILE *dump_out = stdout;
+    if (options.dump_path && options.dump != DUMP_NONE) {
+        dump_out = fopen(options.dump_path, options.dump == DUMP_BINARY ? "wb" : "w");
+        if (!dump_out) {
+            log_write(LOG_ERROR, "Unable to open dump file: %s", options.dump_path);
+            return EXIT_RUN_LOAD_ERROR;
+        }
+    }
+
+    int code = EXIT_RUN_OK;
+    for (int i = 0; i < file_count; i++) {
+        int file_code = run_file(argv[i], &options, dump_out);
+        if (file_code > code)
+            code = file_code;
+    }
+
+    if (dump_out != stdout && fclose(dump_out) != 0 && code == EXIT_RUN_OK)
+        code = EXIT_RUN_LOAD_ERROR;
+    return code;
+}
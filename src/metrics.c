@@ -0,0 +1,496 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "metrics.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "log.h"
+
+/**
+ * @struct MetricsShard
+ * @brief Counters and histograms written by one thread only.
+ */
+typedef struct MetricsShard {
+    _Atomic uint64_t counters[METRIC_COUNTER_COUNT];
+    _Atomic uint64_t buckets[METRIC_HISTOGRAM_COUNT][METRIC_MAX_BUCKETS + 1];  /**< Last one is +Inf */
+    _Atomic uint64_t sums[METRIC_HISTOGRAM_COUNT];
+    struct MetricsShard *next;
+} MetricsShard;
+
+/**
+ * @struct MetricsTotals
+ * @brief Sum of all shards at one scrape.
+ */
+typedef struct {
+    uint64_t counters[METRIC_COUNTER_COUNT];
+    uint64_t buckets[METRIC_HISTOGRAM_COUNT][METRIC_MAX_BUCKETS + 1];
+    uint64_t sums[METRIC_HISTOGRAM_COUNT];
+} MetricsTotals;
+
+/**
+ * @struct HistogramInfo
+ * @brief Exposition name and bucket bounds of a histogram.
+ */
+typedef struct {
+    const char *name;
+    const char *help;
+    double scale;                           /**< Multiplies recorded values for output */
+    uint64_t bounds[METRIC_MAX_BUCKETS];    /**< Upper bounds in recorded units, ascending */
+    size_t bound_count;
+} HistogramInfo;
+
+static const HistogramInfo HISTOGRAMS[METRIC_HISTOGRAM_COUNT] = {
+    [METRIC_RUN_SECONDS] = {
+        "emulator_run_duration_seconds", "Wall time of one program run.", 1e-9,
+        { 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000, 10000000000 }, 8 },
+    [METRIC_JOB_LATENCY] = {
+        "emulator_job_latency_seconds", "Time from parsing a job request to queueing its result.", 1e-9,
+        { 10000, 50000, 100000, 500000, 1000000, 5000000, 10000000, 50000000, 100000000, 500000000,
+          1000000000, 5000000000 }, 12 },
+    [METRIC_RUN_DIRTY_PAGES] = {
+        "emulator_run_dirty_pages", "RAM pages (256 words) dirtied by one interpreted run, input windows included.", 1.0,
+        { 1, 2, 4, 8, 16, 32, 64, 128, 256 }, 9 },
+};
+
+static const char *const GAUGE_NAMES[METRIC_GAUGE_COUNT][2] = {
+    [METRIC_QUEUE_DEPTH] = { "emulator_job_queue_depth", "Jobs waiting for a worker." },
+    [METRIC_OPEN_CONNECTIONS] = { "emulator_open_connections", "Open job server client connections." },
+    [METRIC_WORKERS] = { "emulator_workers", "Job server worker threads." },
+};
+
+static const char *const ERROR_KINDS[] = {
+    "div_zero", "invalid_instruction", "register_index", "address_register_index", "address_literal",
+    "memory_bounds",
+};
+
+static atomic_bool enabled;
+static _Atomic int64_t gauges[METRIC_GAUGE_COUNT];
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static MetricsShard *active_shards;          /**< Shards of live threads */
+static MetricsShard *free_shards;            /**< Zeroed shards of exited threads, for reuse */
+static MetricsTotals retired;                /**< Counts of exited threads */
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t shard_key;
+static _Thread_local MetricsShard *thread_shard;
+
+/**
+ * @brief Thread exit: fold the shard into the retired totals and keep it for reuse.
+ */
+static void retire_shard(void *arg) {
+    MetricsShard *shard = arg;
+    pthread_mutex_lock(&registry_lock);
+    for (size_t i = 0; i < METRIC_COUNTER_COUNT; i++)
+        retired.counters[i] += atomic_load_explicit(&shard->counters[i], memory_order_relaxed);
+    for (size_t h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+        for (size_t b = 0; b <= METRIC_MAX_BUCKETS; b++)
+            retired.buckets[h][b] += atomic_load_explicit(&shard->buckets[h][b], memory_order_relaxed);
+        retired.sums[h] += atomic_load_explicit(&shard->sums[h], memory_order_relaxed);
+    }
+    for (MetricsShard **link = &active_shards; *link; link = &(*link)->next) {
+        if (*link == shard) {
+            *link = shard->next;
+            break;
+        }
+    }
+    memset(shard, 0, sizeof(*shard));
+    shard->next = free_shards;
+    free_shards = shard;
+    pthread_mutex_unlock(&registry_lock);
+}
+
+static void create_key(void) {
+    pthread_key_create(&shard_key, retire_shard);
+}
+
+/**
+ * @brief The calling thread's shard, registered on first use (NULL if memory runs out).
+ */
+static MetricsShard *local_shard(void) {
+    if (thread_shard)
+        return thread_shard;
+    pthread_once(&key_once, create_key);
+    pthread_mutex_lock(&registry_lock);
+    MetricsShard *shard = free_shards;
+    if (shard)
+        free_shards = shard->next;
+    else
+        shard = calloc(1, sizeof(*shard));
+    if (shard) {
+        shard->next = active_shards;
+        active_shards = shard;
+    }
+    pthread_mutex_unlock(&registry_lock);
+    if (shard)
+        pthread_setspecific(shard_key, shard);
+    thread_shard = shard;
+    return shard;
+}
+
+/**
+ * @brief Add to a slot only this thread writes: a plain load and store, no locked instruction.
+ */
+static inline void bump(_Atomic uint64_t *slot, uint64_t amount) {
+    atomic_store_explicit(slot, atomic_load_explicit(slot, memory_order_relaxed) + amount, memory_order_relaxed);
+}
+
+void metrics_set_enabled(bool on) {
+    atomic_store_explicit(&enabled, on, memory_order_relaxed);
+}
+
+bool metrics_enabled(void) {
+    return atomic_load_explicit(&enabled, memory_order_relaxed);
+}
+
+void metrics_add(MetricCounter counter, uint64_t amount) {
+    if (!metrics_enabled() || (unsigned)counter >= METRIC_COUNTER_COUNT)
+        return;
+    MetricsShard *shard = local_shard();
+    if (shard)
+        bump(&shard->counters[counter], amount);
+}
+
+void metrics_observe(MetricHistogram histogram, uint64_t value) {
+    if (!metrics_enabled() || (unsigned)histogram >= METRIC_HISTOGRAM_COUNT)
+        return;
+    MetricsShard *shard = local_shard();
+    if (!shard)
+        return;
+    const HistogramInfo *info = &HISTOGRAMS[histogram];
+    size_t bucket = 0;
+    while (bucket < info->bound_count && value > info->bounds[bucket])
+        bucket++;
+    bump(&shard->buckets[histogram][bucket], 1);
+    bump(&shard->sums[histogram], value);
+}
+
+void metrics_set_gauge(MetricGauge gauge, int64_t value) {
+    if (metrics_enabled() && (unsigned)gauge < METRIC_GAUGE_COUNT)
+        atomic_store_explicit(&gauges[gauge], value, memory_order_relaxed);
+}
+
+/**
+ * @brief Sum the retired totals and every live shard.
+ */
+static void collect(MetricsTotals *totals) {
+    pthread_mutex_lock(&registry_lock);
+    *totals = retired;
+    for (const MetricsShard *shard = active_shards; shard; shard = shard->next) {
+        for (size_t i = 0; i < METRIC_COUNTER_COUNT; i++)
+            totals->counters[i] += atomic_load_explicit(&shard->counters[i], memory_order_relaxed);
+        for (size_t h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+            for (size_t b = 0; b <= METRIC_MAX_BUCKETS; b++)
+                totals->buckets[h][b] += atomic_load_explicit(&shard->buckets[h][b], memory_order_relaxed);
+            totals->sums[h] += atomic_load_explicit(&shard->sums[h], memory_order_relaxed);
+        }
+    }
+    pthread_mutex_unlock(&registry_lock);
+}
+
+static void write_family(FILE *out, const char *name, const char *help, const char *type) {
+    fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+bool metrics_write(FILE *out) {
+    MetricsTotals totals;
+    collect(&totals);
+    const uint64_t *counters = totals.counters;
+
+    write_family(out, "emulator_instructions_retired_total", "Guest instructions retired by finished runs.",
+                 "counter");
+    fprintf(out, "emulator_instructions_retired_total %llu\n", (unsigned long long)counters[METRIC_INSTRUCTIONS]);
+
+    write_family(out, "emulator_runs_total", "Program runs by stop reason.", "counter");
+    for (int reason = CPU_STOP_HALT; reason < METRIC_STOP_REASONS; reason++)
+        fprintf(out, "emulator_runs_total{stop=\"%s\"} %llu\n", cpu_stop_reason_name((CpuStopReason)reason),
+                (unsigned long long)counters[METRIC_RUNS + reason]);
+
+    write_family(out, "emulator_errors_total", "Guest errors by kind.", "counter");
+    for (size_t kind = 0; kind < sizeof(ERROR_KINDS) / sizeof(ERROR_KINDS[0]); kind++)
+        fprintf(out, "emulator_errors_total{kind=\"%s\"} %llu\n", ERROR_KINDS[kind],
+                (unsigned long long)counters[METRIC_ERROR_DIV_ZERO + kind]);
+
+    write_family(out, "emulator_jobs_total", "Job server replies by status.", "counter");
+    for (int status = 0; status < METRIC_JOB_STATUSES; status++)
+        fprintf(out, "emulator_jobs_total{status=\"%s\"} %llu\n", job_status_name((JobStatus)status),
+                (unsigned long long)counters[METRIC_JOBS + status]);
+
+    write_family(out, "emulator_connections_accepted_total", "Job server connections accepted.", "counter");
+    fprintf(out, "emulator_connections_accepted_total %llu\n", (unsigned long long)counters[METRIC_CONNECTIONS]);
+
+    write_family(out, "emulator_program_cache_lookups_total", "Job server program cache lookups by source.",
+                 "counter");
+    fprintf(out, "emulator_program_cache_lookups_total{result=\"hit\"} %llu\n",
+            (unsigned long long)counters[METRIC_CACHE_HITS]);
+    fprintf(out, "emulator_program_cache_lookups_total{result=\"miss\"} %llu\n",
+            (unsigned long long)counters[METRIC_CACHE_MISSES]);
+
+    for (size_t h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+        const HistogramInfo *info = &HISTOGRAMS[h];
+        write_family(out, info->name, info->help, "histogram");
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b < info->bound_count; b++) {
+            cumulative += totals.buckets[h][b];
+            fprintf(out, "%s_bucket{le=\"%g\"} %llu\n", info->name, (double)info->bounds[b] * info->scale,
+                    (unsigned long long)cumulative);
+        }
+        cumulative += totals.buckets[h][info->bound_count];
+        fprintf(out, "%s_bucket{le=\"+Inf\"} %llu\n", info->name, (unsigned long long)cumulative);
+        fprintf(out, "%s_sum %.9g\n", info->name, (double)totals.sums[h] * info->scale);
+        fprintf(out, "%s_count %llu\n", info->name, (unsigned long long)cumulative);
+    }
+
+    for (size_t g = 0; g < METRIC_GAUGE_COUNT; g++) {
+        write_family(out, GAUGE_NAMES[g][0], GAUGE_NAMES[g][1], "gauge");
+        fprintf(out, "%s %lld\n", GAUGE_NAMES[g][0],
+                (long long)atomic_load_explicit(&gauges[g], memory_order_relaxed));
+    }
+    return !ferror(out);
+}
+
+/* ---- Exporter ---- */
+
+struct MetricsExporter {
+    pthread_t thread;
+    int listen_fd;               /**< HTTP listener, or -1 */
+    int stop_pipe[2];            /**< Written by metrics_exporter_stop() */
+    char *textfile;              /**< Textfile path, or NULL */
+    unsigned interval_seconds;
+};
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+/**
+ * @brief Render all metrics into a malloc'd buffer.
+ */
+static char *render(size_t *size) {
+    char *text = NULL;
+    FILE *out = open_memstream(&text, size);
+    if (!out)
+        return NULL;
+    bool ok = metrics_write(out);
+    if (fclose(out) != 0 || !ok) {
+        free(text);
+        return NULL;
+    }
+    return text;
+}
+
+/**
+ * @brief Replace the textfile atomically: write PATH.tmp, then rename it over PATH.
+ */
+static void write_textfile(const char *path) {
+    size_t length = strlen(path) + 5;
+    char *temp = malloc(length);
+    if (!temp)
+        return;
+    snprintf(temp, length, "%s.tmp", path);
+    FILE *out = fopen(temp, "w");
+    bool ok = out && metrics_write(out);
+    if (out && fclose(out) != 0)
+        ok = false;
+    if (!ok || rename(temp, path) != 0) {
+        log_write(LOG_WARN, "Unable to write metrics to %s: %s", path, strerror(errno));
+        unlink(temp);
+    }
+    free(temp);
+}
+
+static bool send_all(int fd, const char *data, size_t size) {
+    while (size) {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return false;
+        data += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+/**
+ * @brief Answer one HTTP request: `GET /metrics` gets the exposition, anything else 404.
+ */
+static void serve_http(int listen_fd) {
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0)
+        return;
+    struct timeval timeout = { 2, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char request[4096];
+    size_t length = 0;
+    while (length < sizeof(request) - 1) {
+        ssize_t got = recv(fd, request + length, sizeof(request) - 1 - length, 0);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            break;
+        length += (size_t)got;
+        request[length] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n"))
+            break;
+    }
+    request[length] = '\0';
+
+    char header[256];
+    size_t size = 0;
+    char *body = NULL;
+    if (strncmp(request, "GET /metrics ", 13) == 0 || strncmp(request, "GET /metrics?", 13) == 0)
+        body = render(&size);
+    if (body) {
+        int header_length = snprintf(header, sizeof(header),
+                                     "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                     "Content-Length: %zu\r\nConnection: close\r\n\r\n", size);
+        if (send_all(fd, header, (size_t)header_length))
+            send_all(fd, body, size);
+        free(body);
+    } else {
+        static const char not_found[] =
+            "HTTP/1.0 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 10\r\n"
+            "Connection: close\r\n\r\nnot found\n";
+        send_all(fd, not_found, sizeof(not_found) - 1);
+    }
+    close(fd);
+}
+
+static void *exporter_main(void *arg) {
+    MetricsExporter *exporter = arg;
+    uint64_t period = (uint64_t)exporter->interval_seconds * 1000u;
+    uint64_t next_write = monotonic_ms();
+    for (;;) {
+        int timeout = -1;
+        if (exporter->textfile) {
+            uint64_t now = monotonic_ms();
+            if (now >= next_write) {
+                write_textfile(exporter->textfile);
+                next_write = now + period;
+            }
+            timeout = (int)(next_write - now > period ? period : next_write - now);
+        }
+        struct pollfd fds[2] = {
+            { .fd = exporter->stop_pipe[0], .events = POLLIN },
+            { .fd = exporter->listen_fd, .events = POLLIN },
+        };
+        int ready = poll(fds, exporter->listen_fd >= 0 ? 2 : 1, timeout);
+        if (ready < 0 && errno != EINTR) {
+            log_write(LOG_ERROR, "Metrics exporter poll failed: %s", strerror(errno));
+            break;
+        }
+        if (ready > 0 && fds[0].revents)
+            break;
+        if (ready > 0 && exporter->listen_fd >= 0 && (fds[1].revents & POLLIN))
+            serve_http(exporter->listen_fd);
+    }
+    if (exporter->textfile)
+        write_textfile(exporter->textfile);
+    return NULL;
+}
+
+/**
+ * @brief Create the HTTP listener for "HOST:PORT" or ":PORT".
+ */
+static int open_http_listener(const char *address) {
+    const char *colon = strrchr(address, ':');
+    char host[64] = "127.0.0.1";
+    if (colon && colon != address) {
+        if ((size_t)(colon - address) >= sizeof(host)) {
+            log_write(LOG_ERROR, "Invalid metrics address: %s", address);
+            return -1;
+        }
+        memcpy(host, address, (size_t)(colon - address));
+        host[colon - address] = '\0';
+    }
+    char *end = NULL;
+    unsigned long port = strtoul(colon ? colon + 1 : address, &end, 10);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (*end != '\0' || port == 0 || port > 65535 || inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        log_write(LOG_ERROR, "Invalid metrics address: %s", address);
+        return -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int one = 1;
+    if (fd >= 0)
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+        log_write(LOG_ERROR, "Unable to listen on %s: %s", address, strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+MetricsExporter *metrics_exporter_start(const char *listen_address, const char *textfile, unsigned interval_seconds) {
+    if (!listen_address && !textfile) {
+        log_write(LOG_ERROR, "Metrics exporter needs an address or a textfile");
+        return NULL;
+    }
+    MetricsExporter *exporter = calloc(1, sizeof(*exporter));
+    if (!exporter) {
+        log_write(LOG_ERROR, "Out of memory creating the metrics exporter");
+        return NULL;
+    }
+    exporter->listen_fd = -1;
+    exporter->stop_pipe[0] = exporter->stop_pipe[1] = -1;
+    exporter->interval_seconds = interval_seconds ? interval_seconds : 15;
+    if (textfile && !(exporter->textfile = strdup(textfile)))
+        goto fail;
+    if (listen_address && (exporter->listen_fd = open_http_listener(listen_address)) < 0)
+        goto fail;
+    if (pipe(exporter->stop_pipe) != 0) {
+        log_write(LOG_ERROR, "pipe failed: %s", strerror(errno));
+        goto fail;
+    }
+    if (pthread_create(&exporter->thread, NULL, exporter_main, exporter) != 0) {
+        log_write(LOG_ERROR, "Unable to start the metrics exporter thread");
+        goto fail;
+    }
+    return exporter;
+
+fail:
+    if (exporter->listen_fd >= 0)
+        close(exporter->listen_fd);
+    if (exporter->stop_pipe[0] >= 0) {
+        close(exporter->stop_pipe[0]);
+        close(exporter->stop_pipe[1]);
+    }
+    free(exporter->textfile);
+    free(exporter);
+    return NULL;
+}
+
+void metrics_exporter_stop(MetricsExporter *exporter) {
+    if (!exporter)
+        return;
+    ssize_t ignored = write(exporter->stop_pipe[1], "x", 1);
+    (void)ignored;
+    pthread_join(exporter->thread, NULL);
+    if (exporter->listen_fd >= 0)
+        close(exporter->listen_fd);
+    close(exporter->stop_pipe[0]);
+    close(exporter->stop_pipe[1]);
+    free(exporter->textfile);
+    free(exporter);
+}
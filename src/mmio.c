@@ -0,0 +1,188 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "mmio.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "log.h"
+
+void mmio_bus_init(MmioBus *bus) {
+    memset(bus, 0, sizeof(*bus));
+}
+
+bool mmio_map(MmioBus *bus, const MmioDevice *device) {
+    const char *name = device->name ? device->name : "device";
+    if (bus->device_count == MMIO_MAX_DEVICES) {
+        log_write(LOG_ERROR, "Cannot map %s: the bus already has %d devices", name, MMIO_MAX_DEVICES);
+        return false;
+    }
+    if (device->base % MMIO_PAGE_WORDS != 0 || device->size == 0 || device->base >= RAM_SIZE
+        || device->size > RAM_SIZE - device->base) {
+        log_write(LOG_ERROR, "Cannot map %s at 0x%X: the base must be a multiple of %u and the range must fit in RAM",
+                  name, device->base, MMIO_PAGE_WORDS);
+        return false;
+    }
+
+    uint32_t first = device->base >> RAM_PAGE_SHIFT;
+    uint32_t last = (device->base + device->size - 1) >> RAM_PAGE_SHIFT;
+    for (uint32_t page = first; page <= last; page++) {
+        if (bus->pages[page]) {
+            log_write(LOG_ERROR, "Cannot map %s at 0x%X: page 0x%X already belongs to %s", name, device->base,
+                      page << RAM_PAGE_SHIFT, bus->devices[bus->pages[page] - 1].name);
+            return false;
+        }
+    }
+
+    bus->devices[bus->device_count++] = *device;
+    for (uint32_t page = first; page <= last; page++)
+        bus->pages[page] = (uint8_t)bus->device_count;
+    return true;
+}
+
+bool mmio_read(const MmioDevice *device, const CPU *cpu, uint32_t address, uint32_t *value) {
+    *value = 0;
+    if (!device->read || device->read(device->context, cpu, address - device->base, value))
+        return true;
+    log_write(LOG_ERROR, "Device %s faulted a read of 0x%X at PC 0x%08X", device->name, address, cpu->pc);
+    return false;
+}
+
+bool mmio_write(const MmioDevice *device, const CPU *cpu, uint32_t address, uint32_t value) {
+    if (!device->write || device->write(device->context, cpu, address - device->base, value))
+        return true;
+    log_write(LOG_ERROR, "Device %s faulted a write of 0x%X at PC 0x%08X", device->name, address, cpu->pc);
+    return false;
+}
+
+void mmio_console_init(MmioConsole *console, FILE *out) {
+    console->out = out;
+    console->written = 0;
+    console->length = 0;
+}
+
+bool mmio_console_flush(MmioConsole *console) {
+    if (console->length && fwrite(console->buffer, 1, console->length, console->out) != console->length) {
+        log_write(LOG_ERROR, "Console output failed");
+        console->length = 0;
+        return false;
+    }
+    console->length = 0;
+    if (fflush(console->out) != 0) {
+        log_write(LOG_ERROR, "Console output failed");
+        return false;
+    }
+    return true;
+}
+
+static bool console_read(void *context, const CPU *cpu, uint32_t offset, uint32_t *value) {
+    (void)cpu;
+    const MmioConsole *console = context;
+    if (offset == MMIO_CONSOLE_COUNT)
+        *value = (uint32_t)console->written;
+    return true;
+}
+
+/**
+ * @brief A failed flush faults the STOREM, so the guest stops instead of writing into the void.
+ */
+static bool console_write(void *context, const CPU *cpu, uint32_t offset, uint32_t value) {
+    (void)cpu;
+    MmioConsole *console = context;
+    if (offset == MMIO_CONSOLE_FLUSH)
+        return mmio_console_flush(console);
+    if (offset != MMIO_CONSOLE_DATA)
+        return true;
+    if (console->length == sizeof(console->buffer) && !mmio_console_flush(console))
+        return false;
+    console->buffer[console->length++] = (char)(value & 0xFF);
+    console->written++;
+    return true;
+}
+
+MmioDevice mmio_console_device(MmioConsole *console, uint32_t base) {
+    return (MmioDevice){
+        .name = "console",
+        .base = base,
+        .size = MMIO_CONSOLE_WORDS,
+        .context = console,
+        .read = console_read,
+        .write = console_write,
+    };
+}
+
+void mmio_cycle_counter_init(MmioCycleCounter *counter) {
+    counter->origin = 0;
+    counter->latched_high = 0;
+}
+
+static bool cycles_read(void *context, const CPU *cpu, uint32_t offset, uint32_t *value) {
+    MmioCycleCounter *counter = context;
+    uint64_t count = cpu->instructions_retired - counter->origin;
+    if (offset == MMIO_CYCLES_LOW) {
+        counter->latched_high = (uint32_t)(count >> 32);
+        *value = (uint32_t)count;
+    } else if (offset == MMIO_CYCLES_HIGH) {
+        *value = counter->latched_high;
+    }
+    return true;
+}
+
+static bool cycles_write(void *context, const CPU *cpu, uint32_t offset, uint32_t value) {
+    (void)value;
+    MmioCycleCounter *counter = context;
+    if (offset == MMIO_CYCLES_RESET)
+        counter->origin = cpu->instructions_retired;
+    return true;
+}
+
+MmioDevice mmio_cycle_counter_device(MmioCycleCounter *counter, uint32_t base) {
+    return (MmioDevice){
+        .name = "cycles",
+        .base = base,
+        .size = MMIO_CYCLES_WORDS,
+        .context = counter,
+        .read = cycles_read,
+        .write = cycles_write,
+    };
+}
+
+bool mmio_bus_parse(MmioBus *bus, const char *spec, MmioConsole *console, MmioCycleCounter *counter) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", spec);
+    bool console_mapped = false;
+    bool counter_mapped = false;
+    char *save = NULL;
+    for (char *item = strtok_r(buffer, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        char *at = strchr(item, '@');
+        if (!at) {
+            log_write(LOG_ERROR, "Device '%s' must be KIND@ADDRESS", item);
+            return false;
+        }
+        *at++ = '\0';
+        char *end = NULL;
+        unsigned long base = strtoul(at, &end, 0);
+        if (end == at || *end != '\0' || base >= RAM_SIZE) {
+            log_write(LOG_ERROR, "Invalid address '%s' for device '%s'", at, item);
+            return false;
+        }
+
+        MmioDevice device;
+        if (strcasecmp(item, "console") == 0 && !console_mapped) {
+            device = mmio_console_device(console, (uint32_t)base);
+            console_mapped = true;
+        } else if (strcasecmp(item, "cycles") == 0 && !counter_mapped) {
+            device = mmio_cycle_counter_device(counter, (uint32_t)base);
+            counter_mapped = true;
+        } else {
+            log_write(LOG_ERROR, "Unknown or repeated device '%s' (console, cycles)", item);
+            return false;
+        }
+        if (!mmio_map(bus, &device))
+            return false;
+    }
+    return true;
+}
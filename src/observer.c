@@ -0,0 +1,122 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "observer.h"
+
+#include <string.h>
+#include <time.h>
+
+/** Layout of StatePublisher.status. */
+#define STATUS_ZERO        0x1u
+#define STATUS_NEGATIVE    0x2u
+#define STATUS_RUNNING     0x4u
+#define STATUS_REASON_SHIFT 8
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void state_publisher_init(StatePublisher *publisher, uint32_t interval) {
+    memset(publisher, 0, sizeof(*publisher));
+    atomic_init(&publisher->sequence, 0);
+    publisher->interval = interval ? interval : OBSERVER_DEFAULT_INTERVAL;
+}
+
+/**
+ * @brief Seqlock write side: make the sequence odd, store the fields, make it even again.
+ *
+ * The release fence keeps the field stores from moving above the odd
+ * sequence number; the release store keeps them below the even one.
+ */
+void state_publish(StatePublisher *publisher, const CPU *cpu) {
+    uint_fast64_t sequence = atomic_load_explicit(&publisher->sequence, memory_order_relaxed);
+    atomic_store_explicit(&publisher->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&publisher->pc, cpu->pc, memory_order_relaxed);
+    for (int i = 0; i < MAX_REGISTERS; i++)
+        atomic_store_explicit(&publisher->registers[i], cpu->registers[i], memory_order_relaxed);
+    for (int i = 0; i < MAX_ADDRESS_REGISTERS; i++)
+        atomic_store_explicit(&publisher->address_registers[i], cpu->address_registers[i], memory_order_relaxed);
+    uint32_t status = (cpu->zero_flag ? STATUS_ZERO : 0) | (cpu->negative_flag ? STATUS_NEGATIVE : 0)
+                    | (cpu->running ? STATUS_RUNNING : 0) | (uint32_t)cpu->stop_reason << STATUS_REASON_SHIFT;
+    atomic_store_explicit(&publisher->status, status, memory_order_relaxed);
+    atomic_store_explicit(&publisher->instructions_retired, cpu->instructions_retired, memory_order_relaxed);
+    atomic_store_explicit(&publisher->published_ns, monotonic_ns(), memory_order_relaxed);
+
+    atomic_store_explicit(&publisher->sequence, sequence + 2, memory_order_release);
+}
+
+/**
+ * @brief Seqlock read side: copy the fields between two equal, even sequence numbers.
+ */
+bool state_snapshot_read(const StatePublisher *publisher, CpuSnapshot *snapshot) {
+    for (;;) {
+        uint_fast64_t begin = atomic_load_explicit(&publisher->sequence, memory_order_acquire);
+        if (begin == 0)
+            return false;
+        if (begin & 1)
+            continue;
+
+        snapshot->pc = atomic_load_explicit(&publisher->pc, memory_order_relaxed);
+        for (int i = 0; i < MAX_REGISTERS; i++)
+            snapshot->registers[i] = atomic_load_explicit(&publisher->registers[i], memory_order_relaxed);
+        for (int i = 0; i < MAX_ADDRESS_REGISTERS; i++)
+            snapshot->address_registers[i] =
+                atomic_load_explicit(&publisher->address_registers[i], memory_order_relaxed);
+        uint32_t status = atomic_load_explicit(&publisher->status, memory_order_relaxed);
+        snapshot->instructions_retired = atomic_load_explicit(&publisher->instructions_retired, memory_order_relaxed);
+        snapshot->published_ns = atomic_load_explicit(&publisher->published_ns, memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&publisher->sequence, memory_order_relaxed) != begin)
+            continue;
+
+        snapshot->zero_flag = status & STATUS_ZERO;
+        snapshot->negative_flag = status & STATUS_NEGATIVE;
+        snapshot->running = status & STATUS_RUNNING;
+        snapshot->stop_reason = (CpuStopReason)(status >> STATUS_REASON_SHIFT);
+        snapshot->publications = begin / 2;
+        return true;
+    }
+}
+
+void state_top_print(FILE *out, StateTopRow *rows, size_t count) {
+    uint64_t now = monotonic_ns();
+    size_t running = 0;
+    double total_mips = 0.0;
+
+    fprintf(out, "%4s %-16s %-12s %10s %16s %9s %10s %10s %10s %10s %2s %8s\n",
+            "ID", "NAME", "STATE", "PC", "INSTRUCTIONS", "MIPS", "R0", "R1", "R2", "R3", "ZN", "AGE");
+    for (size_t i = 0; i < count; i++) {
+        StateTopRow *row = &rows[i];
+        CpuSnapshot snapshot;
+        if (!state_snapshot_read(row->publisher, &snapshot)) {
+            fprintf(out, "%4zu %-16.16s %-12s\n", i, row->name, "waiting");
+            continue;
+        }
+
+        double mips = 0.0;
+        if (row->has_previous && snapshot.published_ns > row->previous.published_ns)
+            mips = (double)(snapshot.instructions_retired - row->previous.instructions_retired) * 1e3
+                 / (double)(snapshot.published_ns - row->previous.published_ns);
+        /* A run stopped by its instruction limit keeps `running` set but is over. */
+        bool live = snapshot.running && snapshot.stop_reason == CPU_STOP_NONE;
+        if (live) {
+            running++;
+            total_mips += mips;
+        }
+        fprintf(out, "%4zu %-16.16s %-12s 0x%08X %16llu %9.2f 0x%08X 0x%08X 0x%08X 0x%08X %c%c %6llums\n",
+                i, row->name, live ? "running" : cpu_stop_reason_name(snapshot.stop_reason),
+                snapshot.pc, (unsigned long long)snapshot.instructions_retired, live ? mips : 0.0,
+                snapshot.registers[0], snapshot.registers[1], snapshot.registers[2], snapshot.registers[3],
+                snapshot.zero_flag ? 'Z' : '-', snapshot.negative_flag ? 'N' : '-',
+                (unsigned long long)((now - snapshot.published_ns) / 1000000));
+        row->previous = snapshot;
+        row->has_previous = true;
+    }
+    fprintf(out, "%zu instances, %zu running, %.2f MIPS\n", count, running, total_mips);
+}
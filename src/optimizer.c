@@ -0,0 +1,590 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "../include/optimizer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+#include "encoding.h"
+#include "log.h"
+
+/** Upper bound on rewrite iterations; each iteration must remove or fold something. */
+#define MAX_OPTIMIZER_PASSES 64
+/** Upper bound on jumps followed when threading a single chain (guards cycles). */
+#define MAX_THREAD_STEPS 64
+
+#define NO_INDEX UINT32_MAX
+
+/**
+ * @struct OptInsn
+ * @brief One instruction of the program being optimized.
+ *
+ * Jump targets are kept as instruction indices while rewriting so that
+ * deleting instructions never requires re-decoding addresses; index
+ * `count` stands for "end of program".
+ */
+typedef struct {
+    DecodedInstruction insn;
+    uint32_t target;  /**< Jumps only: index of the target instruction */
+    bool leader;      /**< First instruction of a basic block */
+    bool removed;     /**< Marked for deletion in the current pass */
+} OptInsn;
+
+/**
+ * @brief Static cost estimate of one instruction, in cycles.
+ *
+ * Rough relative costs only: memory and multiply/divide are dearer than
+ * simple ALU work, and jumps pay for the redirect.
+ */
+static uint32_t estimated_cycles(uint32_t opcode) {
+    switch (opcode) {
+        case ISA_LOADM: case ISA_STOREM: return 3;
+        case ISA_MLP: return 3;
+        case ISA_DIV: return 20;
+        case ISA_JMP: case ISA_JZ: case ISA_JNZ: return 2;
+        default: return 1;
+    }
+}
+
+/**
+ * @brief Return true if the instruction writes the zero flag on success.
+ */
+static bool writes_zero_flag(uint32_t opcode) {
+    return opcode == ISA_LOADI || opcode == ISA_LOADM || opcode == ISA_CMP || isa_is_alu(opcode);
+}
+
+/**
+ * @brief Return true if the instruction can stop the CPU with an error
+ * before updating the flags, making the current flags observable.
+ */
+static bool may_fault(const DecodedInstruction *insn) {
+    if ((insn->opcode == ISA_LOADM || insn->opcode == ISA_STOREM) && insn->mode == ADDR_REGISTER)
+        return true;
+    return insn->opcode == ISA_DIV && insn->mode == OPERAND_REGISTER;
+}
+
+/**
+ * @brief Evaluate an ALU opcode on constants; false for a zero divisor.
+ */
+static bool fold_alu(uint32_t opcode, uint32_t a, uint32_t b, uint32_t *result) {
+    switch (opcode) {
+        case ISA_ADD: *result = a + b; return true;
+        case ISA_SUB: *result = a - b; return true;
+        case ISA_MLP: *result = (uint32_t)((uint64_t)a * (uint64_t)b); return true;
+        case ISA_DIV:
+            if (b == 0)
+                return false;
+            *result = a / b;
+            return true;
+        case ISA_AND: *result = a & b; return true;
+        case ISA_OR: *result = a | b; return true;
+        case ISA_XOR: *result = a ^ b; return true;
+        default: return false;
+    }
+}
+
+/**
+ * @brief Return true if the ALU instruction leaves its destination unchanged.
+ */
+static bool is_identity(const DecodedInstruction *insn) {
+    if (!isa_is_alu(insn->opcode))
+        return false;
+    if (insn->mode == OPERAND_REGISTER)
+        return (insn->opcode == ISA_AND || insn->opcode == ISA_OR) && insn->operand == insn->reg;
+
+    switch (insn->opcode) {
+        case ISA_ADD: case ISA_SUB: case ISA_OR: case ISA_XOR: return insn->operand == 0;
+        case ISA_MLP: case ISA_DIV: return insn->operand == 1;
+        case ISA_AND: return insn->operand == 0xFFFFFFFFu;
+        default: return false;
+    }
+}
+
+/**
+ * @brief Check register fields and modes so rewrites never hide a runtime fault.
+ */
+static bool operands_valid(const DecodedInstruction *insn) {
+    switch (insn->opcode) {
+        case ISA_LOADI:
+            return insn->reg < MAX_REGISTERS;
+        case ISA_LOADA:
+            return insn->reg < MAX_ADDRESS_REGISTERS && insn->operand < RAM_SIZE;
+        case ISA_LOADM: case ISA_STOREM:
+            if (insn->reg >= MAX_REGISTERS || insn->mode > ADDR_LITERAL)
+                return false;
+            return insn->mode == ADDR_LITERAL ? insn->operand < RAM_SIZE : insn->operand < MAX_ADDRESS_REGISTERS;
+        case ISA_CMP:
+            return insn->reg < MAX_REGISTERS && insn->operand < MAX_REGISTERS;
+        case ISA_JMP: case ISA_JZ: case ISA_JNZ: case ISA_HALT:
+            return true;
+        default:
+            if (insn->reg >= MAX_REGISTERS || insn->mode > OPERAND_NUMERIC)
+                return false;
+            return insn->mode == OPERAND_NUMERIC || insn->operand < MAX_REGISTERS;
+    }
+}
+
+/**
+ * @brief Decode the range into an OptInsn array and check it is safe to rewrite.
+ *
+ * @return true if the program can be optimized; false (with a warning) if
+ *         it must be left as is. `*items` is NULL when false is returned.
+ */
+static bool decode_program(const uint32_t *words, uint32_t limit, AssemblyRange range,
+                           OptInsn **items, uint32_t *count) {
+    *items = NULL;
+    *count = 0;
+
+    uint32_t span = range.end_address - range.start_address;
+    uint32_t *index_of = malloc(sizeof(uint32_t) * ((size_t)span + 1));
+    OptInsn *list = malloc(sizeof(OptInsn) * (span ? span : 1));
+    if (!index_of || !list) {
+        free(index_of);
+        free(list);
+        log_write(LOG_ERROR, "Optimizer: out of memory");
+        return false;
+    }
+    for (uint32_t i = 0; i <= span; i++)
+        index_of[i] = NO_INDEX;
+
+    bool ok = true;
+    bool areg_loaded[MAX_ADDRESS_REGISTERS] = { false };
+    uint32_t n = 0;
+    uint32_t pc = range.start_address;
+
+    while (ok && pc < range.end_address) {
+        DecodedInstruction insn;
+        if (!decode_instruction(words, limit, pc, range.encoding, &insn) || !operands_valid(&insn)) {
+            log_write(LOG_WARN, "Optimizer: undecodable or invalid instruction at 0x%08X, program left unchanged", pc);
+            ok = false;
+            break;
+        }
+        if (insn.opcode == ISA_LOADA)
+            areg_loaded[insn.reg] = true;
+
+        uint32_t literal = NO_INDEX;
+        if (insn.opcode == ISA_LOADA || ((insn.opcode == ISA_LOADM || insn.opcode == ISA_STOREM) && insn.mode == ADDR_LITERAL))
+            literal = insn.operand;
+        if (literal != NO_INDEX && literal >= range.start_address && literal < range.end_address) {
+            log_write(LOG_WARN, "Optimizer: instruction at 0x%08X addresses the code itself, program left unchanged", pc);
+            ok = false;
+            break;
+        }
+
+        index_of[pc - range.start_address] = n;
+        list[n++] = (OptInsn){ .insn = insn, .target = NO_INDEX };
+        pc += insn.length;
+    }
+    if (ok && pc != range.end_address) {
+        log_write(LOG_WARN, "Optimizer: last instruction overruns the range end, program left unchanged");
+        ok = false;
+    }
+    index_of[span] = n;
+
+    for (uint32_t i = 0; ok && i < n; i++) {
+        const DecodedInstruction *insn = &list[i].insn;
+        if ((insn->opcode == ISA_LOADM || insn->opcode == ISA_STOREM) && insn->mode == ADDR_REGISTER
+            && !areg_loaded[insn->operand]) {
+            log_write(LOG_WARN, "Optimizer: A%u is used but never loaded, program left unchanged", insn->operand);
+            ok = false;
+            break;
+        }
+        if (!isa_is_jump(insn->opcode))
+            continue;
+        uint32_t target = insn->operand;
+        if (target < range.start_address || target > range.end_address
+            || index_of[target - range.start_address] == NO_INDEX) {
+            log_write(LOG_WARN, "Optimizer: jump at instruction %u to 0x%08X is not an instruction boundary, program left unchanged",
+                      i, target);
+            ok = false;
+            break;
+        }
+        list[i].target = index_of[target - range.start_address];
+    }
+
+    free(index_of);
+    if (!ok) {
+        free(list);
+        return false;
+    }
+    *items = list;
+    *count = n;
+    return true;
+}
+
+/**
+ * @brief Mark basic-block leaders: entry, jump targets and jump/HALT successors.
+ */
+static void mark_leaders(OptInsn *items, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++)
+        items[i].leader = (i == 0);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t op = items[i].insn.opcode;
+        if (isa_is_jump(op)) {
+            if (items[i].target < count)
+                items[items[i].target].leader = true;
+            if (i + 1 < count)
+                items[i + 1].leader = true;
+        } else if (op == ISA_HALT && i + 1 < count) {
+            items[i + 1].leader = true;
+        }
+    }
+}
+
+/**
+ * @brief Successors of instruction i in the control-flow graph.
+ *
+ * Index `count` stands for "falls off the end of the program".
+ *
+ * @return Number of successors written to `succ` (0..2).
+ */
+static int successors(const OptInsn *items, uint32_t i, uint32_t succ[2]) {
+    switch (items[i].insn.opcode) {
+        case ISA_HALT:
+            return 0;
+        case ISA_JMP:
+            succ[0] = items[i].target;
+            return 1;
+        case ISA_JZ: case ISA_JNZ:
+            succ[0] = items[i].target;
+            succ[1] = i + 1;
+            return 2;
+        default:
+            succ[0] = i + 1;
+            return 1;
+    }
+}
+
+/**
+ * @brief Remove instructions unreachable from the entry point.
+ *
+ * @return Number of instructions marked as removed.
+ */
+static uint32_t remove_unreachable(OptInsn *items, uint32_t count, uint32_t *stack, bool *seen) {
+    memset(seen, 0, sizeof(bool) * count);
+    uint32_t top = 0;
+    if (count > 0) {
+        stack[top++] = 0;
+        seen[0] = true;
+    }
+    while (top > 0) {
+        uint32_t i = stack[--top];
+        uint32_t succ[2];
+        int n = successors(items, i, succ);
+        for (int k = 0; k < n; k++) {
+            if (succ[k] < count && !seen[succ[k]]) {
+                seen[succ[k]] = true;
+                stack[top++] = succ[k];
+            }
+        }
+    }
+
+    uint32_t removed = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!seen[i]) {
+            items[i].removed = true;
+            removed++;
+        }
+    }
+    return removed;
+}
+
+/**
+ * @brief Compute whether the zero flag is live after each instruction.
+ *
+ * Backward dataflow over the instruction-level CFG. The flag is live at
+ * HALT and at the end of the program (it is part of the final state), is
+ * read by JZ/JNZ, and is observable before any instruction that may fault.
+ */
+static void zero_flag_liveness(const OptInsn *items, uint32_t count, bool *live_out) {
+    bool *live_in = calloc(count ? count : 1, sizeof(bool));
+    if (!live_in) {
+        for (uint32_t i = 0; i < count; i++)
+            live_out[i] = true;
+        return;
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t k = count; k-- > 0;) {
+            const DecodedInstruction *insn = &items[k].insn;
+            uint32_t succ[2];
+            int n = successors(items, k, succ);
+            bool out = insn->opcode == ISA_HALT;
+            for (int s = 0; s < n; s++)
+                out = out || succ[s] >= count || live_in[succ[s]];
+
+            bool in = insn->opcode == ISA_JZ || insn->opcode == ISA_JNZ || may_fault(insn)
+                   || (!writes_zero_flag(insn->opcode) && out);
+            if (out != live_out[k] || in != live_in[k]) {
+                live_out[k] = out;
+                live_in[k] = in;
+                changed = true;
+            }
+        }
+    }
+    free(live_in);
+}
+
+/**
+ * @brief Follow a jump-to-jump chain from `target` and return the final index.
+ *
+ * JMP is always followed. A conditional jump landing on the same kind of
+ * conditional jump is followed to that jump's target (the flags cannot
+ * change in between); landing on the opposite condition continues at its
+ * fall-through instead.
+ */
+static uint32_t thread_target(const OptInsn *items, uint32_t count, uint32_t opcode, uint32_t target) {
+    for (int steps = 0; steps < MAX_THREAD_STEPS && target < count; steps++) {
+        const OptInsn *next = &items[target];
+        uint32_t op = next->insn.opcode;
+        if (op == ISA_JMP || (op == opcode && opcode != ISA_JMP)) {
+            if (next->target == target)
+                break;
+            target = next->target;
+        } else if ((opcode == ISA_JZ && op == ISA_JNZ) || (opcode == ISA_JNZ && op == ISA_JZ)) {
+            target = target + 1;
+        } else {
+            break;
+        }
+    }
+    return target;
+}
+
+/**
+ * @brief Drop removed instructions and remap jump targets onto the survivors.
+ *
+ * A jump to a removed instruction lands on the first survivor after it,
+ * which is correct because every removal is a no-op in its context.
+ *
+ * @return New instruction count.
+ */
+static uint32_t compact(OptInsn *items, uint32_t count, uint32_t *new_index) {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        new_index[i] = kept;
+        if (!items[i].removed)
+            kept++;
+    }
+    new_index[count] = kept;
+
+    uint32_t out = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (items[i].removed)
+            continue;
+        OptInsn item = items[i];
+        if (isa_is_jump(item.insn.opcode))
+            item.target = new_index[item.target];
+        item.removed = false;
+        items[out++] = item;
+    }
+    return out;
+}
+
+/**
+ * @brief Run one round of all rewrites.
+ *
+ * @return true if anything changed.
+ */
+static bool optimize_pass(OptInsn *items, uint32_t *count, uint32_t *scratch, bool *flags, OptimizerStats *stats) {
+    uint32_t n = *count;
+    bool changed = false;
+
+    uint32_t unreachable = remove_unreachable(items, n, scratch, flags);
+    for (uint32_t i = 0; i < n; i++) {
+        if (items[i].removed)
+            stats->estimated_cycles_saved += estimated_cycles(items[i].insn.opcode);
+    }
+    stats->unreachable_removed += unreachable;
+    if (unreachable) {
+        *count = compact(items, n, scratch);
+        return true;
+    }
+
+    mark_leaders(items, n);
+
+    for (uint32_t i = 0; i < n; i++) {
+        OptInsn *item = &items[i];
+        if (!isa_is_jump(item->insn.opcode))
+            continue;
+        uint32_t threaded = thread_target(items, n, item->insn.opcode, item->target);
+        if (threaded != item->target) {
+            item->target = threaded;
+            stats->jumps_threaded++;
+            changed = true;
+        }
+        if (item->target == i + 1) {
+            item->removed = true;
+            stats->jumps_to_next_removed++;
+            stats->estimated_cycles_saved += estimated_cycles(item->insn.opcode);
+            changed = true;
+        }
+    }
+
+    for (uint32_t i = 0; i + 1 < n; i++) {
+        OptInsn *load = &items[i];
+        OptInsn *op = &items[i + 1];
+        if (load->removed || op->removed || op->leader || load->insn.opcode != ISA_LOADI
+            || !isa_is_alu(op->insn.opcode) || op->insn.reg != load->insn.reg)
+            continue;
+
+        uint32_t rhs;
+        if (op->insn.mode == OPERAND_NUMERIC)
+            rhs = op->insn.operand;
+        else if (op->insn.operand == load->insn.reg)
+            rhs = load->insn.operand;
+        else
+            continue;
+
+        uint32_t value;
+        if (!fold_alu(op->insn.opcode, load->insn.operand, rhs, &value))
+            continue;
+
+        load->insn.operand = value;
+        op->removed = true;
+        stats->constants_folded++;
+        stats->estimated_cycles_saved += estimated_cycles(op->insn.opcode);
+        changed = true;
+        i++;
+    }
+
+    bool *live_out = flags;
+    zero_flag_liveness(items, n, live_out);
+    for (uint32_t i = 0; i < n; i++) {
+        OptInsn *item = &items[i];
+        if (item->removed || !is_identity(&item->insn) || live_out[i])
+            continue;
+        item->removed = true;
+        stats->identities_removed++;
+        stats->estimated_cycles_saved += estimated_cycles(item->insn.opcode);
+        changed = true;
+    }
+
+    if (changed)
+        *count = compact(items, n, scratch);
+    return changed;
+}
+
+/**
+ * @brief Lay out the surviving instructions from the start address and encode them.
+ *
+ * @return false if an instruction could not be encoded (should not happen
+ *         for inputs that decoded successfully).
+ */
+static bool emit_program(uint32_t *words, uint32_t limit, AssemblyRange *range, const OptInsn *items, uint32_t count,
+                         uint32_t *addr_of) {
+    uint32_t pc = range->start_address;
+    for (uint32_t i = 0; i < count; i++) {
+        addr_of[i] = pc;
+        pc += instruction_length(items[i].insn.opcode, items[i].insn.mode != 0, range->encoding);
+    }
+    addr_of[count] = pc;
+    uint32_t new_end = pc;
+
+    for (uint32_t i = 0; i < count; i++) {
+        DecodedInstruction insn = items[i].insn;
+        if (isa_is_jump(insn.opcode))
+            insn.operand = addr_of[items[i].target];
+
+        uint32_t encoded[4];
+        uint32_t n = encode_instruction(&insn, range->encoding, encoded);
+        if (n == 0 || addr_of[i] + n > limit) {
+            log_write(LOG_ERROR, "Optimizer: unable to re-encode instruction %u", i);
+            return false;
+        }
+        memcpy(&words[addr_of[i]], encoded, sizeof(uint32_t) * n);
+    }
+
+    if (new_end < range->end_address)
+        memset(&words[new_end], 0, sizeof(uint32_t) * (range->end_address - new_end));
+    range->end_address = new_end;
+    return true;
+}
+
+/**
+ * @brief Optimize an assembled range in place.
+ */
+bool optimize_range(uint32_t *words, uint32_t limit, AssemblyRange *range, OptimizerStats *stats) {
+    OptimizerStats local = { 0 };
+    if (!stats)
+        stats = &local;
+    *stats = (OptimizerStats){ 0 };
+
+    if (!words || !range || range->error || range->end_address < range->start_address || range->end_address > limit) {
+        log_write(LOG_ERROR, "Optimizer: invalid arguments");
+        return false;
+    }
+
+    stats->words_before = range->end_address - range->start_address;
+    stats->words_after = stats->words_before;
+
+    OptInsn *items;
+    uint32_t count;
+    if (!decode_program(words, limit, *range, &items, &count)) {
+        stats->skipped = true;
+        return true;
+    }
+    stats->instructions_before = count;
+
+    uint32_t *scratch = malloc(sizeof(uint32_t) * ((size_t)count + 1));
+    bool *flags = malloc(sizeof(bool) * (count ? count : 1));
+    if (!scratch || !flags) {
+        free(items);
+        free(scratch);
+        free(flags);
+        log_write(LOG_ERROR, "Optimizer: out of memory");
+        return false;
+    }
+
+    while (stats->passes < MAX_OPTIMIZER_PASSES) {
+        stats->passes++;
+        if (!optimize_pass(items, &count, scratch, flags, stats))
+            break;
+    }
+
+    bool ok = emit_program(words, limit, range, items, count, scratch);
+    stats->instructions_after = count;
+    stats->words_after = range->end_address - range->start_address;
+
+    free(items);
+    free(scratch);
+    free(flags);
+    return ok;
+}
+
+/**
+ * @brief Optimize a program assembled into RAM.
+ */
+bool optimize_program(RAM *ram, AssemblyRange *range, OptimizerStats *stats) {
+    if (!ram) {
+        log_write(LOG_ERROR, "Optimizer: RAM pointer is NULL");
+        return false;
+    }
+    return optimize_range(ram->cells, RAM_SIZE, range, stats);
+}
+
+/**
+ * @brief Print an optimization report to stdout.
+ */
+void optimizer_print_stats(const OptimizerStats *stats) {
+    if (!stats)
+        return;
+    if (stats->skipped) {
+        printf("Optimizer: program not optimized (unsafe to rewrite)\n");
+        return;
+    }
+    printf("Optimizer: %u -> %u instructions, %u -> %u words in %u passes\n",
+           stats->instructions_before, stats->instructions_after,
+           stats->words_before, stats->words_after, stats->passes);
+    printf("  folded %u, identities %u, jumps-to-next %u, threaded %u, unreachable %u\n",
+           stats->constants_folded, stats->identities_removed, stats->jumps_to_next_removed,
+           stats->jumps_threaded, stats->unreachable_removed);
+    printf("  instructions removed: %u, estimated cycles saved (static): %llu\n",
+           stats->instructions_before - stats->instructions_after,
+           (unsigned long long)stats->estimated_cycles_saved);
+}
@@ -3,6 +3,7 @@
 #include "cpu.h"
 #include "isa.h"
 #include "log.h"
+#include "parser.h"
 
 #define ORG_DIRECTIVE ".org"
 #define LABEL_ENDING ':'
@@ -310,26 +311,126 @@ bool is_label(const char *line)
 	return (len > 0 && line[len - 1] == LABEL_ENDING);
 }
 
+/**
+ * @brief Hash a label name (FNV-1a, 32-bit).
+ */
+static uint32_t label_hash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+	for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+		hash ^= *p;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/**
+ * @brief Initialize an empty label table.
+ *
+ * @param labels Table to initialize.
+ */
+void label_table_init(LabelTable *labels)
+{
+	labels->entries = NULL;
+	labels->count = 0;
+	labels->capacity = 0;
+	labels->buckets = NULL;
+	labels->bucket_count = 0;
+}
+
+/**
+ * @brief Release the memory owned by a label table and reset it.
+ *
+ * @param labels Table to release (may be NULL).
+ */
+void label_table_free(LabelTable *labels)
+{
+	if (!labels)
+		return;
+	free(labels->entries);
+	free(labels->buckets);
+	label_table_init(labels);
+}
+
+/**
+ * @brief Return the bucket holding `name`, or the empty bucket where it belongs.
+ */
+static size_t label_slot(const LabelTable *labels, const char *name)
+{
+	size_t mask = labels->bucket_count - 1;
+	size_t slot = label_hash(name) & mask;
+	while (labels->buckets[slot] != 0) {
+		if (strcmp(labels->entries[labels->buckets[slot] - 1].name, name) == 0)
+			break;
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+/**
+ * @brief Double the hash index and re-insert every label.
+ *
+ * @return 0 on success, FAILURE if allocation fails.
+ */
+static int label_table_rehash(LabelTable *labels)
+{
+	size_t bucket_count = labels->bucket_count ? labels->bucket_count * 2 : 64;
+	uint32_t *buckets = calloc(bucket_count, sizeof(uint32_t));
+	if (!buckets)
+		return FAILURE;
+
+	free(labels->buckets);
+	labels->buckets = buckets;
+	labels->bucket_count = bucket_count;
+	for (size_t i = 0; i < labels->count; i++)
+		labels->buckets[label_slot(labels, labels->entries[i].name)] = (uint32_t)(i + 1);
+	return 0;
+}
+
 /**
  * @brief Add a label name and resolved address to the labels table.
  *
+ * A label may be defined once. Names that do not fit in Label::name are
+ * rejected rather than truncated, so two long labels sharing a prefix
+ * cannot collide.
+ *
  * @param label_name NUL-terminated label text.
  * @param addr Address to associate with the label.
- * @param labels Array of Label entries where the label will be stored.
- * @param label_count Pointer to the current label count; incremented on success.
- * @return 0 on success, -1 on error (e.g. table full).
+ * @param labels Table where the label will be stored.
+ * @return 0 on success, -1 on error (duplicate or over-long label, out of memory).
  */
-int add_label(const char *label_name, uint32_t addr, Label labels[], size_t *label_count)
+int add_label(const char *label_name, uint32_t addr, LabelTable *labels)
 {
-	if (*label_count >= MAX_LABELS)
-	{
-		log_write(LOG_ERROR, "Maximum number of labels reached");
+	size_t length = strlen(label_name);
+	if (length >= sizeof(((Label *)0)->name)) {
+		log_write(LOG_ERROR, "Label longer than %zu characters: %s", sizeof(((Label *)0)->name) - 1, label_name);
+		return FAILURE;
+	}
+	if ((labels->count + 1) * 2 > labels->bucket_count && label_table_rehash(labels) == FAILURE) {
+		log_write(LOG_ERROR, "Out of memory growing the label table");
 		return FAILURE;
 	}
-	strncpy(labels[*label_count].name, label_name, sizeof(labels[*label_count].name) - 1);
-	labels[*label_count].name[sizeof(labels[*label_count].name) - 1] = '\0';
-	labels[*label_count].address = addr;
-	(*label_count)++;
+	if (labels->count == labels->capacity) {
+		size_t capacity = labels->capacity ? labels->capacity * 2 : 32;
+		Label *entries = realloc(labels->entries, capacity * sizeof(Label));
+		if (!entries) {
+			log_write(LOG_ERROR, "Out of memory growing the label table");
+			return FAILURE;
+		}
+		labels->entries = entries;
+		labels->capacity = capacity;
+	}
+
+	Label *label = &labels->entries[labels->count];
+	memcpy(label->name, label_name, length + 1);
+	label->address = addr;
+
+	size_t slot = label_slot(labels, label->name);
+	if (labels->buckets[slot] != 0) {
+		log_write(LOG_ERROR, "Duplicate label: %s", label->name);
+		return FAILURE;
+	}
+	labels->buckets[slot] = (uint32_t)(++labels->count);
 	return 0;
 }
 
@@ -337,16 +438,16 @@ int add_label(const char *label_name, uint32_t addr, Label labels[], size_t *lab
  * @brief Find a label by name and return its resolved address.
  *
  * @param label_name NUL-terminated label to search for.
- * @param labels Array of Label entries.
- * @param label_count Number of valid entries in labels[].
+ * @param labels Table of labels.
  * @return Resolved address (>=0) on success, -1 if the label is not found.
  */
-int find_label_addr(const char *label_name, Label labels[], size_t label_count)
+int find_label_addr(const char *label_name, const LabelTable *labels)
 {
-	for (size_t i = 0; i < label_count; i++)
-	{
-		if (strcmp(labels[i].name, label_name) == 0)
-			return (int)labels[i].address;
+	/* add_label() rejects names that do not fit, so a longer one is never defined. */
+	if (labels->count > 0 && strlen(label_name) < sizeof(((Label *)0)->name)) {
+		size_t slot = label_slot(labels, label_name);
+		if (labels->buckets[slot] != 0)
+			return (int)labels->entries[labels->buckets[slot] - 1].address;
 	}
 	log_write(LOG_ERROR, "Label not found: %s", label_name);
 	return FAILURE;
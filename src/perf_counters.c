@@ -0,0 +1,169 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "perf_counters.h"
+
+#include <string.h>
+
+#include "log.h"
+
+void perf_counters_init(PerfCounters *pc) {
+    pc->leader = -1;
+    pc->open_count = 0;
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        pc->fds[c] = -1;
+        pc->ids[c] = 0;
+    }
+}
+
+#ifdef __linux__
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @struct EventSpec
+ * @brief perf_event_attr type/config pair for one PerfCounter.
+ */
+typedef struct {
+    uint32_t type;
+    uint64_t config;
+} EventSpec;
+
+static const EventSpec EVENT_SPECS[PERF_COUNTER_COUNT] = {
+    [PERF_CYCLES]        = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    [PERF_INSTRUCTIONS]  = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    [PERF_BRANCH_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    [PERF_L1D_MISSES]    = { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                                                 | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                                 | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    [PERF_LLC_MISSES]    = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+};
+
+static int perf_event_open(struct perf_event_attr *attr, int group_fd) {
+    return (int)syscall(SYS_perf_event_open, attr, 0 /* this thread */, -1 /* any cpu */, group_fd, 0);
+}
+
+bool perf_counters_open(PerfCounters *pc) {
+    perf_counters_init(pc);
+
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = EVENT_SPECS[c].type;
+        attr.config = EVENT_SPECS[c].config;
+        attr.disabled = pc->leader < 0;   /* members follow the leader */
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID
+                         | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        int fd = perf_event_open(&attr, pc->leader);
+        if (fd < 0) {
+            log_write(LOG_DEBUG, "perf: %s unavailable", perf_counter_name((PerfCounter)c));
+            continue;
+        }
+        if (ioctl(fd, PERF_EVENT_IOC_ID, &pc->ids[c]) != 0) {
+            close(fd);
+            continue;
+        }
+        if (pc->leader < 0)
+            pc->leader = fd;
+        pc->fds[c] = fd;
+        pc->open_count++;
+    }
+    return pc->open_count > 0;
+}
+
+void perf_counters_start(PerfCounters *pc) {
+    if (pc->leader < 0)
+        return;
+    ioctl(pc->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(pc->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+bool perf_counters_stop(PerfCounters *pc, PerfSample *sample) {
+    memset(sample, 0, sizeof(*sample));
+    if (pc->leader < 0)
+        return false;
+    ioctl(pc->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    /* PERF_FORMAT_GROUP layout: nr, time_enabled, time_running, { value, id }[nr] */
+    uint64_t buffer[3 + 2 * PERF_COUNTER_COUNT];
+    ssize_t n = read(pc->leader, buffer, sizeof(buffer));
+    if (n < (ssize_t)(3 * sizeof(uint64_t))) {
+        log_write(LOG_ERROR, "perf: failed to read counter group");
+        return false;
+    }
+
+    uint64_t nr = buffer[0];
+    uint64_t enabled = buffer[1];
+    uint64_t running = buffer[2];
+    if (running == 0)
+        return true;   /* group never got onto the PMU: every value stays invalid */
+
+    for (uint64_t i = 0; i < nr && i < PERF_COUNTER_COUNT; i++) {
+        uint64_t value = buffer[3 + 2 * i];
+        uint64_t id = buffer[4 + 2 * i];
+        for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+            if (pc->fds[c] >= 0 && pc->ids[c] == id) {
+                sample->values[c] = running < enabled
+                    ? (uint64_t)((double)value * (double)enabled / (double)running)
+                    : value;
+                sample->valid[c] = true;
+            }
+        }
+    }
+    return true;
+}
+
+void perf_counters_close(PerfCounters *pc) {
+    /* Members first, leader last. */
+    for (int c = PERF_COUNTER_COUNT - 1; c >= 0; c--) {
+        if (pc->fds[c] >= 0 && pc->fds[c] != pc->leader)
+            close(pc->fds[c]);
+        pc->fds[c] = -1;
+    }
+    if (pc->leader >= 0)
+        close(pc->leader);
+    pc->leader = -1;
+    pc->open_count = 0;
+}
+
+#else /* !__linux__ */
+
+bool perf_counters_open(PerfCounters *pc) {
+    perf_counters_init(pc);
+    return false;
+}
+
+void perf_counters_start(PerfCounters *pc) {
+    (void)pc;
+}
+
+bool perf_counters_stop(PerfCounters *pc, PerfSample *sample) {
+    (void)pc;
+    memset(sample, 0, sizeof(*sample));
+    return false;
+}
+
+void perf_counters_close(PerfCounters *pc) {
+    (void)pc;
+}
+
+#endif
+
+const char *perf_counter_name(PerfCounter counter) {
+    switch (counter) {
+        case PERF_CYCLES:        return "cycles";
+        case PERF_INSTRUCTIONS:  return "instructions";
+        case PERF_BRANCH_MISSES: return "branch-misses";
+        case PERF_L1D_MISSES:    return "l1d-misses";
+        case PERF_LLC_MISSES:    return "llc-misses";
+        default:                 return "unknown";
+    }
+}
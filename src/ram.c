@@ -48,6 +48,7 @@ void ram_init(RAM *ram) {
         return;
     }
     memset(ram->cells, 0, sizeof(ram->cells));
+    memset(ram->dirty, 0, sizeof(ram->dirty));
     pthread_rwlockattr_t attr;
     pthread_rwlockattr_init(&attr);
     // Initialize the read-write lock with default attributes.
@@ -88,6 +89,7 @@ bool ram_store(RAM *ram, const uint32_t address, const uint32_t value) {
     pthread_rwlock_wrlock(&ram->lock);
     // Critical section: single-element write
     ram->cells[address] = value;
+    ram_mark_dirty(ram, address);
     // Release the lock as soon as possible
     pthread_rwlock_unlock(&ram->lock);
 
@@ -184,4 +186,13 @@ bool ram_free(RAM *ram, uint32_t start, uint32_t end) {
 
     log_write(LOG_INFO, "RAM free: Cleared range 0x%04X to 0x%04X", (unscast) start, (unscast) end);
     return true;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Clear the dirty-page bitmap maintained by ram_mark_dirty().
+ *
+ * @param ram RAM whose bitmap is reset.
+ */
+void ram_clear_dirty(RAM *ram) {
+    memset(ram->dirty, 0, sizeof(ram->dirty));
+}
@@ -0,0 +1,403 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "smp.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu_exec.h"
+#include "log.h"
+
+#define SMP_LOG_MAGIC   0x53323343u /* "C32S" */
+#define SMP_LOG_VERSION 1u
+
+/** Busy-wait iterations before a waiting core starts yielding its host CPU. */
+#define SMP_SPINS 64
+
+/** Yields with every core waiting and none advancing before a replay is declared stuck. */
+#define SMP_STALL_YIELDS 100000u
+
+/**
+ * @struct SmpShared
+ * @brief State shared by the cores of one run.
+ */
+struct SmpShared {
+    SmpPage pages[RAM_PAGES];
+    uint32_t cores;
+    atomic_uint finished;        /**< Cores whose engine returned */
+    atomic_uint waiting;         /**< Cores inside smp_replay_wait() */
+    atomic_uint progress;        /**< Replay waits completed so far */
+    atomic_bool abort;           /**< A replaying core diverged */
+};
+
+/**
+ * @struct SmpThread
+ * @brief One core and its thread.
+ */
+typedef struct {
+    SmpCore core;
+    CPU *cpu;
+    RAM *ram;
+    AssemblyRange range;
+    uint64_t max_instructions;
+    pthread_t thread;
+} SmpThread;
+
+void smp_record_transfer(SmpCore *core, uint64_t instruction, uint32_t page, uint64_t accesses) {
+    SmpCoreLog *log = core->log;
+    if (log->count == log->capacity) {
+        size_t capacity = log->capacity ? log->capacity * 2 : 1024;
+        SmpTransfer *transfers = realloc(log->transfers, capacity * sizeof(SmpTransfer));
+        if (!transfers) {
+            if (!core->failed)
+                log_write(LOG_ERROR, "Out of memory recording core %u", core->index);
+            core->failed = true;
+            return;
+        }
+        log->transfers = transfers;
+        log->capacity = capacity;
+    }
+    log->transfers[log->count++] = (SmpTransfer){ .instruction = instruction, .accesses = accesses, .page = page };
+}
+
+void smp_lock_contended(SmpPage *page) {
+    for (uint32_t spins = 0;; spins++) {
+        if (!atomic_load_explicit(&page->lock, memory_order_relaxed)
+            && !atomic_exchange_explicit(&page->lock, 1, memory_order_acquire))
+            return;
+        if (spins >= SMP_SPINS)
+            sched_yield();
+    }
+}
+
+/**
+ * @brief Stop every replaying core after a divergence.
+ */
+static bool replay_diverged(SmpCore *core, const SmpTransfer *transfer, const char *what) {
+    if (!atomic_exchange(&core->shared->abort, true))
+        log_write(LOG_ERROR, "Replay diverges on core %u at instruction %llu (page %u): %s", core->index,
+                  (unsigned long long)transfer->instruction, transfer->page, what);
+    core->failed = true;
+    return false;
+}
+
+bool smp_replay_wait(SmpCore *core, const SmpTransfer *transfer) {
+    struct SmpShared *shared = core->shared;
+    if (transfer->page >= RAM_PAGES)
+        return replay_diverged(core, transfer, "page out of range");
+    SmpPage *page = &core->pages[transfer->page];
+
+    uint64_t seen = atomic_load_explicit(&page->accesses, memory_order_acquire);
+    if (seen == transfer->accesses)
+        return true;
+
+    atomic_fetch_add(&shared->waiting, 1);
+    uint32_t progress = atomic_load(&shared->progress);
+    uint32_t stalled = 0;
+    bool ok = true;
+    for (uint32_t spins = 0;; spins++) {
+        seen = atomic_load_explicit(&page->accesses, memory_order_acquire);
+        if (seen == transfer->accesses)
+            break;
+        if (seen > transfer->accesses) {
+            ok = replay_diverged(core, transfer, "the page was accessed more often than recorded");
+            break;
+        }
+        if (atomic_load(&shared->abort)) {
+            core->failed = true;
+            ok = false;
+            break;
+        }
+        if (spins < SMP_SPINS)
+            continue;
+        sched_yield();
+
+        /* Nobody can advance the page if every other core is waiting or done. */
+        uint32_t now = atomic_load(&shared->progress);
+        if (now != progress
+            || atomic_load(&shared->waiting) + atomic_load(&shared->finished) < shared->cores) {
+            progress = now;
+            stalled = 0;
+        } else if (++stalled == SMP_STALL_YIELDS) {
+            ok = replay_diverged(core, transfer, "no core can reach the recorded access");
+            break;
+        }
+    }
+    atomic_fetch_sub(&shared->waiting, 1);
+    atomic_fetch_add(&shared->progress, 1);
+    return ok;
+}
+
+/**
+ * @brief Thread body: run one core to completion.
+ */
+static void *smp_core_main(void *arg) {
+    SmpThread *t = arg;
+    cpu_init(t->cpu);
+    t->cpu->registers[SMP_CORE_REGISTER] = t->core.index;
+    if (t->core.mode == SMP_FREE)
+        cpu_execute_predecoded(t->cpu, t->ram, t->range, t->max_instructions);
+    else
+        cpu_execute_shared(t->cpu, t->ram, t->range, t->max_instructions, &t->core);
+    atomic_fetch_add(&t->core.shared->finished, 1);
+    return NULL;
+}
+
+bool smp_log_matches(const SmpLog *log, const RAM *ram) {
+    if (smp_state_hash(ram, NULL, 0) == log->initial_hash)
+        return true;
+    log_write(LOG_ERROR, "Replay refused: the program or initial memory differs from the recording");
+    return false;
+}
+
+bool smp_run(RAM *ram, AssemblyRange range, uint32_t cores, uint64_t max_instructions, SmpMode mode,
+             SmpLog *log, CPU *cpus) {
+    if (mode == SMP_REPLAY) {
+        cores = log->cores;
+        max_instructions = log->max_instructions;
+        if (!smp_log_matches(log, ram))
+            return false;
+    }
+    if (cores == 0 || cores > SMP_MAX_CORES) {
+        log_write(LOG_ERROR, "Core count must be between 1 and %d", SMP_MAX_CORES);
+        return false;
+    }
+    if (mode == SMP_RECORD) {
+        memset(log, 0, sizeof(*log));
+        log->cores = cores;
+        log->max_instructions = max_instructions;
+        log->initial_hash = smp_state_hash(ram, NULL, 0);
+    }
+
+    struct SmpShared *shared = aligned_alloc(64, sizeof(struct SmpShared));
+    SmpThread *threads = calloc(cores, sizeof(SmpThread));
+    if (!shared || !threads) {
+        log_write(LOG_ERROR, "Out of memory starting %u cores", cores);
+        free(shared);
+        free(threads);
+        return false;
+    }
+    memset(shared, 0, sizeof(*shared));
+    shared->cores = cores;
+
+    uint32_t started = 0;
+    for (; started < cores; started++) {
+        SmpThread *t = &threads[started];
+        t->core = (SmpCore){ .mode = mode, .index = started, .pages = shared->pages,
+                             .log = log ? &log->core[started] : NULL, .shared = shared };
+        t->cpu = &cpus[started];
+        t->ram = ram;
+        t->range = range;
+        t->max_instructions = max_instructions;
+        if (pthread_create(&t->thread, NULL, smp_core_main, t) != 0) {
+            log_write(LOG_ERROR, "Unable to start core %u", started);
+            break;
+        }
+    }
+    /* Cores that never started count as finished so waiting replays notice. */
+    atomic_fetch_add(&shared->finished, cores - started);
+    bool ok = started == cores;
+    for (uint32_t i = 0; i < started; i++) {
+        pthread_join(threads[i].thread, NULL);
+        ok = ok && !threads[i].core.failed;
+        if (mode == SMP_REPLAY && threads[i].core.next != log->core[i].count && ok) {
+            log_write(LOG_ERROR, "Replay diverges on core %u: %zu of %zu recorded transfers happened", i,
+                      threads[i].core.next, log->core[i].count);
+            ok = false;
+        }
+    }
+
+    uint64_t hash = smp_state_hash(ram, cpus, cores);
+    if (mode == SMP_RECORD) {
+        log->final_hash = hash;
+    } else if (mode == SMP_REPLAY && ok && hash != log->final_hash) {
+        log_write(LOG_ERROR, "Replay diverges: final state hash %016llx, recorded %016llx",
+                  (unsigned long long)hash, (unsigned long long)log->final_hash);
+        ok = false;
+    }
+
+    free(threads);
+    free(shared);
+    return ok;
+}
+
+/**
+ * @brief Fold `size` bytes into an FNV-1a hash.
+ */
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t size) {
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+uint64_t smp_state_hash(const RAM *ram, const CPU *cpus, uint32_t count) {
+    uint64_t hash = fnv1a(0xCBF29CE484222325ull, ram->cells, sizeof(ram->cells));
+    for (uint32_t i = 0; i < count; i++) {
+        const CPU *cpu = &cpus[i];
+        uint32_t flags = (cpu->zero_flag ? 1u : 0u) | (cpu->negative_flag ? 2u : 0u)
+                       | (cpu->running ? 4u : 0u) | ((uint32_t)cpu->stop_reason << 3);
+        hash = fnv1a(hash, &cpu->pc, sizeof(cpu->pc));
+        hash = fnv1a(hash, cpu->registers, sizeof(cpu->registers));
+        hash = fnv1a(hash, cpu->address_registers, sizeof(cpu->address_registers));
+        hash = fnv1a(hash, &cpu->instructions_retired, sizeof(cpu->instructions_retired));
+        hash = fnv1a(hash, &flags, sizeof(flags));
+    }
+    return hash;
+}
+
+size_t smp_log_transfers(const SmpLog *log) {
+    size_t total = 0;
+    for (uint32_t i = 0; i < log->cores; i++)
+        total += log->core[i].count;
+    return total;
+}
+
+/**
+ * @brief Write one little-endian 32-bit value.
+ */
+static bool write_u32(FILE *file, uint32_t value) {
+    unsigned char bytes[4] = {
+        (unsigned char)(value & 0xFF),
+        (unsigned char)((value >> 8) & 0xFF),
+        (unsigned char)((value >> 16) & 0xFF),
+        (unsigned char)((value >> 24) & 0xFF)
+    };
+    return fwrite(bytes, 1, sizeof(bytes), file) == sizeof(bytes);
+}
+
+/**
+ * @brief Read one little-endian 32-bit value.
+ */
+static bool read_u32(FILE *file, uint32_t *value) {
+    unsigned char bytes[4];
+    if (fread(bytes, 1, sizeof(bytes), file) != sizeof(bytes))
+        return false;
+    *value = (uint32_t)bytes[0]
+           | ((uint32_t)bytes[1] << 8)
+           | ((uint32_t)bytes[2] << 16)
+           | ((uint32_t)bytes[3] << 24);
+    return true;
+}
+
+static bool write_u64(FILE *file, uint64_t value) {
+    return write_u32(file, (uint32_t)value) && write_u32(file, (uint32_t)(value >> 32));
+}
+
+static bool read_u64(FILE *file, uint64_t *value) {
+    uint32_t low, high;
+    if (!read_u32(file, &low) || !read_u32(file, &high))
+        return false;
+    *value = (uint64_t)high << 32 | low;
+    return true;
+}
+
+/**
+ * @brief Write an unsigned LEB128 varint.
+ */
+static bool write_varint(FILE *file, uint64_t value) {
+    while (value >= 0x80) {
+        if (putc((int)(value & 0x7F) | 0x80, file) == EOF)
+            return false;
+        value >>= 7;
+    }
+    return putc((int)value, file) != EOF;
+}
+
+/**
+ * @brief Read an unsigned LEB128 varint.
+ */
+static bool read_varint(FILE *file, uint64_t *value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = getc(file);
+        if (byte == EOF)
+            return false;
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool smp_log_write(const SmpLog *log, const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        log_write(LOG_ERROR, "Unable to open replay log: %s", path);
+        return false;
+    }
+    bool ok = write_u32(file, SMP_LOG_MAGIC) && write_u32(file, SMP_LOG_VERSION) && write_u32(file, log->cores)
+           && write_u64(file, log->max_instructions) && write_u64(file, log->initial_hash)
+           && write_u64(file, log->final_hash);
+    for (uint32_t c = 0; ok && c < log->cores; c++) {
+        const SmpCoreLog *core = &log->core[c];
+        ok = write_varint(file, core->count);
+        uint64_t previous = 0;
+        for (size_t i = 0; ok && i < core->count; i++) {
+            const SmpTransfer *t = &core->transfers[i];
+            ok = write_varint(file, t->instruction - previous) && write_varint(file, t->page)
+              && write_varint(file, t->accesses);
+            previous = t->instruction;
+        }
+    }
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+        log_write(LOG_ERROR, "Unable to write replay log: %s", path);
+    return ok;
+}
+
+bool smp_log_read(SmpLog *log, const char *path) {
+    memset(log, 0, sizeof(*log));
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        log_write(LOG_ERROR, "Unable to open replay log: %s", path);
+        return false;
+    }
+    uint32_t magic, version;
+    bool ok = read_u32(file, &magic) && read_u32(file, &version) && read_u32(file, &log->cores)
+           && read_u64(file, &log->max_instructions) && read_u64(file, &log->initial_hash)
+           && read_u64(file, &log->final_hash)
+           && magic == SMP_LOG_MAGIC && version == SMP_LOG_VERSION
+           && log->cores >= 1 && log->cores <= SMP_MAX_CORES;
+    for (uint32_t c = 0; ok && c < log->cores; c++) {
+        SmpCoreLog *core = &log->core[c];
+        uint64_t count;
+        ok = read_varint(file, &count) && count <= SIZE_MAX / sizeof(SmpTransfer);
+        if (ok && count) {
+            core->transfers = malloc(count * sizeof(SmpTransfer));
+            ok = core->transfers != NULL;
+            core->capacity = ok ? count : 0;
+        }
+        uint64_t instruction = 0;
+        for (uint64_t i = 0; ok && i < count; i++) {
+            uint64_t delta = 0, page = 0;
+            SmpTransfer *t = &core->transfers[i];
+            ok = read_varint(file, &delta) && read_varint(file, &page) && read_varint(file, &t->accesses)
+              && page < RAM_PAGES;
+            instruction += delta;
+            t->instruction = instruction;
+            t->page = (uint32_t)page;
+            core->count = i + 1;
+        }
+    }
+    fclose(file);
+    if (!ok) {
+        log_write(LOG_ERROR, "Invalid replay log: %s", path);
+        smp_log_free(log);
+    }
+    return ok;
+}
+
+void smp_log_free(SmpLog *log) {
+    for (uint32_t c = 0; c < SMP_MAX_CORES; c++) {
+        free(log->core[c].transfers);
+        log->core[c] = (SmpCoreLog){0};
+    }
+}
@@ -0,0 +1,157 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "state_dump.h"
+
+#include <string.h>
+
+#include "log.h"
+
+/**
+ * @brief Write one 32-bit value in little-endian byte order.
+ */
+static bool write_u32(FILE *file, uint32_t value) {
+    unsigned char bytes[4] = {
+        (unsigned char)(value & 0xFF),
+        (unsigned char)((value >> 8) & 0xFF),
+        (unsigned char)((value >> 16) & 0xFF),
+        (unsigned char)((value >> 24) & 0xFF)
+    };
+    return fwrite(bytes, 1, sizeof(bytes), file) == sizeof(bytes);
+}
+
+/**
+ * @brief Write a string as a JSON string literal.
+ */
+static void write_json_string(FILE *out, const char *s) {
+    fputc('"', out);
+    for (const unsigned char *p = (const unsigned char *)s; *p; p++) {
+        if (*p == '"' || *p == '\\')
+            fprintf(out, "\\%c", *p);
+        else if (*p < 0x20)
+            fprintf(out, "\\u%04x", *p);
+        else
+            fputc(*p, out);
+    }
+    fputc('"', out);
+}
+
+static void dump_text(FILE *out, const char *label, const char *engine, const CPU *cpu, const RAM *ram,
+                      uint32_t ram_start, uint32_t ram_end) {
+    if (label)
+        fprintf(out, "file:     %s\n", label);
+    if (engine)
+        fprintf(out, "engine:   %s\n", engine);
+    fprintf(out, "stop:     %s\n", cpu_stop_reason_name(cpu->stop_reason));
+    fprintf(out, "pc:       0x%08X\n", cpu->pc);
+    fprintf(out, "retired:  %llu\n", (unsigned long long)cpu->instructions_retired);
+    fprintf(out, "flags:    zero=%d negative=%d running=%d\n", cpu->zero_flag, cpu->negative_flag, cpu->running);
+    for (int i = 0; i < MAX_REGISTERS; i++) {
+        char cell[48];
+        snprintf(cell, sizeof(cell), "R%d = 0x%08X (%u)", i, cpu->registers[i], cpu->registers[i]);
+        fprintf(out, i % 2 ? "%s\n" : "%-32s", cell);
+    }
+    for (int i = 0; i < MAX_ADDRESS_REGISTERS; i++)
+        fprintf(out, "A%d = 0x%08X%s", i, cpu->address_registers[i], i % 4 == 3 ? "\n" : "    ");
+    for (uint32_t addr = ram_start; addr < ram_end; addr += 8) {
+        fprintf(out, "RAM[0x%04X]:", addr);
+        for (uint32_t k = addr; k < addr + 8 && k < ram_end; k++)
+            fprintf(out, " %08X", ram->cells[k]);
+        fputc('\n', out);
+    }
+}
+
+static void dump_json(FILE *out, const char *label, const char *engine, const CPU *cpu, const RAM *ram,
+                      uint32_t ram_start, uint32_t ram_end) {
+    fputc('{', out);
+    if (label) {
+        fputs("\"file\": ", out);
+        write_json_string(out, label);
+        fputs(", ", out);
+    }
+    if (engine) {
+        fputs("\"engine\": ", out);
+        write_json_string(out, engine);
+        fputs(", ", out);
+    }
+    fprintf(out, "\"stop\": \"%s\", \"pc\": %u, \"retired\": %llu, \"zero\": %s, \"negative\": %s, \"running\": %s",
+            cpu_stop_reason_name(cpu->stop_reason), cpu->pc, (unsigned long long)cpu->instructions_retired,
+            cpu->zero_flag ? "true" : "false", cpu->negative_flag ? "true" : "false",
+            cpu->running ? "true" : "false");
+    fputs(", \"registers\": [", out);
+    for (int i = 0; i < MAX_REGISTERS; i++)
+        fprintf(out, "%s%u", i ? ", " : "", cpu->registers[i]);
+    fputs("], \"address_registers\": [", out);
+    for (int i = 0; i < MAX_ADDRESS_REGISTERS; i++)
+        fprintf(out, "%s%u", i ? ", " : "", cpu->address_registers[i]);
+    fputc(']', out);
+    if (ram_end > ram_start) {
+        fprintf(out, ", \"ram\": {\"start\": %u, \"words\": [", ram_start);
+        for (uint32_t addr = ram_start; addr < ram_end; addr++)
+            fprintf(out, "%s%u", addr > ram_start ? ", " : "", ram->cells[addr]);
+        fputs("]}", out);
+    }
+    fputs("}\n", out);
+}
+
+static bool dump_binary(FILE *out, const CPU *cpu, const RAM *ram, uint32_t ram_start, uint32_t ram_end) {
+    uint32_t flags = (cpu->zero_flag ? 1u : 0u) | (cpu->negative_flag ? 2u : 0u) | (cpu->running ? 4u : 0u);
+    bool ok = write_u32(out, STATE_DUMP_MAGIC)
+           && write_u32(out, STATE_DUMP_VERSION)
+           && write_u32(out, cpu->pc)
+           && write_u32(out, flags)
+           && write_u32(out, (uint32_t)cpu->stop_reason)
+           && write_u32(out, (uint32_t)cpu->instructions_retired)
+           && write_u32(out, (uint32_t)(cpu->instructions_retired >> 32));
+    for (int i = 0; ok && i < MAX_REGISTERS; i++)
+        ok = write_u32(out, cpu->registers[i]);
+    for (int i = 0; ok && i < MAX_ADDRESS_REGISTERS; i++)
+        ok = write_u32(out, cpu->address_registers[i]);
+    ok = ok && write_u32(out, ram_start) && write_u32(out, ram_end - ram_start);
+    for (uint32_t addr = ram_start; ok && addr < ram_end; addr++)
+        ok = write_u32(out, ram->cells[addr]);
+    return ok;
+}
+
+bool dump_format_parse(const char *name, DumpFormat *format) {
+    if (strcmp(name, "none") == 0)
+        *format = DUMP_NONE;
+    else if (strcmp(name, "text") == 0)
+        *format = DUMP_TEXT;
+    else if (strcmp(name, "json") == 0)
+        *format = DUMP_JSON;
+    else if (strcmp(name, "binary") == 0)
+        *format = DUMP_BINARY;
+    else {
+        log_write(LOG_ERROR, "Unknown dump format: %s (expected none, text, json or binary)", name);
+        return false;
+    }
+    return true;
+}
+
+bool state_dump_write(FILE *out, DumpFormat format, const char *label, const char *engine, const CPU *cpu,
+                      const RAM *ram, uint32_t ram_start, uint32_t ram_end) {
+    if (ram_end > RAM_SIZE)
+        ram_end = RAM_SIZE;
+    if (!ram || ram_start > ram_end)
+        ram_start = ram_end = 0;
+
+    switch (format) {
+        case DUMP_NONE:
+            return true;
+        case DUMP_TEXT:
+            dump_text(out, label, engine, cpu, ram, ram_start, ram_end);
+            break;
+        case DUMP_JSON:
+            dump_json(out, label, engine, cpu, ram, ram_start, ram_end);
+            break;
+        case DUMP_BINARY:
+            if (!dump_binary(out, cpu, ram, ram_start, ram_end)) {
+                log_write(LOG_ERROR, "I/O error while writing binary state dump");
+                return false;
+            }
+            break;
+    }
+    return !ferror(out);
+}
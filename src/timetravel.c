@@ -0,0 +1,356 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "timetravel.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu_exec.h"
+#include "encoding.h"
+#include "log.h"
+
+#define TT_PAGE_WORDS (1u << RAM_PAGE_SHIFT)
+#define TT_PAGE_BYTES (TT_PAGE_WORDS * sizeof(uint32_t))
+#define TT_MASK_WORDS (RAM_PAGES / 64)
+
+/**
+ * @struct Checkpoint
+ * @brief CPU state plus the pages stored to since the previous checkpoint.
+ */
+typedef struct {
+    CPU cpu;
+    uint64_t present[TT_MASK_WORDS];   /**< Pages held in `data` */
+    uint32_t page_count;
+    uint32_t *data;                    /**< page_count pages, in ascending page order */
+} Checkpoint;
+
+struct TimeTravel {
+    CPU *cpu;
+    RAM *ram;
+    AssemblyRange range;
+    uint64_t interval;
+    size_t memory_limit;
+    size_t bytes;
+    Checkpoint *checkpoints;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t base;                     /**< Checkpoint the RAM's dirty bits are relative to */
+    uint64_t furthest;
+};
+
+static bool page_present(const Checkpoint *checkpoint, uint32_t page) {
+    return (checkpoint->present[page >> 6] >> (page & 63)) & 1;
+}
+
+/**
+ * @brief Words of `page` inside a checkpoint that holds it.
+ */
+static const uint32_t *page_data(const Checkpoint *checkpoint, uint32_t page) {
+    uint32_t rank = 0;
+    for (uint32_t w = 0; w < page >> 6; w++)
+        rank += (uint32_t)__builtin_popcountll(checkpoint->present[w]);
+    rank += (uint32_t)__builtin_popcountll(checkpoint->present[page >> 6] & ((1ull << (page & 63)) - 1));
+    return checkpoint->data + (size_t)rank * TT_PAGE_WORDS;
+}
+
+static size_t checkpoint_bytes(const Checkpoint *checkpoint) {
+    return sizeof(Checkpoint) + (size_t)checkpoint->page_count * TT_PAGE_BYTES;
+}
+
+/**
+ * @brief Merge checkpoint `from` into the later checkpoint `into`.
+ *
+ * Pages only `from` holds were not stored to between the two, so their
+ * content at `into` is the one `from` saved.
+ *
+ * @return false if memory runs out (both are left unchanged).
+ */
+static bool checkpoint_merge(Checkpoint *from, Checkpoint *into) {
+    uint64_t present[TT_MASK_WORDS];
+    uint32_t count = 0;
+    for (uint32_t w = 0; w < TT_MASK_WORDS; w++) {
+        present[w] = from->present[w] | into->present[w];
+        count += (uint32_t)__builtin_popcountll(present[w]);
+    }
+    uint32_t *data = malloc((size_t)count * TT_PAGE_BYTES);
+    if (!data)
+        return false;
+    uint32_t *out = data;
+    for (uint32_t page = 0; page < RAM_PAGES; page++) {
+        if (!((present[page >> 6] >> (page & 63)) & 1))
+            continue;
+        const Checkpoint *source = page_present(into, page) ? into : from;
+        memcpy(out, page_data(source, page), TT_PAGE_BYTES);
+        out += TT_PAGE_WORDS;
+    }
+    free(into->data);
+    free(from->data);
+    from->data = NULL;
+    into->data = data;
+    into->page_count = count;
+    memcpy(into->present, present, sizeof(present));
+    return true;
+}
+
+/**
+ * @brief Halve the number of checkpoints and double the interval.
+ *
+ * The initial and the last checkpoint are always kept.
+ */
+static void thin_checkpoints(TimeTravel *tt) {
+    uint32_t kept = 1;
+    for (uint32_t i = 1; i < tt->count; i++) {
+        if (i % 2 == 1 && i + 1 < tt->count && checkpoint_merge(&tt->checkpoints[i], &tt->checkpoints[i + 1]))
+            continue;
+        tt->checkpoints[kept++] = tt->checkpoints[i];
+    }
+    tt->count = kept;
+    tt->base = kept - 1;
+    tt->interval *= 2;
+    tt->bytes = 0;
+    for (uint32_t i = 0; i < tt->count; i++)
+        tt->bytes += checkpoint_bytes(&tt->checkpoints[i]);
+}
+
+/**
+ * @brief Save the CPU and the dirty pages as a new last checkpoint.
+ *
+ * On allocation failure nothing is saved and the dirty bits are kept, so
+ * the next checkpoint covers both slices.
+ */
+static bool take_checkpoint(TimeTravel *tt) {
+    if (tt->count == tt->capacity) {
+        uint32_t capacity = tt->capacity ? tt->capacity * 2 : 64;
+        Checkpoint *checkpoints = realloc(tt->checkpoints, capacity * sizeof(Checkpoint));
+        if (!checkpoints) {
+            log_write(LOG_WARN, "Out of memory for a checkpoint; continuing without it");
+            return false;
+        }
+        tt->checkpoints = checkpoints;
+        tt->capacity = capacity;
+    }
+
+    Checkpoint *checkpoint = &tt->checkpoints[tt->count];
+    checkpoint->cpu = *tt->cpu;
+    memcpy(checkpoint->present, tt->ram->dirty, sizeof(checkpoint->present));
+    checkpoint->page_count = 0;
+    for (uint32_t w = 0; w < TT_MASK_WORDS; w++)
+        checkpoint->page_count += (uint32_t)__builtin_popcountll(checkpoint->present[w]);
+    checkpoint->data = NULL;
+    if (checkpoint->page_count) {
+        checkpoint->data = malloc((size_t)checkpoint->page_count * TT_PAGE_BYTES);
+        if (!checkpoint->data) {
+            log_write(LOG_WARN, "Out of memory for a checkpoint; continuing without it");
+            return false;
+        }
+        uint32_t *out = checkpoint->data;
+        for (uint32_t page = 0; page < RAM_PAGES; page++) {
+            if (!page_present(checkpoint, page))
+                continue;
+            memcpy(out, &tt->ram->cells[page * TT_PAGE_WORDS], TT_PAGE_BYTES);
+            out += TT_PAGE_WORDS;
+        }
+    }
+    ram_clear_dirty(tt->ram);
+    tt->base = tt->count++;
+    tt->bytes += checkpoint_bytes(checkpoint);
+    while (tt->bytes > tt->memory_limit && tt->count > 2) {
+        uint32_t before = tt->count;
+        thin_checkpoints(tt);
+        if (tt->count == before)
+            break;
+    }
+    return true;
+}
+
+/**
+ * @brief Put the CPU and RAM in the state saved by checkpoint `k`.
+ *
+ * Only pages that can differ are copied: the dirty ones, and those
+ * stored to between the current base checkpoint and `k`.
+ */
+static void restore_checkpoint(TimeTravel *tt, uint32_t k) {
+    uint64_t fix[TT_MASK_WORDS];
+    memcpy(fix, tt->ram->dirty, sizeof(fix));
+    uint32_t low = k < tt->base ? k : tt->base;
+    uint32_t high = k < tt->base ? tt->base : k;
+    for (uint32_t j = low + 1; j <= high; j++)
+        for (uint32_t w = 0; w < TT_MASK_WORDS; w++)
+            fix[w] |= tt->checkpoints[j].present[w];
+
+    for (uint32_t page = 0; page < RAM_PAGES; page++) {
+        if (!((fix[page >> 6] >> (page & 63)) & 1))
+            continue;
+        uint32_t j = k;
+        while (!page_present(&tt->checkpoints[j], page))
+            j--;    /* checkpoint 0 holds every page */
+        memcpy(&tt->ram->cells[page * TT_PAGE_WORDS], page_data(&tt->checkpoints[j], page), TT_PAGE_BYTES);
+    }
+    *tt->cpu = tt->checkpoints[k].cpu;
+    ram_clear_dirty(tt->ram);
+    tt->base = k;
+}
+
+/**
+ * @brief Index of the last checkpoint taken at or before `instruction`.
+ */
+static uint32_t find_checkpoint(const TimeTravel *tt, uint64_t instruction) {
+    uint32_t low = 0, high = tt->count - 1;
+    while (low < high) {
+        uint32_t mid = low + (high - low + 1) / 2;
+        if (tt->checkpoints[mid].cpu.instructions_retired <= instruction)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+    return low;
+}
+
+/**
+ * @brief Restore the nearest checkpoint and re-execute up to `instruction`.
+ */
+static bool replay_to(TimeTravel *tt, uint64_t instruction) {
+    uint32_t k = find_checkpoint(tt, instruction);
+    restore_checkpoint(tt, k);
+    uint64_t remaining = instruction - tt->cpu->instructions_retired;
+    if (remaining)
+        cpu_continue(tt->cpu, tt->ram, tt->range, remaining);
+    return tt->cpu->instructions_retired == instruction;
+}
+
+TimeTravel *tt_create(CPU *cpu, RAM *ram, AssemblyRange range, uint64_t interval, size_t memory_limit) {
+    TimeTravel *tt = calloc(1, sizeof(TimeTravel));
+    if (!tt) {
+        log_write(LOG_ERROR, "Out of memory creating a time-travel session");
+        return NULL;
+    }
+    tt->cpu = cpu;
+    tt->ram = ram;
+    tt->range = range;
+    tt->interval = interval ? interval : TT_DEFAULT_INTERVAL;
+    tt->memory_limit = memory_limit ? memory_limit : TT_DEFAULT_MEMORY_LIMIT;
+
+    cpu->pc = range.start_address;
+    cpu->running = true;
+    cpu->stop_reason = CPU_STOP_NONE;
+    tt->furthest = cpu->instructions_retired;
+    memset(ram->dirty, 0xFF, sizeof(ram->dirty));
+    if (!take_checkpoint(tt)) {
+        log_write(LOG_ERROR, "Out of memory creating a time-travel session");
+        tt_destroy(tt);
+        return NULL;
+    }
+    return tt;
+}
+
+void tt_destroy(TimeTravel *tt) {
+    if (!tt)
+        return;
+    for (uint32_t i = 0; i < tt->count; i++)
+        free(tt->checkpoints[i].data);
+    free(tt->checkpoints);
+    free(tt);
+}
+
+CpuStopReason tt_run(TimeTravel *tt, uint64_t max_instructions) {
+    CPU *cpu = tt->cpu;
+    uint64_t now = cpu->instructions_retired;
+    uint64_t target = max_instructions == 0 || max_instructions > UINT64_MAX - now ? UINT64_MAX
+                                                                                  : now + max_instructions;
+    const Checkpoint *last = &tt->checkpoints[tt->count - 1];
+    if (now < last->cpu.instructions_retired) {
+        /* Inside recorded history: jump to its end instead of re-executing it. */
+        if (target <= last->cpu.instructions_retired) {
+            replay_to(tt, target);
+            return cpu->stop_reason;
+        }
+        restore_checkpoint(tt, tt->count - 1);
+    }
+
+    CpuStopReason reason;
+    for (;;) {
+        uint64_t boundary = tt->checkpoints[tt->count - 1].cpu.instructions_retired + tt->interval;
+        uint64_t stop = boundary < target ? boundary : target;
+        reason = cpu_continue(cpu, tt->ram, tt->range, stop - cpu->instructions_retired);
+        if (cpu->instructions_retired > tt->furthest)
+            tt->furthest = cpu->instructions_retired;
+        if (reason == CPU_STOP_LIMIT && cpu->instructions_retired == boundary)
+            take_checkpoint(tt);
+        if (reason != CPU_STOP_LIMIT || cpu->instructions_retired >= target)
+            break;
+    }
+    return reason;
+}
+
+bool tt_seek(TimeTravel *tt, uint64_t instruction) {
+    uint64_t now = tt->cpu->instructions_retired;
+    if (instruction == now)
+        return true;
+    if (instruction > now) {
+        tt_run(tt, instruction - now);
+        return tt->cpu->instructions_retired == instruction;
+    }
+    return replay_to(tt, instruction);
+}
+
+void tt_step_back(TimeTravel *tt, uint64_t count) {
+    uint64_t now = tt->cpu->instructions_retired;
+    uint64_t first = tt->checkpoints[0].cpu.instructions_retired;
+    tt_seek(tt, now - first > count ? now - count : first);
+}
+
+bool tt_last_write(TimeTravel *tt, uint32_t address, uint64_t *instruction) {
+    CPU *cpu = tt->cpu;
+    uint64_t now = cpu->instructions_retired;
+    uint32_t page = address >> RAM_PAGE_SHIFT;
+    if (address >= RAM_SIZE)
+        return false;
+
+    for (uint32_t j = find_checkpoint(tt, now) + 1; j-- > 0;) {
+        uint64_t start = tt->checkpoints[j].cpu.instructions_retired;
+        bool current = j + 1 == tt->count || tt->checkpoints[j + 1].cpu.instructions_retired > now;
+        uint64_t end = current ? now : tt->checkpoints[j + 1].cpu.instructions_retired;
+        if (end <= start)
+            continue;
+        /* The next checkpoint lists the pages this slice stored to; the slice in progress has the dirty bits. */
+        bool touched = current ? tt->base != j || ((tt->ram->dirty[page >> 6] >> (page & 63)) & 1)
+                               : page_present(&tt->checkpoints[j + 1], page);
+        if (!touched)
+            continue;
+
+        restore_checkpoint(tt, j);
+        bool found = false;
+        uint64_t last = 0;
+        while (cpu->instructions_retired < end) {
+            DecodedInstruction insn;
+            uint64_t index = cpu->instructions_retired;
+            bool store = decode_instruction(tt->ram->cells, RAM_SIZE, cpu->pc, tt->range.encoding, &insn)
+                      && insn.opcode == ISA_STOREM
+                      && (insn.mode == ADDR_LITERAL ? insn.operand
+                                                    : insn.operand < MAX_ADDRESS_REGISTERS
+                                                      ? cpu->address_registers[insn.operand] : RAM_SIZE) == address;
+            if (cpu_stop_is_error(cpu_step(cpu, tt->ram, tt->range)) || cpu->instructions_retired == index)
+                break;
+            if (store) {
+                found = true;
+                last = index;
+            }
+        }
+        if (found) {
+            replay_to(tt, last);
+            *instruction = last;
+            return true;
+        }
+    }
+    replay_to(tt, now);
+    return false;
+}
+
+void tt_stats(const TimeTravel *tt, TimeTravelStats *stats) {
+    stats->checkpoints = tt->count;
+    stats->bytes = tt->bytes;
+    stats->interval = tt->interval;
+    stats->furthest = tt->furthest;
+}
@@ -0,0 +1,434 @@
+//
+// Created by dev on 10/17/26.
+//
+
+#include "trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu_exec.h"
+#include "log.h"
+
+/** Words before the register block: magic, version, flags, start, end, PC. */
+#define TRACE_PREFIX_WORDS 6
+
+/**
+ * @brief Append one little-endian 32-bit word to the writer's buffer.
+ */
+static void put_u32(TraceWriter *writer, uint32_t value) {
+    if (writer->used > TRACE_BUFFER_SIZE - 4)
+        trace_writer_drain(writer);
+    for (int i = 0; i < 4; i++)
+        writer->buffer[writer->used++] = (uint8_t)(value >> (8 * i));
+}
+
+bool trace_writer_open(TraceWriter *writer, const char *path, const CPU *cpu, const RAM *ram, AssemblyRange range) {
+    memset(writer, 0, sizeof(*writer));
+    writer->buffer = malloc(TRACE_BUFFER_SIZE);
+    if (!writer->buffer) {
+        log_write(LOG_ERROR, "Out of memory allocating the trace buffer");
+        return false;
+    }
+    writer->file = fopen(path, "wb");
+    if (!writer->file) {
+        log_write(LOG_ERROR, "Unable to open trace file: %s", path);
+        free(writer->buffer);
+        writer->buffer = NULL;
+        return false;
+    }
+    writer->base_instructions = cpu->instructions_retired;
+
+    put_u32(writer, TRACE_MAGIC);
+    put_u32(writer, TRACE_VERSION);
+    put_u32(writer, range.encoding == ENCODING_PACKED ? TRACE_FLAG_PACKED : 0);
+    put_u32(writer, range.start_address);
+    put_u32(writer, range.end_address);
+    put_u32(writer, range.start_address);
+    for (int i = 0; i < MAX_REGISTERS; i++)
+        put_u32(writer, cpu->registers[i]);
+    for (int i = 0; i < MAX_ADDRESS_REGISTERS; i++)
+        put_u32(writer, cpu->address_registers[i]);
+    put_u32(writer, (cpu->zero_flag ? 1u : 0u) | (cpu->negative_flag ? 2u : 0u));
+
+    uint32_t segments = 0;
+    for (uint32_t a = 0; a < RAM_SIZE; a++)
+        if (ram->cells[a] && (a == 0 || !ram->cells[a - 1]))
+            segments++;
+    put_u32(writer, segments);
+    for (uint32_t a = 0; a < RAM_SIZE;) {
+        if (!ram->cells[a]) {
+            a++;
+            continue;
+        }
+        uint32_t end = a;
+        while (end < RAM_SIZE && ram->cells[end])
+            end++;
+        put_u32(writer, a);
+        put_u32(writer, end - a);
+        for (; a < end; a++)
+            put_u32(writer, ram->cells[a]);
+    }
+    return true;
+}
+
+void trace_writer_drain(TraceWriter *writer) {
+    if (!writer->failed && writer->used
+        && fwrite(writer->buffer, 1, writer->used, writer->file) != writer->used) {
+        log_write(LOG_ERROR, "Unable to write the trace file");
+        writer->failed = true;
+    }
+    writer->bytes += writer->used;
+    writer->used = 0;
+}
+
+void trace_flush_branches(TraceWriter *writer) {
+    if (!writer->bit_count)
+        return;
+    if (writer->used > TRACE_BUFFER_SIZE - TRACE_EVENT_MAX)
+        trace_writer_drain(writer);
+    writer->buffer[writer->used++] = TRACE_TAG_BRANCHES;
+    trace_put_varint(writer, writer->bit_count);
+    for (uint32_t i = 0; i < writer->bit_count; i += 8)
+        writer->buffer[writer->used++] = (uint8_t)(writer->bits >> i);
+    writer->branches += writer->bit_count;
+    writer->bits = 0;
+    writer->bit_count = 0;
+}
+
+bool trace_writer_close(TraceWriter *writer, const CPU *cpu) {
+    trace_flush_branches(writer);
+    if (writer->used > TRACE_BUFFER_SIZE - TRACE_EVENT_MAX)
+        trace_writer_drain(writer);
+    writer->buffer[writer->used++] = TRACE_TAG_END;
+    trace_put_varint(writer, cpu->stop_reason);
+    trace_put_varint(writer, cpu->instructions_retired - writer->base_instructions);
+    trace_put_varint(writer, cpu->pc);
+    trace_writer_drain(writer);
+
+    bool ok = !writer->failed;
+    if (fclose(writer->file) != 0 && ok) {
+        log_write(LOG_ERROR, "Unable to write the trace file");
+        ok = false;
+    }
+    free(writer->buffer);
+    writer->file = NULL;
+    writer->buffer = NULL;
+    return ok;
+}
+
+/**
+ * @brief Read one little-endian 32-bit word from the header.
+ */
+static bool read_u32(FILE *file, uint32_t *value) {
+    unsigned char bytes[4];
+    if (fread(bytes, 1, sizeof(bytes), file) != sizeof(bytes))
+        return false;
+    *value = (uint32_t)bytes[0]
+           | ((uint32_t)bytes[1] << 8)
+           | ((uint32_t)bytes[2] << 16)
+           | ((uint32_t)bytes[3] << 24);
+    return true;
+}
+
+/**
+ * @brief Log a header problem, close the file and fail.
+ */
+static bool reader_fail(TraceReader *reader, const char *path, const char *what) {
+    log_write(LOG_ERROR, "Invalid trace file %s: %s", path, what);
+    fclose(reader->file);
+    free(reader->buffer);
+    reader->file = NULL;
+    reader->buffer = NULL;
+    return false;
+}
+
+bool trace_reader_open(TraceReader *reader, const char *path, RAM *ram, CPU *cpu, AssemblyRange *range) {
+    memset(reader, 0, sizeof(*reader));
+    reader->buffer = malloc(TRACE_BUFFER_SIZE);
+    if (!reader->buffer) {
+        log_write(LOG_ERROR, "Out of memory allocating the trace buffer");
+        return false;
+    }
+    reader->file = fopen(path, "rb");
+    if (!reader->file) {
+        log_write(LOG_ERROR, "Unable to open trace file: %s", path);
+        free(reader->buffer);
+        reader->buffer = NULL;
+        return false;
+    }
+
+    uint32_t prefix[TRACE_PREFIX_WORDS];
+    for (int i = 0; i < TRACE_PREFIX_WORDS; i++)
+        if (!read_u32(reader->file, &prefix[i]))
+            return reader_fail(reader, path, "truncated header");
+    if (prefix[0] != TRACE_MAGIC)
+        return reader_fail(reader, path, "bad magic");
+    if (prefix[1] != TRACE_VERSION)
+        return reader_fail(reader, path, "unsupported version");
+    if (prefix[2] & ~TRACE_FLAG_PACKED)
+        return reader_fail(reader, path, "unknown flags");
+    if (prefix[3] > prefix[4] || prefix[4] > RAM_SIZE)
+        return reader_fail(reader, path, "bad program range");
+
+    range->start_address = prefix[3];
+    range->end_address = prefix[4];
+    range->encoding = (prefix[2] & TRACE_FLAG_PACKED) ? ENCODING_PACKED : ENCODING_WIDE;
+    range->error = false;
+
+    cpu_init(cpu);
+    cpu->pc = prefix[5];
+    uint32_t flags = 0;
+    bool ok = true;
+    for (int i = 0; i < MAX_REGISTERS; i++)
+        ok = ok && read_u32(reader->file, &cpu->registers[i]);
+    for (int i = 0; i < MAX_ADDRESS_REGISTERS; i++)
+        ok = ok && read_u32(reader->file, &cpu->address_registers[i]);
+    ok = ok && read_u32(reader->file, &flags);
+    if (!ok)
+        return reader_fail(reader, path, "truncated header");
+    cpu->zero_flag = flags & 1u;
+    cpu->negative_flag = (flags & 2u) != 0;
+    cpu->running = true;
+
+    ram_init(ram);
+    uint32_t segments;
+    if (!read_u32(reader->file, &segments))
+        return reader_fail(reader, path, "truncated header");
+    for (uint32_t s = 0; s < segments; s++) {
+        uint32_t address, count;
+        if (!read_u32(reader->file, &address) || !read_u32(reader->file, &count))
+            return reader_fail(reader, path, "truncated memory segment");
+        if (address > RAM_SIZE || count > RAM_SIZE - address)
+            return reader_fail(reader, path, "memory segment out of range");
+        for (uint32_t i = 0; i < count; i++)
+            if (!read_u32(reader->file, &ram->cells[address + i]))
+                return reader_fail(reader, path, "truncated memory segment");
+    }
+    return true;
+}
+
+/**
+ * @brief Next byte of the event stream, or -1 at end of file.
+ */
+static int reader_byte(TraceReader *reader) {
+    if (reader->position == reader->used) {
+        reader->used = fread(reader->buffer, 1, TRACE_BUFFER_SIZE, reader->file);
+        reader->position = 0;
+        if (reader->used == 0)
+            return -1;
+    }
+    return reader->buffer[reader->position++];
+}
+
+/**
+ * @brief Read one LEB128 varint.
+ */
+static bool reader_varint(TraceReader *reader, uint64_t *value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = reader_byte(reader);
+        if (byte < 0)
+            return false;
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Read a zigzag-encoded 32-bit delta.
+ */
+static bool reader_delta(TraceReader *reader, uint32_t *delta) {
+    uint64_t raw;
+    if (!reader_varint(reader, &raw) || raw > UINT32_MAX)
+        return false;
+    *delta = (uint32_t)(raw >> 1) ^ (uint32_t)-(int32_t)(raw & 1);
+    return true;
+}
+
+/**
+ * @brief Load up to 64 more outcomes of the current branch record.
+ */
+static bool reader_refill_bits(TraceReader *reader) {
+    uint32_t count = reader->record_bits_left > 64 ? 64 : (uint32_t)reader->record_bits_left;
+    reader->bits = 0;
+    for (uint32_t i = 0; i < count; i += 8) {
+        int byte = reader_byte(reader);
+        if (byte < 0)
+            return false;
+        reader->bits |= (uint64_t)byte << i;
+    }
+    reader->bits_left = count;
+    reader->record_bits_left -= count;
+    return true;
+}
+
+TraceEventKind trace_reader_next(TraceReader *reader, TraceEvent *event) {
+    memset(event, 0, sizeof(*event));
+    if (reader->ended) {
+        event->kind = TRACE_EVENT_END;
+        return event->kind;
+    }
+
+    while (!reader->bits_left) {
+        if (reader->record_bits_left) {
+            if (!reader_refill_bits(reader))
+                goto error;
+            continue;
+        }
+
+        int tag = reader_byte(reader);
+        uint64_t a, b, c;
+        uint32_t address_delta, value_delta;
+        switch (tag) {
+            case TRACE_TAG_BRANCHES:
+                if (!reader_varint(reader, &a) || a == 0)
+                    goto error;
+                reader->record_bits_left = a;
+                break;
+            case TRACE_TAG_WRITE:
+                if (!reader_delta(reader, &address_delta) || !reader_delta(reader, &value_delta))
+                    goto error;
+                reader->last_address += address_delta;
+                reader->last_value += value_delta;
+                event->kind = TRACE_EVENT_WRITE;
+                event->address = reader->last_address;
+                event->value = reader->last_value;
+                return event->kind;
+            case TRACE_TAG_END:
+                if (!reader_varint(reader, &a) || !reader_varint(reader, &b) || !reader_varint(reader, &c)
+                    || a > CPU_STOP_ERROR || c > UINT32_MAX)
+                    goto error;
+                reader->ended = true;
+                event->kind = TRACE_EVENT_END;
+                event->stop = (CpuStopReason)a;
+                event->instructions = b;
+                event->pc = (uint32_t)c;
+                return event->kind;
+            default:
+                goto error;
+        }
+    }
+
+    event->kind = TRACE_EVENT_BRANCH;
+    event->taken = reader->bits & 1;
+    reader->bits >>= 1;
+    reader->bits_left--;
+    return event->kind;
+
+error:
+    event->kind = TRACE_EVENT_ERROR;
+    return event->kind;
+}
+
+void trace_reader_close(TraceReader *reader) {
+    if (reader->file)
+        fclose(reader->file);
+    free(reader->buffer);
+    reader->file = NULL;
+    reader->buffer = NULL;
+}
+
+bool trace_replay_open(TraceReplay *replay, const char *path) {
+    memset(replay, 0, sizeof(*replay));
+    replay->ram = malloc(sizeof(RAM));
+    if (!replay->ram) {
+        log_write(LOG_ERROR, "Out of memory allocating the replay RAM");
+        return false;
+    }
+    if (!trace_reader_open(&replay->reader, path, replay->ram, &replay->cpu, &replay->range)) {
+        free(replay->ram);
+        replay->ram = NULL;
+        return false;
+    }
+    trace_reader_next(&replay->reader, &replay->next);
+    return true;
+}
+
+/**
+ * @brief Log a divergence at the current instruction.
+ */
+static TraceStepStatus replay_diverged(const TraceReplay *replay, uint32_t pc, const char *what) {
+    log_write(LOG_ERROR, "Trace diverges at instruction %llu (PC 0x%08X): %s",
+              (unsigned long long)replay->cpu.instructions_retired, pc, what);
+    return TRACE_STEP_DIVERGED;
+}
+
+/**
+ * @brief Check the END event against the replayed state.
+ */
+static TraceStepStatus replay_end(TraceReplay *replay) {
+    replay->end = replay->next;
+    CPU *cpu = &replay->cpu;
+    if (cpu->pc != replay->end.pc)
+        return replay_diverged(replay, cpu->pc, "the recorded run ended at another PC");
+    switch (replay->end.stop) {
+        case CPU_STOP_HALT:
+            if (cpu->stop_reason != CPU_STOP_HALT)
+                return replay_diverged(replay, cpu->pc, "the recorded run halted here");
+            break;
+        case CPU_STOP_END:
+            if (cpu->pc != replay->range.end_address)
+                return replay_diverged(replay, cpu->pc, "the recorded run reached the end of the range here");
+            break;
+        case CPU_STOP_LIMIT:
+            break;
+        default:
+            /* The faulting instruction did not retire; re-run it to confirm the fault. */
+            if (cpu->running && cpu_step(cpu, replay->ram, replay->range) != replay->end.stop)
+                return replay_diverged(replay, cpu->pc, "the recorded run faulted here");
+            break;
+    }
+    return TRACE_STEP_END;
+}
+
+TraceStepStatus trace_replay_step(TraceReplay *replay, TraceStep *step) {
+    CPU *cpu = &replay->cpu;
+    memset(step, 0, sizeof(*step));
+    step->index = cpu->instructions_retired;
+    step->pc = cpu->pc;
+
+    if (replay->next.kind == TRACE_EVENT_ERROR) {
+        log_write(LOG_ERROR, "Trace is truncated or malformed after %llu instructions",
+                  (unsigned long long)cpu->instructions_retired);
+        return TRACE_STEP_ERROR;
+    }
+    if (replay->next.kind == TRACE_EVENT_END && cpu->instructions_retired == replay->next.instructions)
+        return replay_end(replay);
+    if (!cpu->running || cpu->pc == replay->range.end_address)
+        return replay_diverged(replay, cpu->pc, "the replay stopped but the trace continues");
+
+    step->decoded = decode_instruction(replay->ram->cells, RAM_SIZE, cpu->pc, replay->range.encoding, &step->insn);
+    CpuStopReason reason = cpu_step(cpu, replay->ram, replay->range);
+    if (cpu_stop_is_error(reason))
+        return replay_diverged(replay, step->pc, "the replay faulted but the recorded run did not");
+
+    if (step->insn.opcode == ISA_JZ || step->insn.opcode == ISA_JNZ) {
+        step->branch = true;
+        step->taken = (step->insn.opcode == ISA_JZ) == cpu->zero_flag;
+        if (replay->next.kind != TRACE_EVENT_BRANCH)
+            return replay_diverged(replay, step->pc, "no branch outcome recorded");
+        if (replay->next.taken != step->taken)
+            return replay_diverged(replay, step->pc, "recorded branch outcome differs");
+        trace_reader_next(&replay->reader, &replay->next);
+    } else if (step->insn.opcode == ISA_STOREM) {
+        step->wrote = true;
+        step->address = step->insn.mode == ADDR_LITERAL ? step->insn.operand
+                                                        : cpu->address_registers[step->insn.operand];
+        step->value = replay->ram->cells[step->address];
+        if (replay->next.kind != TRACE_EVENT_WRITE)
+            return replay_diverged(replay, step->pc, "no write recorded");
+        if (replay->next.address != step->address || replay->next.value != step->value)
+            return replay_diverged(replay, step->pc, "recorded write differs");
+        trace_reader_next(&replay->reader, &replay->next);
+    }
+    return TRACE_STEP_OK;
+}
+
+void trace_replay_close(TraceReplay *replay) {
+    trace_reader_close(&replay->reader);
+    free(replay->ram);
+    replay->ram = NULL;
+}
@@ -1,5 +1,6 @@
 #include "../include/validation.h"
 #include "log.h"
+#include "metrics.h"
 #include "ram.h"
 
 /**
@@ -125,6 +126,7 @@ bool is_memory_access_valid(uint32_t start, uint32_t size) {
 bool is_reg_index_valid_runtime(uint32_t reg_index, CPU *cpu) {
     if (reg_index >= MAX_REGISTERS) {
         cpu->running = false;
+        metrics_add(METRIC_ERROR_REGISTER_INDEX, 1);
         log_write(LOG_ERROR, "Invalid register index %u", reg_index);
         return false;
     }
@@ -144,6 +146,7 @@ bool is_reg_index_valid_runtime(uint32_t reg_index, CPU *cpu) {
 bool is_addr_index_valid_runtime(uint32_t addr_index, CPU *cpu) {
     if (addr_index >= MAX_ADDRESS_REGISTERS) {
         cpu->running = false;
+        metrics_add(METRIC_ERROR_ADDRESS_INDEX, 1);
         log_write(LOG_ERROR, "Invalid address register index %u", addr_index);
         return false;
     }
@@ -163,6 +166,7 @@ bool is_addr_index_valid_runtime(uint32_t addr_index, CPU *cpu) {
 bool is_addr_literal_valid_runtime(uint32_t addr, CPU *cpu) {
     if (addr >= RAM_SIZE) {
         cpu->running = false;
+        metrics_add(METRIC_ERROR_ADDRESS_LITERAL, 1);
         log_write(LOG_ERROR, "Invalid literal address: 0x%08X", addr);
         return false;
     }
@@ -183,6 +187,7 @@ bool is_addr_literal_valid_runtime(uint32_t addr, CPU *cpu) {
 bool is_memory_access_valid_runtime(uint32_t start, uint32_t size, CPU *cpu) {
     if (!is_memory_access_valid(start, size)) {
         cpu->running = false;
+        metrics_add(METRIC_ERROR_MEMORY_BOUNDS, 1);
         return false;
     }
     return true;
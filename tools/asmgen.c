@@ -0,0 +1,99 @@
+//
+// Created by dev on 10/17/26.
+//
+
+/**
+ * @file asmgen.c
+ * @brief Generate a synthetic assembly program (see asmgen.h).
+ *
+ * Usage: asmgen [options]
+ *   -o FILE              write to FILE instead of stdout
+ *   --seed N             RNG seed (default 1)
+ *   --instructions N     body size in instructions (default 4096)
+ *   --labels N           labels spread over the body (default 256)
+ *   --branch-density F   fraction of body instructions that branch (default 0.10)
+ *   --memory N           data region size in words (default 4096)
+ *   --data-base ADDR     first data word (default: top of RAM)
+ *   --iterations N       outer loop trip count (default 256)
+ *   --org ADDR           address of the first instruction (default 0)
+ *   --mix SPEC           class weights, e.g. alu=40,mul=5,div=3,load=15,store=10,cmp=10,loadi=7
+ * A summary (static size, labels, upper bound on retired instructions) is
+ * printed to stderr.
+ *
+ * Example: asmgen --instructions 1000000 --labels 50000 --iterations 1 -o big.asm
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "asmgen.h"
+#include "log.h"
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [-o FILE] [--seed N] [--instructions N] [--labels N] [--branch-density F]\n"
+                    "       [--memory N] [--data-base ADDR] [--iterations N] [--org ADDR] [--mix SPEC]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    AsmGenConfig config;
+    asmgen_default_config(&config);
+    const char *output = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!value) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (strcmp(arg, "-o") == 0) {
+            output = value;
+        } else if (strcmp(arg, "--seed") == 0) {
+            config.seed = strtoull(value, NULL, 0);
+        } else if (strcmp(arg, "--instructions") == 0) {
+            config.instructions = (uint32_t)strtoul(value, NULL, 0);
+        } else if (strcmp(arg, "--labels") == 0) {
+            config.labels = (uint32_t)strtoul(value, NULL, 0);
+        } else if (strcmp(arg, "--branch-density") == 0) {
+            config.branch_density = atof(value);
+        } else if (strcmp(arg, "--memory") == 0) {
+            config.memory_words = (uint32_t)strtoul(value, NULL, 0);
+        } else if (strcmp(arg, "--data-base") == 0) {
+            config.data_base = (uint32_t)strtoul(value, NULL, 0);
+        } else if (strcmp(arg, "--iterations") == 0) {
+            config.iterations = (uint32_t)strtoul(value, NULL, 0);
+        } else if (strcmp(arg, "--org") == 0) {
+            config.origin = (uint32_t)strtoul(value, NULL, 0);
+        } else if (strcmp(arg, "--mix") == 0) {
+            if (!asmgen_parse_mix(value, &config.mix))
+                return 2;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+    }
+
+    log_set_enabled(LOG_DEBUG, false);
+    log_set_enabled(LOG_INFO, false);
+
+    FILE *out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+        perror(output);
+        return 1;
+    }
+
+    AsmGenStats stats;
+    bool ok = asmgen_write(&config, out, &stats);
+    if (output && fclose(out) != 0)
+        ok = false;
+    if (!ok)
+        return 1;
+
+    fprintf(stderr, "asmgen: %llu instructions (%llu words wide), %u labels, %u branches, %u loads, %u stores, "
+                    "<= %llu retired\n",
+            (unsigned long long)stats.instructions, (unsigned long long)stats.wide_words, stats.labels,
+            stats.branches, stats.loads, stats.stores, (unsigned long long)stats.dynamic_upper);
+    return 0;
+}
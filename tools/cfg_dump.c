@@ -0,0 +1,99 @@
+//
+// Created by dev on 10/17/26.
+//
+
+/**
+ * @file cfg_dump.c
+ * @brief Print the control-flow graph of a program as Graphviz DOT.
+ *
+ * Usage: cfg_dump [--packed] [--summary] [--no-insns] file
+ *   --packed    assemble .asm input with the packed encoding
+ *   --summary   print block/loop statistics and build time instead of DOT
+ *   --no-insns  omit instruction listings from the DOT node labels
+ * Files ending in ".asm" are assembled; anything else is loaded as a
+ * binary image (see image.h).
+ *
+ * Example: cfg_dump asm-programs/loop.asm | dot -Tsvg -o loop.svg
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "assembler.h"
+#include "cfg.h"
+#include "image.h"
+#include "log.h"
+#include "ram.h"
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static bool has_suffix(const char *s, const char *suffix) {
+    size_t len = strlen(s);
+    size_t slen = strlen(suffix);
+    return len >= slen && strcmp(s + len - slen, suffix) == 0;
+}
+
+int main(int argc, char **argv) {
+    InstructionEncoding encoding = ENCODING_WIDE;
+    bool summary = false;
+    bool with_instructions = true;
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--packed") == 0) {
+            encoding = ENCODING_PACKED;
+        } else if (strcmp(argv[i], "--summary") == 0) {
+            summary = true;
+        } else if (strcmp(argv[i], "--no-insns") == 0) {
+            with_instructions = false;
+        } else if (argv[i][0] == '-' || path) {
+            fprintf(stderr, "Usage: %s [--packed] [--summary] [--no-insns] file\n", argv[0]);
+            return 2;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "Usage: %s [--packed] [--summary] [--no-insns] file\n", argv[0]);
+        return 2;
+    }
+
+    log_set_enabled(LOG_DEBUG, false);
+    log_set_enabled(LOG_INFO, false);
+
+    static RAM ram;
+    ram_init(&ram);
+    AssemblyRange range = has_suffix(path, ".asm")
+        ? assemble_into(ram.cells, RAM_SIZE, path, encoding)
+        : image_load(&ram, path);
+    if (range.error) {
+        fprintf(stderr, "Unable to load %s\n", path);
+        return 1;
+    }
+
+    ControlFlowGraph cfg;
+    uint64_t t0 = now_ns();
+    bool ok = cfg_build(&cfg, ram.cells, RAM_SIZE, range);
+    uint64_t elapsed = now_ns() - t0;
+    if (!ok) {
+        cfg_free(&cfg);
+        return 1;
+    }
+
+    if (summary) {
+        cfg_print_summary(&cfg, stdout);
+        printf("  built in %.3f ms (%.1f ns/instruction)\n", (double)elapsed / 1e6,
+               cfg.insn_count ? (double)elapsed / cfg.insn_count : 0.0);
+    } else {
+        cfg_write_dot(&cfg, stdout, with_instructions);
+    }
+
+    cfg_free(&cfg);
+    return 0;
+}
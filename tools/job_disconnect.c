@@ -0,0 +1,227 @@
+//
+// Created by dev on 10/17/26.
+//
+
+/**
+ * @file job_disconnect.c
+ * @brief Regression client: disconnect from the job server with jobs in flight.
+ *
+ * Each round opens `connections` sockets, pipelines `depth` RUN_SOURCE
+ * requests on each in one write and hangs up at once, so the server sees
+ * the hangups while the workers still hold their jobs and completions land
+ * in the same epoll batch as the hangup events. Every other round
+ * half-closes all sockets first (shutdown(SHUT_WR)) and spreads the hangups
+ * out, so the server reaches end of input with jobs pending and the last
+ * result of a connection, which makes the server close it, races its
+ * hangup. After the last round one request is run to completion to check
+ * the server is still serving; run the server under AddressSanitizer to
+ * catch a use-after-free.
+ *
+ * Usage: job_disconnect -s SOCKET [-r rounds] [-c connections] [-d depth] [-f program.asm]
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "job_protocol.h"
+
+#define MAX_CONNECTIONS 256
+
+/** A few dozen instructions, so completions race the hangups in the same epoll batch. */
+static const char default_program[] =
+    "    LOADI R0, 0\n"
+    "    LOADI R2, 20\n"
+    "loop:\n"
+    "    ADD R0, 1\n"
+    "    CMP R0, R2\n"
+    "    JNZ loop\n"
+    "    HALT\n";
+
+static int connect_socket(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool send_all(int fd, const JobBuffer *out) {
+    size_t sent = 0;
+    while (sent < out->length) {
+        ssize_t n = send(fd, out->data + sent, out->length - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * @brief Run one request to completion on a fresh connection.
+ */
+static bool check_alive(const char *socket_path, const JobBuffer *frame) {
+    int fd = connect_socket(socket_path);
+    if (fd < 0)
+        return false;
+    JobBuffer in = { 0 }, scratch = { 0 };
+    JobResult result;
+    uint32_t length;
+    int ready = 0;
+    bool ok = send_all(fd, frame);
+    while (ok && (ready = job_frame_ready(&in, &length)) == 0) {
+        uint8_t chunk[4096];
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        ok = n > 0 && job_buffer_append(&in, chunk, (size_t)n);
+    }
+    ok = ok && ready > 0 && job_buffer_append(&scratch, in.data + 4, length)
+         && job_decode_result(scratch.data, length, &result) && result.status == JOB_STATUS_OK;
+    close(fd);
+    job_buffer_free(&in);
+    job_buffer_free(&scratch);
+    return ok;
+}
+
+/**
+ * @brief Read a whole file into a malloc'd buffer.
+ */
+static char *read_file(const char *path, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+    char *data = NULL;
+    size_t capacity = 0, used = 0, n;
+    do {
+        if (used == capacity) {
+            capacity = capacity ? capacity * 2 : 4096;
+            char *grown = realloc(data, capacity);
+            if (!grown) {
+                free(data);
+                fclose(file);
+                return NULL;
+            }
+            data = grown;
+        }
+        n = fread(data + used, 1, capacity - used, file);
+        used += n;
+    } while (n > 0);
+    fclose(file);
+    *length = used;
+    return data;
+}
+
+int main(int argc, char **argv) {
+    const char *socket_path = NULL;
+    const char *program_path = NULL;
+    size_t rounds = 1000, connections = 16, depth = 50;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!value) {
+            fprintf(stderr, "usage: %s -s SOCKET [-r rounds] [-c connections] [-d depth] [-f program.asm]\n",
+                    argv[0]);
+            return 2;
+        }
+        if (strcmp(argv[i], "-s") == 0)
+            socket_path = value;
+        else if (strcmp(argv[i], "-r") == 0)
+            rounds = strtoul(value, NULL, 10);
+        else if (strcmp(argv[i], "-c") == 0)
+            connections = strtoul(value, NULL, 10);
+        else if (strcmp(argv[i], "-d") == 0)
+            depth = strtoul(value, NULL, 10);
+        else if (strcmp(argv[i], "-f") == 0)
+            program_path = value;
+        else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+        i++;
+    }
+    if (!socket_path || connections == 0 || connections > MAX_CONNECTIONS || depth == 0) {
+        fprintf(stderr, "need -s SOCKET, -c from 1 to %d and a nonzero -d\n", MAX_CONNECTIONS);
+        return 2;
+    }
+
+    const char *source = default_program;
+    size_t source_length = strlen(default_program);
+    char *loaded = NULL;
+    if (program_path) {
+        loaded = read_file(program_path, &source_length);
+        if (!loaded) {
+            fprintf(stderr, "cannot read %s\n", program_path);
+            return 1;
+        }
+        source = loaded;
+    }
+
+    /* The same `depth` frames are sent every round. */
+    JobBuffer burst = { 0 }, single = { 0 };
+    JobRequest request;
+    memset(&request, 0, sizeof(request));
+    request.type = JOB_MSG_RUN_SOURCE;
+    request.source = source;
+    request.source_length = (uint32_t)source_length;
+    bool ok = job_encode_request(&single, &request);
+    for (size_t i = 0; ok && i < depth; i++) {
+        request.request_id = (uint32_t)i;
+        ok = job_encode_request(&burst, &request);
+    }
+    if (!ok) {
+        fprintf(stderr, "out of memory encoding the requests\n");
+        return 1;
+    }
+
+    int fds[MAX_CONNECTIONS];
+    size_t failed_connects = 0;
+    for (size_t round = 0; round < rounds; round++) {
+        size_t open = 0;
+        for (size_t c = 0; c < connections; c++) {
+            int fd = connect_socket(socket_path);
+            if (fd < 0) {
+                /* The backlog may be full for a moment; a server that died fails check_alive(). */
+                failed_connects++;
+                continue;
+            }
+            send_all(fd, &burst);
+            fds[open++] = fd;
+        }
+        if (round % 2) {
+            /* Let the server read end of input, then hang up while the results trickle out. */
+            for (size_t c = 0; c < open; c++)
+                shutdown(fds[c], SHUT_WR);
+            for (size_t c = 0; c < open; c++) {
+                usleep(20);
+                close(fds[c]);
+            }
+        } else {
+            for (size_t c = 0; c < open; c++)
+                close(fds[c]);
+        }
+    }
+
+    bool alive = check_alive(socket_path, &single);
+    printf("rounds     %zu x %zu connections (%zu requests each, %zu connects failed)\n", rounds, connections,
+           depth, failed_connects);
+    printf("server     %s\n", alive ? "still serving" : "NOT RESPONDING");
+
+    job_buffer_free(&burst);
+    job_buffer_free(&single);
+    free(loaded);
+    return alive ? 0 : 1;
+}
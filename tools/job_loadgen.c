@@ -0,0 +1,378 @@
+//
+// Created by dev on 10/17/26.
+//
+
+/**
+ * @file job_loadgen.c
+ * @brief Load generator for the job server (32bit_cpu_emulator --serve).
+ *
+ * Each connection runs on its own thread: it sends the program source once
+ * to learn its cache id, then keeps `depth` RUN_PROGRAM requests in flight,
+ * each patching a fresh input window. Results may arrive out of order, so
+ * every in-flight request owns a slot (its request id) until it completes. Latency is measured per request from
+ * encode to decoded result, and the percentiles over all connections are
+ * printed at the end. With the built-in program every result is checked
+ * against the checksum computed on the host.
+ *
+ * Usage: job_loadgen -s SOCKET [-c connections] [-n requests] [-d depth]
+ *                    [-f program.asm] [-p patch_words] [-l limit]
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "job_protocol.h"
+
+#define INPUT_BASE   0x4000
+#define OUTPUT_BASE  0x4100
+#define MAX_WORDS    4096
+
+/** Sum of the input window into R0, stored at OUTPUT_BASE (written by build_default_program). */
+static char default_program[1 << 16];
+
+typedef struct {
+    const char *socket_path;
+    const char *source;
+    size_t source_length;
+    bool verify;                 /**< Built-in program: check the checksum */
+    size_t requests;             /**< Requests for this connection */
+    size_t depth;
+    uint32_t patch_words;
+    uint64_t limit;
+    unsigned seed;
+
+    uint64_t *latencies;         /**< One entry per completed request */
+    size_t completed;
+    size_t failed;               /**< status != OK */
+    size_t wrong;                /**< Checksum mismatches */
+    bool error;                  /**< Connection-level failure */
+} Client;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void build_default_program(uint32_t words) {
+    size_t n = (size_t)snprintf(default_program, sizeof(default_program), ".org 0x0000\n    LOADI R0, 0\n");
+    for (uint32_t i = 0; i < words; i++)
+        n += (size_t)snprintf(default_program + n, sizeof(default_program) - n,
+                              "    LOADM R1, (0x%04X)\n    ADD R0, R1\n", INPUT_BASE + i);
+    snprintf(default_program + n, sizeof(default_program) - n, "    STOREM (0x%04X), R0\n    HALT\n",
+             OUTPUT_BASE);
+}
+
+static int connect_socket(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool send_all(int fd, JobBuffer *out) {
+    size_t sent = 0;
+    while (sent < out->length) {
+        ssize_t n = send(fd, out->data + sent, out->length - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        sent += (size_t)n;
+    }
+    out->length = 0;
+    return true;
+}
+
+/**
+ * @brief Block until one result frame is buffered, then decode it.
+ *
+ * `scratch` receives an aligned copy of the payload the result points into.
+ */
+static bool receive_result(int fd, JobBuffer *in, JobBuffer *scratch, JobResult *result) {
+    uint32_t length;
+    int ready;
+    while ((ready = job_frame_ready(in, &length)) == 0) {
+        uint8_t chunk[65536];
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0 || !job_buffer_append(in, chunk, (size_t)n))
+            return false;
+    }
+    if (ready < 0)
+        return false;
+    scratch->length = 0;
+    if (!job_buffer_append(scratch, in->data + 4, length))
+        return false;
+    job_buffer_consume(in, 4 + (size_t)length);
+    return job_decode_result(scratch->data, length, result);
+}
+
+static void *client_main(void *arg) {
+    Client *client = arg;
+    int fd = connect_socket(client->socket_path);
+    if (fd < 0) {
+        fprintf(stderr, "connect %s: %s\n", client->socket_path, strerror(errno));
+        client->error = true;
+        return NULL;
+    }
+
+    JobBuffer out = { 0 }, in = { 0 }, scratch = { 0 };
+    JobResult result;
+    uint32_t *inputs = malloc(client->depth * MAX_WORDS * sizeof(uint32_t));
+    uint64_t *sent_at = malloc(client->depth * sizeof(uint64_t));
+    uint32_t *free_slots = malloc(client->depth * sizeof(uint32_t));
+    client->latencies = malloc((client->requests ? client->requests : 1) * sizeof(uint64_t));
+    if (!inputs || !sent_at || !free_slots || !client->latencies) {
+        client->error = true;
+        goto done;
+    }
+
+    /* Register the program: the first run assembles it and returns its id. */
+    JobRequest request;
+    memset(&request, 0, sizeof(request));
+    request.type = JOB_MSG_RUN_SOURCE;
+    request.source = client->source;
+    request.source_length = (uint32_t)client->source_length;
+    if (!job_encode_request(&out, &request) || !send_all(fd, &out)
+        || !receive_result(fd, &in, &scratch, &result) || result.status != JOB_STATUS_OK) {
+        fprintf(stderr, "program registration failed (%s)\n", job_status_name((JobStatus)result.status));
+        client->error = true;
+        goto done;
+    }
+    uint64_t program_id = result.program_id;
+
+    size_t sent = 0, free_count = client->depth;
+    for (size_t i = 0; i < client->depth; i++)
+        free_slots[i] = (uint32_t)(client->depth - 1 - i);
+    while (client->completed + client->failed < client->requests) {
+        /* Top the pipeline up to `depth` requests. */
+        while (free_count > 0 && sent < client->requests) {
+            uint32_t slot = free_slots[--free_count];
+            uint32_t *words = &inputs[(size_t)slot * MAX_WORDS];
+            for (uint32_t i = 0; i < client->patch_words; i++)
+                words[i] = (uint32_t)rand_r(&client->seed);
+            JobPatch patch = { INPUT_BASE, client->patch_words, words };
+            memset(&request, 0, sizeof(request));
+            request.type = JOB_MSG_RUN_PROGRAM;
+            request.request_id = slot;
+            request.program_id = program_id;
+            request.max_instructions = client->limit;
+            request.patches = &patch;
+            request.patch_count = client->patch_words ? 1 : 0;
+            request.output_address = OUTPUT_BASE;
+            request.output_count = client->verify ? 1 : 0;
+            sent_at[slot] = now_ns();
+            if (!job_encode_request(&out, &request)) {
+                client->error = true;
+                goto done;
+            }
+            sent++;
+        }
+        if (out.length && !send_all(fd, &out)) {
+            client->error = true;
+            goto done;
+        }
+
+        if (!receive_result(fd, &in, &scratch, &result)) {
+            fprintf(stderr, "connection lost\n");
+            client->error = true;
+            goto done;
+        }
+        uint32_t slot = result.request_id;
+        if (slot >= client->depth) {
+            client->error = true;
+            goto done;
+        }
+        free_slots[free_count++] = slot;
+        if (result.status != JOB_STATUS_OK) {
+            client->failed++;
+            continue;
+        }
+        client->latencies[client->completed++] = now_ns() - sent_at[slot];
+        if (client->verify) {
+            uint32_t expected = 0;
+            for (uint32_t i = 0; i < client->patch_words; i++)
+                expected += inputs[(size_t)slot * MAX_WORDS + i];
+            if (result.output_count != 1 || result.output[0] != expected || result.registers[0] != expected)
+                client->wrong++;
+        }
+    }
+
+done:
+    close(fd);
+    job_buffer_free(&out);
+    job_buffer_free(&in);
+    job_buffer_free(&scratch);
+    free(inputs);
+    free(sent_at);
+    free(free_slots);
+    return NULL;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_us(const uint64_t *sorted, size_t count, double p) {
+    if (count == 0)
+        return 0.0;
+    size_t index = (size_t)(p / 100.0 * (double)(count - 1) + 0.5);
+    return (double)sorted[index] / 1e3;
+}
+
+/**
+ * @brief Read a whole file into a malloc'd buffer.
+ */
+static char *read_file(const char *path, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+    char *data = NULL;
+    size_t capacity = 0, used = 0, n;
+    do {
+        if (used == capacity) {
+            capacity = capacity ? capacity * 2 : 4096;
+            char *grown = realloc(data, capacity);
+            if (!grown) {
+                free(data);
+                fclose(file);
+                return NULL;
+            }
+            data = grown;
+        }
+        n = fread(data + used, 1, capacity - used, file);
+        used += n;
+    } while (n > 0);
+    fclose(file);
+    *length = used;
+    return data;
+}
+
+int main(int argc, char **argv) {
+    const char *socket_path = NULL;
+    const char *program_path = NULL;
+    size_t connections = 4, requests = 100000, depth = 8;
+    uint32_t patch_words = 16;
+    uint64_t limit = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!value) {
+            fprintf(stderr, "usage: %s -s SOCKET [-c connections] [-n requests] [-d depth] [-f program.asm] "
+                            "[-p patch_words] [-l limit]\n", argv[0]);
+            return 2;
+        }
+        if (strcmp(argv[i], "-s") == 0)
+            socket_path = value;
+        else if (strcmp(argv[i], "-c") == 0)
+            connections = strtoul(value, NULL, 10);
+        else if (strcmp(argv[i], "-n") == 0)
+            requests = strtoul(value, NULL, 10);
+        else if (strcmp(argv[i], "-d") == 0)
+            depth = strtoul(value, NULL, 10);
+        else if (strcmp(argv[i], "-f") == 0)
+            program_path = value;
+        else if (strcmp(argv[i], "-p") == 0)
+            patch_words = (uint32_t)strtoul(value, NULL, 10);
+        else if (strcmp(argv[i], "-l") == 0)
+            limit = strtoull(value, NULL, 0);
+        else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+        i++;
+    }
+    if (!socket_path || connections == 0 || depth == 0 || patch_words > MAX_WORDS) {
+        fprintf(stderr, "need -s SOCKET, nonzero -c/-d and -p <= %d\n", MAX_WORDS);
+        return 2;
+    }
+
+    const char *source;
+    size_t source_length;
+    char *loaded = NULL;
+    if (program_path) {
+        loaded = read_file(program_path, &source_length);
+        if (!loaded) {
+            fprintf(stderr, "cannot read %s\n", program_path);
+            return 1;
+        }
+        source = loaded;
+    } else {
+        if (patch_words > 1000) {
+            fprintf(stderr, "the built-in program sums at most 1000 words\n");
+            return 2;
+        }
+        build_default_program(patch_words);
+        source = default_program;
+        source_length = strlen(default_program);
+    }
+
+    Client *clients = calloc(connections, sizeof(Client));
+    pthread_t *threads = calloc(connections, sizeof(pthread_t));
+    if (!clients || !threads)
+        return 1;
+    for (size_t c = 0; c < connections; c++) {
+        clients[c] = (Client){
+            .socket_path = socket_path, .source = source, .source_length = source_length,
+            .verify = program_path == NULL, .requests = requests / connections + (c < requests % connections),
+            .depth = depth, .patch_words = patch_words, .limit = limit, .seed = (unsigned)(c * 7919 + 1),
+        };
+    }
+
+    uint64_t t0 = now_ns();
+    for (size_t c = 0; c < connections; c++)
+        pthread_create(&threads[c], NULL, client_main, &clients[c]);
+    for (size_t c = 0; c < connections; c++)
+        pthread_join(threads[c], NULL);
+    uint64_t elapsed = now_ns() - t0;
+
+    size_t completed = 0, failed = 0, wrong = 0;
+    bool error = false;
+    for (size_t c = 0; c < connections; c++) {
+        completed += clients[c].completed;
+        failed += clients[c].failed;
+        wrong += clients[c].wrong;
+        error |= clients[c].error;
+    }
+    uint64_t *all = malloc((completed ? completed : 1) * sizeof(uint64_t));
+    size_t at = 0;
+    for (size_t c = 0; c < connections; c++) {
+        if (clients[c].latencies && clients[c].completed)
+            memcpy(all + at, clients[c].latencies, clients[c].completed * sizeof(uint64_t));
+        at += clients[c].completed;
+        free(clients[c].latencies);
+    }
+    qsort(all, completed, sizeof(uint64_t), compare_u64);
+
+    printf("requests   %zu ok, %zu failed, %zu wrong results (%zu connections, depth %zu)\n", completed, failed,
+           wrong, connections, depth);
+    printf("throughput %.0f req/s over %.3f s\n", (double)completed * 1e9 / (double)elapsed, (double)elapsed / 1e9);
+    printf("latency us p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n", percentile_us(all, completed, 50),
+           percentile_us(all, completed, 90), percentile_us(all, completed, 99),
+           percentile_us(all, completed, 99.9), completed ? (double)all[completed - 1] / 1e3 : 0.0);
+
+    free(all);
+    free(clients);
+    free(threads);
+    free(loaded);
+    return error || failed || wrong ? 1 : 0;
+}
@@ -0,0 +1,327 @@
+//
+// Created by dev on 10/17/26.
+//
+
+/**
+ * @file trace_tool.c
+ * @brief Offline analysis of execution traces recorded with --trace.
+ *
+ * Usage: trace_tool dump [--full] [--from N] [--count N] trace
+ *        trace_tool stats trace
+ *        trace_tool diff trace_a trace_b
+ *   dump   replay the trace and print one line per instruction: index,
+ *          PC, disassembly, branch outcome, store, and the registers and
+ *          flags it changed (--full: every register after it)
+ *   stats  instruction mix, branch and store counts, hottest PCs and the
+ *          size of the trace per instruction
+ *   diff   replay both traces in lockstep and report the first
+ *          instruction where PC, registers, flags or stores differ
+ * Every command re-executes the program from the initial state stored in
+ * the trace and checks each recorded event, so a trace that does not
+ * match its program is reported instead of silently misread.
+ *
+ * Exit status: 0 success (diff: identical), 1 traces differ, 2 usage or
+ * I/O error, 3 the trace is inconsistent.
+ *
+ * Example: 32bit_cpu_emulator -q --trace run.trc prog.asm && trace_tool stats run.trc
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+#include "disasm.h"
+#include "encoding.h"
+#include "log.h"
+#include "trace.h"
+
+#define HOT_PCS 10
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "Usage: %s dump [--full] [--from N] [--count N] trace\n"
+            "       %s stats trace\n"
+            "       %s diff trace_a trace_b\n",
+            argv0, argv0, argv0);
+}
+
+/**
+ * @brief Print the CPU registers and flags that differ between `before` and `after`.
+ */
+static void print_changes(const CPU *before, const CPU *after, bool full) {
+    for (int i = 0; i < MAX_REGISTERS; i++)
+        if (full || before->registers[i] != after->registers[i])
+            printf(" R%d=%u", i, after->registers[i]);
+    for (int i = 0; i < MAX_ADDRESS_REGISTERS; i++)
+        if (full || before->address_registers[i] != after->address_registers[i])
+            printf(" A%d=0x%X", i, after->address_registers[i]);
+    if (full || before->zero_flag != after->zero_flag)
+        printf(" Z=%d", after->zero_flag);
+    if (full || before->negative_flag != after->negative_flag)
+        printf(" N=%d", after->negative_flag);
+}
+
+/**
+ * @brief Print one replayed instruction.
+ */
+static void print_step(const TraceStep *step, const CPU *before, const CPU *after, bool full) {
+    char text[64];
+    if (step->decoded)
+        format_instruction(&step->insn, text, sizeof(text));
+    else
+        snprintf(text, sizeof(text), "??? 0x%08X", step->insn.opcode);
+    printf("%10llu  %08X  %-28s", (unsigned long long)step->index, step->pc, text);
+    if (step->branch)
+        printf(" %s", step->taken ? "taken" : "not-taken");
+    if (step->wrote)
+        printf(" [0x%X]=%u", step->address, step->value);
+    print_changes(before, after, full);
+    printf("\n");
+}
+
+/**
+ * @brief Print how the replay ended (or why it could not finish).
+ *
+ * @return Exit status for the command.
+ */
+static int report_end(const TraceReplay *replay, TraceStepStatus status) {
+    if (status != TRACE_STEP_END)
+        return 3;
+    printf("end: %s at PC %08X after %llu instructions\n", cpu_stop_reason_name(replay->end.stop),
+           replay->end.pc, (unsigned long long)replay->end.instructions);
+    return 0;
+}
+
+static int command_dump(const char *path, bool full, uint64_t from, uint64_t count) {
+    TraceReplay replay;
+    if (!trace_replay_open(&replay, path))
+        return 2;
+
+    TraceStep step;
+    TraceStepStatus status;
+    CPU before = replay.cpu;
+    while ((status = trace_replay_step(&replay, &step)) == TRACE_STEP_OK) {
+        if (step.index >= from && step.index - from < count)
+            print_step(&step, &before, &replay.cpu, full);
+        before = replay.cpu;
+    }
+    int code = report_end(&replay, status);
+    trace_replay_close(&replay);
+    return code;
+}
+
+static int compare_counts(const void *a, const void *b) {
+    const uint64_t *x = a;
+    const uint64_t *y = b;
+    return x[1] < y[1] ? 1 : x[1] > y[1] ? -1 : 0;
+}
+
+static int command_stats(const char *path) {
+    TraceReplay replay;
+    if (!trace_replay_open(&replay, path))
+        return 2;
+    uint64_t *pc_counts = calloc(RAM_SIZE, sizeof(uint64_t));
+    uint8_t *written = calloc(RAM_SIZE, 1);
+    if (!pc_counts || !written) {
+        log_write(LOG_ERROR, "Out of memory");
+        free(pc_counts);
+        free(written);
+        trace_replay_close(&replay);
+        return 2;
+    }
+
+    uint64_t opcodes[256] = {0};
+    uint64_t branches = 0, taken = 0, writes = 0;
+    uint32_t distinct = 0;
+    TraceStep step;
+    TraceStepStatus status;
+    while ((status = trace_replay_step(&replay, &step)) == TRACE_STEP_OK) {
+        opcodes[step.insn.opcode & 0xFF]++;
+        if (step.pc < RAM_SIZE)
+            pc_counts[step.pc]++;
+        branches += step.branch;
+        taken += step.branch && step.taken;
+        if (step.wrote) {
+            writes++;
+            distinct += !written[step.address];
+            written[step.address] = 1;
+        }
+    }
+
+    int code = report_end(&replay, status);
+    uint64_t total = replay.cpu.instructions_retired;
+    FILE *file = fopen(path, "rb");
+    long bytes = -1;
+    if (file && fseek(file, 0, SEEK_END) == 0)
+        bytes = ftell(file);
+    if (file)
+        fclose(file);
+
+    printf("instructions: %llu\n", (unsigned long long)total);
+    if (bytes >= 0)
+        printf("trace size:   %ld bytes (%.3f bytes/instruction)\n", bytes,
+               total ? (double)bytes / (double)total : 0.0);
+    printf("branches:     %llu conditional, %.1f%% taken\n", (unsigned long long)branches,
+           branches ? 100.0 * (double)taken / (double)branches : 0.0);
+    printf("stores:       %llu to %u distinct addresses\n", (unsigned long long)writes, distinct);
+
+    printf("\ninstruction mix:\n");
+    for (int op = 0; op < 256; op++)
+        if (opcodes[op])
+            printf("  %-8s %12llu  %5.1f%%\n", opcode_mnemonic((uint32_t)op), (unsigned long long)opcodes[op],
+                   100.0 * (double)opcodes[op] / (double)(total ? total : 1));
+
+    /* (pc, count) pairs of every executed PC, hottest first. */
+    uint64_t (*hot)[2] = malloc(RAM_SIZE * sizeof(*hot));
+    uint32_t hot_count = 0;
+    if (hot) {
+        for (uint32_t pc = 0; pc < RAM_SIZE; pc++)
+            if (pc_counts[pc]) {
+                hot[hot_count][0] = pc;
+                hot[hot_count][1] = pc_counts[pc];
+                hot_count++;
+            }
+        qsort(hot, hot_count, sizeof(*hot), compare_counts);
+        printf("\nhottest PCs:\n");
+        for (uint32_t i = 0; i < hot_count && i < HOT_PCS; i++)
+            printf("  %08llX %12llu  %5.1f%%\n", (unsigned long long)hot[i][0], (unsigned long long)hot[i][1],
+                   100.0 * (double)hot[i][1] / (double)(total ? total : 1));
+        free(hot);
+    }
+
+    free(pc_counts);
+    free(written);
+    trace_replay_close(&replay);
+    return code;
+}
+
+/**
+ * @brief Return true if the architectural state of two CPUs matches.
+ */
+static bool same_cpu(const CPU *a, const CPU *b) {
+    return a->pc == b->pc && a->zero_flag == b->zero_flag && a->negative_flag == b->negative_flag
+        && memcmp(a->registers, b->registers, sizeof(a->registers)) == 0
+        && memcmp(a->address_registers, b->address_registers, sizeof(a->address_registers)) == 0;
+}
+
+static int command_diff(const char *path_a, const char *path_b) {
+    TraceReplay a, b;
+    if (!trace_replay_open(&a, path_a))
+        return 2;
+    if (!trace_replay_open(&b, path_b)) {
+        trace_replay_close(&a);
+        return 2;
+    }
+
+    int code = 0;
+    if (a.range.start_address != b.range.start_address || a.range.end_address != b.range.end_address
+        || a.range.encoding != b.range.encoding) {
+        printf("program ranges differ: [%08X, %08X) vs [%08X, %08X)\n", a.range.start_address,
+               a.range.end_address, b.range.start_address, b.range.end_address);
+        code = 1;
+    }
+    uint32_t differing = 0, first = 0;
+    for (uint32_t address = RAM_SIZE; address-- > 0;)
+        if (a.ram->cells[address] != b.ram->cells[address]) {
+            differing++;
+            first = address;
+        }
+    if (differing) {
+        printf("initial memory differs in %u words, first at %08X: %u vs %u\n", differing, first,
+               a.ram->cells[first], b.ram->cells[first]);
+        code = 1;
+    }
+    if (!same_cpu(&a.cpu, &b.cpu)) {
+        printf("initial CPU state differs\n");
+        code = 1;
+    }
+
+    CPU before_a = a.cpu, before_b = b.cpu;
+    for (;;) {
+        TraceStep step_a, step_b;
+        TraceStepStatus status_a = trace_replay_step(&a, &step_a);
+        TraceStepStatus status_b = trace_replay_step(&b, &step_b);
+        if (status_a == TRACE_STEP_OK && status_b == TRACE_STEP_OK) {
+            if (same_cpu(&a.cpu, &b.cpu) && step_a.wrote == step_b.wrote
+                && (!step_a.wrote || (step_a.address == step_b.address && step_a.value == step_b.value))) {
+                before_a = a.cpu;
+                before_b = b.cpu;
+                continue;
+            }
+            printf("first difference at instruction %llu:\n", (unsigned long long)step_a.index);
+            printf("< ");
+            print_step(&step_a, &before_a, &a.cpu, true);
+            printf("> ");
+            print_step(&step_b, &before_b, &b.cpu, true);
+            code = 1;
+            break;
+        }
+        if (status_a == TRACE_STEP_END && status_b == TRACE_STEP_END) {
+            if (a.end.stop != b.end.stop) {
+                printf("both end after %llu instructions: %s vs %s\n",
+                       (unsigned long long)a.end.instructions, cpu_stop_reason_name(a.end.stop),
+                       cpu_stop_reason_name(b.end.stop));
+                code = 1;
+            } else if (code == 0) {
+                printf("identical: %llu instructions, %s\n", (unsigned long long)a.end.instructions,
+                       cpu_stop_reason_name(a.end.stop));
+            }
+            break;
+        }
+        if (status_a == TRACE_STEP_END || status_b == TRACE_STEP_END) {
+            const TraceReplay *ended = status_a == TRACE_STEP_END ? &a : &b;
+            printf("%s ends first, after %llu instructions (%s)\n", status_a == TRACE_STEP_END ? path_a : path_b,
+                   (unsigned long long)ended->end.instructions, cpu_stop_reason_name(ended->end.stop));
+            code = 1;
+            break;
+        }
+        code = 3;
+        break;
+    }
+
+    trace_replay_close(&a);
+    trace_replay_close(&b);
+    return code;
+}
+
+int main(int argc, char **argv) {
+    log_set_enabled(LOG_DEBUG, false);
+    log_set_enabled(LOG_INFO, false);
+    if (argc < 3) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (strcmp(argv[1], "dump") == 0) {
+        bool full = false;
+        uint64_t from = 0, count = UINT64_MAX;
+        const char *path = NULL;
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--full") == 0) {
+                full = true;
+            } else if (strcmp(argv[i], "--from") == 0 && i + 1 < argc) {
+                from = strtoull(argv[++i], NULL, 0);
+            } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+                count = strtoull(argv[++i], NULL, 0);
+            } else if (argv[i][0] == '-' || path) {
+                usage(argv[0]);
+                return 2;
+            } else {
+                path = argv[i];
+            }
+        }
+        if (!path) {
+            usage(argv[0]);
+            return 2;
+        }
+        return command_dump(path, full, from, count);
+    }
+    if (strcmp(argv[1], "stats") == 0 && argc == 3)
+        return command_stats(argv[2]);
+    if (strcmp(argv[1], "diff") == 0 && argc == 4)
+        return command_diff(argv[2], argv[3]);
+
+    usage(argv[0]);
+    return 2;
+}